@@ -16,7 +16,6 @@
 
 #include "abstractdownloaditem.h"
 
-#include <QtCore/QDateTime>
 #include <QtCore/QDebug>
 #include <QtCore/QtMath>
 
@@ -28,17 +27,11 @@
  *
  */
 
-constexpr int timeout_update_msec = 150; // in milliseconds
-
 /*!
  * \brief Constructor
  */
 AbstractDownloadItem::AbstractDownloadItem(QObject *parent) : QObject(parent)
-  , m_log(QString())
 {
-    connect(&m_updateInfoTimer, SIGNAL(timeout()), this, SLOT(updateInfo()));
-    connect(&m_updateCountDownTimer, SIGNAL(timeout()), this, SLOT(updateInfo()));
-
     m_state = State::Idle;
 
     m_speed = -1;
@@ -47,6 +40,7 @@ AbstractDownloadItem::AbstractDownloadItem(QObject *parent) : QObject(parent)
 
     m_maxConnectionSegments = 4;
     m_maxConnections = 1;
+    m_priority = NormalPriority;
 }
 
 /******************************************************************************
@@ -162,7 +156,10 @@ QString AbstractDownloadItem::errorMessage() const
 
 void AbstractDownloadItem::setErrorMessage(const QString &message)
 {
-    m_errorMessage = message;
+    if (m_errorMessage != message) {
+        m_errorMessage = message;
+        emit otherChanged();
+    }
 }
 
 /******************************************************************************
@@ -193,25 +190,73 @@ void AbstractDownloadItem::setMaxConnections(int connections)
 
 /******************************************************************************
  ******************************************************************************/
+/*!
+ * \brief Returns the priority of the item, used by the WeightedPriority
+ * scheduling policy.
+ */
+IDownloadItem::Priority AbstractDownloadItem::priority() const
+{
+    return m_priority;
+}
+
+void AbstractDownloadItem::setPriority(Priority priority)
+{
+    if (priority >= LowPriority && priority <= HighPriority && m_priority != priority) {
+        m_priority = priority;
+        emit otherChanged();
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the latest events of the log, kept in memory.
+ *
+ * The whole log, if saved, is read from the LogStore.
+ */
 QString AbstractDownloadItem::log() const
 {
-    return m_log;
+    return m_eventLog.toString();
 }
 
-void AbstractDownloadItem::setLog(const QString &log)
+EventLog* AbstractDownloadItem::eventLog()
 {
-    m_log = log;
+    return &m_eventLog;
 }
 
 /*!
- * Apped the given message to the log.
+ * \brief Appends the event to the log.
+ *
+ * The \a format is a string literal, where %0 to %9 are replaced by the
+ * \a args, only when the log is read.
  */
-void AbstractDownloadItem::logInfo(const QString &message)
+void AbstractDownloadItem::logDebug(const char *format, const QStringList &args)
+{
+    appendEvent(EventLog::Debug, format, args);
+}
+
+void AbstractDownloadItem::logInfo(const char *format, const QStringList &args)
+{
+    appendEvent(EventLog::Info, format, args);
+}
+
+void AbstractDownloadItem::logWarning(const char *format, const QStringList &args)
+{
+    appendEvent(EventLog::Warning, format, args);
+}
+
+void AbstractDownloadItem::logError(const char *format, const QStringList &args)
 {
-    QDateTime local(QDateTime::currentDateTime());
-    auto timestamp = local.toString(QLatin1String("yyyy-MM-dd HH:mm:ss.zzz"));
-    m_log.append("[" + timestamp + "] " + message + "\n");
-    qInfo() << message;
+    appendEvent(EventLog::Error, format, args);
+}
+
+void AbstractDownloadItem::appendEvent(EventLog::Level level, const char *format, const QStringList &args)
+{
+    const bool wasPending = m_eventLog.pendingCount() > 0;
+    m_eventLog.append(level, format, args);
+    if (!wasPending && m_eventLog.pendingCount() > 0) {
+        emit eventsPending();
+    }
 }
 
 /******************************************************************************
@@ -284,6 +329,8 @@ void AbstractDownloadItem::stop()
     m_speed = -1;
     m_bytesReceived = 0;
     m_bytesTotal = 0;
+    m_rate.reset();
+    m_remainingTime = QTime();
 
     emit changed();
     finish();
@@ -296,7 +343,10 @@ void AbstractDownloadItem::beginResume()
     m_state = Idle;
     emit changed();
 
+    /* Speed of this session only, not counting the bytes received before a pause */
     m_downloadElapsedTimer.start();
+    m_rate.reset();
+    m_rate.addSample(0, m_bytesReceived);
 
     /* Ensure the destination directory exists */
     m_state = Preparing;
@@ -319,17 +369,10 @@ bool AbstractDownloadItem::checkResume(bool connected)
 void AbstractDownloadItem::tearDownResume()
 {
     /*
-     * This timer ticks each second, in order to update the remaining time information (countdown)
-     */
-    m_updateCountDownTimer.start(1000);
-
-    /*
-     * This timer updates the speed/progress info.
-     * It can be quicker than the countdown timer.
+     * Start downloading now.
+     * From now, the speed/progress info is sampled by the clock of the
+     * DownloadEngine, with the other active items.
      */
-    m_updateInfoTimer.start(timeout_update_msec);
-
-    /* Start downloading now. */
     m_state = Downloading;
     emit changed();
 }
@@ -347,12 +390,24 @@ void AbstractDownloadItem::preFinish(bool commited)
     emit changed();
 }
 
+/*!
+ * \brief Pauses the item, but keeps the bytes received so far.
+ *
+ * Unlike pause(), which stops the item, this is for items that can
+ * continue where they stopped.
+ */
+void AbstractDownloadItem::suspend()
+{
+    m_state = Paused;
+    m_speed = -1;
+    emit changed();
+    finish();
+}
+
 /******************************************************************************
  ******************************************************************************/
 void AbstractDownloadItem::finish()
 {
-    m_updateCountDownTimer.stop();
-    m_updateInfoTimer.stop();
     emit finished();
 }
 
@@ -369,12 +424,6 @@ void AbstractDownloadItem::updateInfo(qsizetype bytesReceived, qsizetype bytesTo
 {
     m_bytesReceived = bytesReceived;
     m_bytesTotal = bytesTotal;
-    const int elapsed = m_downloadElapsedTimer.elapsed();
-    if (elapsed > 0) {
-        m_speed = qreal(1000 * bytesReceived) / m_downloadElapsedTimer.elapsed();
-    } else {
-        m_speed = qreal(-1);
-    }
     /*
      * It's very tempting to add 'emit changed();' here, but don't do that.
      *
@@ -385,15 +434,31 @@ void AbstractDownloadItem::updateInfo(qsizetype bytesReceived, qsizetype bytesTo
      */
 }
 
+/*!
+ * \brief Samples the bytes received, and updates the speed and the
+ * remaining time.
+ *
+ * Called by the clock of the DownloadEngine, that samples all the active
+ * items at once and notifies the changes in one batch: unlike the other
+ * setters, this doesn't emit changed().
+ *
+ * The speed is the rate of the last seconds, not the average since the
+ * beginning, so that a stall shows at once.
+ */
 void AbstractDownloadItem::updateInfo()
 {
-    if (m_speed > 0 && m_bytesReceived > 0 && m_bytesTotal > 0) {
-        const int estimatedTime = qCeil(qreal(m_bytesTotal - m_bytesReceived) / m_speed);
+    if (!m_downloadElapsedTimer.isValid()) {
+        m_downloadElapsedTimer.start(); /* Not resumed in this session, e.g. seeding */
+    }
+    m_rate.addSample(m_downloadElapsedTimer.elapsed(), m_bytesReceived, m_bytesTotal);
+    m_speed = m_rate.rate();
+
+    const qint64 estimatedTime = m_rate.remainingTime();
+    if (estimatedTime >= 0 && m_bytesReceived > 0) {
         QTime time(0, 0, 0);
         time = time.addSecs(estimatedTime);
         m_remainingTime = time;
     } else {
         m_remainingTime = QTime();
     }
-    emit changed();
 }
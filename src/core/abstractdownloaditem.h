@@ -17,14 +17,15 @@
 #ifndef CORE_ABSTRACT_DOWNLOAD_ITEM_H
 #define CORE_ABSTRACT_DOWNLOAD_ITEM_H
 
+#include <Core/EventLog>
 #include <Core/IDownloadItem>
+#include <Core/RateEstimator>
 
 #include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
 #include <QtCore/QString>
 #include <QtCore/QUrl>
 #include <QtCore/QTime>
-#include <QtCore/QTimer>
 
 class AbstractDownloadItem : public QObject, public IDownloadItem
 {
@@ -57,9 +58,16 @@ public:
     int maxConnections() const Q_DECL_OVERRIDE;
     void setMaxConnections(int connections);
 
+    Priority priority() const Q_DECL_OVERRIDE;
+    void setPriority(Priority priority);
+
     QString log() const Q_DECL_OVERRIDE;
-    void setLog(const QString &log);
-    void logInfo(const QString &message);
+    EventLog* eventLog();
+
+    void logDebug(const char *format, const QStringList &args = {});
+    void logInfo(const char *format, const QStringList &args = {});
+    void logWarning(const char *format, const QStringList &args = {});
+    void logError(const char *format, const QStringList &args = {});
 
     bool isResumable() const Q_DECL_OVERRIDE;
     bool isPausable() const Q_DECL_OVERRIDE;
@@ -67,6 +75,7 @@ public:
     bool isDownloading() const Q_DECL_OVERRIDE;
 
     QTime remainingTime();
+    void updateInfo();
 
     void setReadyToResume() Q_DECL_OVERRIDE;
 
@@ -77,6 +86,7 @@ public:
     bool checkResume(bool connected);
     void tearDownResume();
     void preFinish(bool commited);
+    void suspend();
 
     void finish();
 
@@ -84,15 +94,14 @@ public:
 
 signals:
     void changed();
+    void otherChanged(); ///< Priority, error message, etc.
     void finished();
     void renamed(QString oldName, QString newName, bool success);
+    void eventsPending(); ///< First event of the log since the last takePending()
 
 public slots:
     void updateInfo(qsizetype bytesReceived, qsizetype bytesTotal);
 
-private slots:
-    void updateInfo();
-
 private:
     State m_state;
 
@@ -104,14 +113,15 @@ private:
 
     int m_maxConnectionSegments;
     int m_maxConnections;
+    Priority m_priority;
+
+    EventLog m_eventLog;
 
-    QString m_log;
+    void appendEvent(EventLog::Level level, const char *format, const QStringList &args);
 
     QElapsedTimer m_downloadElapsedTimer;
+    RateEstimator m_rate;
     QTime m_remainingTime;
-    QTimer m_updateInfoTimer;
-    QTimer m_updateCountDownTimer;
-
 };
 
 #endif // CORE_ABSTRACT_DOWNLOAD_ITEM_H
@@ -0,0 +1,339 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bandwidthmanager.h"
+
+#include <QtCore/QMutexLocker>
+#include <QtCore/QTime>
+
+#include <limits>
+
+constexpr qint64 msec_burst = 250;          ///< Bytes that can be read at once, in time at full rate
+constexpr qint64 min_burst_size = 16 * 1024;
+
+static qint64 minLimit(qint64 a, qint64 b)
+{
+    if (a <= 0) {
+        return qMax(qint64(0), b);
+    }
+    return b <= 0 ? a : qMin(a, b);
+}
+
+/*!
+ * \class TokenBucket
+ *
+ * The class TokenBucket limits a rate: it fills up with the rate in bytes
+ * per second, up to a small burst, and the bytes read are taken from it.
+ *
+ * The bucket can go below zero, when several readers take the same tokens:
+ * it's then empty until the debt is paid back.
+ */
+
+/******************************************************************************
+ ******************************************************************************/
+qint64 TokenBucket::rate() const
+{
+    return m_rate;
+}
+
+/*!
+ * \brief Sets the rate, in bytes per second, or 0 if unlimited.
+ */
+void TokenBucket::setRate(qint64 bytesPerSecond)
+{
+    m_rate = qMax(qint64(0), bytesPerSecond);
+    m_tokens = qMin(m_tokens, capacity());
+}
+
+/*!
+ * \brief Returns the bytes that can be read at the given time.
+ */
+qint64 TokenBucket::available(qint64 msecs)
+{
+    if (m_rate <= 0) {
+        return std::numeric_limits<qint64>::max();
+    }
+    if (m_lastMsecs < 0) {
+        m_tokens = capacity();
+    } else if (msecs > m_lastMsecs) {
+        m_tokens = qMin(capacity(), m_tokens + qreal(m_rate * (msecs - m_lastMsecs)) / 1000);
+    }
+    m_lastMsecs = msecs;
+    return qMax(qint64(0), qint64(m_tokens));
+}
+
+void TokenBucket::consume(qint64 bytes)
+{
+    if (m_rate > 0) {
+        m_tokens -= bytes;
+    }
+}
+
+qreal TokenBucket::capacity() const
+{
+    return qMax(qreal(min_burst_size), qreal(m_rate * msec_burst) / 1000);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \class BandwidthManager
+ *
+ * The class BandwidthManager enforces a global bandwidth limit, shared by
+ * the HTTP, stream and torrent downloads, and optional limits per host and
+ * per download.
+ *
+ * The global limit is a hard cap on the sum of the protocols:
+ * \li each stream reserves its share when it starts, as the '--limit-rate'
+ * of its process (see reserveStreamLimit()); it can't change until the stream
+ * restarts, so it's taken out of the global limit until the stream releases it
+ * (see releaseStreamLimit());
+ * \li the rest is split between the HTTP transfers and the torrents in
+ * proportion to their active downloads, so that none of them is starved;
+ * \li the HTTP transfers share a token bucket, and stop reading their
+ * sockets when it's empty (see available() and consume());
+ * \li the torrents share the rate limit of the libtorrent session, given
+ * by protocolLimit(Torrent).
+ *
+ * The per-host limit applies to the HTTP transfers only.
+ *
+ * The methods are thread-safe: the HTTP transfers run in transfer threads.
+ */
+BandwidthManager& BandwidthManager::getInstance()
+{
+    static BandwidthManager instance; // lazy singleton, instantiated on first use
+    return instance;
+}
+
+BandwidthManager::BandwidthManager() : QObject()
+{
+    m_clock.start();
+}
+
+/*!
+ * \brief Returns true if the time is in the period between \a from and \a to,
+ * that can span midnight (e.g. from 22:00 to 06:00).
+ */
+bool BandwidthManager::isInPeriod(const QTime &time, const QTime &from, const QTime &to)
+{
+    if (!from.isValid() || !to.isValid() || from == to) {
+        return false;
+    }
+    if (from < to) {
+        return from <= time && time < to;
+    }
+    return from <= time || time < to;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+qint64 BandwidthManager::globalLimit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_globalLimit;
+}
+
+void BandwidthManager::setGlobalLimit(qint64 bytesPerSecond)
+{
+    QMutexLocker locker(&m_mutex);
+    bytesPerSecond = qMax(qint64(0), bytesPerSecond);
+    if (m_globalLimit == bytesPerSecond) {
+        return;
+    }
+    m_globalLimit = bytesPerSecond;
+    updateLocked();
+    locker.unlock();
+    emit limitsChanged();
+}
+
+qint64 BandwidthManager::hostLimit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hostLimit;
+}
+
+void BandwidthManager::setHostLimit(qint64 bytesPerSecond)
+{
+    QMutexLocker locker(&m_mutex);
+    m_hostLimit = qMax(qint64(0), bytesPerSecond);
+    m_hostBuckets.clear();
+}
+
+qint64 BandwidthManager::itemLimit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_itemLimit;
+}
+
+/*!
+ * \brief Sets the limit of each download. It applies to the downloads
+ * started afterwards.
+ */
+void BandwidthManager::setItemLimit(qint64 bytesPerSecond)
+{
+    QMutexLocker locker(&m_mutex);
+    m_itemLimit = qMax(qint64(0), bytesPerSecond);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Sets the number of active downloads of the protocol, to split the
+ * global limit.
+ */
+void BandwidthManager::setActiveCount(Protocol protocol, int count)
+{
+    QMutexLocker locker(&m_mutex);
+    count = qMax(0, count);
+    if (m_activeCounts[protocol] == count) {
+        return;
+    }
+    const qint64 torrentLimit = protocolLimitLocked(Torrent);
+    m_activeCounts[protocol] = count;
+    updateLocked();
+    const bool changed = protocolLimitLocked(Torrent) != torrentLimit;
+    locker.unlock();
+    if (changed) {
+        emit limitsChanged();
+    }
+}
+
+/*!
+ * \brief Returns the share of the global limit for all the downloads of
+ * the protocol, or 0 if unlimited.
+ *
+ * For the streams, it's the sum of the limits reserved by the running streams.
+ */
+qint64 BandwidthManager::protocolLimit(Protocol protocol) const
+{
+    QMutexLocker locker(&m_mutex);
+    return protocolLimitLocked(protocol);
+}
+
+/*!
+ * \brief Returns the limit of a stream that starts now, or 0 if unlimited,
+ * and reserves it until releaseStreamLimit() is called.
+ *
+ * The stream gets its share of the global limit, but no more than what the
+ * other running streams left.
+ */
+qint64 BandwidthManager::reserveStreamLimit()
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 share = 0;
+    if (m_globalLimit > 0) {
+        const int total = m_activeCounts[Http] + m_activeCounts[Torrent]
+                + m_streamReservedCount + 1;
+        share = m_globalLimit / total;
+        share = qMax(qint64(1), qMin(share, m_globalLimit - m_streamReserved));
+    }
+    const qint64 limit = minLimit(share, m_itemLimit);
+    locker.unlock();
+    changeStreamReserved(limit, 1);
+    return limit;
+}
+
+/*!
+ * \brief Gives back the limit reserved by a stream that stopped.
+ */
+void BandwidthManager::releaseStreamLimit(qint64 bytesPerSecond)
+{
+    changeStreamReserved(-bytesPerSecond, -1);
+}
+
+void BandwidthManager::changeStreamReserved(qint64 bytesPerSecond, int count)
+{
+    if (bytesPerSecond == 0) {
+        return; // unlimited stream
+    }
+    QMutexLocker locker(&m_mutex);
+    const qint64 torrentLimit = protocolLimitLocked(Torrent);
+    m_streamReserved = qMax(qint64(0), m_streamReserved + bytesPerSecond);
+    m_streamReservedCount = qMax(0, m_streamReservedCount + count);
+    updateLocked();
+    const bool changed = protocolLimitLocked(Torrent) != torrentLimit;
+    locker.unlock();
+    if (changed) {
+        emit limitsChanged();
+    }
+}
+
+qint64 BandwidthManager::protocolLimitLocked(Protocol protocol) const
+{
+    if (m_globalLimit <= 0) {
+        return 0;
+    }
+    if (protocol == Stream) {
+        return m_streamReserved > 0 ? m_streamReserved : m_globalLimit;
+    }
+    const qint64 budget = qMax(qint64(1), m_globalLimit - m_streamReserved);
+    const int total = m_activeCounts[Http] + m_activeCounts[Torrent];
+    if (total == 0 || m_activeCounts[protocol] == 0) {
+        return budget;
+    }
+    return qMax(qint64(1), budget * m_activeCounts[protocol] / total);
+}
+
+void BandwidthManager::updateLocked()
+{
+    m_httpBucket.setRate(protocolLimitLocked(Http));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the bytes that an HTTP transfer from \a host can read now.
+ *
+ * When it's 0, the transfer must stop reading its sockets and try again
+ * a bit later.
+ */
+qint64 BandwidthManager::available(const QString &host, TokenBucket *itemBucket)
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 now = m_clock.elapsed();
+    qint64 bytes = m_httpBucket.available(now);
+    if (m_hostLimit > 0) {
+        auto it = m_hostBuckets.find(host);
+        if (it == m_hostBuckets.end()) {
+            it = m_hostBuckets.insert(host, TokenBucket());
+            it->setRate(m_hostLimit);
+        }
+        bytes = qMin(bytes, it->available(now));
+    }
+    if (itemBucket) {
+        bytes = qMin(bytes, itemBucket->available(now));
+    }
+    return bytes;
+}
+
+/*!
+ * \brief Takes the bytes read by an HTTP transfer from \a host out of the
+ * budgets.
+ */
+void BandwidthManager::consume(const QString &host, qint64 bytes, TokenBucket *itemBucket)
+{
+    QMutexLocker locker(&m_mutex);
+    m_httpBucket.consume(bytes);
+    if (m_hostLimit > 0) {
+        auto it = m_hostBuckets.find(host);
+        if (it != m_hostBuckets.end()) {
+            it->consume(bytes);
+        }
+    }
+    if (itemBucket) {
+        itemBucket->consume(bytes);
+    }
+}
@@ -0,0 +1,112 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_BANDWIDTH_MANAGER_H
+#define CORE_BANDWIDTH_MANAGER_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+class QTime;
+
+class TokenBucket
+{
+public:
+    TokenBucket() = default;
+
+    qint64 rate() const;
+    void setRate(qint64 bytesPerSecond);
+
+    qint64 available(qint64 msecs);
+    void consume(qint64 bytes);
+
+private:
+    qint64 m_rate{0};
+    qreal m_tokens{0};
+    qint64 m_lastMsecs{-1};
+
+    qreal capacity() const;
+};
+
+class BandwidthManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Protocol {
+        Http = 0,
+        Stream,
+        Torrent,
+        ProtocolCount
+    };
+
+    static BandwidthManager& getInstance();
+
+    static bool isInPeriod(const QTime &time, const QTime &from, const QTime &to);
+
+    /* Limits, in bytes per second, or 0 if unlimited */
+    qint64 globalLimit() const;
+    void setGlobalLimit(qint64 bytesPerSecond);
+
+    qint64 hostLimit() const;
+    void setHostLimit(qint64 bytesPerSecond);
+
+    qint64 itemLimit() const;
+    void setItemLimit(qint64 bytesPerSecond);
+
+    void setActiveCount(Protocol protocol, int count);
+    qint64 protocolLimit(Protocol protocol) const;
+
+    qint64 reserveStreamLimit();
+    void releaseStreamLimit(qint64 bytesPerSecond);
+
+    /* HTTP readers */
+    qint64 available(const QString &host, TokenBucket *itemBucket = Q_NULLPTR);
+    void consume(const QString &host, qint64 bytes, TokenBucket *itemBucket = Q_NULLPTR);
+
+signals:
+    void limitsChanged();
+
+private:
+    BandwidthManager();
+    ~BandwidthManager() Q_DECL_OVERRIDE = default;
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_clock;
+
+    qint64 m_globalLimit{0};
+    qint64 m_hostLimit{0};
+    qint64 m_itemLimit{0};
+    int m_activeCounts[ProtocolCount] = {0, 0, 0};
+    qint64 m_streamReserved{0};
+    int m_streamReservedCount{0};
+
+    TokenBucket m_httpBucket;
+    QHash<QString, TokenBucket> m_hostBuckets;
+
+    qint64 protocolLimitLocked(Protocol protocol) const;
+    void updateLocked();
+    void changeStreamReserved(qint64 bytesPerSecond, int count);
+
+public:
+    BandwidthManager(BandwidthManager const&) = delete;
+    void operator=(BandwidthManager const&) = delete;
+};
+
+#endif // CORE_BANDWIDTH_MANAGER_H
@@ -0,0 +1,108 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "bufferpool.h"
+
+#include <QtCore/QMutexLocker>
+
+constexpr qsizetype slab_size = 256 * 1024;  ///< 256 KiB per buffer
+constexpr int max_free_buffers = 64;        ///< Keep at most 16 MiB of unused buffers
+
+/*!
+ * \class BufferPool
+ *
+ * The class BufferPool recycles the fixed-size buffers where the transfers
+ * read the network data, instead of allocating a new QByteArray for each
+ * chunk of data.
+ *
+ * A transfer fills the buffer, writes it to the file in one call when it's
+ * full, and gives it back to the pool. The pool is shared by all the
+ * transfers, and is thread-safe.
+ */
+
+BufferPool& BufferPool::getInstance()
+{
+    static BufferPool instance; // lazy singleton, instantiated on first use
+    return instance;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+qsizetype BufferPool::slabSize()
+{
+    return slab_size;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns a buffer of slabSize() bytes, reused if possible.
+ */
+QByteArray BufferPool::acquire()
+{
+    m_acquireCount++;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_freeBuffers.isEmpty()) {
+            return m_freeBuffers.takeLast();
+        }
+    }
+    m_allocationCount++;
+    return QByteArray(slab_size, Qt::Uninitialized);
+}
+
+/*!
+ * \brief Gives the buffer back to the pool, and clears the given reference.
+ */
+void BufferPool::release(QByteArray &buffer)
+{
+    if (buffer.size() != slab_size) {
+        buffer = QByteArray();
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    if (m_freeBuffers.count() < max_free_buffers) {
+        m_freeBuffers.append(std::move(buffer));
+    }
+    buffer = QByteArray();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the number of buffers allocated since the start.
+ */
+qint64 BufferPool::allocationCount() const
+{
+    return m_allocationCount;
+}
+
+/*!
+ * \brief Returns the number of buffers requested since the start.
+ */
+qint64 BufferPool::acquireCount() const
+{
+    return m_acquireCount;
+}
+
+/*!
+ * \brief Returns the number of unused buffers kept in the pool.
+ */
+int BufferPool::freeCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_freeBuffers.count();
+}
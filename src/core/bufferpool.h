@@ -0,0 +1,56 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_BUFFER_POOL_H
+#define CORE_BUFFER_POOL_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+
+#include <atomic>
+
+class BufferPool
+{
+public:
+    static BufferPool& getInstance();
+
+    static qsizetype slabSize();
+
+    QByteArray acquire();
+    void release(QByteArray &buffer);
+
+    /* Statistics */
+    qint64 allocationCount() const;
+    qint64 acquireCount() const;
+    int freeCount() const;
+
+private:
+    BufferPool() = default;
+    ~BufferPool() = default;
+
+    mutable QMutex m_mutex;
+    QList<QByteArray> m_freeBuffers;
+
+    std::atomic<qint64> m_allocationCount{0};
+    std::atomic<qint64> m_acquireCount{0};
+
+public:
+    BufferPool(BufferPool const&) = delete;
+    void operator=(BufferPool const&) = delete;
+};
+
+#endif // CORE_BUFFER_POOL_H
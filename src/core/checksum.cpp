@@ -0,0 +1,227 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "checksum.h"
+
+#include <Core/BufferPool>
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QMutexLocker>
+
+struct HashAlgorithm
+{
+    const char *name;
+    QCryptographicHash::Algorithm algorithm;
+    int length;     ///< Number of hexadecimal digits of the digest
+};
+
+static const HashAlgorithm s_algorithms[] = {
+    { "md5",    QCryptographicHash::Md5,     32 },
+    { "sha1",   QCryptographicHash::Sha1,    40 },
+    { "sha256", QCryptographicHash::Sha256,  64 },
+    { "sha512", QCryptographicHash::Sha512, 128 }
+};
+
+static bool isHexadecimal(const QByteArray &text)
+{
+    for (const char c : text) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return !text.isEmpty();
+}
+
+/*!
+ * \class Checksum
+ *
+ * The class Checksum computes the hash of a download while it's written,
+ * to compare it with the expected checksum of the resource.
+ *
+ * The segments of a download are written in any order, but a hash can only
+ * be computed in order: the bytes that follow the bytes hashed so far are
+ * hashed at once, and the others are read back from the file later, with
+ * addFile(). A download received in order is thus never read again.
+ *
+ * The methods are thread-safe.
+ */
+
+Checksum::Checksum(const QString &checkSum)
+    : m_isValid(parse(checkSum, &m_algorithm, &m_expected))
+    , m_hash(m_algorithm)
+{
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Parses the given checksum, e.g. "sha256:9f86d0...", into its
+ * \a algorithm and its hexadecimal \a digest.
+ *
+ * The algorithm (MD5, SHA-1, SHA-256 or SHA-512) is given by the prefix,
+ * if any, otherwise it's detected from the length of the digest.
+ *
+ * Returns false if the checksum isn't recognized.
+ */
+bool Checksum::parse(const QString &checkSum,
+                     QCryptographicHash::Algorithm *algorithm, QByteArray *digest)
+{
+    QString text = checkSum.trimmed().toLower();
+    QString name;
+    for (int i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (c == ':' || c == '=' || c.isSpace()) {
+            name = text.left(i).remove('-').remove('_');
+            text = text.mid(i + 1).trimmed();
+            break;
+        }
+    }
+    const QByteArray hex = text.toLatin1();
+    if (!isHexadecimal(hex)) {
+        return false;
+    }
+    for (const HashAlgorithm &known : s_algorithms) {
+        const bool matches = name.isEmpty()
+                ? hex.size() == known.length
+                : name == QLatin1String(known.name);
+        if (matches) {
+            if (hex.size() != known.length) {
+                return false;
+            }
+            if (algorithm) {
+                *algorithm = known.algorithm;
+            }
+            if (digest) {
+                *digest = hex;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool Checksum::isValid() const
+{
+    return m_isValid;
+}
+
+QCryptographicHash::Algorithm Checksum::algorithm() const
+{
+    return m_algorithm;
+}
+
+/*!
+ * \brief Returns the expected digest, in lowercase hexadecimal.
+ */
+QByteArray Checksum::expected() const
+{
+    return m_expected;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the number of bytes hashed so far, from the beginning of
+ * the file.
+ */
+qsizetype Checksum::position() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_position;
+}
+
+/*!
+ * \brief Hashes the given bytes, written at the given offset of the file.
+ *
+ * Only the bytes that continue the bytes hashed so far are hashed. The
+ * bytes after a gap are ignored, and must be hashed later with addFile().
+ */
+void Checksum::addData(qsizetype offset, const char *data, qsizetype size)
+{
+    QMutexLocker locker(&m_mutex);
+    if (offset > m_position || offset + size <= m_position) {
+        return;
+    }
+    const qsizetype skipped = m_position - offset;
+    m_hash.addData(QByteArrayView(data + skipped, size - skipped));
+    m_position = offset + size;
+}
+
+/*!
+ * \brief Reads the given file, to hash the bytes that are not hashed yet,
+ * up to the given size.
+ *
+ * Returns true if the bytes are hashed up to the given size, or false if
+ * the file is too short, can't be read, or if it's canceled.
+ */
+bool Checksum::addFile(const QString &fileName, qsizetype size,
+                       const std::atomic<bool> &canceled)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        qWarning("Couldn't read file to hash.");
+        return false;
+    }
+    QByteArray buffer = BufferPool::getInstance().acquire();
+    qsizetype position = this->position();
+    while (position < size && !canceled) {
+        const qint64 count = qMin(qsizetype(buffer.size()), size - position);
+        if (!file.seek(position) || file.read(buffer.data(), count) != count) {
+            break;
+        }
+        /* Unlocked while reading: the writes can continue meanwhile */
+        addData(position, buffer.constData(), count);
+        position = this->position();
+    }
+    BufferPool::getInstance().release(buffer);
+    return position >= size;
+}
+
+/*!
+ * \brief Forgets the bytes hashed so far, e.g. when the file is truncated.
+ */
+void Checksum::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_hash.reset();
+    m_position = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the digest of the bytes hashed so far, in lowercase
+ * hexadecimal.
+ *
+ * Call it once all the bytes are hashed: the digest isn't updated by the
+ * bytes added after.
+ */
+QByteArray Checksum::result()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hash.result().toHex();
+}
+
+/*!
+ * \brief Returns true if the bytes hashed so far match the expected digest.
+ */
+bool Checksum::verify()
+{
+    return m_isValid && result() == m_expected;
+}
@@ -0,0 +1,57 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_CHECKSUM_H
+#define CORE_CHECKSUM_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+
+#include <atomic>
+
+class Checksum
+{
+public:
+    explicit Checksum(const QString &checkSum = QString());
+
+    static bool parse(const QString &checkSum,
+                      QCryptographicHash::Algorithm *algorithm, QByteArray *digest);
+
+    bool isValid() const;
+    QCryptographicHash::Algorithm algorithm() const;
+    QByteArray expected() const;
+
+    qsizetype position() const;
+    void addData(qsizetype offset, const char *data, qsizetype size);
+    bool addFile(const QString &fileName, qsizetype size, const std::atomic<bool> &canceled);
+    void reset();
+
+    QByteArray result();
+    bool verify();
+
+private:
+    QCryptographicHash::Algorithm m_algorithm{QCryptographicHash::Md5};
+    QByteArray m_expected;
+    bool m_isValid{false};
+
+    mutable QMutex m_mutex;
+    QCryptographicHash m_hash;
+    qsizetype m_position{0};    ///< End of the bytes hashed so far
+};
+
+#endif // CORE_CHECKSUM_H
@@ -0,0 +1,167 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "concurrencycontroller.h"
+
+constexpr int samples_per_period = 5;       ///< Samples averaged before each decision
+constexpr qreal min_goodput_gain = 0.05;    ///< One more download must bring 5% more goodput
+constexpr qreal decrease_factor = 0.75;     ///< Multiplicative decrease on congestion
+constexpr int hold_periods = 12;            ///< Periods to wait before probing again
+constexpr int congestion_min_errors = 2;    ///< Errors of a host before it's congested
+constexpr qreal congestion_error_rate = 0.25;
+
+/*!
+ * \class ConcurrencyController
+ *
+ * The class ConcurrencyController finds the number of simultaneous
+ * downloads that gives the best aggregate goodput, instead of a fixed
+ * number that suits one network but not another.
+ *
+ * It's an AIMD controller (additive increase, multiplicative decrease):
+ * \li while the queue has waiting items, it adds one download at a time,
+ * and keeps it if the goodput grows by at least 5%;
+ * \li if it doesn't, the knee is passed: it removes that download, and
+ * holds the limit for a while before probing again;
+ * \li if a host fails too often (errors or timeouts), it reduces the
+ * limit by a quarter.
+ *
+ * The engine gives a goodput sample each second with addSample(), and the
+ * end of each download with addResult().
+ */
+
+/******************************************************************************
+ ******************************************************************************/
+int ConcurrencyController::limit() const
+{
+    return m_limit;
+}
+
+/*!
+ * \brief Restarts the search from the given limit.
+ */
+void ConcurrencyController::reset(int limit)
+{
+    m_limit = qBound(m_minimum, limit, m_maximum);
+    m_hostStats.clear();
+    m_goodputSum = 0;
+    m_sampleCount = 0;
+    m_isSaturated = true;
+    m_previousGoodput = 0;
+    m_isProbing = false;
+    m_holdPeriods = 0;
+}
+
+int ConcurrencyController::minimum() const
+{
+    return m_minimum;
+}
+
+int ConcurrencyController::maximum() const
+{
+    return m_maximum;
+}
+
+void ConcurrencyController::setRange(int minimum, int maximum)
+{
+    m_minimum = qMax(1, minimum);
+    m_maximum = qMax(m_minimum, maximum);
+    m_limit = qBound(m_minimum, m_limit, m_maximum);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Records the end of a download from the given host.
+ *
+ * A \a failed download is a network error, including the timeouts.
+ */
+void ConcurrencyController::addResult(const QString &host, bool failed)
+{
+    auto &stats = m_hostStats[host];
+    if (failed) {
+        stats.errors++;
+    } else {
+        stats.successes++;
+    }
+}
+
+/*!
+ * \brief Records the aggregate goodput, in bytes per second.
+ *
+ * \a isSaturated is true if all the slots are used and items are waiting:
+ * only then does one more slot make a difference.
+ *
+ * Returns true if the limit has changed.
+ */
+bool ConcurrencyController::addSample(qreal goodput, bool isSaturated)
+{
+    m_goodputSum += qMax(goodput, qreal(0));
+    m_isSaturated = m_isSaturated && isSaturated;
+    if (++m_sampleCount < samples_per_period) {
+        return false;
+    }
+    const bool changed = update(m_goodputSum / m_sampleCount);
+    m_goodputSum = 0;
+    m_sampleCount = 0;
+    m_isSaturated = true;
+    return changed;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool ConcurrencyController::hasCongestedHost() const
+{
+    for (const auto &stats : m_hostStats) {
+        const int total = stats.errors + stats.successes;
+        if (stats.errors >= congestion_min_errors
+                && stats.errors >= congestion_error_rate * total) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ConcurrencyController::update(qreal goodput)
+{
+    const int previousLimit = m_limit;
+    const bool wasProbing = m_isProbing;
+    m_isProbing = false;
+
+    if (hasCongestedHost()) {
+        /* Multiplicative decrease, of at least one download */
+        m_limit = qMax(m_minimum, qMin(m_limit - 1, int(m_limit * decrease_factor)));
+        m_holdPeriods = hold_periods;
+
+    } else if (!m_isSaturated) {
+        /* Not enough items to measure anything */
+
+    } else if (wasProbing && goodput < m_previousGoodput * (1 + min_goodput_gain)) {
+        /* The knee: the last download added doesn't bring more goodput */
+        m_limit = qMax(m_minimum, m_limit - 1);
+        m_holdPeriods = hold_periods;
+
+    } else if (m_holdPeriods > 0) {
+        m_holdPeriods--;
+
+    } else if (m_limit < m_maximum) {
+        /* Additive increase */
+        m_limit++;
+        m_isProbing = true;
+    }
+    m_previousGoodput = goodput;
+    m_hostStats.clear();
+    return m_limit != previousLimit;
+}
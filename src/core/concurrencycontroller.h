@@ -0,0 +1,62 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_CONCURRENCY_CONTROLLER_H
+#define CORE_CONCURRENCY_CONTROLLER_H
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+
+class ConcurrencyController
+{
+public:
+    ConcurrencyController() = default;
+
+    int limit() const;
+    void reset(int limit);
+
+    int minimum() const;
+    int maximum() const;
+    void setRange(int minimum, int maximum);
+
+    void addResult(const QString &host, bool failed);
+    bool addSample(qreal goodput, bool isSaturated);
+
+private:
+    struct HostStats
+    {
+        int successes{0};
+        int errors{0};
+    };
+    QHash<QString, HostStats> m_hostStats;
+
+    int m_limit{4};
+    int m_minimum{1};
+    int m_maximum{20};
+
+    qreal m_goodputSum{0};
+    int m_sampleCount{0};
+    bool m_isSaturated{true};
+
+    qreal m_previousGoodput{0};
+    bool m_isProbing{false};
+    int m_holdPeriods{0};
+
+    bool hasCongestedHost() const;
+    bool update(qreal goodput);
+};
+
+#endif // CORE_CONCURRENCY_CONTROLLER_H
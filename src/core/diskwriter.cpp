@@ -0,0 +1,378 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "diskwriter.h"
+
+#include <Core/BufferPool>
+#include <Core/File>
+#include <Core/IoUring>
+
+#include <QtCore/QDebug>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+
+#include <cerrno>
+
+constexpr int max_queued_writes = 32;   ///< Up to 8 MiB of pooled buffers per volume
+
+/*!
+ * \class DiskWriter
+ *
+ * The class DiskWriter writes the data of the files in the background,
+ * so that a slow disk (e.g. a NAS or a spinning disk) doesn't block the
+ * transfers or the GUI.
+ *
+ * Each volume has its own worker thread and its own queue, so that a
+ * stalled volume doesn't delay the writes to the other volumes, and the
+ * writes to a given volume are never done in parallel.
+ *
+ * The queue of a volume is bounded: when isFull() returns true, the
+ * transfers stop reading the sockets, until writable() is emitted.
+ *
+ * On Linux, the writes can go through io_uring (see setIoUringEnabled()):
+ * the worker then takes all the queued writes of its volume, and submits
+ * them in a single system call. If io_uring isn't available, or fails,
+ * the worker falls back to the plain writes.
+ *
+ * The buffers are given back to the BufferPool once written.
+ *
+ * A failed write (e.g. disk full, I/O error) is kept per file, until
+ * clearError(): the bytes are lost, so the download must fail rather than
+ * count them. See errorString().
+ */
+
+DiskWriter& DiskWriter::getInstance()
+{
+    static DiskWriter instance; // lazy singleton, instantiated on first use
+    return instance;
+}
+
+DiskWriter::DiskWriter() : QObject()
+{
+}
+
+DiskWriter::~DiskWriter()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_isQuitting = true;
+        for (auto volume : std::as_const(m_volumes)) {
+            volume->wakeUp.wakeAll();
+        }
+    }
+    /* The workers write the remaining jobs before they quit */
+    for (auto volume : std::as_const(m_volumes)) {
+        volume->thread->wait();
+        delete volume->thread;
+        delete volume;
+    }
+    m_volumes.clear();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the maximum number of writes queued per volume, before
+ * the transfers are paused.
+ */
+int DiskWriter::maxQueuedWrites()
+{
+    return max_queued_writes;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns true if io_uring can be used on this system.
+ */
+bool DiskWriter::isIoUringSupported()
+{
+    return IoUring::isSupported();
+}
+
+bool DiskWriter::isIoUringEnabled() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_isIoUringEnabled;
+}
+
+/*!
+ * \brief Writes the data with io_uring instead of the plain writes, if supported.
+ */
+void DiskWriter::setIoUringEnabled(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_isIoUringEnabled = enabled;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Queues the first size bytes of buffer, to be written at the given
+ * offset of the file.
+ *
+ * The buffer is shared, not copied: the caller must not modify it anymore.
+ */
+void DiskWriter::write(File *file, const QString &volume,
+                       qsizetype offset, const QByteArray &buffer, qsizetype size)
+{
+    Job job;
+    job.file = file;
+    job.offset = offset;
+    job.buffer = buffer;
+    job.size = size;
+    job.timer.start();
+
+    QMutexLocker locker(&m_mutex);
+    Volume *v = this->volume(volume);
+    v->jobs.enqueue(std::move(job));
+    if (v->jobs.count() >= max_queued_writes) {
+        v->isFull = true;
+    }
+    m_pendingWrites[file]++;
+    m_queueDepth++;
+    m_maxQueueDepth = qMax(m_maxQueueDepth, m_queueDepth);
+    v->wakeUp.wakeOne();
+}
+
+/*!
+ * \brief Blocks until all the queued writes of the given file are written.
+ *
+ * Returns false if a write of the file failed.
+ */
+bool DiskWriter::waitForWrites(const File *file)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_pendingWrites.value(file) > 0) {
+        m_written.wait(&m_mutex);
+    }
+    return !m_errors.contains(file);
+}
+
+/*!
+ * \brief Returns the error of the first write of the file that failed, or
+ * an empty string if all its writes succeeded so far.
+ */
+QString DiskWriter::errorString(const File *file) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_errors.value(file);
+}
+
+/*!
+ * \brief Forgets the error of the file, e.g. when its partial file is
+ * removed or truncated.
+ */
+void DiskWriter::clearError(const File *file)
+{
+    QMutexLocker locker(&m_mutex);
+    m_errors.remove(file);
+}
+
+/*!
+ * \brief Returns true if the queue of the given volume is full.
+ *
+ * In that case, writable() is emitted once the queue is half empty.
+ */
+bool DiskWriter::isFull(const QString &volume)
+{
+    QMutexLocker locker(&m_mutex);
+    Volume *v = m_volumes.value(volume, Q_NULLPTR);
+    if (!v) {
+        return false;
+    }
+    if (v->jobs.count() >= max_queued_writes) {
+        v->isFull = true;
+    }
+    return v->isFull;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the number of writes in the queues, for all the volumes.
+ */
+int DiskWriter::queueDepth() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_queueDepth;
+}
+
+/*!
+ * \brief Returns the highest number of writes in the queues, since the start.
+ */
+int DiskWriter::maxQueueDepth() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxQueueDepth;
+}
+
+/*!
+ * \brief Returns the average time, in msec, between the queuing of a write
+ * and the end of the write.
+ */
+qreal DiskWriter::averageLatency() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_writeCount > 0 ? qreal(m_totalLatency) / m_writeCount : 0;
+}
+
+/*!
+ * \brief Returns the longest time, in msec, taken by a write since the start.
+ */
+qint64 DiskWriter::maxLatency() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxLatency;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+DiskWriter::Volume* DiskWriter::volume(const QString &name)
+{
+    Volume *volume = m_volumes.value(name, Q_NULLPTR);
+    if (!volume) {
+        volume = new Volume();
+        volume->thread = QThread::create([this, volume]() { run(volume); });
+        volume->thread->setObjectName(QString("DiskWriter %0").arg(name));
+        volume->thread->start();
+        m_volumes.insert(name, volume);
+    }
+    return volume;
+}
+
+void DiskWriter::run(Volume *volume)
+{
+    QScopedPointer<IoUring> ring;
+    bool isRingBroken = false;
+
+    QMutexLocker locker(&m_mutex);
+    forever {
+        while (volume->jobs.isEmpty() && !m_isQuitting) {
+            volume->wakeUp.wait(&m_mutex);
+        }
+        if (volume->jobs.isEmpty()) {
+            return;
+        }
+        if (!m_isIoUringEnabled || isRingBroken) {
+            ring.reset();
+        } else if (!ring && IoUring::isSupported()) {
+            ring.reset(new IoUring(max_queued_writes));
+        }
+        const int batchSize = ring && ring->isValid() ? int(ring->capacity()) : 1;
+
+        QList<Job> batch;
+        while (!volume->jobs.isEmpty() && batch.count() < batchSize) {
+            batch.append(volume->jobs.dequeue());
+        }
+        m_queueDepth -= batch.count();
+        locker.unlock();
+
+        if (batchSize > 1) {
+            if (!writeBatch(ring.data(), batch)) {
+                qWarning("io_uring failed, fall back to plain writes.");
+                isRingBroken = true;
+                ring.reset();
+            }
+        } else {
+            for (Job &job : batch) {
+                job.error = job.file->writeNow(job.offset, job.buffer.constData(), job.size);
+            }
+        }
+        QList<qint64> latencies;
+        latencies.reserve(batch.count());
+        for (Job &job : batch) {
+            latencies.append(job.timer.elapsed());
+            if (job.buffer.isDetached()) {
+                BufferPool::getInstance().release(job.buffer);
+            }
+        }
+
+        locker.relock();
+        for (int i = 0; i < batch.count(); ++i) {
+            const File *file = batch.at(i).file;
+            if (!batch.at(i).error.isEmpty() && !m_errors.contains(file)) {
+                m_errors.insert(file, batch.at(i).error);
+            }
+            m_writeCount++;
+            m_totalLatency += latencies.at(i);
+            m_maxLatency = qMax(m_maxLatency, latencies.at(i));
+            if (--m_pendingWrites[file] <= 0) {
+                m_pendingWrites.remove(file);
+            }
+        }
+        m_written.wakeAll();
+
+        if (volume->isFull && volume->jobs.count() <= max_queued_writes / 2) {
+            volume->isFull = false;
+            locker.unlock();
+            emit writable();
+            locker.relock();
+        }
+    }
+}
+
+/*!
+ * \brief Writes the batch with the ring, in one submission.
+ *
+ * The writes that the ring can't do are done with plain writes, so that
+ * all the jobs are written when the method returns. Returns false if the
+ * ring doesn't work and shouldn't be used anymore.
+ */
+bool DiskWriter::writeBatch(IoUring *ring, QList<Job> &batch)
+{
+    QList<qsizetype> writtenSizes(batch.count(), 0);
+    bool isSubmitted = false;
+    for (int i = 0; i < batch.count(); ++i) {
+        const Job &job = batch.at(i);
+        const int fd = job.file->descriptor();
+        if (fd != -1 && ring->prepareWrite(fd, job.buffer.constData(), job.size, job.offset, quint64(i))) {
+            isSubmitted = true;
+        }
+    }
+    bool isWorking = !isSubmitted || ring->submitAndWait() >= 0;
+
+    quint64 index = 0;
+    int result = 0;
+    while (isWorking && ring->takeCompletion(&index, &result)) {
+        if (index >= quint64(batch.count())) {
+            continue;
+        }
+        if (result >= 0) {
+            writtenSizes[int(index)] = result;
+        } else if (result == -EINVAL || result == -EOPNOTSUPP) {
+            isWorking = false; /* E.g. IORING_OP_WRITE needs Linux 5.6 */
+        }
+    }
+    /*
+     * In the order of the queue, so that the files hash their bytes in order.
+     * Not submitted, failed, not completed or short writes: use the plain
+     * writes for the rest.
+     */
+    for (int i = 0; i < batch.count(); ++i) {
+        Job &job = batch[i];
+        const qsizetype size = writtenSizes.at(i);
+        if (size > 0) {
+            job.file->written(job.offset, job.buffer.constData(), size);
+        }
+        if (size < job.size) {
+            job.error = job.file->writeNow(job.offset + size, job.buffer.constData() + size,
+                                           job.size - size);
+        }
+    }
+    return isWorking;
+}
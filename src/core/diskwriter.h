@@ -0,0 +1,108 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_DISK_WRITER_H
+#define CORE_DISK_WRITER_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QString>
+#include <QtCore/QWaitCondition>
+
+class File;
+class IoUring;
+class QThread;
+
+class DiskWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    static DiskWriter& getInstance();
+
+    static int maxQueuedWrites();
+
+    static bool isIoUringSupported();
+    bool isIoUringEnabled() const;
+    void setIoUringEnabled(bool enabled);
+
+    void write(File *file, const QString &volume,
+               qsizetype offset, const QByteArray &buffer, qsizetype size);
+    bool waitForWrites(const File *file);
+    bool isFull(const QString &volume);
+
+    QString errorString(const File *file) const;
+    void clearError(const File *file);
+
+    /* Statistics */
+    int queueDepth() const;
+    int maxQueueDepth() const;
+    qreal averageLatency() const;
+    qint64 maxLatency() const;
+
+signals:
+    void writable();
+
+private:
+    struct Job
+    {
+        File *file{Q_NULLPTR};
+        qsizetype offset{0};
+        QByteArray buffer;
+        qsizetype size{0};
+        QElapsedTimer timer;    ///< Started when the write is queued
+        QString error;          ///< Empty if written
+    };
+
+    struct Volume
+    {
+        QThread *thread{Q_NULLPTR};
+        QQueue<Job> jobs;
+        QWaitCondition wakeUp;
+        bool isFull{false};     ///< True until the queue is drained enough
+    };
+
+    DiskWriter();
+    ~DiskWriter() Q_DECL_OVERRIDE;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_written;
+    QHash<QString, Volume*> m_volumes;
+    QHash<const File*, int> m_pendingWrites;
+    QHash<const File*, QString> m_errors;   ///< First failed write of the file
+    bool m_isQuitting{false};
+    bool m_isIoUringEnabled{false};
+
+    int m_queueDepth{0};
+    int m_maxQueueDepth{0};
+    qint64 m_writeCount{0};
+    qint64 m_totalLatency{0};
+    qint64 m_maxLatency{0};
+
+    Volume* volume(const QString &name);
+    void run(Volume *volume);
+    bool writeBatch(IoUring *ring, QList<Job> &batch);
+
+public:
+    DiskWriter(DiskWriter const&) = delete;
+    void operator=(DiskWriter const&) = delete;
+};
+
+#endif // CORE_DISK_WRITER_H
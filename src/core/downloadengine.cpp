@@ -17,61 +17,344 @@
 #include "downloadengine.h"
 
 #include <Core/AbstractDownloadItem>
+#include <Core/DownloadStreamItem>
+#include <Core/DownloadTorrentItem>
 
 #include <QtCore/QDebug>
+#include <QtCore/QSet>
 #include <QtCore/QtMath>
 
 constexpr int selection_display_limit = 10;
-constexpr int msec_speed_display_time = 2000;
+constexpr int msec_concurrency_sample = 1000;
+constexpr int msec_tick = 150;  ///< Period of the clock that samples the active items
+constexpr int msec_frame = 16;  ///< At most one batch of changes per frame
+constexpr int max_prepared_items = 4;
+
+/* States of the items sampled by the clock */
+static const QList<IDownloadItem::State> s_tickingStates = {
+    IDownloadItem::Preparing,
+    IDownloadItem::Connecting,
+    IDownloadItem::DownloadingMetadata,
+    IDownloadItem::Downloading,
+    IDownloadItem::Endgame,
+    IDownloadItem::Seeding
+};
+
+/* States of the items counted as running, by the scheduler too */
+static const QList<IDownloadItem::State> s_runningStates = {
+    IDownloadItem::Preparing,
+    IDownloadItem::Connecting,
+    IDownloadItem::DownloadingMetadata,
+    IDownloadItem::Downloading,
+    IDownloadItem::Endgame
+};
 
 DownloadEngine::DownloadEngine(QObject *parent) : QObject(parent)
   , m_maxSimultaneousDownloads(4)
+  , m_scheduler(Scheduler::create(Scheduler::Fifo))
   , m_selectionAboutToChange(false)
 {
     connect(this, SIGNAL(jobFinished(IDownloadItem*)),
             this, SLOT(startNext(IDownloadItem*)));
 
-    connect(&m_speedTimer, SIGNAL(timeout()), this, SLOT(onSpeedTimerTimeout()));
+    connect(&m_concurrencyTimer, SIGNAL(timeout()), this, SLOT(onConcurrencyTimerTimeout()));
+    m_concurrency.setRange(1, m_maxSimultaneousDownloads);
+    connect(&m_tickTimer, SIGNAL(timeout()), this, SLOT(onTickTimerTimeout()));
+    m_clock.start();
+
+    m_frameTimer.setSingleShot(true);
+    connect(&m_frameTimer, SIGNAL(timeout()), this, SLOT(flushChanges()));
 }
 
 DownloadEngine::~DownloadEngine()
 {
-    clear();
+    /*
+     * Don't cancel the HTTP items, like clear() does: their partial files
+     * are kept for the next session. The streams and the torrents are
+     * still stopped, so that their process is ended and their torrent is
+     * removed from the TorrentContext before they're deleted.
+     */
+    foreach (auto item, m_items) {
+        auto downloadItem = dynamic_cast<AbstractDownloadItem*>(item);
+        if (downloadItem) {
+            downloadItem->disconnect(this);
+            if (dynamic_cast<DownloadStreamItem*>(downloadItem)
+                    || dynamic_cast<DownloadTorrentItem*>(downloadItem)) {
+                cancel(downloadItem);
+            }
+            delete downloadItem;
+        }
+    }
+    m_items.clear();
 }
 
 /******************************************************************************
  ******************************************************************************/
 /**
- * \fn void DownloadEngine::jobStateChanged(IDownloadItem *item)
- * This signal is emited whenever the download data or its progress or its state has changed
+ * \fn void DownloadEngine::jobsChanged(DownloadChanges changes)
+ * This signal is emited at most once per frame, with the items whose data
+ * or state have changed since the previous batch, and the fields that changed
  */
 
 /******************************************************************************
  ******************************************************************************/
-int DownloadEngine::downloadingCount() const
+/*!
+ * \brief Starts the Idle items chosen by the scheduler, until the maximum
+ * number of simultaneous downloads is reached.
+ *
+ * The Idle items and the running items are taken from the index, so the
+ * queue isn't scanned.
+ */
+void DownloadEngine::startNext(IDownloadItem * /*item*/)
 {
-    int count = 0;
-    foreach (auto item, m_items) {
-        if (item->isDownloading()) {
-            count++;
+    if (m_isStartingNext) {
+        return; /* Called by an item that finished at once: the loop continues */
+    }
+    m_isStartingNext = true;
+    while (runningCount() < simultaneousDownloadsLimit()) {
+        auto item = m_scheduler->next();
+        if (!item) {
+            break; /* None, or their hosts are busy */
+        }
+        item->resume();
+        updateIndex(item);
+        if (item->state() == IDownloadItem::Idle) {
+            break; /* Can't be started */
         }
     }
-    return count;
+    m_isStartingNext = false;
+
+    /* The next items of the scheduler start as soon as the running ones finish */
+    const int count = qMin(runningCount(), max_prepared_items);
+    const auto items = m_scheduler->candidates(count);
+    for (auto item : items) {
+        prepareToStart(item);
+    }
 }
 
-void DownloadEngine::startNext(IDownloadItem * /*item*/)
+/*!
+ * \brief Called for the Idle items that are about to start, to prepare
+ * them (e.g. to open their connection in advance).
+ *
+ * The default implementation does nothing.
+ */
+void DownloadEngine::prepareToStart(IDownloadItem * /*item*/)
 {
-    if (downloadingCount() < m_maxSimultaneousDownloads) {
-        foreach (auto item, m_items) {
-            if (item->state() == IDownloadItem::Idle) {
-                item->resume();
-                startNext(Q_NULLPTR);
-                break;
-            }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Indexes the item appended to the queue.
+ *
+ * The index keeps the items of each state sorted by their rank in the
+ * queue, and is updated each time an item changes.
+ */
+void DownloadEngine::addToIndex(IDownloadItem *item)
+{
+    IndexEntry entry;
+    entry.rank = m_nextRank++;
+    entry.state = item->state();
+    m_index.insert(item, entry);
+    m_itemsByState[entry.state].insert(entry.rank, item);
+    addToScheduler(item, entry.state, entry.rank);
+    startTicking(entry.state);
+}
+
+void DownloadEngine::removeFromIndex(IDownloadItem *item)
+{
+    auto it = m_index.find(item);
+    if (it != m_index.end()) {
+        m_itemsByState[it->state].remove(it->rank);
+        removeFromScheduler(item, it->state);
+        m_index.erase(it);
+    }
+}
+
+void DownloadEngine::updateIndex(IDownloadItem *item)
+{
+    auto it = m_index.find(item);
+    if (it == m_index.end()) {
+        return; /* Not in the queue (yet) */
+    }
+    const IDownloadItem::State state = item->state();
+    if (it->state != state) {
+        sampleBytes(item); /* The bytes received since the last tick, if finished */
+        m_itemsByState[it->state].remove(it->rank);
+        m_itemsByState[state].insert(it->rank, item);
+        removeFromScheduler(item, it->state);
+        addToScheduler(item, state, it->rank);
+        it->state = state;
+        startTicking(state);
+        if (m_isAutoSimultaneous
+                && (state == IDownloadItem::Completed || state == IDownloadItem::NetworkError)) {
+            m_concurrency.addResult(Scheduler::host(item), state == IDownloadItem::NetworkError);
         }
+    } else if (state == IDownloadItem::Idle) {
+        m_scheduler->updateIdle(item, it->rank); /* e.g. its size or its priority */
     }
 }
 
+/*!
+ * \brief Keeps the scheduler informed of the Idle and running items.
+ */
+void DownloadEngine::addToScheduler(IDownloadItem *item, IDownloadItem::State state, qint64 rank)
+{
+    if (state == IDownloadItem::Idle) {
+        m_scheduler->addIdle(item, rank);
+    } else if (s_runningStates.contains(state)) {
+        m_scheduler->addRunning(item);
+    }
+}
+
+void DownloadEngine::removeFromScheduler(IDownloadItem *item, IDownloadItem::State state)
+{
+    if (state == IDownloadItem::Idle) {
+        m_scheduler->removeIdle(item);
+    } else if (s_runningStates.contains(state)) {
+        m_scheduler->removeRunning(item);
+    }
+}
+
+/*!
+ * \brief Starts the clock when an item becomes active.
+ *
+ * It stops by itself, at the first tick without active item.
+ */
+void DownloadEngine::startTicking(IDownloadItem::State state)
+{
+    if (!m_tickTimer.isActive() && s_tickingStates.contains(state)) {
+        m_tickTimer.start(msec_tick);
+    }
+}
+
+/*!
+ * \brief Counts the bytes received by the item since it was last sampled,
+ * for the aggregate rate.
+ */
+void DownloadEngine::sampleBytes(IDownloadItem *item)
+{
+    auto it = m_sampledBytes.find(item);
+    if (it == m_sampledBytes.end()) {
+        return;
+    }
+    const qsizetype bytesReceived = item->bytesReceived();
+    if (bytesReceived > *it) {
+        m_totalBytes += bytesReceived - *it;
+    }
+    *it = bytesReceived; /* Or restarted from the beginning */
+}
+
+/*!
+ * \brief Adds the item to the next batch of changes.
+ *
+ * The fields that changed are found when the batch is sent, by comparing
+ * the item with its last notified values. \a changes are notified anyway.
+ */
+void DownloadEngine::markChanged(IDownloadItem *item, IDownloadItem::Changes changes)
+{
+    auto it = m_pendingChanges.find(item);
+    if (it == m_pendingChanges.end()) {
+        m_pendingChanges.insert(item, changes);
+        m_changedItems.append(item);
+    } else {
+        *it |= changes;
+    }
+    if (!m_frameTimer.isActive()) {
+        m_frameTimer.start(msec_frame);
+    }
+}
+
+DownloadEngine::Snapshot DownloadEngine::snapshot(const IDownloadItem *item)
+{
+    Snapshot snapshot;
+    snapshot.state = item->state();
+    snapshot.bytesReceived = item->bytesReceived();
+    snapshot.bytesTotal = item->bytesTotal();
+    snapshot.speed = item->speed();
+    snapshot.fileName = item->localFileName();
+    return snapshot;
+}
+
+/*!
+ * \brief Sends the pending changes in one batch.
+ *
+ * The items that didn't change aren't notified, so the views only redraw
+ * what changed.
+ */
+void DownloadEngine::flushChanges()
+{
+    m_frameTimer.stop();
+    DownloadChanges changes;
+    changes.reserve(m_changedItems.count());
+    for (auto item : std::as_const(m_changedItems)) {
+        auto it = m_notified.find(item);
+        if (it == m_notified.end()) {
+            continue;
+        }
+        const Snapshot current = snapshot(item);
+        IDownloadItem::Changes itemChanges = m_pendingChanges.value(item);
+        if (current.state != it->state) {
+            itemChanges |= IDownloadItem::StateChange;
+        }
+        if (current.bytesReceived != it->bytesReceived || current.bytesTotal != it->bytesTotal) {
+            itemChanges |= IDownloadItem::ProgressChange;
+        }
+        if (current.speed != it->speed) {
+            itemChanges |= IDownloadItem::SpeedChange;
+        }
+        if (current.fileName != it->fileName) {
+            itemChanges |= IDownloadItem::NameChange;
+        }
+        *it = current;
+        if (itemChanges != IDownloadItem::NoChange) {
+            changes.append({item, itemChanges});
+        }
+    }
+    m_pendingChanges.clear();
+    m_changedItems.clear();
+    if (!changes.isEmpty()) {
+        emit jobsChanged(changes);
+    }
+}
+
+/*!
+ * \brief Ranks the items again, after they're moved in the queue.
+ */
+void DownloadEngine::rebuildIndex()
+{
+    for (auto &items : m_itemsByState) {
+        items.clear();
+    }
+    m_index.clear();
+    m_scheduler->clear();
+    m_nextRank = 0;
+    for (auto item : std::as_const(m_items)) {
+        addToIndex(item);
+    }
+}
+
+QList<IDownloadItem*> DownloadEngine::indexedItems(const QList<IDownloadItem::State> &states) const
+{
+    if (states.count() == 1) {
+        return m_itemsByState[states.first()].values();
+    }
+    QMap<qint64, IDownloadItem*> items;
+    for (auto state : states) {
+        items.insert(m_itemsByState[state]);
+    }
+    return items.values();
+}
+
+int DownloadEngine::indexedCount(const QList<IDownloadItem::State> &states) const
+{
+    int count = 0;
+    for (auto state : states) {
+        count += m_itemsByState[state].count();
+    }
+    return count;
+}
+
 /******************************************************************************
  ******************************************************************************/
 int DownloadEngine::count() const
@@ -101,6 +384,7 @@ void DownloadEngine::append(const QList<IDownloadItem*> &items, bool started)
         }
 
         connect(downloadItem, SIGNAL(changed()), this, SLOT(onChanged()));
+        connect(downloadItem, SIGNAL(otherChanged()), this, SLOT(onOtherChanged()));
         connect(downloadItem, SIGNAL(finished()), this, SLOT(onFinished()));
         connect(downloadItem, SIGNAL(renamed(QString, QString, bool)),
                 this, SLOT(onRenamed(QString, QString, bool)));
@@ -115,6 +399,9 @@ void DownloadEngine::append(const QList<IDownloadItem*> &items, bool started)
             }
         }
         m_items.append(downloadItem);
+        addToIndex(downloadItem);
+        m_notified.insert(downloadItem, snapshot(downloadItem));
+        m_sampledBytes.insert(downloadItem, downloadItem->bytesReceived());
     }
 
     emit jobAppended(items);
@@ -136,22 +423,37 @@ void DownloadEngine::remove(const QList<IDownloadItem*> &items)
     }
     endSelectionChange();
 
+    /* Unindex first, so that the removed items aren't started meanwhile */
+    QSet<IDownloadItem*> removedItems;
+    foreach (auto item, items) {
+        removeFromIndex(item);
+        m_notified.remove(item);
+        m_sampledBytes.remove(item);
+        m_pendingChanges.remove(item);
+        removedItems.insert(item);
+    }
+    m_changedItems.removeIf([&removedItems](IDownloadItem *item) {
+        return removedItems.contains(item);
+    });
+
     /* Then, remove */
     foreach (auto item, items) {
         cancel(item); // stop the reply first
-        m_items.removeAll(item);
         auto downloadItem = dynamic_cast<AbstractDownloadItem*>(item);
         if (downloadItem) {
             downloadItem->deleteLater();
         }
     }
+    m_items.removeIf([&removedItems](IDownloadItem *item) {
+        return removedItems.contains(item);
+    });
     emit jobRemoved(items);
 }
 
 void DownloadEngine::updateItems(const QList<IDownloadItem *> &items)
 {
     foreach (auto item, items) {
-        emit jobStateChanged(item);
+        markChanged(item, IDownloadItem::AllChanges);
     }
 }
 
@@ -170,9 +472,91 @@ int DownloadEngine::maxSimultaneousDownloads() const
     return m_maxSimultaneousDownloads;
 }
 
+/*!
+ * \brief Sets the number of simultaneous downloads, or the maximum that the
+ * automatic mode can reach when it's enabled.
+ */
 void DownloadEngine::setMaxSimultaneousDownloads(int number)
 {
     m_maxSimultaneousDownloads = number;
+    m_concurrency.setRange(1, number); /* Bounds the current limit too */
+}
+
+bool DownloadEngine::isAutoSimultaneousDownloadsEnabled() const
+{
+    return m_isAutoSimultaneous;
+}
+
+/*!
+ * \brief Enables the automatic mode, where a ConcurrencyController adjusts
+ * the number of simultaneous downloads to the network.
+ */
+void DownloadEngine::setAutoSimultaneousDownloadsEnabled(bool enabled)
+{
+    if (m_isAutoSimultaneous == enabled) {
+        return;
+    }
+    m_isAutoSimultaneous = enabled;
+    if (m_isAutoSimultaneous) {
+        m_concurrency.reset(m_concurrency.limit()); /* The last limit found */
+        m_concurrencyTimer.start(msec_concurrency_sample);
+    } else {
+        m_concurrencyTimer.stop();
+    }
+    startNext(Q_NULLPTR);
+}
+
+/*!
+ * \brief Returns the number of simultaneous downloads currently allowed.
+ *
+ * When the limit decreases, the running items aren't paused: they finish,
+ * and no other item is started until the limit is reached again.
+ */
+int DownloadEngine::simultaneousDownloadsLimit() const
+{
+    return m_isAutoSimultaneous ? m_concurrency.limit() : m_maxSimultaneousDownloads;
+}
+
+void DownloadEngine::onConcurrencyTimerTimeout()
+{
+    const bool isSaturated = waitingCount() > 0
+            && runningCount() >= simultaneousDownloadsLimit();
+    if (m_concurrency.addSample(totalSpeed(), isSaturated)) {
+        startNext(Q_NULLPTR);
+    }
+}
+
+Scheduler::Policy DownloadEngine::schedulingPolicy() const
+{
+    return m_scheduler->policy();
+}
+
+/*!
+ * \brief Sets the policy that chooses the next item to start.
+ */
+void DownloadEngine::setSchedulingPolicy(Scheduler::Policy policy)
+{
+    if (m_scheduler->policy() == policy) {
+        return;
+    }
+    const int maxDownloadsPerHost = m_scheduler->maxDownloadsPerHost();
+    m_scheduler.reset(Scheduler::create(policy));
+    m_scheduler->setMaxDownloadsPerHost(maxDownloadsPerHost);
+    rebuildIndex(); /* Indexes the queue in the new scheduler */
+}
+
+int DownloadEngine::maxDownloadsPerHost() const
+{
+    return m_scheduler->maxDownloadsPerHost();
+}
+
+/*!
+ * \brief Sets the maximum number of simultaneous downloads per host, or 0
+ * if unlimited.
+ */
+void DownloadEngine::setMaxDownloadsPerHost(int count)
+{
+    m_scheduler->setMaxDownloadsPerHost(count);
 }
 
 /******************************************************************************
@@ -182,73 +566,115 @@ QList<IDownloadItem *> DownloadEngine::downloadItems() const
     return m_items;
 }
 
-static inline QList<IDownloadItem*> filter(const QList<IDownloadItem*> &items,
-                                           const QList<IDownloadItem::State> &states)
-{
-    QList<IDownloadItem*> list;
-    foreach (auto item, items) {
-        foreach (auto state, states) {
-            if (item->state() == state) {
-                list.append(item);
-            }
-        }
-    }
-    return list;
-}
+static const QList<IDownloadItem::State> s_waitingStates = {
+    IDownloadItem::Idle
+};
+
+static const QList<IDownloadItem::State> s_completedStates = {
+    IDownloadItem::Completed,
+    IDownloadItem::Seeding
+};
+
+static const QList<IDownloadItem::State> s_pausedStates = {
+    IDownloadItem::Paused
+};
+
+static const QList<IDownloadItem::State> s_failedStates = {
+    IDownloadItem::Stopped,
+    IDownloadItem::Skipped,
+    IDownloadItem::NetworkError,
+    IDownloadItem::FileError
+};
 
 QList<IDownloadItem*> DownloadEngine::waitingJobs() const
 {
-    return filter(m_items, {IDownloadItem::Idle});
+    return indexedItems(s_waitingStates);
 }
 
 QList<IDownloadItem*> DownloadEngine::completedJobs() const
 {
-    return filter(m_items, {IDownloadItem::Completed,
-                            IDownloadItem::Seeding});
+    return indexedItems(s_completedStates);
 }
 
 QList<IDownloadItem*> DownloadEngine::pausedJobs() const
 {
-    return filter(m_items, {IDownloadItem::Paused});
+    return indexedItems(s_pausedStates);
 }
 
 QList<IDownloadItem*> DownloadEngine::failedJobs() const
 {
-    return filter(m_items, {IDownloadItem::Stopped,
-                            IDownloadItem::Skipped,
-                            IDownloadItem::NetworkError,
-                            IDownloadItem::FileError});
+    return indexedItems(s_failedStates);
 }
 
 QList<IDownloadItem*> DownloadEngine::runningJobs() const
 {
-    return filter(m_items, {IDownloadItem::Preparing,
-                            IDownloadItem::Connecting,
-                            IDownloadItem::DownloadingMetadata,
-                            IDownloadItem::Downloading,
-                            IDownloadItem::Endgame});
+    return indexedItems(s_runningStates);
 }
 
-/******************************************************************************
- ******************************************************************************/
-void DownloadEngine::onSpeedTimerTimeout()
+int DownloadEngine::waitingCount() const
 {
-    m_speedTimer.stop();
-    m_previouSpeed = 0;
-    emit onChanged();
+    return indexedCount(s_waitingStates);
 }
 
-qreal DownloadEngine::totalSpeed()
+int DownloadEngine::completedCount() const
 {
-    qreal speed = 0;
-    foreach (auto item, m_items) {
-        speed += qMax(item->speed(), qreal(0));
+    return indexedCount(s_completedStates);
+}
+
+int DownloadEngine::pausedCount() const
+{
+    return indexedCount(s_pausedStates);
+}
+
+int DownloadEngine::failedCount() const
+{
+    return indexedCount(s_failedStates);
+}
+
+int DownloadEngine::runningCount() const
+{
+    return indexedCount(s_runningStates);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Samples all the active items, and notifies them in one batch.
+ *
+ * One clock for all the items, and one signal per tick, whatever the
+ * number of active items.
+ */
+void DownloadEngine::onTickTimerTimeout()
+{
+    const auto items = indexedItems(s_tickingStates);
+    if (items.isEmpty()) {
+        m_tickTimer.stop();
+        m_totalRate.reset();
+        emit jobsChanged(DownloadChanges()); // only the total speed changed
+        return;
     }
-    if (speed > 0) {
-        m_previouSpeed = speed;
-        m_speedTimer.start(msec_speed_display_time);
+    for (auto item : items) {
+        auto downloadItem = dynamic_cast<AbstractDownloadItem*>(item);
+        if (downloadItem) {
+            downloadItem->updateInfo();
+        }
+        sampleBytes(item);
+        markChanged(item);
     }
-    return m_previouSpeed;
+    m_totalRate.addSample(m_clock.elapsed(), m_totalBytes);
+    flushChanges();
+}
+
+/*!
+ * \brief Returns the aggregate rate of all the items, in bytes per second.
+ *
+ * It's estimated from the bytes received by all the items, including
+ * the ones that finished since the last tick, rather than the sum of the
+ * speeds of the items.
+ */
+qreal DownloadEngine::totalSpeed() const
+{
+    return qMax(m_totalRate.rate(), qreal(0));
 }
 
 /******************************************************************************
@@ -280,7 +706,24 @@ void DownloadEngine::cancel(IDownloadItem *item)
 void DownloadEngine::onChanged()
 {
     auto downloadItem = qobject_cast<AbstractDownloadItem *>(sender());
-    emit jobStateChanged(downloadItem);
+    if (!downloadItem || !m_notified.contains(downloadItem)) {
+        return; /* Not in the queue (yet) */
+    }
+    updateIndex(downloadItem);
+    markChanged(downloadItem); /* What changed is found by comparison */
+}
+
+/*!
+ * \brief Notifies a change of the fields that markChanged() doesn't compare.
+ */
+void DownloadEngine::onOtherChanged()
+{
+    auto downloadItem = qobject_cast<AbstractDownloadItem *>(sender());
+    if (!downloadItem || !m_notified.contains(downloadItem)) {
+        return;
+    }
+    updateIndex(downloadItem); /* e.g. the priority, for the scheduler */
+    markChanged(downloadItem, IDownloadItem::OtherChange);
 }
 
 void DownloadEngine::onFinished()
@@ -291,6 +734,10 @@ void DownloadEngine::onFinished()
 
 void DownloadEngine::onRenamed(const QString &oldName, const QString &newName, bool success)
 {
+    auto downloadItem = qobject_cast<AbstractDownloadItem *>(sender());
+    if (downloadItem && m_notified.contains(downloadItem)) {
+        markChanged(downloadItem); /* The file name */
+    }
     emit jobRenamed(oldName, newName, success);
 }
 
@@ -398,6 +845,7 @@ void DownloadEngine::moveUpTo(int targetIndex)
 #endif
         }
     }
+    rebuildIndex();
     emit sortChanged();
 }
 
@@ -415,6 +863,7 @@ void DownloadEngine::moveDownTo(int targetIndex)
 #endif
         }
     }
+    rebuildIndex();
     emit sortChanged();
 }
 
@@ -479,6 +928,28 @@ void DownloadEngine::oneFewerSegment()
     }
 }
 
+/******************************************************************************
+ ******************************************************************************/
+void DownloadEngine::raisePriority()
+{
+    foreach (auto item, selection()) {
+        auto downloadItem = dynamic_cast<AbstractDownloadItem*>(item);
+        if (downloadItem && downloadItem->priority() < IDownloadItem::HighPriority) {
+            downloadItem->setPriority(static_cast<IDownloadItem::Priority>(downloadItem->priority() + 1));
+        }
+    }
+}
+
+void DownloadEngine::lowerPriority()
+{
+    foreach (auto item, selection()) {
+        auto downloadItem = dynamic_cast<AbstractDownloadItem*>(item);
+        if (downloadItem && downloadItem->priority() > IDownloadItem::LowPriority) {
+            downloadItem->setPriority(static_cast<IDownloadItem::Priority>(downloadItem->priority() - 1));
+        }
+    }
+}
+
 /******************************************************************************
  ******************************************************************************/
 /*!
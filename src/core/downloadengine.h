@@ -17,10 +17,17 @@
 #ifndef CORE_DOWNLOAD_ENGINE_H
 #define CORE_DOWNLOAD_ENGINE_H
 
+#include <Core/ConcurrencyController>
 #include <Core/IDownloadItem>
+#include <Core/RateEstimator>
+#include <Core/Scheduler>
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QObject>
+#include <QtCore/QHash>
 #include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QScopedPointer>
 #include <QtCore/QString>
 #include <QtCore/QTimer>
 
@@ -47,6 +54,16 @@ public:
     int maxSimultaneousDownloads() const;
     void setMaxSimultaneousDownloads(int number);
 
+    bool isAutoSimultaneousDownloadsEnabled() const;
+    void setAutoSimultaneousDownloadsEnabled(bool enabled);
+    int simultaneousDownloadsLimit() const;
+
+    Scheduler::Policy schedulingPolicy() const;
+    void setSchedulingPolicy(Scheduler::Policy policy);
+
+    int maxDownloadsPerHost() const;
+    void setMaxDownloadsPerHost(int count);
+
     /* Statistics */
     QList<IDownloadItem *> downloadItems() const;
     QList<IDownloadItem *> waitingJobs() const;
@@ -55,7 +72,13 @@ public:
     QList<IDownloadItem *> failedJobs() const;
     QList<IDownloadItem *> runningJobs() const;
 
-    qreal totalSpeed();
+    int waitingCount() const;
+    int completedCount() const;
+    int pausedCount() const;
+    int failedCount() const;
+    int runningCount() const;
+
+    qreal totalSpeed() const;
 
     /* Actions */
     void resume(IDownloadItem *item);
@@ -85,6 +108,10 @@ public:
     void oneMoreSegment();
     void oneFewerSegment();
 
+    /* Priority */
+    void raisePriority();
+    void lowerPriority();
+
     /* Utility */
     virtual IDownloadItem* createItem(const QUrl &url);
     virtual IDownloadItem* createTorrentItem(const QUrl &url);
@@ -92,33 +119,85 @@ public:
 signals:
     void jobAppended(DownloadRange range);
     void jobRemoved(DownloadRange range);
-    void jobStateChanged(IDownloadItem *item);
+    void jobsChanged(DownloadChanges changes);
     void jobFinished(IDownloadItem *item);
     void jobRenamed(QString oldName, QString newName, bool success);
 
     void selectionChanged();
     void sortChanged();
 
+protected:
+    virtual void prepareToStart(IDownloadItem *item);
+
 public slots:
 
 private slots:
     void onChanged();
+    void onOtherChanged();
     void onFinished();
     void onRenamed(const QString &oldName, const QString &newName, bool success);
     void startNext(IDownloadItem *item);
 
 private slots:
-    void onSpeedTimerTimeout();
+    void onConcurrencyTimerTimeout();
+    void onTickTimerTimeout();
+    void flushChanges();
 
 private:
     QList<IDownloadItem *> m_items;
 
-    qreal m_previouSpeed = 0;
-    QTimer m_speedTimer;
+    QTimer m_tickTimer;
+    QElapsedTimer m_clock;
+
+    // Aggregate rate of all the items
+    RateEstimator m_totalRate;
+    qint64 m_totalBytes = 0;
+    QHash<IDownloadItem *, qsizetype> m_sampledBytes;
+
+    // Changes, notified in batch at most once per frame
+    struct Snapshot
+    {
+        IDownloadItem::State state{IDownloadItem::Idle};
+        qsizetype bytesReceived{0};
+        qsizetype bytesTotal{0};
+        qreal speed{0};
+        QString fileName;
+    };
+    QHash<IDownloadItem *, Snapshot> m_notified;
+    QHash<IDownloadItem *, IDownloadItem::Changes> m_pendingChanges;
+    QList<IDownloadItem *> m_changedItems;
+    QTimer m_frameTimer;
 
     // Pool
     int m_maxSimultaneousDownloads;
-    int downloadingCount() const;
+    bool m_isStartingNext = false;
+    bool m_isAutoSimultaneous = false;
+    ConcurrencyController m_concurrency;
+    QTimer m_concurrencyTimer;
+    QScopedPointer<Scheduler> m_scheduler;
+
+    // Index of the items by state, in the order of the queue
+    struct IndexEntry
+    {
+        qint64 rank{0};
+        IDownloadItem::State state{IDownloadItem::Idle};
+    };
+    QHash<IDownloadItem *, IndexEntry> m_index;
+    QMap<qint64, IDownloadItem *> m_itemsByState[IDownloadItem::FileError + 1];
+    qint64 m_nextRank = 0;
+
+    void addToIndex(IDownloadItem *item);
+    void removeFromIndex(IDownloadItem *item);
+    void updateIndex(IDownloadItem *item);
+    void addToScheduler(IDownloadItem *item, IDownloadItem::State state, qint64 rank);
+    void removeFromScheduler(IDownloadItem *item, IDownloadItem::State state);
+    void startTicking(IDownloadItem::State state);
+    void sampleBytes(IDownloadItem *item);
+    void markChanged(IDownloadItem *item, IDownloadItem::Changes changes = IDownloadItem::NoChange);
+    static Snapshot snapshot(const IDownloadItem *item);
+    void rebuildIndex();
+    QList<IDownloadItem *> indexedItems(const QList<IDownloadItem::State> &states) const;
+    int indexedCount(const QList<IDownloadItem::State> &states) const;
 
     QList<IDownloadItem *> m_selectedItems;
     bool m_selectionAboutToChange;
@@ -18,19 +18,97 @@
 
 #include <Core/DownloadManager>
 #include <Core/File>
+#include <Core/HttpTransfer>
 #include <Core/NetworkManager>
 #include <Core/ResourceItem>
+#include <Core/Session>
 #include <Core/Settings>
 
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QDir>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
 #include <QtNetwork/QNetworkReply>
 
+/* A retry succeeded once the download really progressed again */
+constexpr qsizetype min_retry_progress = 1024 * 1024;
+constexpr qint64 msec_min_retry_running = 30000;
+
 DownloadItemPrivate::DownloadItemPrivate(DownloadItem *qq)
     : q(qq)
 {
-    file = new File(qq);
+}
+
+/*!
+ * \brief Creates the file on demand: the jobs read from the session don't
+ * need it until they're resumed.
+ */
+File* DownloadItemPrivate::ensureFile()
+{
+    if (!file) {
+        file = new File(q);
+        QObject::connect(file, SIGNAL(moved(bool)), q, SLOT(onFileMoved(bool)));
+        QObject::connect(file, SIGNAL(verified(bool)), q, SLOT(onFileVerified(bool)));
+    }
+    return file;
+}
+
+/*!
+ * \brief Decodes the job read from the session, if not done yet.
+ */
+void DownloadItemPrivate::load()
+{
+    if (record.isEmpty()) {
+        return;
+    }
+    const QByteArray job = record;
+    record.clear();
+    recordSummary = {};
+    Session::load(q, job);
+}
+
+/*!
+ * \brief Schedules a retry. The timer is created on demand: most of the
+ * items of a big queue never fail.
+ */
+void DownloadItemPrivate::startRetryTimer(int msecs)
+{
+    if (!retryTimer) {
+        retryTimer = new QTimer(q);
+        retryTimer->setSingleShot(true);
+        QObject::connect(retryTimer, SIGNAL(timeout()), q, SLOT(onRetryTimeout()));
+    }
+    retryTimer->start(msecs);
+}
+
+void DownloadItemPrivate::stopRetryTimer()
+{
+    if (retryTimer) {
+        retryTimer->stop();
+    }
+}
+
+/*!
+ * \brief Aborts the transfer, and keeps its segments to resume it later.
+ *
+ * The transfer runs in a transfer thread: wait until it has stopped
+ * writing to the file, before the file is closed or removed.
+ */
+void DownloadItemPrivate::releaseTransfer()
+{
+    if (!transfer) {
+        return;
+    }
+    QThread *thread = transfer->thread();
+    if (thread == QThread::currentThread() || !thread->isRunning()) {
+        transfer->abort();
+    } else {
+        QMetaObject::invokeMethod(transfer, "abort", Qt::BlockingQueuedConnection);
+    }
+    segments = transfer->segments();
+    transfer->deleteLater();
+    transfer = Q_NULLPTR;
 }
 
 /******************************************************************************
@@ -43,27 +121,40 @@ DownloadItem::DownloadItem(DownloadManager *downloadManager) : AbstractDownloadI
 
 DownloadItem::~DownloadItem()
 {
+    d->releaseTransfer();
+
     if (d->file) {
         d->file->deleteLater();
         d->file = Q_NULLPTR;
     }
-
-    if (d->reply) {
-        d->reply->abort();
-        d->reply->deleteLater();
-        d->reply = Q_NULLPTR;
-    }
 }
 
 /******************************************************************************
  ******************************************************************************/
 void DownloadItem::resume()
 {
-    logInfo(QString("Resume '%0' (destination: '%1').").arg(d->resource->url(), localFullFileName()));
+    logInfo("Resume '%0' (destination: '%1').", {resource()->url(), localFullFileName()});
 
     this->beginResume();
 
-    File::OpenFlag flag = d->file->open(d->resource);
+    d->releaseTransfer();
+
+    /* A manual resume gets all its retries back */
+    d->stopRetryTimer();
+    if (!d->isRetrying) {
+        d->retryAttempts = 0;
+    }
+    d->retryClock.start();
+    d->isRetrying = false;
+    d->isPartialKept = false;
+
+    /* Continue where it stopped, if paused, or after a network error */
+    const bool resuming = !d->segments.isEmpty() && bytesReceived() > 0;
+    if (!resuming) {
+        setBytesTotal(0); /* The probed size, if any, is confirmed by the transfer */
+    }
+
+    File::OpenFlag flag = file()->open(resource(), resuming);
 
     if (flag == File::Skip) {
         setState(Skipped);
@@ -74,58 +165,113 @@ void DownloadItem::resume()
 
     const bool connected = flag == File::Open;
 
-    /* Prepare the connection, try to contact the server */
-    if (this->checkResume(connected)) {
+    if (connected && resuming && file()->size() < writtenSize()) {
+        logWarning("Partial file '%0' is missing or truncated, restart from the beginning.",
+                   {file()->partialFileName()});
+        file()->truncate(0);
+        d->segments.clear();
+    }
 
-        QUrl url(d->resource->url());
-        d->reply = d->downloadManager->networkManager()->get(url);
-        d->reply->setParent(this);
+    if (connected) {
+        /* The bytes already downloaded are hashed again, in the background */
+        const qsizetype existingSize = resuming ? Segment::contiguousSize(d->segments) : 0;
+        if (!file()->setCheckSum(resource()->checkSum(), existingSize)) {
+            logWarning("Unknown checksum '%0', the file won't be verified.",
+                       {resource()->checkSum()});
+        }
+    }
 
-        /* Signals/Slots of QNetworkReply */
-        connect(d->reply, SIGNAL(metaDataChanged()), this, SLOT(onMetaDataChanged()));
-        connect(d->reply, SIGNAL(downloadProgress(qint64, qint64)),
-                this, SLOT(onDownloadProgress(qint64, qint64)));
-        connect(d->reply, SIGNAL(redirected(QUrl)), this, SLOT(onRedirected(QUrl)));
-        connect(d->reply, SIGNAL(errorOccurred(QNetworkReply::NetworkError)),
-                this, SLOT(onErrorOccurred(QNetworkReply::NetworkError)));
-        connect(d->reply, SIGNAL(finished()), this, SLOT(onFinished()));
+    /* Prepare the connection, try to contact the server */
+    if (this->checkResume(connected)) {
 
-        /* Signals/Slots of QIODevice */
-        connect(d->reply, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
-        connect(d->reply, SIGNAL(aboutToClose()), this, SLOT(onAboutToClose()));
+        startTransfer();
 
         this->tearDownResume();
     }
 }
 
+/*!
+ * \brief Starts the transfer of the remaining segments into the open file.
+ */
+void DownloadItem::startTransfer()
+{
+    NetworkManager *networkManager = d->downloadManager->networkManager();
+    d->transfer = new HttpTransfer(networkManager);
+    d->transfer->setUrl(resource()->distantFileUrl());
+    d->transfer->setFile(file());
+    d->transfer->setMaxSegments(maxConnectionSegments());
+    d->transfer->setSegments(d->segments);
+    d->transfer->setValidator(validator());
+    auto settings = d->downloadManager->settings();
+    if (settings) {
+        d->transfer->setPreallocationEnabled(settings->isFilePreallocationEnabled());
+        d->transfer->setDiskSpaceCheckEnabled(settings->isDiskSpaceCheckEnabled());
+    }
+    d->transfer->moveToThread(networkManager->transferThread(resource()->host()));
+
+    /* Signals/Slots of HttpTransfer */
+    connect(d->transfer, SIGNAL(metaDataChanged(QDateTime)), this, SLOT(onMetaDataChanged(QDateTime)));
+    connect(d->transfer, SIGNAL(validatorsChanged(QString, QString)),
+            this, SLOT(onValidatorsChanged(QString, QString)));
+    connect(d->transfer, SIGNAL(downloadProgress(qint64, qint64)),
+            this, SLOT(onDownloadProgress(qint64, qint64)));
+    connect(d->transfer, SIGNAL(segmentsChanged(QList<Segment>)),
+            this, SLOT(onSegmentsChanged(QList<Segment>)));
+    connect(d->transfer, SIGNAL(redirected(QUrl)), this, SLOT(onRedirected(QUrl)));
+    connect(d->transfer, SIGNAL(errorOccurred(QNetworkReply::NetworkError, QString)),
+            this, SLOT(onErrorOccurred(QNetworkReply::NetworkError, QString)));
+    connect(d->transfer, SIGNAL(fileErrorOccurred(QString)), this, SLOT(onFileErrorOccurred(QString)));
+    connect(d->transfer, SIGNAL(infoLogged(QString)), this, SLOT(onInfoLogged(QString)));
+    connect(d->transfer, SIGNAL(finished()), this, SLOT(onTransferFinished()));
+
+    QMetaObject::invokeMethod(d->transfer, "start", Qt::QueuedConnection);
+}
+
 void DownloadItem::pause()
 {
-    /// \todo implement?
-    logInfo(QString("Pause '%0'.").arg(d->resource->url()));
-    AbstractDownloadItem::pause();
+    logInfo("Pause '%0'.", {resource()->url()});
+    d->stopRetryTimer();
+    d->isRetrying = false;
+    d->releaseTransfer();
+    /* Keep the partial file, to resume later */
+    file()->close();
+    AbstractDownloadItem::suspend();
 }
 
 void DownloadItem::stop()
 {
-    logInfo(QString("Stop '%0'.").arg(d->resource->url()));
-    d->file->cancel();
-    if (d->reply) {
-        d->reply->abort();
-        d->reply->deleteLater();
-        d->reply = Q_NULLPTR;
-    }
+    logInfo("Stop '%0'.", {resource()->url()});
+    d->stopRetryTimer();
+    d->retryAttempts = 0;
+    d->isRetrying = false;
+    d->isPartialKept = false;
+    d->releaseTransfer();
+    d->segments.clear();
+    file()->cancel();
     AbstractDownloadItem::stop();
 }
 
+/*!
+ * \brief Returns true if the item can be canceled.
+ *
+ * A download that failed with a transient error keeps its partial file,
+ * so it can be canceled to remove it.
+ */
+bool DownloadItem::isCancelable() const
+{
+    return AbstractDownloadItem::isCancelable()
+            || (state() == NetworkError && d->isPartialKept);
+}
+
 /******************************************************************************
  ******************************************************************************/
 void DownloadItem::rename(const QString &newName)
 {
     QString newCustomFileName = newName.trimmed().isEmpty() ? QString() : newName;
-    const QString oldPath = d->resource->localFileFullPath(d->resource->customFileName());
-    const QString newPath = d->resource->localFileFullPath(newCustomFileName);
+    const QString oldPath = resource()->localFileFullPath(resource()->customFileName());
+    const QString newPath = resource()->localFileFullPath(newCustomFileName);
 
-    const QString oldFileName = d->resource->fileName();
+    const QString oldFileName = resource()->fileName();
 
     if (oldPath == newPath) {
         return;
@@ -138,56 +284,73 @@ void DownloadItem::rename(const QString &newName)
         success = false; /* File error */
     }
     if (success) {
-        d->resource->setCustomFileName(newCustomFileName);
-        if (d->file->isOpen()) {
-            d->file->rename(d->resource);
+        resource()->setCustomFileName(newCustomFileName);
+        if (file()->isOpen() && !file()->rename(resource())) {
+            /* Another file system: stop writing while the file is moved */
+            logInfo("Move partial file '%0' to '%1'.", {file()->partialFileName(), newPath});
+            d->releaseTransfer();
+            file()->move(resource());
         }
     }
-    const QString newFileName = success ? d->resource->fileName() : newName;
+    const QString newFileName = success ? resource()->fileName() : newName;
     emit renamed(oldFileName, newFileName, success);
 }
 
 /******************************************************************************
  ******************************************************************************/
-void DownloadItem::onMetaDataChanged()
-{
-    if (d->reply) {
-        auto rawNewUrl = d->reply->header(QNetworkRequest::LocationHeader);
-        if (rawNewUrl.isValid()) {
-            const QUrl oldUrl = d->resource->url();
-            const QUrl newUrl = rawNewUrl.toUrl();
-            /* Check if the metadata change is a redirection */
-            if (newUrl.isValid() && oldUrl.isValid() && oldUrl != newUrl) {
-                logInfo(QString("HTTP redirect: '%0' to '%1'.").arg(oldUrl.toString(), newUrl.toString()));
-            }
+void DownloadItem::onMetaDataChanged(const QDateTime &lastModified)
+{
+    if (sender() != d->transfer) {
+        return; /* Queued before the transfer was released */
+    }
+    auto settings = d->downloadManager->settings();
+    if (settings && lastModified.isValid()) {
+        if (settings->isRemoteCreationTimeEnabled()) {
+            file()->setCreationFileTime(lastModified);
         }
-        auto settings = d->downloadManager->settings();
-        auto rawTime = d->reply->header(QNetworkRequest::LastModifiedHeader);
-        if (settings && rawTime.isValid()) {
-            auto time = rawTime.toDateTime();
-            if (settings->isRemoteCreationTimeEnabled()) {
-                d->file->setCreationFileTime(time);
-            }
-            if (settings->isRemoteLastModifiedTimeEnabled()) {
-                d->file->setLastModifiedFileTime(time);
-            }
-            if (settings->isRemoteAccessTimeEnabled()) {
-                d->file->setAccessFileTime(time);
-            }
-            if (settings->isRemoteMetadataChangeTimeEnabled()) {
-                d->file->setMetadataChangeFileTime(time);
-            }
+        if (settings->isRemoteLastModifiedTimeEnabled()) {
+            file()->setLastModifiedFileTime(lastModified);
+        }
+        if (settings->isRemoteAccessTimeEnabled()) {
+            file()->setAccessFileTime(lastModified);
         }
+        if (settings->isRemoteMetadataChangeTimeEnabled()) {
+            file()->setMetadataChangeFileTime(lastModified);
+        }
+    }
+}
+
+void DownloadItem::onValidatorsChanged(const QString &eTag, const QString &lastModified)
+{
+    if (sender() != d->transfer) {
+        return;
     }
+    resource()->setETag(eTag);
+    resource()->setLastModified(lastModified);
+}
+
+void DownloadItem::onInfoLogged(const QString &message)
+{
+    logInfo("%0", {message});
 }
 
 void DownloadItem::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
-    if (d->reply && bytesReceived > 0 && bytesTotal > 0) {
-        logInfo(QString("Downloaded '%0' (%1 of %2 bytes).")
-                .arg(d->reply->url().toString(),
-                     QString::number(bytesReceived),
-                     QString::number(bytesTotal)));
+    if (sender() != d->transfer) {
+        return;
+    }
+    /*
+     * Not at the first bytes: a server that drops the connection after each
+     * chunk would get infinite retries.
+     */
+    if (d->retryAttempts > 0 && bytesReceived > d->retryOffset
+            && (bytesReceived - d->retryOffset >= min_retry_progress
+                || d->retryClock.elapsed() >= msec_min_retry_running)) {
+        d->retryAttempts = 0; /* The retry succeeded */
+    }
+    if (d->transfer && bytesReceived > 0 && bytesTotal > 0 && EventLog::isEnabled(EventLog::Debug)) {
+        logDebug("Downloaded '%0' (%1 of %2 bytes).",
+                 {resource()->url(), QString::number(bytesReceived), QString::number(bytesTotal)});
     }
     updateInfo(static_cast<qsizetype>(bytesReceived),
                static_cast<qsizetype>(bytesTotal));
@@ -195,15 +358,34 @@ void DownloadItem::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 
 void DownloadItem::onRedirected(const QUrl &url)
 {
-    if (d->reply) {
-        logInfo(QString("HTTP redirect: redirected '%0' to '%1'.")
-                .arg(d->reply->url().toString(), url.toString()));
+    logInfo("HTTP redirect: redirected '%0' to '%1'.", {resource()->url(), url.toString()});
+}
+
+void DownloadItem::onSegmentsChanged(const QList<Segment> &segments)
+{
+    if (sender() != d->transfer) {
+        return;
     }
+    d->segments = segments;
+}
+
+void DownloadItem::onTransferFinished()
+{
+    if (sender() != d->transfer) {
+        return;
+    }
+    if (state() == Downloading && bytesTotal() > 0 && file()->hasCheckSum()) {
+        logInfo("Verify checksum of '%0'.", {localFullFileName()});
+        setState(Endgame);
+        file()->verify();
+        return;
+    }
+    onFinished();
 }
 
 void DownloadItem::onFinished()
 {
-    logInfo(QString("Finished (%0) '%1'.").arg(state_c_str(), localFullFileName()));
+    logInfo("Finished (%0) '%1'.", {state_c_str(), localFullFileName()});
     switch (state()) {
     case Idle:
     case Preparing:
@@ -224,30 +406,54 @@ void DownloadItem::onFinished()
             setState(NetworkError);
             setBytesReceived(0);
             // setBytesTotal(0);
-            d->file->cancel();
+            file()->cancel();
             emit changed();
         } else {
             /* Here, finish the operation if downloading. */
             /* If network error or file error, just ignore */
-            bool commited = d->file->commit();
+            bool commited = file()->commit();
+            if (!commited && !file()->errorString().isEmpty()) {
+                logError("File error '%0': '%1'.", {localFullFileName(), file()->errorString()});
+                setErrorMessage(file()->errorString());
+            }
             preFinish(commited);
         }
         break;
 
     case Paused:
+        /* Keep the partial file */
+        file()->close();
+        emit changed();
+        break;
+
+    case NetworkError:
+        if (d->isPartialKept) {
+            /* Keep the partial file, to continue where it failed */
+            file()->close();
+            emit changed();
+            break;
+        }
+        setBytesReceived(0);
+        setBytesTotal(0);
+        file()->cancel();
+        emit changed();
+        break;
+
     case Stopped:
     case Skipped:
-    case NetworkError:
     case FileError:
         setBytesReceived(0);
         setBytesTotal(0);
-        d->file->cancel();
+        file()->cancel();
         emit changed();
         break;
     }
-    if (d->reply) {
-        d->reply->deleteLater();
-        d->reply = Q_NULLPTR;
+    if (d->transfer) {
+        d->transfer->deleteLater();
+        d->transfer = Q_NULLPTR;
+    }
+    if (state() != Paused && !(state() == NetworkError && d->isPartialKept)) {
+        d->segments.clear();
     }
     this->finish();
 }
@@ -313,49 +519,284 @@ QString DownloadItem::statusToHttp(QNetworkReply::NetworkError error)
     Q_UNREACHABLE();
 }
 
-void DownloadItem::onErrorOccurred(QNetworkReply::NetworkError error)
+void DownloadItem::onErrorOccurred(QNetworkReply::NetworkError error, const QString &errorString)
 {
-    /// \todo Use instead: auto reply = qobject_cast<QNetworkReply*>(sender());
-    if (d->reply) {
-        logInfo(QString("Error '%0': '%1'.").arg(d->reply->url().toString(),d->reply->errorString()));
+    if (sender() != d->transfer) {
+        return;
     }
-    d->file->cancel();
+    logError("Error '%0': '%1'.", {resource()->url(), errorString});
     auto httpError = statusToHttp(error);
     setErrorMessage(httpError);
+
+    /* After a transient error, the download continues where it failed */
+    d->isPartialKept = RetryPolicy::isTransient(error)
+            && !d->segments.isEmpty() && bytesReceived() > 0;
+    if (!d->isPartialKept) {
+        file()->cancel();
+    }
+
+    const RetryPolicy policy = retryPolicy();
+    if (policy.shouldRetry(error, d->retryAttempts)) {
+        const qint64 delay = policy.delay(d->retryAttempts);
+        d->retryAttempts++;
+        d->retryOffset = bytesReceived();
+        logWarning("Retry %0 of %1 for '%2' in %3 msec.",
+                   {QString::number(d->retryAttempts), QString::number(policy.maxAttempts()),
+                    resource()->url(), QString::number(delay)});
+        d->startRetryTimer(static_cast<int>(delay));
+    }
     setState(NetworkError);
 }
 
-void DownloadItem::onReadyRead()
+void DownloadItem::onFileErrorOccurred(const QString &errorString)
 {
-    if (!d->reply || !d->file) {
+    if (sender() != d->transfer) {
+        return;
+    }
+    logError("File error '%0': '%1'.", {localFullFileName(), errorString});
+    file()->cancel();
+    setErrorMessage(errorString);
+    setState(FileError);
+}
+
+/*!
+ * \brief Restarts the transfer, once the partial file is moved to the new destination.
+ */
+void DownloadItem::onFileMoved(bool success)
+{
+    if (!success) {
+        logWarning("Couldn't move partial file to '%0'.", {localFullFileName()});
+    }
+    if (!isDownloading()) {
+        file()->close();
+        return;
+    }
+    if (!success) {
+        file()->cancel();
+        setErrorMessage(tr("Couldn't move the partial file"));
+        setState(FileError);
+        onFinished();
         return;
     }
-    QByteArray data = d->reply->readAll();
-    d->file->write(data);
+    startTransfer();
+}
+
+/*!
+ * \brief Completes the item, once the checksum of the file is verified.
+ */
+void DownloadItem::onFileVerified(bool success)
+{
+    if (state() != Endgame) {
+        return; /* Paused or stopped meanwhile */
+    }
+    if (!success) {
+        logError("Checksum mismatch '%0'.", {localFullFileName()});
+        setErrorMessage(tr("Checksum mismatch"));
+        setState(FileError);
+    }
+    onFinished();
 }
 
 void DownloadItem::onAboutToClose()
 {
-    logInfo(QString("Finished (%0) '%1'.").arg(state_c_str(), localFullFileName()));
+    logInfo("Finished (%0) '%1'.", {state_c_str(), localFullFileName()});
+}
+
+/*!
+ * \brief Queues the failed download again, once the retry delay is over.
+ *
+ * The download waits for a free slot like any queued download, and
+ * continues from the segments saved when it failed.
+ */
+void DownloadItem::onRetryTimeout()
+{
+    if (state() != NetworkError) {
+        return;
+    }
+    d->isRetrying = true;
+    d->downloadManager->resume(this);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the byte ranges downloaded so far.
+ */
+QList<Segment> DownloadItem::segments() const
+{
+    d->load();
+    return d->segments;
+}
+
+void DownloadItem::setSegments(const QList<Segment> &segments)
+{
+    d->load();
+    d->segments = segments;
+}
+
+QString DownloadItem::partialFileName() const
+{
+    d->load();
+    return file()->partialFileName();
+}
+
+void DownloadItem::setPartialFileName(const QString &partialFileName)
+{
+    d->load();
+    file()->setPartialFileName(partialFileName);
+}
+
+/*!
+ * \brief Returns the partial file, to wait for its queued writes with
+ * DiskWriter::waitForWrites(), so that segments() matches the bytes on disk.
+ */
+const File* DownloadItem::partialFile() const
+{
+    return d->file;
+}
+
+/*!
+ * \brief Returns true if the download failed and will be tried again.
+ */
+bool DownloadItem::isRetryPending() const
+{
+    return state() == NetworkError && d->retryTimer && d->retryTimer->isActive();
 }
 
 /******************************************************************************
  ******************************************************************************/
+/*!
+ * \brief Returns true if the metadata of the remote file can be requested
+ * before the download starts.
+ *
+ * A job read from the session answers from its record, without being decoded.
+ */
+bool DownloadItem::isProbeable() const
+{
+    if ((state() != Idle && state() != Paused) || bytesReceived() > 0) {
+        return false;
+    }
+    if (!isLoaded()) {
+        return d->recordSummary.isRegular && !d->recordSummary.isProbed;
+    }
+    return resource()->type() == ResourceItem::Type::Regular && !resource()->isProbed();
+}
+
+/*!
+ * \brief Stores the metadata given by the pre-flight probe, and shows the
+ * size of the file while it's still queued.
+ */
+void DownloadItem::setRemoteMetaData(const ResourceProber::MetaData &metaData)
+{
+    if (!isProbeable()) {
+        return; /* Started meanwhile: the transfer knows better */
+    }
+    resource()->setRedirectedUrl(metaData.redirectedUrl.toString());
+    resource()->setRemoteFileName(metaData.fileName);
+    resource()->setRemoteFileSize(metaData.size);
+    resource()->setRangeSupported(metaData.isRangeSupported);
+    resource()->setProbed(true);
+    resource()->setETag(metaData.eTag);
+    resource()->setLastModified(metaData.lastModified);
+    if (metaData.size > 0) {
+        setBytesTotal(metaData.size);
+    }
+    logInfo("Probed '%0' (%1 bytes%2).",
+            {resource()->url(),
+             QString::number(metaData.size),
+             metaData.isRangeSupported ? QString(", ranges accepted") : QString()});
+    emit otherChanged();
+}
+
+RetryPolicy DownloadItem::retryPolicy() const
+{
+    RetryPolicy policy;
+    auto settings = d->downloadManager->settings();
+    if (settings) {
+        policy.setMaxAttempts(settings->retryMaxAttempts());
+        policy.setBaseDelay(1000 * qint64(settings->retryDelay()));
+    }
+    return policy;
+}
+
+/*!
+ * \brief Returns the minimum size of the partial file, to resume the segments.
+ */
+qsizetype DownloadItem::writtenSize() const
+{
+    qsizetype size = 0;
+    for (const Segment &segment : std::as_const(d->segments)) {
+        if (segment.received() > 0) {
+            size = qMax(size, segment.position());
+        }
+    }
+    return size;
+}
+
+/*!
+ * \brief Returns the value of the 'If-Range' header.
+ *
+ * A weak ETag (i.e. W/"...") can't be used for a range request,
+ * so the Last-Modified date is used instead.
+ */
+QString DownloadItem::validator() const
+{
+    const QString eTag = resource()->eTag();
+    if (!eTag.isEmpty() && !eTag.startsWith(QLatin1String("W/"))) {
+        return eTag;
+    }
+    return resource()->lastModified();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the resource. The job read from the session is decoded
+ * on first use.
+ */
 ResourceItem* DownloadItem::resource() const
 {
+    d->load();
     return d->resource;
 }
 
 void DownloadItem::setResource(ResourceItem *resource)
 {
+    d->record.clear();
     d->resource = resource;
 }
 
+/*!
+ * \brief Keeps the \a job read from the session, to decode it on first
+ * use: when the item is scheduled, or when its details are requested.
+ *
+ * Meanwhile, the item shows the url and file name of the \a summary,
+ * and tells from it whether it can be probed.
+ */
+void DownloadItem::setRecord(const QByteArray &job, const RecordSummary &summary)
+{
+    d->record = job;
+    d->recordSummary = summary;
+}
+
+/*!
+ * \brief Returns the job read from the session, if not decoded yet.
+ */
+QByteArray DownloadItem::record() const
+{
+    return d->record;
+}
+
+bool DownloadItem::isLoaded() const
+{
+    return d->record.isEmpty();
+}
+
 /******************************************************************************
  ******************************************************************************/
 File* DownloadItem::file() const
 {
-    return d->file;
+    return d->ensureFile();
 }
 
 /******************************************************************************
@@ -365,7 +806,21 @@ File* DownloadItem::file() const
  */
 QUrl DownloadItem::sourceUrl() const
 {
-    return QUrl(d->resource->url());
+    if (!isLoaded()) {
+        return QUrl(d->recordSummary.url);
+    }
+    return resource()->distantFileUrl();
+}
+
+/**
+ * The page that referred the source Url
+ */
+QString DownloadItem::referringPage() const
+{
+    if (!isLoaded()) {
+        return d->recordSummary.referringPage;
+    }
+    return resource()->referringPage();
 }
 
 /**
@@ -373,7 +828,7 @@ QUrl DownloadItem::sourceUrl() const
  */
 QString DownloadItem::localFullFileName() const
 {
-    const QUrl target = d->resource->localFileUrl();
+    const QUrl target = resource()->localFileUrl();
     return target.toLocalFile();
 }
 
@@ -382,7 +837,10 @@ QString DownloadItem::localFullFileName() const
  */
 QString DownloadItem::localFileName() const
 {
-    const QUrl target = d->resource->localFileUrl();
+    if (!isLoaded()) {
+        return d->recordSummary.fileName;
+    }
+    const QUrl target = resource()->localFileUrl();
     const QFileInfo fi(target.toLocalFile());
     return fi.fileName();
 }
@@ -392,14 +850,14 @@ QString DownloadItem::localFileName() const
  */
 QString DownloadItem::localFilePath() const
 {
-    const QUrl target = d->resource->localFileUrl();
+    const QUrl target = resource()->localFileUrl();
     const QFileInfo fi(target.toLocalFile());
     return fi.absolutePath();
 }
 
 QUrl DownloadItem::localFileUrl() const
 {
-    return d->resource->localFileUrl();
+    return resource()->localFileUrl();
 }
 
 QUrl DownloadItem::localDirUrl() const
@@ -18,7 +18,12 @@
 #define CORE_DOWNLOAD_ITEM_H
 
 #include <Core/AbstractDownloadItem>
+#include <Core/ResourceProber>
+#include <Core/RetryPolicy>
+#include <Core/Segment>
 
+#include <QtCore/QByteArray>
+#include <QtCore/QDateTime>
 #include <QtCore/QObject>
 #include <QtCore/QString>
 #include <QtCore/QUrl>
@@ -41,8 +46,22 @@ public:
     ResourceItem* resource() const;
     virtual void setResource(ResourceItem *resource);
 
+    /* Lazy loading of the session */
+    struct RecordSummary
+    {
+        QString url;
+        QString fileName;
+        QString referringPage;
+        bool isRegular{true};
+        bool isProbed{false};
+    };
+    void setRecord(const QByteArray &job, const RecordSummary &summary);
+    QByteArray record() const;
+    bool isLoaded() const;
+
     /* Convenient */
     QUrl sourceUrl() const Q_DECL_OVERRIDE;
+    QString referringPage() const;
     QString localFileName() const Q_DECL_OVERRIDE;
     QString localFullFileName() const Q_DECL_OVERRIDE;
     QString localFilePath() const Q_DECL_OVERRIDE;
@@ -53,16 +72,40 @@ public:
     void pause() Q_DECL_OVERRIDE;
     void stop() Q_DECL_OVERRIDE;
 
+    bool isCancelable() const Q_DECL_OVERRIDE;
+
     void rename(const QString &newName) Q_DECL_OVERRIDE;
 
+    /* Partial download, to continue in a later session */
+    QList<Segment> segments() const;
+    void setSegments(const QList<Segment> &segments);
+
+    QString partialFileName() const;
+    void setPartialFileName(const QString &partialFileName);
+
+    const File* partialFile() const;
+
+    bool isRetryPending() const;
+
+    /* Pre-flight probe */
+    bool isProbeable() const;
+    void setRemoteMetaData(const ResourceProber::MetaData &metaData);
+
 private slots:
-    void onMetaDataChanged();
+    void onMetaDataChanged(const QDateTime &lastModified);
+    void onValidatorsChanged(const QString &eTag, const QString &lastModified);
+    void onInfoLogged(const QString &message);
     void onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
     void onRedirected(const QUrl &url);
+    void onSegmentsChanged(const QList<Segment> &segments);
+    void onTransferFinished();
     void onFinished();
-    void onErrorOccurred(QNetworkReply::NetworkError error);
-    void onReadyRead();
+    void onErrorOccurred(QNetworkReply::NetworkError error, const QString &errorString);
+    void onFileErrorOccurred(const QString &errorString);
+    void onFileMoved(bool success);
+    void onFileVerified(bool success);
     void onAboutToClose();
+    void onRetryTimeout();
 
 protected:
     File* file() const;
@@ -71,7 +114,11 @@ private:
     DownloadItemPrivate *d;
     friend class DownloadItemPrivate;
 
+    void startTransfer();
     QString statusToHttp(QNetworkReply::NetworkError error);
+    qsizetype writtenSize() const;
+    QString validator() const;
+    RetryPolicy retryPolicy() const;
 };
 
 #endif // CORE_DOWNLOAD_ITEM_H
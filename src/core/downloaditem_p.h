@@ -19,21 +19,43 @@
 
 #include "downloaditem.h"
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
+
 class DownloadManager;
 class File;
+class HttpTransfer;
 class ResourceItem;
-
-class QNetworkReply;
+class QTimer;
 
 class DownloadItemPrivate
 {    
 public:
     DownloadItemPrivate(DownloadItem *qq);
 
+    File* ensureFile();
+    void load();
+    void releaseTransfer();
+    void startRetryTimer(int msecs);
+    void stopRetryTimer();
+
     DownloadManager *downloadManager{Q_NULLPTR};
     ResourceItem *resource{Q_NULLPTR};
-    QNetworkReply *reply{Q_NULLPTR};
-    File *file;
+    HttpTransfer *transfer{Q_NULLPTR};
+    File *file{Q_NULLPTR};   ///< Created on demand
+    QList<Segment> segments; ///< Segments of the paused transfer
+
+    /* Job read from the session, decoded on first use */
+    QByteArray record;
+    DownloadItem::RecordSummary recordSummary;
+
+    /* Automatic retry after a network error */
+    QTimer *retryTimer{Q_NULLPTR};
+    int retryAttempts{0};       ///< Retries since the download last progressed
+    qsizetype retryOffset{0};   ///< Bytes received when the last retry was scheduled
+    QElapsedTimer retryClock;   ///< Time since the download was last resumed
+    bool isRetrying{false};     ///< True if resumed by the retry timer
+    bool isPartialKept{false};  ///< True if the failed download keeps its partial file
 
     DownloadItem *q;
 };
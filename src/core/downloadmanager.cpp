@@ -16,21 +16,53 @@
 
 #include "downloadmanager.h"
 
+#include <Core/BandwidthManager>
+#include <Core/DiskWriter>
 #include <Core/DownloadItem>
+#include <Core/DownloadStreamItem>
 #include <Core/DownloadTorrentItem>
 #include <Core/NetworkManager>
 #include <Core/ResourceItem>
+#include <Core/ResourceProber>
 #include <Core/Session>
+#include <Core/SessionJournal>
 #include <Core/Settings>
+#include <Core/TorrentContext>
 
 #include <QtCore/QDebug>
+#include <QtCore/QFile>
 #include <QtCore/QSettings>
+#include <QtCore/QTime>
 #include <QtCore/QTimer>
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkRequest>
 #include <QtNetwork/QNetworkReply>
 
+#include <limits>
+
 constexpr int msec_auto_save = 3000; ///< Autosave the queue every 3 seconds.
+constexpr int min_journal_records = 1000; ///< Compact the journal once it has more records than jobs.
+constexpr int msec_bandwidth_period = 60000; ///< Check the reduced bandwidth period every minute.
+constexpr qint64 bytes_per_kib = 1024;
+
+/*!
+ * \brief Returns a barrier that waits for the queued writes of the files.
+ *
+ * The barrier runs in the session thread, so that a slow disk doesn't
+ * block the GUI thread. The files are only keys of the DiskWriter: they
+ * can be deleted meanwhile.
+ */
+static SessionJournal::Barrier waitForWrites(const QList<const File *> &files)
+{
+    if (files.isEmpty()) {
+        return {};
+    }
+    return [files]() {
+        for (auto file : files) {
+            DiskWriter::getInstance().waitForWrites(file);
+        }
+    };
+}
 
 /*!
  * \class DownloadManager
@@ -48,25 +80,47 @@ DownloadManager::DownloadManager(QObject *parent) : DownloadEngine(parent)
   , m_settings(Q_NULLPTR)
   , m_dirtyQueueTimer(Q_NULLPTR)
   , m_queueFile(QString())
+  , m_sessionJournal(new SessionJournal(this))
+  , m_nextJournalId(0)
+  , m_isCompactionNeeded(false)
+  , m_isOrderChanged(false)
+  , m_savedFilters(-1)
+  , m_bandwidthTimer(new QTimer(this))
+  , m_resourceProber(new ResourceProber(m_networkManager, this))
 {
     /* Auto save of the queue */
     connect(this, SIGNAL(jobAppended(DownloadRange)), this, SLOT(onQueueChanged(DownloadRange)));
     connect(this, SIGNAL(jobRemoved(DownloadRange)), this, SLOT(onQueueChanged(DownloadRange)));
-    connect(this, SIGNAL(jobStateChanged(IDownloadItem*)), this, SLOT(onQueueChanged(IDownloadItem*)));
+    connect(this, SIGNAL(jobsChanged(DownloadChanges)), this, SLOT(onQueueChanged(DownloadChanges)));
+    connect(this, SIGNAL(sortChanged()), this, SLOT(onSortChanged()));
+
+    /* Bandwidth */
+    connect(&BandwidthManager::getInstance(), SIGNAL(limitsChanged()), this, SLOT(onBandwidthLimitsChanged()));
+    connect(m_bandwidthTimer, SIGNAL(timeout()), this, SLOT(updateBandwidth()));
+    m_bandwidthTimer->start(msec_bandwidth_period);
+
+    /* Pre-flight probe */
+    connect(this, SIGNAL(jobAppended(DownloadRange)), this, SLOT(onJobAppended(DownloadRange)));
+    connect(this, SIGNAL(jobRemoved(DownloadRange)), this, SLOT(onJobRemoved(DownloadRange)));
+    connect(m_resourceProber, SIGNAL(probed(IDownloadItem*, ResourceProber::MetaData)),
+            this, SLOT(onResourceProbed(IDownloadItem*, ResourceProber::MetaData)));
 }
 
 DownloadManager::~DownloadManager()
 {
-    saveQueue();
+    if (!m_queueFile.isEmpty()) {
+        saveLogs();
+        compactQueue();
+        m_sessionJournal->waitForWrites();
+    }
+    const auto stats = m_networkManager->statistics();
+    if (stats.requests > 0) {
+        qInfo("Network: %lld requests, %lld connections (%lld reused), %lld over HTTP/2, %lld warmed up.",
+              stats.requests, stats.connections, stats.reusedConnections(),
+              stats.http2Requests, stats.warmUps);
+    }
 }
 
-/******************************************************************************
- ******************************************************************************/
-/**
- * \fn void DownloadManager::jobStateChanged(IDownloadItem *downloadItem)
- * This signal is emited whenever the download data or its progress or its state has changed
- */
-
 /******************************************************************************
  ******************************************************************************/
 Settings *DownloadManager::settings() const
@@ -84,11 +138,36 @@ void DownloadManager::setSettings(Settings *settings)
         connect(m_settings, SIGNAL(changed()), this, SLOT(onSettingsChanged()));
     }
     m_networkManager->setSettings(m_settings);
+    if (m_settings) {
+        DiskWriter::getInstance().setIoUringEnabled(m_settings->isIoUringEnabled());
+        setMaxSimultaneousDownloads(m_settings->maxSimultaneousDownloads());
+        setAutoSimultaneousDownloadsEnabled(m_settings->isAutoSimultaneousDownloadsEnabled());
+        updateScheduler();
+        updateBandwidth();
+        updateProber();
+        updateSavedFilters();
+    }
+}
+
+void DownloadManager::updateScheduler()
+{
+    auto policy = m_settings->schedulingPolicy();
+    if (policy < 0 || policy >= Scheduler::LastPolicy) {
+        policy = Scheduler::Fifo;
+    }
+    setSchedulingPolicy(static_cast<Scheduler::Policy>(policy));
+    setMaxDownloadsPerHost(m_settings->maxDownloadsPerHost());
 }
 
 void DownloadManager::onSettingsChanged()
 {
     setMaxSimultaneousDownloads(m_settings->maxSimultaneousDownloads());
+    setAutoSimultaneousDownloadsEnabled(m_settings->isAutoSimultaneousDownloadsEnabled());
+    DiskWriter::getInstance().setIoUringEnabled(m_settings->isIoUringEnabled());
+    updateScheduler();
+    updateBandwidth();
+    updateProber();
+    updateSavedFilters();
     // reload the queue here
     if (m_queueFile != m_settings->database()) {
         m_queueFile = m_settings->database();
@@ -96,75 +175,420 @@ void DownloadManager::onSettingsChanged()
     }
 }
 
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Gives the limits of the settings to the BandwidthManager.
+ *
+ * The reduced limit, if any, replaces the global limit during its period.
+ */
+void DownloadManager::updateBandwidth()
+{
+    if (!m_settings) {
+        return;
+    }
+    qint64 limit = m_settings->bandwidthLimit();
+    if (m_settings->bandwidthReducedLimit() > 0) {
+        const QTime from = QTime::fromString(m_settings->bandwidthReducedFrom(), "HH:mm");
+        const QTime to = QTime::fromString(m_settings->bandwidthReducedTo(), "HH:mm");
+        if (BandwidthManager::isInPeriod(QTime::currentTime(), from, to)) {
+            limit = m_settings->bandwidthReducedLimit();
+        }
+    }
+    auto &bandwidth = BandwidthManager::getInstance();
+    bandwidth.setGlobalLimit(limit * bytes_per_kib);
+    bandwidth.setHostLimit(m_settings->bandwidthHostLimit() * bytes_per_kib);
+    bandwidth.setItemLimit(m_settings->bandwidthItemLimit() * bytes_per_kib);
+}
+
+void DownloadManager::onBandwidthLimitsChanged()
+{
+    const qint64 limit = BandwidthManager::getInstance().protocolLimit(BandwidthManager::Torrent);
+    TorrentContext::getInstance().setDownloadRateLimit(static_cast<int>(qMin(limit, qint64(std::numeric_limits<int>::max()))));
+}
+
+/*!
+ * \brief Counts the running downloads of each protocol, to split the
+ * global limit between them.
+ */
+void DownloadManager::updateActiveCounts()
+{
+    int counts[BandwidthManager::ProtocolCount] = {0, 0, 0};
+    const auto items = runningJobs();
+    for (auto item : items) {
+        if (dynamic_cast<DownloadStreamItem*>(item)) {
+            counts[BandwidthManager::Stream]++;
+        } else if (dynamic_cast<DownloadTorrentItem*>(item)) {
+            counts[BandwidthManager::Torrent]++;
+        } else {
+            counts[BandwidthManager::Http]++;
+        }
+    }
+    auto &bandwidth = BandwidthManager::getInstance();
+    for (int i = 0; i < BandwidthManager::ProtocolCount; ++i) {
+        bandwidth.setActiveCount(static_cast<BandwidthManager::Protocol>(i), counts[i]);
+    }
+}
+
+/*!
+ * \brief Opens the connection of the HTTP download that starts next.
+ */
+void DownloadManager::prepareToStart(IDownloadItem *item)
+{
+    if (dynamic_cast<DownloadStreamItem*>(item) || dynamic_cast<DownloadTorrentItem*>(item)) {
+        return;
+    }
+    m_networkManager->warmUp(item->sourceUrl());
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Probes the queued items if enabled, otherwise drops the pending probes.
+ */
+void DownloadManager::updateProber()
+{
+    if (m_settings && m_settings->isPreflightProbeEnabled()) {
+        probe(waitingJobs() + pausedJobs());
+    } else {
+        m_resourceProber->clear();
+    }
+}
+
+void DownloadManager::probe(const DownloadRange &range)
+{
+    for (auto item : range) {
+        auto downloadItem = dynamic_cast<DownloadItem*>(item);
+        if (downloadItem && downloadItem->isProbeable()) {
+            m_resourceProber->probe(item, downloadItem->sourceUrl(),
+                                    downloadItem->referringPage());
+        }
+    }
+}
+
+void DownloadManager::onJobAppended(const DownloadRange &range)
+{
+    for (auto item : range) {
+        m_journalIds.insert(item, m_nextJournalId++);
+        m_dirtyItems.insert(item);
+
+        auto abstractItem = dynamic_cast<AbstractDownloadItem*>(item);
+        if (abstractItem) {
+            connect(abstractItem, SIGNAL(eventsPending()), this, SLOT(onEventsPending()));
+            if (abstractItem->eventLog()->pendingCount() > 0) {
+                m_pendingLogItems.insert(abstractItem);
+            }
+        }
+    }
+    if (m_settings && m_settings->isPreflightProbeEnabled()) {
+        probe(range);
+    }
+}
+
+void DownloadManager::onJobRemoved(const DownloadRange &range)
+{
+    for (auto item : range) {
+        m_resourceProber->cancel(item);
+
+        auto it = m_journalIds.find(item);
+        if (it != m_journalIds.end()) {
+            m_removedIds.append(it.value());
+            m_journalIds.erase(it);
+        }
+        m_dirtyItems.remove(item);
+        m_pendingLogItems.remove(dynamic_cast<AbstractDownloadItem*>(item));
+    }
+}
+
+void DownloadManager::onResourceProbed(IDownloadItem *item, const ResourceProber::MetaData &metaData)
+{
+    auto downloadItem = dynamic_cast<DownloadItem*>(item);
+    if (downloadItem) {
+        downloadItem->setRemoteMetaData(metaData);
+    }
+}
+
+void DownloadManager::onEventsPending()
+{
+    auto item = qobject_cast<AbstractDownloadItem*>(sender());
+    if (item) {
+        m_pendingLogItems.insert(item);
+    }
+}
+
 /******************************************************************************
  ******************************************************************************/
 void DownloadManager::loadQueue()
 {
     if (!m_queueFile.isEmpty()) {
         QList<DownloadItem*> downloadItems;
-        Session::read(downloadItems, m_queueFile, this);
+        QList<qint64> ids;
+        bool isOutdated = false;
+        Session::read(downloadItems, m_queueFile, this, &ids, &isOutdated);
 
         QList<IDownloadItem*> abstractItems;
+        QList<IDownloadItem*> runningItems;
         foreach (auto item, downloadItems) {
             // Cast items of the list
             abstractItems.append(static_cast<IDownloadItem*>(item));
+            if (item->state() == IDownloadItem::Idle) {
+                runningItems.append(static_cast<IDownloadItem*>(item));
+            }
         }
         clear();
+
         append(abstractItems, false);
+
+        /*
+         * The items are saved as they were read: keep their ids, so that
+         * the journal continues without a new snapshot.
+         */
+        m_journalIds.clear();
+        m_nextJournalId = 0;
+        for (qsizetype i = 0; i < abstractItems.count(); ++i) {
+            m_journalIds.insert(abstractItems.at(i), ids.at(i));
+            m_nextJournalId = qMax(m_nextJournalId, ids.at(i) + 1);
+        }
+        m_dirtyItems.clear();
+        m_removedIds.clear();
+        m_isOrderChanged = false;
+        if (isOutdated) {
+            /* Write the jobs again, so that the next startup decodes them lazily */
+            for (auto item : std::as_const(abstractItems)) {
+                m_dirtyItems.insert(item);
+            }
+        }
+        m_sessionJournal->setFileName(m_queueFile);
+
+        /* Merge the journal of the last session at the first save */
+        m_isCompactionNeeded = isOutdated
+                || QFile::exists(SessionJournal::journalFileName(m_queueFile));
+        if (m_isCompactionNeeded) {
+            onQueueChanged();
+        }
+
+        /* The logs of the items not read are obsolete */
+        m_logStore.setDirectory(m_queueFile + QLatin1String(".logs"));
+        const LogStore logStore = m_logStore;
+        m_sessionJournal->post([logStore, ids]() {
+            logStore.prune(ids);
+        });
+
+        /* Continue the downloads interrupted by the last exit (or crash) */
+        foreach (auto item, runningItems) {
+            resume(item);
+        }
     }
 }
 
+/*!
+ * \brief Saves the changes of the queue since the last save.
+ *
+ * Only the items that changed are written, as records appended to the
+ * journal. The journal is merged into the session file when it becomes
+ * bigger than the queue.
+ */
 void DownloadManager::saveQueue()
 {
-    if (!m_queueFile.isEmpty()) {
-        QList<DownloadItem *> items;
-
-        const bool skipCompleted = m_settings->isRemoveCompletedEnabled();
-        const bool skipCanceled = m_settings->isRemoveCanceledEnabled();
-        const bool skipPaused = m_settings->isRemovePausedEnabled();
-
-        QList<IDownloadItem *> abstractItems = downloadItems();
-        foreach (auto abstractItem, abstractItems) {
-            auto item = dynamic_cast<DownloadItem*>(abstractItem);
-            if (item) {
-                switch (item->state()) {
-                case IDownloadItem::Idle:
-                case IDownloadItem::Paused:
-                case IDownloadItem::Preparing:
-                case IDownloadItem::Connecting:
-                case IDownloadItem::DownloadingMetadata:
-                case IDownloadItem::Downloading:
-                case IDownloadItem::Endgame:
-                    if (skipPaused) continue;
-                    break;
-
-                case IDownloadItem::Completed:
-                case IDownloadItem::Seeding:
-                    if (skipCompleted) continue;
-                    break;
-
-                case IDownloadItem::Stopped:
-                case IDownloadItem::Skipped:
-                case IDownloadItem::NetworkError:
-                case IDownloadItem::FileError:
-                    if (skipCanceled) continue;
-                    break;
-                }
-                items.append(item);
+    if (m_queueFile.isEmpty()) {
+        return;
+    }
+    saveLogs();
+    const int maxRecords = qMax(min_journal_records, static_cast<int>(m_journalIds.count()));
+    if (m_isCompactionNeeded || m_sessionJournal->recordCount() >= maxRecords) {
+        compactQueue();
+        return;
+    }
+    appendPendingRecords();
+}
+
+/*!
+ * \brief Appends the records of the items changed or removed since the
+ * last save to the journal.
+ */
+void DownloadManager::appendPendingRecords()
+{
+    QByteArray records;
+    QList<const File *> files;
+    int count = 0;
+    for (auto id : std::as_const(m_removedIds)) {
+        records += SessionJournal::removeRecord(id);
+        count++;
+    }
+    for (auto abstractItem : std::as_const(m_dirtyItems)) {
+        auto item = dynamic_cast<DownloadItem*>(abstractItem);
+        auto id = m_journalIds.value(abstractItem, -1);
+        if (!item || id < 0) {
+            continue;
+        }
+        if (isSaved(item)) {
+            if (item->isDownloading()) {
+                files.append(item->partialFile());
+            }
+            records += Session::putRecord(item, id);
+        } else {
+            records += SessionJournal::removeRecord(id);
+        }
+        count++;
+    }
+    if (m_isOrderChanged) {
+        QList<qint64> ids;
+        const QList<IDownloadItem *> abstractItems = downloadItems();
+        for (auto abstractItem : abstractItems) {
+            auto id = m_journalIds.value(abstractItem, -1);
+            if (id >= 0) {
+                ids.append(id);
             }
         }
-        Session::write(items, m_queueFile);
+        records += SessionJournal::orderRecord(ids);
+        count++;
+    }
+    m_removedIds.clear();
+    m_dirtyItems.clear();
+    m_isOrderChanged = false;
+    /* The saved progress is written once it's on disk */
+    m_sessionJournal->append(records, count, waitForWrites(files));
+}
+
+/*!
+ * \brief Appends the pending changes, then merges the journal into a new
+ * session file.
+ *
+ * The merge runs in the session thread: only the changed items are
+ * encoded here.
+ */
+void DownloadManager::compactQueue()
+{
+    if (m_queueFile.isEmpty()) {
+        return;
+    }
+    appendPendingRecords();
+    m_sessionJournal->compact();
+    m_isCompactionNeeded = false;
+}
+
+/*!
+ * \brief Appends the new events of the logs to the LogStore, and removes
+ * the logs of the removed items.
+ *
+ * Only the items that logged since the last save are visited.
+ */
+void DownloadManager::saveLogs()
+{
+    QHash<qint64, QList<EventLog::Entry> > logs;
+    for (auto item : std::as_const(m_pendingLogItems)) {
+        auto id = m_journalIds.value(item, -1);
+        if (id >= 0) {
+            logs.insert(id, item->eventLog()->takePending());
+        }
+    }
+    m_pendingLogItems.clear();
+    if (logs.isEmpty() && m_removedIds.isEmpty()) {
+        return;
     }
+    /* The files are written in the session thread */
+    const LogStore logStore = m_logStore;
+    const QList<qint64> removedIds = m_removedIds;
+    m_sessionJournal->post([logStore, removedIds, logs]() {
+        for (auto id : removedIds) {
+            logStore.remove(id);
+        }
+        for (auto it = logs.constBegin(); it != logs.constEnd(); ++it) {
+            logStore.append(it.key(), it.value());
+        }
+    });
+}
+
+/*!
+ * \brief Writes a new snapshot if the cleaning options have changed.
+ */
+void DownloadManager::updateSavedFilters()
+{
+    const int filters = (m_settings->isRemovePausedEnabled() ? 0x1 : 0)
+            | (m_settings->isRemoveCompletedEnabled() ? 0x2 : 0)
+            | (m_settings->isRemoveCanceledEnabled() ? 0x4 : 0);
+    if (m_savedFilters >= 0 && m_savedFilters != filters) {
+        /* The journal must record the jobs that are now saved, or not */
+        const QList<IDownloadItem *> items = downloadItems();
+        for (auto item : items) {
+            m_dirtyItems.insert(item);
+        }
+        m_isCompactionNeeded = true;
+        onQueueChanged();
+    }
+    m_savedFilters = filters;
+}
+
+/*!
+ * \brief Returns true if the item is kept in the session, according to
+ * the cleaning options of the settings.
+ */
+bool DownloadManager::isSaved(const DownloadItem *item) const
+{
+    switch (item->state()) {
+    case IDownloadItem::Idle:
+    case IDownloadItem::Paused:
+    case IDownloadItem::Preparing:
+    case IDownloadItem::Connecting:
+    case IDownloadItem::DownloadingMetadata:
+    case IDownloadItem::Downloading:
+    case IDownloadItem::Endgame:
+        return !m_settings->isRemovePausedEnabled();
+
+    case IDownloadItem::Completed:
+    case IDownloadItem::Seeding:
+        return !m_settings->isRemoveCompletedEnabled();
+
+    case IDownloadItem::Stopped:
+    case IDownloadItem::Skipped:
+    case IDownloadItem::NetworkError:
+    case IDownloadItem::FileError:
+        return !m_settings->isRemoveCanceledEnabled();
+    }
+    return true;
 }
 
 
 void DownloadManager::onQueueChanged(const DownloadRange &/*range*/)
 {
+    updateActiveCounts();
     onQueueChanged();
 }
 
-void DownloadManager::onQueueChanged(IDownloadItem* /*item*/)
+void DownloadManager::onQueueChanged(const DownloadChanges &changes)
+{
+    /* The speed isn't saved */
+    const IDownloadItem::Changes saved = IDownloadItem::StateChange
+            | IDownloadItem::ProgressChange
+            | IDownloadItem::NameChange
+            | IDownloadItem::OtherChange;
+    bool dirty = false;
+    bool stateChanged = false;
+    for (const auto &change : changes) {
+        if (change.changes & saved) {
+            m_dirtyItems.insert(change.item);
+            dirty = true;
+        }
+        if (change.changes.testFlag(IDownloadItem::StateChange)) {
+            stateChanged = true;
+            if (m_resourceProber->pendingCount() > 0
+                    && change.item->state() != IDownloadItem::Idle
+                    && change.item->state() != IDownloadItem::Paused) {
+                m_resourceProber->cancel(change.item); /* Started: no need to probe it */
+            }
+        }
+    }
+    if (stateChanged) {
+        updateActiveCounts();
+    }
+    if (dirty) {
+        onQueueChanged();
+    }
+}
+
+void DownloadManager::onSortChanged()
 {
+    m_isOrderChanged = true;
     onQueueChanged();
 }
 
@@ -180,6 +604,24 @@ void DownloadManager::onQueueChanged()
     }
 }
 
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the whole log of the item, read from the LogStore.
+ *
+ * If the queue isn't saved, returns the latest events only.
+ */
+QString DownloadManager::log(IDownloadItem *item)
+{
+    auto it = m_journalIds.constFind(item);
+    if (m_queueFile.isEmpty() || it == m_journalIds.constEnd()) {
+        return item->log();
+    }
+    saveLogs();
+    m_sessionJournal->waitForWrites();
+    return m_logStore.read(it.value());
+}
+
 /******************************************************************************
  ******************************************************************************/
 NetworkManager* DownloadManager::networkManager() const
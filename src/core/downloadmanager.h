@@ -18,15 +18,23 @@
 #define CORE_DOWNLOAD_MANAGER_H
 
 #include <Core/DownloadEngine>
+#include <Core/LogStore>
+#include <Core/ResourceProber>
 
+#include <QtCore/QHash>
 #include <QtCore/QList>
+#include <QtCore/QSet>
 #include <QtCore/QString>
 
+class AbstractDownloadItem;
 class ResourceItem;
 class Settings;
 
 class QTimer;
 class NetworkManager;
+class DownloadItem;
+class SessionJournal;
+
 class QNetworkReply;
 
 class DownloadManager : public DownloadEngine
@@ -48,13 +56,28 @@ public:
     IDownloadItem* createItem(const QUrl &url) Q_DECL_OVERRIDE;
     IDownloadItem* createTorrentItem(const QUrl &url) Q_DECL_OVERRIDE;
 
+    QString log(IDownloadItem *item);
+
+protected:
+    void prepareToStart(IDownloadItem *item) Q_DECL_OVERRIDE;
+
 private slots:
     void onSettingsChanged();
 
     void onQueueChanged(const DownloadRange &range);
-    void onQueueChanged(IDownloadItem* item);
+    void onQueueChanged(const DownloadChanges &changes);
     void onQueueChanged();
 
+    void onBandwidthLimitsChanged();
+    void updateBandwidth();
+
+    void onJobAppended(const DownloadRange &range);
+    void onJobRemoved(const DownloadRange &range);
+    void onResourceProbed(IDownloadItem *item, const ResourceProber::MetaData &metaData);
+    void onEventsPending();
+
+    void onSortChanged();
+
     void loadQueue();
     void saveQueue();
 
@@ -66,7 +89,37 @@ private:
     /* Crash Recovery */
     QTimer* m_dirtyQueueTimer;
     QString m_queueFile;
+    SessionJournal *m_sessionJournal;
+    QHash<IDownloadItem*, qint64> m_journalIds;
+    qint64 m_nextJournalId;
+    QSet<IDownloadItem*> m_dirtyItems;
+    QList<qint64> m_removedIds;
+    bool m_isCompactionNeeded;
+    bool m_isOrderChanged;
+    int m_savedFilters;
+
+    bool isSaved(const DownloadItem *item) const;
+    void updateSavedFilters();
+    void appendPendingRecords();
+    void compactQueue();
+
+    /* Logs of the items, out of the session */
+    LogStore m_logStore;
+    QSet<AbstractDownloadItem*> m_pendingLogItems; ///< Items with events not saved yet
+
+    void saveLogs();
+
+    /* Reduced bandwidth period */
+    QTimer* m_bandwidthTimer;
+
+    /* Pre-flight probe of the queued items */
+    ResourceProber *m_resourceProber;
+
+    void updateProber();
+    void probe(const DownloadRange &range);
 
+    void updateScheduler();
+    void updateActiveCounts();
     inline ResourceItem* createResourceItem(const QUrl &url);
 };
 
@@ -16,6 +16,7 @@
 
 #include "downloadstreamitem.h"
 
+#include <Core/BandwidthManager>
 #include <Core/DownloadManager>
 #include <Core/File>
 #include <Core/ResourceItem>
@@ -26,14 +27,20 @@
 DownloadStreamItem::DownloadStreamItem(DownloadManager *downloadManager)
     : DownloadItem(downloadManager)
     , m_stream(Q_NULLPTR)
+    , m_rateLimit(0)
 {
 }
 
+DownloadStreamItem::~DownloadStreamItem()
+{
+    releaseRateLimit();
+}
+
 /******************************************************************************
  ******************************************************************************/
 void DownloadStreamItem::resume()
 {
-    logInfo(QString("Resume '%0' (destination: '%1').").arg(resource()->url(), localFullFileName()));
+    logInfo("Resume '%0' (destination: '%1').", {resource()->url(), localFullFileName()});
 
     this->beginResume();
 
@@ -54,6 +61,7 @@ void DownloadStreamItem::resume()
             m_stream->deleteLater();
             m_stream = Q_NULLPTR;
         }
+        releaseRateLimit();
         m_stream = new Stream(this);
 
         const QString outputPath = localFullFileName();
@@ -65,13 +73,15 @@ void DownloadStreamItem::resume()
         m_stream->setFileSizeInBytes(resource()->streamFileSize());
 
         m_stream->setConfig(resource()->streamConfig());
+        m_rateLimit = BandwidthManager::getInstance().reserveStreamLimit();
+        m_stream->setRateLimit(m_rateLimit);
 
         connect(m_stream, SIGNAL(downloadMetadataChanged()), this, SLOT(onMetaDataChanged()));
         connect(m_stream, SIGNAL(downloadProgress(qsizetype, qsizetype)), this, SLOT(onDownloadProgress(qsizetype, qsizetype)));
         connect(m_stream, SIGNAL(downloadError(QString)), this, SLOT(onError(QString)));
         connect(m_stream, SIGNAL(downloadFinished()), this, SLOT(onFinished()));
 
-        logInfo(m_stream->command());
+        logInfo("%0", {m_stream->command()});
 
         m_stream->start();
 
@@ -82,19 +92,20 @@ void DownloadStreamItem::resume()
 void DownloadStreamItem::pause()
 {
     /// \todo implement?
-    logInfo(QString("Pause '%0'.").arg(resource()->url()));
+    logInfo("Pause '%0'.", {resource()->url()});
     AbstractDownloadItem::pause();
 }
 
 void DownloadStreamItem::stop()
 {
-    logInfo(QString("Stop '%0'.").arg(resource()->url()));
+    logInfo("Stop '%0'.", {resource()->url()});
     file()->cancel();
     if (m_stream) {
         m_stream->abort();
         m_stream->deleteLater();
         m_stream = Q_NULLPTR;
     }
+    releaseRateLimit();
     AbstractDownloadItem::stop();
 }
 
@@ -105,25 +116,24 @@ void DownloadStreamItem::onMetaDataChanged()
     auto oldFileName = resource()->streamFileName();
     auto newFileName = m_stream->fileName();
     if (oldFileName != newFileName) {
-        logInfo(QString("HTTP redirect: '%0' to '%1'.").arg(oldFileName, newFileName));
+        logInfo("HTTP redirect: '%0' to '%1'.", {oldFileName, newFileName});
         resource()->setStreamFileName(newFileName);
     }
 }
 
 void DownloadStreamItem::onDownloadProgress(qsizetype bytesReceived, qsizetype bytesTotal)
 {
-    if (bytesReceived > 0 && bytesTotal > 0) {
-        logInfo(QString("Downloaded '%0' (%1 of %2 bytes).")
-                .arg(resource()->url(),
-                     QString::number(bytesReceived),
-                     QString::number(bytesTotal)));
+    if (bytesReceived > 0 && bytesTotal > 0 && EventLog::isEnabled(EventLog::Debug)) {
+        logDebug("Downloaded '%0' (%1 of %2 bytes).",
+                 {resource()->url(), QString::number(bytesReceived), QString::number(bytesTotal)});
     }
     updateInfo(bytesReceived, bytesTotal);
 }
 
 void DownloadStreamItem::onFinished()
 {
-    logInfo(QString("Finished (%0) '%1'.").arg(state_c_str(), localFullFileName()));
+    logInfo("Finished (%0) '%1'.", {state_c_str(), localFullFileName()});
+    releaseRateLimit();
     switch (state()) {
     case Idle:
     case Preparing:
@@ -173,8 +183,20 @@ void DownloadStreamItem::onFinished()
 
 void DownloadStreamItem::onError(const QString &errorMessage)
 {
-    logInfo(QString("Error '%0': '%1'.").arg(resource()->url(), errorMessage));
+    logError("Error '%0': '%1'.", {resource()->url(), errorMessage});
+    releaseRateLimit();
     file()->cancel();
     setErrorMessage(errorMessage);
     setState(NetworkError);
 }
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Gives the rate limit of the stream back to the global limit.
+ */
+void DownloadStreamItem::releaseRateLimit()
+{
+    BandwidthManager::getInstance().releaseStreamLimit(m_rateLimit);
+    m_rateLimit = 0;
+}
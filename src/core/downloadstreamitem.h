@@ -31,7 +31,7 @@ class DownloadStreamItem : public DownloadItem
 
 public:
     DownloadStreamItem(DownloadManager *downloadManager);
-    ~DownloadStreamItem() Q_DECL_OVERRIDE = default;
+    ~DownloadStreamItem() Q_DECL_OVERRIDE;
 
     void resume() Q_DECL_OVERRIDE;
     void pause() Q_DECL_OVERRIDE;
@@ -45,6 +45,9 @@ private slots:
 
 private:
     Stream *m_stream;
+    qint64 m_rateLimit;
+
+    void releaseRateLimit();
 };
 
 #endif // CORE_DOWNLOAD_STREAM_ITEM_H
@@ -65,7 +65,7 @@ void DownloadTorrentItem::setResource(ResourceItem *resource)
 
     // Restore the previous session's data.
     m_torrent->setPreferredFilePriorities(fileStates);
-    emit changed();
+    emit otherChanged();
 }
 
 /******************************************************************************
@@ -80,7 +80,11 @@ Torrent* DownloadTorrentItem::torrent() const
 void DownloadTorrentItem::onTorrentChanged()
 {
     // save file priorities and states
-    this->resource()->setTorrentPreferredFilePriorities(m_torrent->preferredFilePriorities());
+    const QString priorities = m_torrent->preferredFilePriorities();
+    if (this->resource()->torrentPreferredFilePriorities() != priorities) {
+        this->resource()->setTorrentPreferredFilePriorities(priorities);
+        emit otherChanged();
+    }
 
     // info.bytesTotal is > 0 for state 'downloading' only,
     // otherwise info.bytesTotal == 0, even when 'completed'.
@@ -89,10 +93,10 @@ void DownloadTorrentItem::onTorrentChanged()
 
     if (m_torrent->info().error.type != TorrentError::NoError) {
 
-        logInfo(QString("Error ('%0'), file %1: '%2'.").arg(
-              QString::number(m_torrent->info().error.type),
-              QString::number(m_torrent->info().error.fileIndex),
-              m_torrent->info().error.message));
+        logError("Error ('%0'), file %1: '%2'.",
+                 {QString::number(m_torrent->info().error.type),
+                  QString::number(m_torrent->info().error.fileIndex),
+                  m_torrent->info().error.message});
 
         QString message;
 
@@ -211,9 +215,9 @@ void DownloadTorrentItem::resume()
     if (isPreparing()) {
         return;
     }
-    logInfo(QString("Resume '%0' (destination: '%1').")
-            .arg(resource()->url(), // remote/origine/t.torrent
-                 localFullFileName())); // localdrive/destination/t.torrent
+    logInfo("Resume '%0' (destination: '%1').",
+            {resource()->url(), // remote/origine/t.torrent
+             localFullFileName()}); // localdrive/destination/t.torrent
 
     this->beginResume();
 
@@ -241,7 +245,7 @@ void DownloadTorrentItem::resume()
 
 void DownloadTorrentItem::pause()
 {
-    logInfo(QString("Pause '%0'.").arg(resource()->url()));
+    logInfo("Pause '%0'.", {resource()->url()});
     if (isSeeding()) {
         if (TorrentContext::getInstance().hasTorrent(m_torrent)) {
             TorrentContext::getInstance().removeTorrent(m_torrent);
@@ -264,7 +268,7 @@ void DownloadTorrentItem::pause()
 
 void DownloadTorrentItem::stop()
 {
-    logInfo(QString("Stop '%0'.").arg(resource()->url()));
+    logInfo("Stop '%0'.", {resource()->url()});
     file()->cancel();
 
     if (isPreparing()) {
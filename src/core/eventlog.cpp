@@ -0,0 +1,247 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "eventlog.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDateTime>
+#include <QtCore/QDebug>
+#include <QtCore/QLoggingCategory>
+
+Q_LOGGING_CATEGORY(lcItem, "downzemall.item", QtWarningMsg)
+
+/*!
+ * \class EventLog
+ *
+ * The class EventLog keeps the latest events of a download item, in a
+ * ring buffer: once full, the oldest event is dropped.
+ *
+ * An event is stored as a string literal and its arguments. The message
+ * is formatted only when it's read, so that logging is cheap.
+ * The events below the verbosity level are ignored. By default, the
+ * verbosity is Info, or Debug if the 'downzemall.item.debug' logging rule
+ * is enabled (e.g. QT_LOGGING_RULES="downzemall.item.debug=true").
+ *
+ * Only the warnings and the errors are also written to the console by
+ * default, so that the Info events are not formatted when appended.
+ *
+ * The events not saved yet are said pending, see takePending().
+ */
+
+static QAtomicInt& verbosityLevel()
+{
+    static QAtomicInt level(lcItem().isDebugEnabled() ? EventLog::Debug : EventLog::Info);
+    return level;
+}
+
+static inline const char* levelPrefix(EventLog::Level level)
+{
+    switch (level) {
+    case EventLog::Debug:   return "Debug: ";
+    case EventLog::Info:    return "";
+    case EventLog::Warning: return "Warning: ";
+    case EventLog::Error:   return "Error: ";
+    }
+    return "";
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the message, where %0 to %9 are replaced by the arguments.
+ *
+ * Unlike chained QString::arg(), an argument that contains a marker isn't
+ * replaced again.
+ */
+QString EventLog::Entry::message() const
+{
+    const QString text = QString::fromUtf8(format ? format : "");
+    QString result;
+    result.reserve(text.size());
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (c == QLatin1Char('%') && i + 1 < text.size() && text.at(i + 1).isDigit()) {
+            const int index = text.at(i + 1).digitValue();
+            if (index < args.count()) {
+                result += args.at(index);
+                ++i;
+                continue;
+            }
+        }
+        result += c;
+    }
+    return result;
+}
+
+/*!
+ * \brief Returns the line of the log, as "[yyyy-MM-dd HH:mm:ss.zzz] message".
+ */
+QString EventLog::Entry::toString() const
+{
+    const QDateTime local = QDateTime::fromMSecsSinceEpoch(msecs);
+    const QString timestamp = local.toString(QLatin1String("yyyy-MM-dd HH:mm:ss.zzz"));
+    return "[" + timestamp + "] " + levelPrefix(level) + message();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+EventLog::EventLog(qsizetype capacity)
+    : m_capacity(qMax<qsizetype>(1, capacity))
+{
+}
+
+/******************************************************************************
+ ******************************************************************************/
+EventLog::Level EventLog::verbosity()
+{
+    return static_cast<Level>(verbosityLevel().loadRelaxed());
+}
+
+void EventLog::setVerbosity(Level level)
+{
+    verbosityLevel().storeRelaxed(level);
+}
+
+/*!
+ * \brief Returns true if the events of the given level are kept.
+ *
+ * Test it before computing costly arguments.
+ */
+bool EventLog::isEnabled(Level level)
+{
+    return level >= verbosity();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+qsizetype EventLog::capacity() const
+{
+    return m_capacity;
+}
+
+qsizetype EventLog::count() const
+{
+    return m_entries.count();
+}
+
+/*!
+ * \brief Returns the number of events dropped to make room for newer ones.
+ */
+qsizetype EventLog::droppedCount() const
+{
+    return m_dropped;
+}
+
+qsizetype EventLog::pendingCount() const
+{
+    return m_pending;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Appends the event, if its level is enabled.
+ *
+ * The \a format must be a string literal, as only its pointer is kept.
+ */
+void EventLog::append(Level level, const char *format, const QStringList &args)
+{
+    if (!isEnabled(level)) {
+        return;
+    }
+    Entry entry;
+    entry.msecs = QDateTime::currentMSecsSinceEpoch();
+    entry.level = level;
+    entry.format = format;
+    entry.args = args;
+
+    /* The message is formatted only if the category is enabled for the level */
+    switch (level) {
+    case Debug:   qCDebug(lcItem).noquote() << entry.message(); break;
+    case Info:    qCInfo(lcItem).noquote() << entry.message(); break;
+    case Warning: qCWarning(lcItem).noquote() << entry.message(); break;
+    case Error:   qCCritical(lcItem).noquote() << entry.message(); break;
+    }
+
+    if (m_entries.count() < m_capacity) {
+        m_entries.append(entry);
+    } else {
+        m_entries[m_first] = entry;
+        m_first = (m_first + 1) % m_capacity;
+        m_dropped++;
+    }
+    m_pending = qMin(m_pending + 1, m_entries.count());
+}
+
+void EventLog::clear()
+{
+    m_entries.clear();
+    m_first = 0;
+    m_pending = 0;
+    m_dropped = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the i-th event, from the oldest.
+ */
+EventLog::Entry EventLog::at(qsizetype i) const
+{
+    Q_ASSERT(i >= 0 && i < m_entries.count());
+    return m_entries.at((m_first + i) % m_entries.count());
+}
+
+QList<EventLog::Entry> EventLog::entries() const
+{
+    QList<Entry> entries;
+    entries.reserve(m_entries.count());
+    for (qsizetype i = 0; i < m_entries.count(); ++i) {
+        entries.append(at(i));
+    }
+    return entries;
+}
+
+/*!
+ * \brief Returns the events appended since the last call, from the oldest.
+ */
+QList<EventLog::Entry> EventLog::takePending()
+{
+    QList<Entry> entries;
+    entries.reserve(m_pending);
+    for (qsizetype i = m_entries.count() - m_pending; i < m_entries.count(); ++i) {
+        entries.append(at(i));
+    }
+    m_pending = 0;
+    return entries;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the events, one line per event.
+ */
+QString EventLog::toString() const
+{
+    QString text;
+    if (m_dropped > 0) {
+        text += QString("(%0 earlier events not shown)\n").arg(m_dropped);
+    }
+    for (qsizetype i = 0; i < m_entries.count(); ++i) {
+        text += at(i).toString() + "\n";
+    }
+    return text;
+}
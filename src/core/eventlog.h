@@ -0,0 +1,75 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_EVENT_LOG_H
+#define CORE_EVENT_LOG_H
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+class EventLog
+{
+public:
+    enum Level {
+        Debug = 0,
+        Info,
+        Warning,
+        Error
+    };
+
+    struct Entry
+    {
+        qint64 msecs{0};                ///< Time since epoch
+        Level level{Info};
+        const char *format{Q_NULLPTR};  ///< String literal, with %0 to %9 markers
+        QStringList args;
+
+        QString message() const;
+        QString toString() const;
+    };
+
+    static constexpr qsizetype defaultCapacity = 128;
+
+    explicit EventLog(qsizetype capacity = defaultCapacity);
+
+    static Level verbosity();
+    static void setVerbosity(Level level);
+    static bool isEnabled(Level level);
+
+    qsizetype capacity() const;
+    qsizetype count() const;
+    qsizetype droppedCount() const;
+    qsizetype pendingCount() const;
+
+    void append(Level level, const char *format, const QStringList &args = {});
+    void clear();
+
+    Entry at(qsizetype i) const;
+    QList<Entry> entries() const;
+    QList<Entry> takePending();
+
+    QString toString() const;
+
+private:
+    QList<Entry> m_entries;
+    qsizetype m_capacity{defaultCapacity};
+    qsizetype m_first{0};
+    qsizetype m_pending{0};
+    qsizetype m_dropped{0};
+};
+
+#endif // CORE_EVENT_LOG_H
@@ -16,6 +16,9 @@
 
 #include "file.h"
 
+#include <Core/BufferPool>
+#include <Core/Checksum>
+#include <Core/DiskWriter>
 #include <Core/IFileAccessManager>
 #include <Core/ResourceItem>
 #include <Core/Settings>
@@ -24,12 +27,32 @@
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
 #include <QtCore/QDir>
-#include <QtCore/QSaveFile>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QStorageInfo>
+#include <QtCore/QThread>
 #include <QtCore/QDate>
 #include <QtCore/QTime>
 
+#include <atomic>
+
+#if defined(Q_OS_LINUX)
+#  include <fcntl.h>
+#endif
+#if defined(Q_OS_UNIX)
+#  include <cerrno>
+#  include <cstring>
+#  include <unistd.h>
+#endif
+
 static IFileAccessManager *s_fileAccessManager = Q_NULLPTR;
 
+static const QString s_partial_suffix(".dzapart");
+
+constexpr qsizetype copy_chunk_size = 64 * 1024 * 1024; ///< Check for cancellation every 64 MiB
+
+static std::atomic<qint64> s_writeCount{0};
+static std::atomic<qint64> s_bytesWritten{0};
+
 static ExistingFileOption existingFileOption()
 {
     ExistingFileOption option = ExistingFileOption::Overwrite;
@@ -42,13 +65,40 @@ static ExistingFileOption existingFileOption()
     return option;
 }
 
+/*!
+ * \class File
+ *
+ * The class File writes a download to its partial file, then renames it
+ * to the destination file.
+ *
+ * The bytes can be written at any offset, so that the segments of a
+ * download are written in place, in any order. Once the size of the
+ * download is known, the partial file can be preallocated to its full
+ * size, to avoid the fragmentation of the file and to fail early if the
+ * disk is full.
+ *
+ * The writes at an offset are asynchronous: they are queued to the
+ * DiskWriter of the volume, and commit(), close() and flush() wait until
+ * they are written. If one of them fails, errorString() tells why, and
+ * commit() fails: the file has a hole.
+ *
+ * If the download has a checksum, the bytes are hashed while they're
+ * written, and verify() checks the file before it's committed.
+ *
+ * The methods are thread-safe: the bytes are written by the transfer
+ * thread, while the file is opened and committed by the GUI thread.
+ */
+
 File::File(QObject *parent) : QObject(parent)
 {
 }
 
 File::~File()
 {
-    cancel();
+    waitForMove();
+    close();
+    DiskWriter::getInstance().clearError(this);
+    delete m_checksum;
 }
 
 /******************************************************************************
@@ -62,19 +112,27 @@ void File::setFileAccessManager(IFileAccessManager *manager)
  ******************************************************************************/
 /*!
  * \brief Opens the given fileName, returning Open if successful; otherwise Error or Skip.
+ *
+ * The bytes are written to a partial file, next to the destination file,
+ * that is renamed to the destination file by commit().
+ *
+ * If \a resume is true, the existing partial file is kept as is, so that
+ * the download can continue where it stopped. Otherwise it is truncated.
  */
-File::OpenFlag File::open(ResourceItem *resource)
+File::OpenFlag File::open(ResourceItem *resource, bool resume)
 {
+    QMutexLocker locker(&m_mutex);
     Q_ASSERT(resource);
+    waitForMove();
     const QUrl target = resource->localFileUrl();
     const QString fileName = target.toLocalFile();
 
-    const OpenFlag flag = open(fileName);
+    const OpenFlag flag = open(fileName, resume);
     resource->setCustomFileName(customFileName());
     return flag;
 }
 
-File::OpenFlag File::open(const QString &fileName)
+File::OpenFlag File::open(const QString &fileName, bool resume)
 {
     // Check Path
     const QFileInfo fi(fileName);
@@ -105,61 +163,409 @@ File::OpenFlag File::open(const QString &fileName)
         }
     }
 
-    // Create and open file
+    // Create and open the partial file
     if (m_file) {
-        cancel();
+        close();
     }
-    m_file = new QSaveFile(this);
-    m_file->setFileName(safeFileName);
-    if (m_file->isOpen() || m_file->open(QIODevice::WriteOnly)) {
-        return Open;
+    if (!resume) {
+        DiskWriter::getInstance().clearError(this); /* Truncated */
     }
-    return Error;
+    m_fileName = safeFileName;
+    return openPartialFile(resume) ? Open : Error;
+}
+
+inline bool File::openPartialFile(bool resume)
+{
+    Q_ASSERT(!m_file);
+    m_file = new QFile(partialFileName(m_fileName), this);
+    /* The transfers coalesce the data in large buffers, so don't buffer twice */
+    QIODevice::OpenMode mode = QIODevice::ReadWrite | QIODevice::Unbuffered;
+    if (!resume) {
+        mode |= QIODevice::Truncate;
+    }
+    if (m_file->open(mode)) {
+        m_volume = QStorageInfo(m_file->fileName()).rootPath();
+        return true;
+    }
+    return false;
 }
 
 /******************************************************************************
  ******************************************************************************/
 bool File::isOpen() const
 {
+    QMutexLocker locker(&m_mutex);
     return m_file && m_file->isOpen();
 }
 
+/*!
+ * \brief Returns the error of the first write that failed, or an empty
+ * string if the bytes written so far are all on the disk.
+ *
+ * Doesn't wait for the queued writes.
+ */
+QString File::errorString() const
+{
+    return DiskWriter::getInstance().errorString(this);
+}
+
+/*!
+ * \brief Returns the size of the partial file.
+ *
+ * It's the end of the last byte written so far, or the full size of the
+ * download if the file is preallocated.
+ */
+qsizetype File::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file) {
+        waitForWrites();
+        return m_file->size();
+    }
+    const QString partial = partialFileName();
+    return partial.isEmpty() ? 0 : QFileInfo(partial).size();
+}
+
+QString File::partialFileName() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_fileName.isEmpty() ? QString() : partialFileName(m_fileName);
+}
+
+/*!
+ * \brief Sets the partial file of a download paused in a previous session,
+ * so that it can be removed by cancel() even if the file is never reopened.
+ */
+void File::setPartialFileName(const QString &partialFileName)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file) {
+        return;
+    }
+    m_fileName = partialFileName.endsWith(s_partial_suffix)
+            ? partialFileName.chopped(s_partial_suffix.size())
+            : QString();
+}
+
+/*!
+ * \brief Returns the name of the partial file of the given destination file.
+ */
+QString File::partialFileName(const QString &fileName)
+{
+    return fileName + s_partial_suffix;
+}
+
 /*!
  * \brief Rename file to the given resource file name.
  * If rename is a success, return true. Otherwise return false.
+ *
+ * The partial file is renamed in place: the downloaded bytes are neither
+ * read nor copied, so the download can continue. The file stays open, and
+ * the queued writes go to the renamed file. On Windows, where an open file
+ * can't be renamed, the file is closed, then reopened.
+ *
+ * Returns false, and keeps the file as is, if the partial file can't be
+ * renamed, e.g. if the new destination is on another file system. In that
+ * case, use move() instead.
  */
 bool File::rename(ResourceItem *resource)
 {
-    /* Flush and close the previous temporary file */
-    QByteArray data;
-    if (m_file && m_file->isOpen()) {
-        m_file->flush();
-        m_file->commit();
-        QString oldFile = m_file->fileName();
-
-        QFile inputFile(this);
-        inputFile.setFileName(oldFile);
-        if (inputFile.open(QIODevice::ReadOnly)) {
-            data = inputFile.readAll();
-            inputFile.close();
+    QMutexLocker locker(&m_mutex);
+    Q_ASSERT(resource);
+    if (!m_file || !m_file->isOpen()) {
+        return open(resource) == Open;
+    }
+    const QString newFileName = resource->localFileUrl().toLocalFile();
+    const QString oldPartial = partialFileName();
+    const QString newPartial = partialFileName(newFileName);
+    if (newPartial == oldPartial) {
+        return true;
+    }
+    QDir().mkpath(QFileInfo(newFileName).absolutePath());
+    QFile::remove(newPartial);
+
+    const bool isVerifying = m_isVerifying;
+#if defined(Q_OS_WIN)
+    close(); /* Waits for the pending writes */
+    const bool renamed = QDir().rename(oldPartial, newPartial);
+    if (renamed) {
+        m_fileName = newFileName;
+    }
+    const bool opened = openPartialFile(true);
+    if (opened && isVerifying) {
+        verify();
+    }
+    return opened && renamed;
+#else
+    /* The hashing thread reads the file by its name */
+    stopHashing();
+    const bool renamed = QDir().rename(oldPartial, newPartial);
+    if (renamed) {
+        m_fileName = newFileName;
+    }
+    if (isVerifying) {
+        verify();
+    }
+    return renamed;
+#endif
+}
+
+/*!
+ * \brief Moves the partial file to the given resource file name, in the
+ * background. Emits moved() when done.
+ *
+ * Used when rename() fails, because the new destination is on another
+ * file system. The file is closed during the copy, so the download must be
+ * stopped before, and restarted after.
+ */
+void File::move(ResourceItem *resource)
+{
+    QMutexLocker locker(&m_mutex);
+    Q_ASSERT(resource);
+    if (m_moveThread || m_fileName.isEmpty()) {
+        return;
+    }
+    close();
+
+    const QString newFileName = resource->localFileUrl().toLocalFile();
+    const QString oldPartial = partialFileName();
+    const QString newPartial = partialFileName(newFileName);
+    QDir().mkpath(QFileInfo(newFileName).absolutePath());
+
+    m_moveFileName = m_fileName;
+    m_fileName = newFileName;
+    m_isMoved = false;
+    m_isMoveCanceled = false;
+    m_moveThread = QThread::create([this, oldPartial, newPartial]() {
+        m_isMoved = copyFile(oldPartial, newPartial, m_isMoveCanceled);
+        if (m_isMoved) {
+            QFile::remove(oldPartial);
+        } else {
+            QFile::remove(newPartial);
         }
-        m_file->deleteLater();
-        m_file = Q_NULLPTR;
-        QFile::remove(oldFile);
+    });
+    connect(m_moveThread, SIGNAL(finished()), this, SLOT(onMoveFinished()));
+    m_moveThread->start();
+}
+
+bool File::isMoving() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_moveThread != Q_NULLPTR;
+}
+
+void File::onMoveFinished()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_moveThread) {
+        return; /* Already finished by waitForMove() */
+    }
+    const bool moved = finishMove();
+    openPartialFile(true);
+    locker.unlock();
+    emit this->moved(moved);
+}
+
+/*!
+ * \brief Blocks until the background move, if any, is finished, and
+ * leaves the file closed.
+ */
+void File::waitForMove()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_moveThread) {
+        m_moveThread->wait();
+        finishMove();
+    }
+}
+
+/*!
+ * \brief Forgets the finished move, and returns true if it succeeded.
+ *
+ * If it failed, the partial file is still at its previous place.
+ */
+inline bool File::finishMove()
+{
+    m_moveThread->deleteLater();
+    m_moveThread = Q_NULLPTR;
+    const bool moved = m_isMoved;
+    if (!moved) {
+        m_fileName = m_moveFileName;
+    }
+    m_moveFileName.clear();
+    return moved;
+}
+
+/*!
+ * \brief Copies the source file to the destination file, without loading
+ * it in memory.
+ *
+ * On Linux, copy_file_range() lets the kernel copy the data, without going
+ * through the user space. Otherwise, or if not supported between the two
+ * file systems, the data is streamed through a pooled buffer.
+ */
+bool File::copyFile(const QString &source, const QString &destination,
+                    const std::atomic<bool> &canceled)
+{
+    QFile input(source);
+    QFile output(destination);
+    if (!input.open(QIODevice::ReadOnly | QIODevice::Unbuffered)
+            || !output.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        return false;
+    }
+    const qsizetype size = input.size();
+    qsizetype copied = 0;
+#if defined(Q_OS_LINUX)
+    while (copied < size && !canceled) {
+        const size_t chunk = size_t(qMin(size - copied, copy_chunk_size));
+        const ssize_t count = ::copy_file_range(input.handle(), Q_NULLPTR,
+                                                output.handle(), Q_NULLPTR, chunk, 0);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break; /* Not supported (e.g. EXDEV): stream the rest */
+        }
+        copied += count;
     }
-    /* Open a new temporary file and append previous data */
-    File::OpenFlag flag = open(resource);
-    if (flag == Open) {
-        write(data);
+#endif
+    if (copied < size && (!input.seek(copied) || !output.seek(copied))) {
+        return false;
+    }
+    QByteArray buffer = BufferPool::getInstance().acquire();
+    while (copied < size && !canceled) {
+        const qint64 count = input.read(buffer.data(), buffer.size());
+        if (count <= 0 || output.write(buffer.constData(), count) != count) {
+            break;
+        }
+        copied += count;
+    }
+    BufferPool::getInstance().release(buffer);
+    return copied == size && !canceled;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Sets the expected checksum of the file, e.g. "sha256:9f86d0...",
+ * or clears it if empty.
+ *
+ * The bytes are hashed while they're written. If the download is resumed,
+ * the first \a existingSize bytes, already in the partial file, are
+ * hashed in the background.
+ *
+ * Must be called before the bytes are written. Returns false if the
+ * checksum isn't recognized, in which case the file isn't verified.
+ */
+bool File::setCheckSum(const QString &checkSum, qsizetype existingSize)
+{
+    QMutexLocker locker(&m_mutex);
+    stopHashing();
+    waitForWrites();
+    delete m_checksum;
+    m_checksum = Q_NULLPTR;
+    if (checkSum.isEmpty()) {
         return true;
     }
-    return false;
+    auto checksum = new Checksum(checkSum);
+    if (!checksum->isValid()) {
+        delete checksum;
+        return false;
+    }
+    m_checksum = checksum;
+    if (existingSize > 0 && m_file) {
+        startHashing(existingSize);
+    }
+    return true;
+}
+
+bool File::hasCheckSum() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_checksum != Q_NULLPTR;
+}
+
+/*!
+ * \brief Verifies the checksum of the file, in the background. Emits
+ * verified() when done.
+ *
+ * Only the bytes that weren't hashed while written are read again.
+ */
+void File::verify()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_checksum || !m_file) {
+        QMetaObject::invokeMethod(this, "verified", Qt::QueuedConnection,
+                                  Q_ARG(bool, m_checksum == Q_NULLPTR));
+        return;
+    }
+    m_isVerifying = true;
+    if (!m_hashThread) {
+        startHashing(size()); /* Waits for the pending writes */
+    }
+    /* Otherwise, continues once the existing bytes are hashed */
+}
+
+void File::startHashing(qsizetype size)
+{
+    Q_ASSERT(!m_hashThread);
+    Checksum *checksum = m_checksum;
+    const QString fileName = partialFileName();
+    m_hashSize = size;
+    m_isHashCanceled = false;
+    m_hashThread = QThread::create([this, checksum, fileName, size]() {
+        checksum->addFile(fileName, size, m_isHashCanceled);
+    });
+    connect(m_hashThread, SIGNAL(finished()), this, SLOT(onHashFinished()));
+    m_hashThread->start();
+}
+
+/*!
+ * \brief Stops hashing in the background. The bytes not hashed yet will be
+ * read again by verify().
+ */
+void File::stopHashing()
+{
+    if (m_hashThread) {
+        m_isHashCanceled = true;
+        m_hashThread->wait();
+        m_hashThread->deleteLater();
+        m_hashThread = Q_NULLPTR;
+    }
+    m_isVerifying = false;
+}
+
+void File::onHashFinished()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_hashThread || sender() != m_hashThread) {
+        return; /* Already stopped by stopHashing() */
+    }
+    m_hashThread->deleteLater();
+    m_hashThread = Q_NULLPTR;
+    if (!m_isVerifying) {
+        return; /* Existing bytes hashed: the download continues */
+    }
+    const qsizetype size = this->size();
+    if (m_hashSize < size) {
+        startHashing(size); /* Now the bytes not hashed while written */
+        return;
+    }
+    m_isVerifying = false;
+    const bool success = m_checksum->position() == size && m_checksum->verify();
+    if (!success) {
+        qWarning("Checksum mismatch: expected %s, got %s.",
+                 m_checksum->expected().constData(), m_checksum->result().constData());
+    }
+    locker.unlock();
+    emit verified(success);
 }
 
 /******************************************************************************
  ******************************************************************************/
 void File::setCreationFileTime(const QDateTime &newDate)
 {
+    QMutexLocker locker(&m_mutex);
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
     if (m_file && m_file->isOpen()) {
         m_file->setFileTime(newDate, QFileDevice::FileBirthTime);
@@ -171,6 +577,7 @@ void File::setCreationFileTime(const QDateTime &newDate)
 
 void File::setLastModifiedFileTime(const QDateTime &newDate)
 {
+    QMutexLocker locker(&m_mutex);
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
     if (m_file && m_file->isOpen()) {
         m_file->setFileTime(newDate, QFileDevice::FileModificationTime);
@@ -182,6 +589,7 @@ void File::setLastModifiedFileTime(const QDateTime &newDate)
 
 void File::setAccessFileTime(const QDateTime &newDate)
 {
+    QMutexLocker locker(&m_mutex);
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
     if (m_file && m_file->isOpen()) {
         m_file->setFileTime(newDate, QFileDevice::FileAccessTime);
@@ -193,6 +601,7 @@ void File::setAccessFileTime(const QDateTime &newDate)
 
 void File::setMetadataChangeFileTime(const QDateTime &newDate)
 {
+    QMutexLocker locker(&m_mutex);
 #if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
     if (m_file && m_file->isOpen()) {
         m_file->setFileTime(newDate, QFileDevice::FileMetadataChangeTime);
@@ -231,8 +640,251 @@ inline QString File::nextAvailableName(const QString &name)
  */
 void File::write(const QByteArray &data)
 {
+    QMutexLocker locker(&m_mutex);
     if (m_file) {
-        m_file->write(data);
+        waitForWrites();
+        const qsizetype offset = m_file->pos();
+        if (m_file->write(data) == data.size()) {
+            written(offset, data.constData(), data.size());
+        }
+    }
+}
+
+/*!
+ * \brief Writes the given bytes of data to the device, at the given offset.
+ *
+ * Used by segmented downloads, where the segments are received out of order.
+ * Writing beyond the end of the file extends it.
+ *
+ * The data is written asynchronously, by the DiskWriter.
+ */
+void File::write(qsizetype offset, const QByteArray &data)
+{
+    write(offset, data, data.size());
+}
+
+/*!
+ * \brief Writes the first size bytes of the buffer at the given offset,
+ * asynchronously.
+ *
+ * The buffer is shared with the DiskWriter, not copied, and given back to
+ * the BufferPool once written: the caller must not modify it anymore.
+ */
+void File::write(qsizetype offset, const QByteArray &buffer, qsizetype size)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file && size > 0) {
+        DiskWriter::getInstance().write(this, m_volume, offset, buffer, size);
+    }
+}
+
+/*!
+ * \brief Returns true if the writes of the file are waiting for the disk,
+ * in which case the download should pause until DiskWriter::writable().
+ */
+bool File::isWriteQueueFull() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_file && DiskWriter::getInstance().isFull(m_volume);
+}
+
+/*!
+ * \brief Writes the data, called by the DiskWriter thread of the volume.
+ *
+ * Doesn't lock the file: the file can't be closed or reopened while
+ * writes are pending, and these writes are serialized by the DiskWriter.
+ *
+ * Returns the error, or an empty string if the data is written.
+ */
+QString File::writeNow(qsizetype offset, const char *data, qsizetype size)
+{
+    if (!m_file) {
+        return tr("File closed before the write.");
+    }
+#if defined(Q_OS_UNIX)
+    /* Positional write: no seek, and the file position is left untouched */
+    const int fd = m_file->handle();
+    if (fd != -1) {
+        const char *bytes = data;
+        qsizetype position = offset;
+        qsizetype remaining = size;
+        while (remaining > 0) {
+            const ssize_t count = ::pwrite(fd, bytes, size_t(remaining), off_t(position));
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                const QString error = QString::fromLocal8Bit(strerror(errno));
+                qWarning("Couldn't write in file: %s.", qPrintable(error));
+                return tr("Couldn't write in file: %0.").arg(error);
+            }
+            bytes += count;
+            position += count;
+            remaining -= count;
+        }
+        written(offset, data, size);
+        return QString();
+    }
+#endif
+    if (m_file->pos() != offset && !m_file->seek(offset)) {
+        qWarning("Couldn't seek in file.");
+        return tr("Couldn't seek in file: %0.").arg(m_file->errorString());
+    }
+    if (m_file->write(data, size) != size) {
+        qWarning("Couldn't write in file.");
+        return tr("Couldn't write in file: %0.").arg(m_file->errorString());
+    }
+    written(offset, data, size);
+    return QString();
+}
+
+/*!
+ * \brief Returns the file descriptor, for the DiskWriter, or -1 if closed.
+ */
+int File::descriptor() const
+{
+    return m_file ? m_file->handle() : -1;
+}
+
+/*!
+ * \brief Counts the bytes written at the given offset, and hashes them if
+ * the file has a checksum.
+ */
+void File::written(qsizetype offset, const char *data, qsizetype size)
+{
+    s_writeCount++;
+    s_bytesWritten += size;
+    if (m_checksum) {
+        m_checksum->addData(offset, data, size);
+    }
+}
+
+/*!
+ * \brief Blocks until the queued writes of the file are written.
+ *
+ * Returns false if one of them failed.
+ */
+bool File::waitForWrites() const
+{
+    return DiskWriter::getInstance().waitForWrites(this);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the number of writes to the disk, for all the files.
+ */
+qint64 File::writeCount()
+{
+    return s_writeCount;
+}
+
+/*!
+ * \brief Returns the number of bytes written to the disk, for all the files.
+ */
+qint64 File::bytesWritten()
+{
+    return s_bytesWritten;
+}
+
+/*!
+ * \brief Returns the average number of writes per MiB written.
+ */
+qreal File::writesPerMegabyte()
+{
+    const qint64 bytes = s_bytesWritten;
+    return bytes > 0 ? qreal(s_writeCount) * 1024 * 1024 / bytes : 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Resizes the partial file to the given size.
+ *
+ * Used to discard the bytes already written when the download restarts.
+ */
+bool File::truncate(qsizetype size)
+{
+    QMutexLocker locker(&m_mutex);
+    stopHashing();
+    waitForWrites();
+    if (m_checksum && m_checksum->position() > size) {
+        m_checksum->reset();
+    }
+    return m_file && m_file->resize(size);
+}
+
+/*!
+ * \brief Allocates the disk space of the partial file, up to the given size.
+ *
+ * The blocks are reserved at once, so that the file isn't fragmented when
+ * its segments are written in any order, and the write fails now rather
+ * than at the end of the download if the disk is full.
+ *
+ * If the file system doesn't support the allocation, the file stays sparse.
+ *
+ * Returns false if the space can't be allocated.
+ */
+bool File::preallocate(qsizetype size)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file || !m_file->isOpen()) {
+        return false;
+    }
+    if (size <= m_file->size()) {
+        return true;
+    }
+#if defined(Q_OS_LINUX)
+    const int fd = m_file->handle();
+    if (fd != -1) {
+        int ret;
+        do {
+            ret = ::fallocate(fd, 0, 0, off_t(size));
+        } while (ret != 0 && errno == EINTR);
+        if (ret == 0) {
+            return true;
+        }
+        if (errno != EOPNOTSUPP && errno != ENOSYS) {
+            qWarning("Couldn't preallocate file: %s.", strerror(errno));
+            return false;
+        }
+    }
+    return true; /* Not supported, e.g. FAT or NFS: keep the file sparse */
+#else
+    return m_file->resize(size);
+#endif
+}
+
+/*!
+ * \brief Returns true if the volume of the partial file has enough free
+ * space to grow the file to the given size.
+ */
+bool File::isSpaceAvailable(qsizetype size) const
+{
+    QMutexLocker locker(&m_mutex);
+    const QString partial = partialFileName();
+    if (partial.isEmpty()) {
+        return true;
+    }
+    const QStorageInfo storage(QFileInfo(partial).absolutePath());
+    if (!storage.isValid() || !storage.isReady()) {
+        return true; /* Unknown volume: let the writes decide */
+    }
+    const qsizetype missing = size - this->size();
+    return missing <= 0 || storage.bytesAvailable() >= missing;
+}
+
+/*!
+ * \brief Flushes the written bytes to the partial file.
+ *
+ * Waits for the queued writes, without locking the file meanwhile.
+ */
+void File::flush()
+{
+    waitForWrites();
+    QMutexLocker locker(&m_mutex);
+    if (m_file) {
+        m_file->flush();
     }
 }
 
@@ -241,43 +893,75 @@ void File::write(const QByteArray &data)
 /*!
  * \brief Finish writing the file (flush) and close it.
  *
- * Returns true if the temporary file is renamed to the final file.
+ * Returns true if the partial file is renamed to the final file.
  * Other returns false.
  *
  * It is mandatory to call this at the end of the saving operation,
- * otherwise the file will be discarded.
+ * otherwise the partial file remains.
  */
 bool File::commit()
 {
+    QMutexLocker locker(&m_mutex);
+    if (m_moveThread) {
+        waitForMove();
+        openPartialFile(true);
+    }
     if (m_file) {
-        const bool commited = m_file->commit();
-        m_file->deleteLater();
-        m_file = Q_NULLPTR;
+        const QString partial = partialFileName(); /* Not m_file: renamed while open */
+        close();
+        if (!errorString().isEmpty()) {
+            return false; /* Some bytes aren't on the disk */
+        }
+        const bool commited = QFile::rename(partial, m_fileName);
+        if (commited) {
+            m_fileName.clear();
+        }
         return commited;
     }
     return false;
 }
 
-/******************************************************************************
- ******************************************************************************/
 /*!
- * \brief Cancel writing (close) and remove the temporary file (if exists).
+ * \brief Flush and close the partial file, but keep it for a later resume.
  */
-void File::cancel()
+void File::close()
 {
+    QMutexLocker locker(&m_mutex);
+    stopHashing();
     if (m_file) {
-        m_file->cancelWriting();
+        waitForWrites();
+        m_file->flush();
+        m_file->close();
         m_file->deleteLater();
         m_file = Q_NULLPTR;
     }
 }
 
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Cancel writing (close) and remove the partial file (if exists).
+ */
+void File::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_isMoveCanceled = true;
+    waitForMove();
+    close();
+    DiskWriter::getInstance().clearError(this);
+    if (!m_fileName.isEmpty()) {
+        QFile::remove(partialFileName(m_fileName));
+        m_fileName.clear();
+    }
+}
+
 /******************************************************************************
  ******************************************************************************/
 QString File::customFileName() const
 {
-    if (m_file) {
-        QFileInfo fi(m_file->fileName());
+    QMutexLocker locker(&m_mutex);
+    if (!m_fileName.isEmpty()) {
+        QFileInfo fi(m_fileName);
         return fi.completeBaseName();
     }
     return QString();
@@ -18,11 +18,16 @@
 #define CORE_FILE_H
 
 #include <QtCore/QObject>
+#include <QtCore/QRecursiveMutex>
 
+#include <atomic>
+
+class Checksum;
 class ResourceItem;
 class Settings;
 class IFileAccessManager;
-class QSaveFile;
+class QFile;
+class QThread;
 
 class File : public QObject
 {
@@ -40,25 +45,85 @@ public:
 
     static void setFileAccessManager(IFileAccessManager *manager);
 
-    OpenFlag open(ResourceItem *resource);
+    OpenFlag open(ResourceItem *resource, bool resume = false);
 
     void write(const QByteArray &data);
+    void write(qsizetype offset, const QByteArray &data);
+    void write(qsizetype offset, const QByteArray &buffer, qsizetype size);
+    bool isWriteQueueFull() const;
+    bool truncate(qsizetype size);
+    bool preallocate(qsizetype size);
+    bool isSpaceAvailable(qsizetype size) const;
+    void flush();
     bool commit();
+    void close();
     void cancel();
 
     bool isOpen() const;
+    QString errorString() const;
+    qsizetype size() const;
+    QString partialFileName() const;
+    void setPartialFileName(const QString &partialFileName);
+    static QString partialFileName(const QString &fileName);
+
+    /* Statistics */
+    static qint64 writeCount();
+    static qint64 bytesWritten();
+    static qreal writesPerMegabyte();
+
     bool rename(ResourceItem *resource);
+    void move(ResourceItem *resource);
+    bool isMoving() const;
     QString customFileName() const;
 
+    bool setCheckSum(const QString &checkSum, qsizetype existingSize = 0);
+    bool hasCheckSum() const;
+    void verify();
+
     void setCreationFileTime(const QDateTime &newDate);
     void setLastModifiedFileTime(const QDateTime &newDate);
     void setAccessFileTime(const QDateTime &newDate);
     void setMetadataChangeFileTime(const QDateTime &newDate);
 
+signals:
+    void moved(bool success);
+    void verified(bool success);
+
+private slots:
+    void onMoveFinished();
+    void onHashFinished();
+
 private:
-    QSaveFile *m_file = Q_NULLPTR;
+    QFile *m_file = Q_NULLPTR;
+    QString m_fileName;
+    QString m_volume;
+    mutable QRecursiveMutex m_mutex;
+
+    QThread *m_moveThread = Q_NULLPTR;
+    QString m_moveFileName;     ///< Destination file before the move
+    std::atomic<bool> m_isMoved{false};
+    std::atomic<bool> m_isMoveCanceled{false};
+
+    Checksum *m_checksum = Q_NULLPTR;
+    QThread *m_hashThread = Q_NULLPTR;
+    qsizetype m_hashSize{0};    ///< Size of the file hashed by the thread
+    bool m_isVerifying{false};
+    std::atomic<bool> m_isHashCanceled{false};
+
+    friend class DiskWriter;
+    int descriptor() const;
+    QString writeNow(qsizetype offset, const char *data, qsizetype size);
+    void written(qsizetype offset, const char *data, qsizetype size);
+    bool waitForWrites() const;
 
-    inline OpenFlag open(const QString &fileName);
+    inline OpenFlag open(const QString &fileName, bool resume);
+    inline bool openPartialFile(bool resume);
+    void waitForMove();
+    inline bool finishMove();
+    void startHashing(qsizetype size);
+    void stopHashing();
+    static bool copyFile(const QString &source, const QString &destination,
+                         const std::atomic<bool> &canceled);
     static inline QString nextAvailableName(const QString &name);
 };
 
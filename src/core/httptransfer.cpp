@@ -0,0 +1,885 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "httptransfer.h"
+
+#include <Core/BufferPool>
+#include <Core/DiskWriter>
+#include <Core/File>
+#include <Core/NetworkManager>
+
+#include <QtCore/QDebug>
+#include <QtCore/QTimer>
+#include <QtNetwork/QNetworkRequest>
+
+/*!
+ * Segments smaller than this are not worth their own connection.
+ */
+constexpr qsizetype min_segment_size = 1024 * 1024;
+
+/*!
+ * The progress is reported to the GUI thread at most every 100 msec.
+ */
+constexpr qint64 msec_progress_interval = 100;
+
+/*!
+ * The socket isn't read beyond this, so that a download waiting for the disk
+ * stops receiving data.
+ */
+constexpr qint64 read_buffer_size = 1024 * 1024;
+
+/*!
+ * When the bandwidth is exhausted, the sockets are read again after this delay.
+ */
+constexpr int msec_throttle_delay = 50;
+
+/*!
+ * \class HttpTransfer
+ *
+ * The class HttpTransfer downloads one remote file through one or several
+ * connections, and writes the received bytes directly into a File.
+ *
+ * The transfer starts with a single plain GET request. When the server
+ * advertises 'Accept-Ranges: bytes' and the file is big enough, the file
+ * is split into up to maxSegments() segments, each of them downloaded by a
+ * 'Range: bytes=begin-end' request.
+ *
+ * When a connection completes its segment, the largest remaining segment
+ * is split in two and the connection is reused for the second half, so
+ * that fast connections help slow ones until the end of the file.
+ *
+ * If the server ignores the 'Range' header (status 200 instead of 206),
+ * the additional connection is dropped and its segment is downloaded
+ * later by the connection of the preceding segment. Likewise if its
+ * 'Content-Range' doesn't match the segment.
+ *
+ * If a connection fails (e.g. 503 or 429 from a server that limits the
+ * connections), the transfer continues with fewer connections, and the
+ * segment is taken over by the next free one. The transfer fails only when
+ * no connection is left.
+ *
+ * A paused transfer is resumed by giving back its segments with
+ * setSegments(), and the ETag or Last-Modified of the remote file with
+ * setValidator(). The requests carry 'If-Range', so the transfer restarts
+ * from the beginning only if the file has changed or if the server
+ * doesn't support ranges.
+ *
+ * The data is read into buffers of the BufferPool, and written to the
+ * File in large writes, when the buffer is full, when the segment is
+ * complete, and before each progress snapshot (so that the reported
+ * segments are always on the disk). The writes are asynchronous (see
+ * DiskWriter): when the write queue of the disk is full, the transfer stops
+ * reading the sockets until the queue is drained.
+ *
+ * Likewise, the bytes read are taken from the budget of the
+ * BandwidthManager: when the global, host or item limit is reached, the
+ * sockets are read again a bit later, and the TCP flow control slows down
+ * the server.
+ *
+ * As soon as the size of the file is known, the free disk space is
+ * checked and the file is preallocated to its full size, if enabled.
+ * If the disk is full, the transfer fails with fileErrorOccurred().
+ * Likewise if a queued write fails later: the bytes are lost, so they
+ * mustn't be counted as received.
+ *
+ * The class doesn't own the File.
+ *
+ * The transfer is meant to run in a transfer thread (see
+ * NetworkManager::transferThread()), out of the GUI thread. It only
+ * communicates with signals, and its progress is throttled to a few
+ * snapshots per second. Use QMetaObject::invokeMethod() to call start()
+ * and abort() from another thread.
+ */
+
+HttpTransfer::HttpTransfer(NetworkManager *networkManager, QObject *parent) : QObject(parent)
+  , m_networkManager(networkManager)
+  , m_file(Q_NULLPTR)
+  , m_maxSegments(1)
+  , m_isPreallocationEnabled(false)
+  , m_isDiskSpaceCheckEnabled(false)
+  , m_bytesReceived(0)
+  , m_bytesTotal(0)
+  , m_isRangeAccepted(false)
+  , m_isResuming(false)
+  , m_isFinished(false)
+  , m_isWaitingForDisk(false)
+  , m_isThrottled(false)
+{
+    connect(&DiskWriter::getInstance(), SIGNAL(writable()), this, SLOT(onWritable()));
+}
+
+HttpTransfer::~HttpTransfer()
+{
+    releaseAll();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QUrl HttpTransfer::url() const
+{
+    return m_url;
+}
+
+void HttpTransfer::setUrl(const QUrl &url)
+{
+    m_url = url;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+File* HttpTransfer::file() const
+{
+    return m_file;
+}
+
+void HttpTransfer::setFile(File *file)
+{
+    m_file = file;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+int HttpTransfer::maxSegments() const
+{
+    return m_maxSegments;
+}
+
+void HttpTransfer::setMaxSegments(int segments)
+{
+    m_maxSegments = qMax(1, segments);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QList<Segment> HttpTransfer::segments() const
+{
+    return m_segments.values();
+}
+
+/*!
+ * \brief Sets the segments of a previous transfer, to continue it.
+ */
+void HttpTransfer::setSegments(const QList<Segment> &segments)
+{
+    m_segments.clear();
+    for (const Segment &segment : segments) {
+        m_segments.insert(segment.begin(), segment);
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QString HttpTransfer::validator() const
+{
+    return m_validator;
+}
+
+/*!
+ * \brief Sets the ETag or the Last-Modified date of the partial file.
+ */
+void HttpTransfer::setValidator(const QString &validator)
+{
+    m_validator = validator;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool HttpTransfer::isPreallocationEnabled() const
+{
+    return m_isPreallocationEnabled;
+}
+
+/*!
+ * \brief Reserves the full size of the file on the disk, once known.
+ */
+void HttpTransfer::setPreallocationEnabled(bool enabled)
+{
+    m_isPreallocationEnabled = enabled;
+}
+
+bool HttpTransfer::isDiskSpaceCheckEnabled() const
+{
+    return m_isDiskSpaceCheckEnabled;
+}
+
+/*!
+ * \brief Fails before downloading anything if the file can't fit on the disk.
+ */
+void HttpTransfer::setDiskSpaceCheckEnabled(bool enabled)
+{
+    m_isDiskSpaceCheckEnabled = enabled;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+qsizetype HttpTransfer::bytesReceived() const
+{
+    return m_bytesReceived;
+}
+
+qsizetype HttpTransfer::bytesTotal() const
+{
+    return m_bytesTotal;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void HttpTransfer::start()
+{
+    releaseAll();
+    if (m_segments.isEmpty()) {
+        m_segments.insert(0, Segment(0, -1));
+    }
+    m_bytesReceived = 0;
+    for (const Segment &segment : std::as_const(m_segments)) {
+        m_bytesReceived += segment.received();
+    }
+    const Segment last = m_segments.last();
+    m_bytesTotal = last.isOpenEnded() ? 0 : last.end() + 1;
+    m_isResuming = m_bytesReceived > 0;
+    m_isRangeAccepted = m_isResuming;
+    m_isFinished = false;
+    m_isWaitingForDisk = false;
+    m_isThrottled = false;
+    m_itemBucket = TokenBucket();
+    m_itemBucket.setRate(BandwidthManager::getInstance().itemLimit());
+
+    if (!checkFile() || !allocate()) {
+        return;
+    }
+
+    const auto begins = m_segments.keys();
+    for (auto begin : begins) {
+        if (!m_segments.value(begin).isComplete()) {
+            request(begin);
+        }
+    }
+    checkCompleted();
+}
+
+/*!
+ * \brief Aborts all the connections, silently.
+ */
+void HttpTransfer::abort()
+{
+    releaseAll();
+    m_isFinished = true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void HttpTransfer::request(qsizetype begin)
+{
+    const Segment segment = m_segments.value(begin);
+
+    Connection connection;
+    connection.begin = begin;
+    connection.isOpenEnded = segment.isOpenEnded();
+
+    QNetworkReply *reply = Q_NULLPTR;
+    if (segment.position() == 0 && segment.isOpenEnded()) {
+        reply = m_networkManager->get(m_url);
+    } else {
+        reply = m_networkManager->getRange(m_url, segment.position(), segment.end(), m_validator);
+    }
+    reply->setParent(this);
+    reply->setReadBufferSize(read_buffer_size);
+    m_connections.insert(reply, connection);
+
+    /* Signals/Slots of QNetworkReply */
+    connect(reply, SIGNAL(metaDataChanged()), this, SLOT(onMetaDataChanged()));
+    connect(reply, SIGNAL(redirected(QUrl)), this, SLOT(onRedirected(QUrl)));
+    connect(reply, SIGNAL(errorOccurred(QNetworkReply::NetworkError)),
+            this, SLOT(onErrorOccurred(QNetworkReply::NetworkError)));
+    connect(reply, SIGNAL(finished()), this, SLOT(onFinished()));
+
+    /* Signals/Slots of QIODevice */
+    connect(reply, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+}
+
+void HttpTransfer::release(QNetworkReply *reply)
+{
+    if (!reply) {
+        return;
+    }
+    auto it = m_connections.find(reply);
+    if (it != m_connections.end()) {
+        flushBuffer(it.value());
+        BufferPool::getInstance().release(it.value().buffer);
+        m_connections.erase(it);
+    }
+    reply->disconnect(this);
+    if (reply->isRunning()) {
+        reply->abort();
+    }
+    reply->deleteLater();
+}
+
+void HttpTransfer::releaseAll()
+{
+    const auto replies = m_connections.keys();
+    for (auto reply : replies) {
+        release(reply);
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void HttpTransfer::onMetaDataChanged()
+{
+    auto reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply || !m_connections.contains(reply)) {
+        return;
+    }
+    auto rawNewUrl = reply->header(QNetworkRequest::LocationHeader);
+    if (rawNewUrl.isValid()) {
+        const QUrl newUrl = rawNewUrl.toUrl();
+        /* Check if the metadata change is a redirection */
+        if (newUrl.isValid() && m_url.isValid() && m_url != newUrl) {
+            emit infoLogged(QString("HTTP redirect: '%0' to '%1'.").arg(m_url.toString(), newUrl.toString()));
+        }
+    }
+
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode >= 300) {
+        return; /* Redirection or error, handled elsewhere */
+    }
+
+    const Connection connection = m_connections.value(reply);
+    if (statusCode == 206) {
+        /* The body must start at the position of the segment, and stay in it */
+        const QByteArray contentRange = reply->rawHeader("Content-Range");
+        const Segment segment = m_segments.value(connection.begin);
+        Segment range;
+        qsizetype total = -1;
+        if (!Segment::fromContentRange(contentRange, range, total)
+                || range.begin() != segment.position()
+                || (!segment.isOpenEnded() && range.end() > segment.end())) {
+            const QString reason = QString("Server sent the range '%0' instead of %1.")
+                    .arg(QString::fromLatin1(contentRange), segment.toString());
+            m_isRangeAccepted = false; /* Don't split anymore */
+            release(reply);
+            if (m_connections.isEmpty()) {
+                restart(reason);
+            } else {
+                emit infoLogged(reason);
+            }
+            return;
+        }
+        /* Check that the remote file is still the same */
+        if (total > 0 && m_bytesTotal > 0 && total != m_bytesTotal) {
+            restart(QString("Size of the remote file has changed (%0 bytes instead of %1).")
+                    .arg(total).arg(m_bytesTotal));
+            return;
+        }
+        if (total > 0 && m_bytesTotal <= 0) {
+            m_bytesTotal = total;
+            m_segments[connection.begin].setEnd(total - 1);
+            allocate();
+        }
+        return;
+    }
+
+    if (connection.begin == 0 && connection.isOpenEnded && m_segments.value(0).received() == 0) {
+        /* First response: learn the size of the file and if it can be split */
+        const qsizetype length = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        if (m_isResuming && length != m_bytesTotal) {
+            restart(QString("Size of the remote file has changed (%0 bytes instead of %1).")
+                    .arg(length).arg(m_bytesTotal));
+            return;
+        }
+        m_isRangeAccepted = reply->rawHeader("Accept-Ranges").trimmed().toLower() == "bytes";
+        if (length > 0 && m_segments.value(0).isOpenEnded()) {
+            m_bytesTotal = length;
+            m_segments[0].setEnd(length - 1);
+            if (!allocate()) {
+                return;
+            }
+        }
+        emit metaDataChanged(reply->header(QNetworkRequest::LastModifiedHeader).toDateTime());
+        emit validatorsChanged(QString::fromLatin1(reply->rawHeader("ETag")),
+                               QString::fromLatin1(reply->rawHeader("Last-Modified")));
+        split();
+
+    } else if (m_isResuming) {
+        /* The file has changed, or the server doesn't support ranges anymore */
+        restart(QString("Server refused to resume at byte %0.").arg(connection.begin));
+
+    } else {
+        /* The server ignored the range: drop the connection */
+        emit infoLogged(QString("Server ignored range request at byte %0.").arg(connection.begin));
+        m_isRangeAccepted = false; /* Don't split anymore */
+        release(reply);
+    }
+}
+
+void HttpTransfer::onRedirected(const QUrl &url)
+{
+    emit redirected(url);
+}
+
+void HttpTransfer::onReadyRead()
+{
+    auto reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply || !m_connections.contains(reply)) {
+        return;
+    }
+    processData(reply);
+}
+
+/*!
+ * \brief Resumes the reading of the sockets, once the disk has caught up.
+ */
+void HttpTransfer::onWritable()
+{
+    if (!m_isWaitingForDisk || m_isFinished) {
+        return;
+    }
+    m_isWaitingForDisk = false;
+    if (!checkFile()) {
+        return;
+    }
+    const auto replies = m_connections.keys();
+    for (auto reply : replies) {
+        if (m_connections.contains(reply)) {
+            processData(reply);
+        }
+    }
+}
+
+/*!
+ * \brief Resumes the reading of the sockets, once the bandwidth is available.
+ */
+void HttpTransfer::onThrottleTimeout()
+{
+    if (!m_isThrottled || m_isFinished) {
+        return;
+    }
+    m_isThrottled = false;
+    const auto replies = m_connections.keys();
+    for (auto reply : replies) {
+        if (m_connections.contains(reply)) {
+            processData(reply);
+        }
+    }
+}
+
+void HttpTransfer::processData(QNetworkReply *reply)
+{
+    readData(reply);
+
+    reportProgress(false);
+
+    const Connection connection = m_connections.value(reply);
+    if (m_segments.value(connection.begin).isComplete()
+            && !(connection.isOpenEnded && absorbNext(connection.begin))) {
+        release(reply);
+        rebalance();
+        checkCompleted();
+    }
+}
+
+void HttpTransfer::onFinished()
+{
+    auto reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply || !m_connections.contains(reply)) {
+        return;
+    }
+    readData(reply, true);
+
+    const Connection connection = m_connections.value(reply);
+    release(reply);
+
+    Segment &segment = m_segments[connection.begin];
+    if (segment.isOpenEnded()) {
+        /* Unknown size: the end of the stream is the end of the file */
+        m_bytesTotal = segment.position();
+        if (segment.position() > 0) {
+            segment.setEnd(segment.position() - 1);
+        }
+        if (!checkFile(true)) {
+            return;
+        }
+        m_isFinished = true;
+        reportProgress(true);
+        emit finished();
+        return;
+    }
+    if (!segment.isComplete()) {
+        const QString errorString =
+                tr("Connection closed before the end of the segment %0.").arg(segment.toString());
+        if (m_connections.isEmpty()) {
+            fail(QNetworkReply::RemoteHostClosedError, errorString);
+        } else {
+            reduceConnections(errorString);
+        }
+        return;
+    }
+    rebalance();
+    checkCompleted();
+}
+
+/*!
+ * \brief Drops the connection that failed, and continues with the others.
+ *
+ * Fails the transfer only if no connection is left.
+ */
+void HttpTransfer::onErrorOccurred(QNetworkReply::NetworkError error)
+{
+    auto reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply || !m_connections.contains(reply)) {
+        return;
+    }
+    const QString errorString = reply->errorString();
+    release(reply);
+    if (m_connections.isEmpty()) {
+        fail(error, errorString);
+        return;
+    }
+    reduceConnections(errorString);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Writes the available bytes of the reply into its segment.
+ *
+ * An open-ended connection continues with the next segment once its own
+ * segment is complete, if nobody else downloads it.
+ *
+ * Unless \a force is true, the reading stops when the write queue of the
+ * disk is full, or when the bandwidth limit is reached.
+ */
+void HttpTransfer::readData(QNetworkReply *reply, bool force)
+{
+    auto it = m_connections.find(reply);
+    if (!m_file || it == m_connections.end()) {
+        return;
+    }
+    Connection &connection = it.value();
+    const qsizetype begin = connection.begin;
+    const QString host = m_url.host();
+    while (reply->bytesAvailable() > 0) {
+        if (m_segments.value(begin).isComplete()
+                && !(connection.isOpenEnded && absorbNext(begin))) {
+            break;
+        }
+        Segment &segment = m_segments[begin];
+        if (connection.buffer.isEmpty()) {
+            if (!force && m_file->isWriteQueueFull()) {
+                m_isWaitingForDisk = true;
+                break;
+            }
+            connection.buffer = BufferPool::getInstance().acquire();
+        }
+        if (connection.bufferSize == 0) {
+            connection.bufferOffset = segment.position();
+        }
+        qint64 maxSize = connection.buffer.size() - connection.bufferSize;
+        if (!segment.isOpenEnded()) {
+            maxSize = qMin(maxSize, qint64(segment.remaining()));
+        }
+        if (!force) {
+            const qint64 granted = BandwidthManager::getInstance().available(host, &m_itemBucket);
+            if (granted <= 0) {
+                if (!m_isThrottled) {
+                    m_isThrottled = true;
+                    QTimer::singleShot(msec_throttle_delay, this, SLOT(onThrottleTimeout()));
+                }
+                break;
+            }
+            maxSize = qMin(maxSize, granted);
+        }
+        const qint64 count = reply->read(connection.buffer.data() + connection.bufferSize, maxSize);
+        if (count <= 0) {
+            break;
+        }
+        BandwidthManager::getInstance().consume(host, count, &m_itemBucket);
+        connection.bufferSize += count;
+        segment.setReceived(segment.received() + count);
+        m_bytesReceived += count;
+
+        if (connection.bufferSize == connection.buffer.size()) {
+            flushBuffer(connection);
+        }
+    }
+}
+
+/*!
+ * \brief Writes the buffered data of the connection to the file, in one call.
+ *
+ * The buffer is handed over to the file, that gives it back to the pool
+ * once written.
+ */
+void HttpTransfer::flushBuffer(Connection &connection)
+{
+    if (m_file && connection.bufferSize > 0) {
+        m_file->write(connection.bufferOffset, connection.buffer, connection.bufferSize);
+        connection.buffer = QByteArray();
+    }
+    connection.bufferOffset += connection.bufferSize;
+    connection.bufferSize = 0;
+}
+
+void HttpTransfer::flushAll()
+{
+    for (auto it = m_connections.begin(); it != m_connections.end(); ++it) {
+        flushBuffer(it.value());
+    }
+}
+
+/*!
+ * \brief Checks the free disk space and preallocates the file, if enabled.
+ *
+ * Returns false, after failing the transfer, if the file doesn't fit on the disk.
+ */
+bool HttpTransfer::allocate()
+{
+    if (!m_file || m_bytesTotal <= 0) {
+        return true;
+    }
+    if (m_isDiskSpaceCheckEnabled && !m_file->isSpaceAvailable(m_bytesTotal)) {
+        failFile(tr("Not enough free disk space for %0 bytes.").arg(m_bytesTotal));
+        return false;
+    }
+    if (m_isPreallocationEnabled && !m_file->preallocate(m_bytesTotal)) {
+        failFile(tr("Couldn't allocate %0 bytes on the disk.").arg(m_bytesTotal));
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief Splits the file after the first response.
+ *
+ * The first connection keeps the first segment, the other segments get
+ * their own connection.
+ */
+void HttpTransfer::split()
+{
+    if (!m_isRangeAccepted || m_maxSegments < 2 || m_bytesTotal < 2 * min_segment_size
+            || m_segments.count() > 1) {
+        return;
+    }
+    const QList<Segment> parts = Segment::split(m_bytesTotal, m_maxSegments, min_segment_size);
+    Segment &first = m_segments[0];
+    if (parts.count() < 2 || first.received() >= parts.first().size()) {
+        return;
+    }
+    first.setEnd(parts.first().end());
+    for (int i = 1; i < parts.count(); ++i) {
+        m_segments.insert(parts.at(i).begin(), parts.at(i));
+        request(parts.at(i).begin());
+    }
+    emit infoLogged(QString("Split '%0' into %1 segments.").arg(m_url.toString()).arg(parts.count()));
+}
+
+/*!
+ * \brief Emits a snapshot of the progress, unless the last one is too recent.
+ */
+void HttpTransfer::reportProgress(bool force)
+{
+    if (!force && m_progressTimer.isValid() && m_progressTimer.elapsed() < msec_progress_interval) {
+        return;
+    }
+    m_progressTimer.start();
+    flushAll();
+    if (!checkFile()) {
+        return; /* Don't report the segments with lost bytes */
+    }
+    emit downloadProgress(m_bytesReceived, m_bytesTotal);
+    emit segmentsChanged(m_segments.values());
+}
+
+/*!
+ * \brief Discards the bytes received so far and downloads the whole file again.
+ */
+void HttpTransfer::restart(const QString &reason)
+{
+    emit infoLogged(QString("%0 Restart '%1' from the beginning.").arg(reason, m_url.toString()));
+    releaseAll();
+    m_segments.clear();
+    m_segments.insert(0, Segment(0, -1));
+    m_bytesReceived = 0;
+    m_bytesTotal = 0;
+    m_isRangeAccepted = false;
+    m_isResuming = false;
+    if (m_file) {
+        m_file->truncate(0);
+    }
+    reportProgress(true);
+    request(0);
+}
+
+/*!
+ * \brief Merges the segment following the given segment into it.
+ *
+ * Returns false if there is no such segment, or if it is being downloaded.
+ */
+bool HttpTransfer::absorbNext(qsizetype begin)
+{
+    const Segment segment = m_segments.value(begin);
+    const qsizetype nextBegin = segment.end() + 1;
+    if (segment.isOpenEnded() || !m_segments.contains(nextBegin) || isDownloading(nextBegin)) {
+        return false;
+    }
+    if (m_segments.value(nextBegin).received() > 0) {
+        return false; /* Don't download twice the bytes already received */
+    }
+    const Segment next = m_segments.take(nextBegin);
+    m_segments[begin].setEnd(next.end());
+    return true;
+}
+
+/*!
+ * \brief Continues with the connections left, after one of them failed.
+ *
+ * E.g. the servers or the CDNs that limit the connections per client
+ * answer the additional range requests with 503 or 429. The segment of the
+ * failed connection is taken over by the next free connection, see
+ * rebalance().
+ */
+void HttpTransfer::reduceConnections(const QString &reason)
+{
+    m_maxSegments = qMax(1, int(m_connections.count()));
+    emit infoLogged(QString("%0 Continue '%1' with %2 connections.")
+                    .arg(reason, m_url.toString()).arg(m_maxSegments));
+}
+
+/*!
+ * \brief Returns true if a connection downloads the given segment.
+ */
+bool HttpTransfer::isDownloading(qsizetype begin) const
+{
+    for (auto it = m_connections.constBegin(); it != m_connections.constEnd(); ++it) {
+        if (it.value().begin == begin) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * \brief Reuses the free connection slots for the segments left without
+ * connection, then to help the slowest segment.
+ */
+void HttpTransfer::rebalance()
+{
+    if (!m_isRangeAccepted) {
+        return;
+    }
+    const auto begins = m_segments.keys();
+    for (auto begin : begins) {
+        if (m_connections.count() >= m_maxSegments) {
+            return;
+        }
+        if (!m_segments.value(begin).isComplete() && !isDownloading(begin)) {
+            request(begin);
+        }
+    }
+    while (m_connections.count() < m_maxSegments) {
+        qsizetype largest = -1;
+        qsizetype largestRemaining = 0;
+        for (auto it = m_connections.constBegin(); it != m_connections.constEnd(); ++it) {
+            const qsizetype remaining = m_segments.value(it.value().begin).remaining();
+            if (remaining > largestRemaining) {
+                largestRemaining = remaining;
+                largest = it.value().begin;
+            }
+        }
+        if (largest < 0) {
+            return;
+        }
+        Segment tail;
+        if (!Segment::splitRemaining(m_segments[largest], tail, min_segment_size)) {
+            return;
+        }
+        m_segments.insert(tail.begin(), tail);
+        request(tail.begin());
+    }
+}
+
+/*!
+ * \brief Emits finished() when all the segments are complete.
+ */
+void HttpTransfer::checkCompleted()
+{
+    if (m_isFinished) {
+        return;
+    }
+    for (const Segment &segment : std::as_const(m_segments)) {
+        if (!segment.isComplete()) {
+            if (m_connections.isEmpty()) {
+                fail(QNetworkReply::ProtocolFailure,
+                     tr("No connection left for the segment %0.").arg(segment.toString()));
+            }
+            return;
+        }
+    }
+    if (!checkFile(true)) {
+        return;
+    }
+    m_isFinished = true;
+    reportProgress(true);
+    emit finished();
+}
+
+/*!
+ * \brief Fails the transfer if a queued write of the file failed.
+ *
+ * If \a wait is true, the buffered data is written first, and the queued
+ * writes are waited for, e.g. before the transfer finishes.
+ *
+ * Returns false in that case.
+ */
+bool HttpTransfer::checkFile(bool wait)
+{
+    if (!m_file) {
+        return true;
+    }
+    if (wait) {
+        flushAll();
+        m_file->flush();
+    }
+    const QString error = m_file->errorString();
+    if (error.isEmpty()) {
+        return true;
+    }
+    failFile(error);
+    return false;
+}
+
+void HttpTransfer::fail(QNetworkReply::NetworkError error, const QString &errorString)
+{
+    if (m_isFinished) {
+        return;
+    }
+    releaseAll();
+    m_isFinished = true;
+    emit errorOccurred(error, errorString);
+    emit finished();
+}
+
+void HttpTransfer::failFile(const QString &errorString)
+{
+    if (m_isFinished) {
+        return;
+    }
+    releaseAll();
+    m_isFinished = true;
+    emit fileErrorOccurred(errorString);
+    emit finished();
+}
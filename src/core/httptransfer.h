@@ -0,0 +1,144 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_HTTP_TRANSFER_H
+#define CORE_HTTP_TRANSFER_H
+
+#include <Core/BandwidthManager>
+#include <Core/Segment>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QObject>
+#include <QtCore/QUrl>
+#include <QtNetwork/QNetworkReply>
+
+class File;
+class NetworkManager;
+
+class HttpTransfer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HttpTransfer(NetworkManager *networkManager, QObject *parent = Q_NULLPTR);
+    ~HttpTransfer() Q_DECL_OVERRIDE;
+
+    QUrl url() const;
+    void setUrl(const QUrl &url);
+
+    File* file() const;
+    void setFile(File *file);
+
+    int maxSegments() const;
+    void setMaxSegments(int segments);
+
+    QList<Segment> segments() const;
+    void setSegments(const QList<Segment> &segments);
+
+    QString validator() const;
+    void setValidator(const QString &validator);
+
+    bool isPreallocationEnabled() const;
+    void setPreallocationEnabled(bool enabled);
+
+    bool isDiskSpaceCheckEnabled() const;
+    void setDiskSpaceCheckEnabled(bool enabled);
+
+    qsizetype bytesReceived() const;
+    qsizetype bytesTotal() const;
+
+public slots:
+    void start();
+    void abort();
+
+signals:
+    void metaDataChanged(const QDateTime &lastModified);
+    void validatorsChanged(const QString &eTag, const QString &lastModified);
+    void redirected(const QUrl &url);
+    void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+    void segmentsChanged(const QList<Segment> &segments);
+    void errorOccurred(QNetworkReply::NetworkError error, const QString &errorString);
+    void fileErrorOccurred(const QString &errorString);
+    void finished();
+    void infoLogged(const QString &message);
+
+private slots:
+    void onMetaDataChanged();
+    void onRedirected(const QUrl &url);
+    void onReadyRead();
+    void onFinished();
+    void onErrorOccurred(QNetworkReply::NetworkError error);
+    void onWritable();
+    void onThrottleTimeout();
+
+private:
+    struct Connection
+    {
+        qsizetype begin{0};     ///< Key of the segment in m_segments
+        bool isOpenEnded{false};///< True if the request has no upper bound
+
+        QByteArray buffer;      ///< Pooled buffer, where the data is coalesced
+        qsizetype bufferSize{0};///< Bytes of the buffer not yet written
+        qsizetype bufferOffset{0}; ///< Position in the file of the buffer
+    };
+
+    NetworkManager *m_networkManager;
+    File *m_file;
+    QUrl m_url;
+    int m_maxSegments;
+    QString m_validator;
+    bool m_isPreallocationEnabled;
+    bool m_isDiskSpaceCheckEnabled;
+
+    QMap<qsizetype, Segment> m_segments; ///< Segments, sorted by their first byte
+    QHash<QNetworkReply*, Connection> m_connections;
+
+    qsizetype m_bytesReceived;
+    qsizetype m_bytesTotal;
+    bool m_isRangeAccepted;
+    bool m_isResuming;
+    bool m_isFinished;
+    bool m_isWaitingForDisk;
+    bool m_isThrottled;
+    TokenBucket m_itemBucket;
+    QElapsedTimer m_progressTimer;
+
+    void request(qsizetype begin);
+    void release(QNetworkReply *reply);
+    void releaseAll();
+
+    void processData(QNetworkReply *reply);
+    void readData(QNetworkReply *reply, bool force = false);
+    void flushBuffer(Connection &connection);
+    void flushAll();
+    bool allocate();
+    bool checkFile(bool wait = false);
+    void split();
+    void restart(const QString &reason);
+    bool absorbNext(qsizetype begin);
+    bool isDownloading(qsizetype begin) const;
+    void reduceConnections(const QString &reason);
+    void rebalance();
+    void checkCompleted();
+    void reportProgress(bool force);
+    void fail(QNetworkReply::NetworkError error, const QString &errorString);
+    void failFile(const QString &errorString);
+};
+
+#endif // CORE_HTTP_TRANSFER_H
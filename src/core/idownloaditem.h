@@ -17,6 +17,8 @@
 #ifndef CORE_I_DOWNLOAD_ITEM_H
 #define CORE_I_DOWNLOAD_ITEM_H
 
+#include <QtCore/QFlags>
+#include <QtCore/QList>
 #include <QtCore/QString>
 #include <QtCore/QUrl>
 
@@ -39,6 +41,24 @@ public:
         FileError
     };
 
+    enum Priority {
+        LowPriority = 0,
+        NormalPriority,
+        HighPriority
+    };
+
+    /* Fields of the item that changed, since its last notification */
+    enum Change {
+        NoChange = 0x0,
+        StateChange = 0x1,
+        ProgressChange = 0x2,   /*!< Bytes received or total */
+        SpeedChange = 0x4,      /*!< Speed and remaining time */
+        NameChange = 0x8,
+        OtherChange = 0x10,     /*!< Priority, error message, etc. */
+        AllChanges = 0x1F
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
+
     IDownloadItem() = default;
     virtual ~IDownloadItem() noexcept = default; /* Pure virtual interface */
 
@@ -52,6 +72,7 @@ public:
 
     virtual int maxConnectionSegments() const = 0;
     virtual int maxConnections() const = 0;
+    virtual Priority priority() const = 0;
     virtual QString log() const = 0;
 
     virtual QUrl sourceUrl() const = 0;
@@ -73,4 +94,14 @@ public:
 
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(IDownloadItem::Changes)
+
+struct DownloadChange
+{
+    IDownloadItem *item{nullptr};
+    IDownloadItem::Changes changes;
+};
+
+using DownloadChanges = QList<DownloadChange>;
+
 #endif // CORE_I_DOWNLOAD_ITEM_H
@@ -0,0 +1,269 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "iouring.h"
+
+#if defined(Q_OS_LINUX) && __has_include(<linux/io_uring.h>)
+#  define HAVE_IO_URING
+#endif
+
+#ifdef HAVE_IO_URING
+#  include <cerrno>
+#  include <climits>
+#  include <cstring>
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+
+static int sys_io_uring_setup(unsigned entries, io_uring_params *params)
+{
+    return int(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int sys_io_uring_enter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return int(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, Q_NULLPTR, 0));
+}
+#endif
+
+/*!
+ * \class IoUring
+ *
+ * The class IoUring is a minimal io_uring submission queue, for the writes
+ * of the DiskWriter on Linux. A batch of writes is submitted in a single
+ * system call, then their completions are collected.
+ *
+ * The ring talks directly to the kernel (no liburing), and is only used
+ * from the thread that owns it.
+ *
+ * If io_uring isn't available (not Linux, kernel older than 5.1, or
+ * disabled by the system), isValid() returns false, and the caller falls
+ * back to the plain writes.
+ */
+
+IoUring::IoUring(unsigned entries)
+{
+#ifdef HAVE_IO_URING
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    m_fd = sys_io_uring_setup(entries, &params);
+    if (m_fd < 0) {
+        m_fd = -1;
+        return;
+    }
+    m_entries = params.sq_entries;
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool isSingleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (isSingleMap) {
+        m_sqRingSize = m_cqRingSize = qMax(m_sqRingSize, m_cqRingSize);
+    }
+    m_sqRing = ::mmap(Q_NULLPTR, m_sqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        m_sqRing = Q_NULLPTR;
+        release();
+        return;
+    }
+    if (isSingleMap) {
+        m_cqRing = m_sqRing;
+    } else {
+        m_cqRing = ::mmap(Q_NULLPTR, m_cqRingSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED) {
+            m_cqRing = Q_NULLPTR;
+            release();
+            return;
+        }
+    }
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    m_sqes = ::mmap(Q_NULLPTR, m_sqesSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    if (m_sqes == MAP_FAILED) {
+        m_sqes = Q_NULLPTR;
+        release();
+        return;
+    }
+
+    auto sq = static_cast<char*>(m_sqRing);
+    m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    auto cq = static_cast<char*>(m_cqRing);
+    m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    m_cqes = cq + params.cq_off.cqes;
+#else
+    Q_UNUSED(entries)
+#endif
+}
+
+IoUring::~IoUring()
+{
+    release();
+}
+
+void IoUring::release()
+{
+#ifdef HAVE_IO_URING
+    if (m_sqes) {
+        ::munmap(m_sqes, m_sqesSize);
+    }
+    if (m_cqRing && m_cqRing != m_sqRing) {
+        ::munmap(m_cqRing, m_cqRingSize);
+    }
+    if (m_sqRing) {
+        ::munmap(m_sqRing, m_sqRingSize);
+    }
+    if (m_fd != -1) {
+        ::close(m_fd);
+    }
+#endif
+    m_sqes = Q_NULLPTR;
+    m_cqRing = Q_NULLPTR;
+    m_sqRing = Q_NULLPTR;
+    m_fd = -1;
+    m_entries = 0;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns true if the system supports io_uring.
+ */
+bool IoUring::isSupported()
+{
+    static const bool supported = IoUring(2).isValid();
+    return supported;
+}
+
+bool IoUring::isValid() const
+{
+    return m_fd != -1;
+}
+
+/*!
+ * \brief Returns the maximum number of operations of a batch.
+ */
+unsigned IoUring::capacity() const
+{
+    return m_entries;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Queues the write of size bytes of data at the given offset of the
+ * file descriptor fd. The data must stay valid until its completion.
+ *
+ * Returns false if the queue is full.
+ */
+bool IoUring::prepareWrite(int fd, const char *data, qsizetype size, qsizetype offset, quint64 userData)
+{
+#ifdef HAVE_IO_URING
+    if (!isValid() || size < 0 || size > qsizetype(UINT_MAX)) {
+        return false;
+    }
+    const unsigned tail = *m_sqTail;
+    const unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+    if (tail - head >= m_entries) {
+        return false;
+    }
+    const unsigned index = tail & *m_sqMask;
+    auto sqe = static_cast<io_uring_sqe*>(m_sqes) + index;
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<quint64>(data);
+    sqe->len = unsigned(size);
+    sqe->off = quint64(offset);
+    sqe->user_data = userData;
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    m_prepared++;
+    return true;
+#else
+    Q_UNUSED(fd)
+    Q_UNUSED(data)
+    Q_UNUSED(size)
+    Q_UNUSED(offset)
+    Q_UNUSED(userData)
+    return false;
+#endif
+}
+
+/*!
+ * \brief Submits the prepared operations in one system call, and waits
+ * until all of them are completed.
+ *
+ * Returns the number of operations submitted, or a negative error code.
+ */
+int IoUring::submitAndWait()
+{
+#ifdef HAVE_IO_URING
+    const unsigned count = m_prepared;
+    m_prepared = 0;
+    if (!isValid() || count == 0) {
+        return 0;
+    }
+    forever {
+        const unsigned unsubmitted = *m_sqTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        const int ret = sys_io_uring_enter(m_fd, unsubmitted, count, IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue; /* Interrupted while waiting: wait again */
+            }
+            return -errno;
+        }
+        if (unsigned(ret) == unsubmitted) {
+            return int(count);
+        }
+    }
+#else
+    return -1;
+#endif
+}
+
+/*!
+ * \brief Takes the next completion, if any: the userData of the operation,
+ * and its result (bytes written, or a negative error code).
+ */
+bool IoUring::takeCompletion(quint64 *userData, int *result)
+{
+#ifdef HAVE_IO_URING
+    if (!isValid()) {
+        return false;
+    }
+    const unsigned head = *m_cqHead;
+    if (head == __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    const auto cqe = static_cast<const io_uring_cqe*>(m_cqes) + (head & *m_cqMask);
+    *userData = cqe->user_data;
+    *result = cqe->res;
+    __atomic_store_n(m_cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+#else
+    Q_UNUSED(userData)
+    Q_UNUSED(result)
+    return false;
+#endif
+}
@@ -0,0 +1,67 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_IO_URING_H
+#define CORE_IO_URING_H
+
+#include <QtCore/QtGlobal>
+
+#include <cstddef>
+
+class IoUring
+{
+public:
+    explicit IoUring(unsigned entries = 64);
+    ~IoUring();
+
+    static bool isSupported();
+
+    bool isValid() const;
+    unsigned capacity() const;
+
+    bool prepareWrite(int fd, const char *data, qsizetype size, qsizetype offset, quint64 userData);
+    int submitAndWait();
+    bool takeCompletion(quint64 *userData, int *result);
+
+private:
+    int m_fd{-1};
+    unsigned m_entries{0};
+    unsigned m_prepared{0};     ///< Entries prepared since the last submission
+
+    void *m_sqRing{Q_NULLPTR};
+    std::size_t m_sqRingSize{0};
+    void *m_cqRing{Q_NULLPTR};
+    std::size_t m_cqRingSize{0};
+    void *m_sqes{Q_NULLPTR};
+    std::size_t m_sqesSize{0};
+
+    unsigned *m_sqHead{Q_NULLPTR};
+    unsigned *m_sqTail{Q_NULLPTR};
+    unsigned *m_sqMask{Q_NULLPTR};
+    unsigned *m_sqArray{Q_NULLPTR};
+    unsigned *m_cqHead{Q_NULLPTR};
+    unsigned *m_cqTail{Q_NULLPTR};
+    unsigned *m_cqMask{Q_NULLPTR};
+    void *m_cqes{Q_NULLPTR};
+
+    void release();
+
+public:
+    IoUring(IoUring const&) = delete;
+    void operator=(IoUring const&) = delete;
+};
+
+#endif // CORE_IO_URING_H
@@ -0,0 +1,154 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "logstore.h"
+
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSet>
+
+/*!
+ * \class LogStore
+ *
+ * The class LogStore saves the logs of the download items on disk, out of
+ * the session, one file per item, named by the id of the item.
+ *
+ * The events are appended to "<id>.log". When the file exceeds the maximum
+ * size, it becomes "<id>.log.1", replacing the previous one, so that a log
+ * uses at most twice the maximum size.
+ *
+ * The log is read on demand only, e.g. to show it.
+ */
+
+static inline QString rotatedFileName(const QString &fileName)
+{
+    return fileName + QLatin1String(".1");
+}
+
+static QByteArray readAll(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return file.readAll();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QString LogStore::directory() const
+{
+    return m_directory;
+}
+
+void LogStore::setDirectory(const QString &path)
+{
+    m_directory = path;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+qint64 LogStore::maxFileSize() const
+{
+    return m_maxFileSize;
+}
+
+void LogStore::setMaxFileSize(qint64 bytes)
+{
+    m_maxFileSize = qMax<qint64>(1, bytes);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QString LogStore::fileName(qint64 id) const
+{
+    return QDir(m_directory).filePath(QString("%0.log").arg(id));
+}
+
+/*!
+ * \brief Appends the events to the log of the item \a id, and rotates the
+ * file if it becomes too big.
+ */
+bool LogStore::append(qint64 id, const QList<EventLog::Entry> &entries) const
+{
+    if (m_directory.isEmpty() || entries.isEmpty()) {
+        return false;
+    }
+    QByteArray data;
+    for (const auto &entry : entries) {
+        data += entry.toString().toUtf8();
+        data += '\n';
+    }
+    const QString name = fileName(id);
+    const qint64 size = QFileInfo(name).size();
+    if (size > 0 && size + data.size() > m_maxFileSize) {
+        QFile::remove(rotatedFileName(name));
+        QFile::rename(name, rotatedFileName(name));
+    }
+    QFile file(name);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        if (!QDir().mkpath(m_directory) || !file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning("Can't write log file '%s'.", qPrintable(name));
+            return false;
+        }
+    }
+    return file.write(data) == data.size();
+}
+
+/*!
+ * \brief Returns the log of the item \a id, from the oldest event.
+ */
+QString LogStore::read(qint64 id) const
+{
+    if (m_directory.isEmpty()) {
+        return {};
+    }
+    const QString name = fileName(id);
+    return QString::fromUtf8(readAll(rotatedFileName(name)) + readAll(name));
+}
+
+void LogStore::remove(qint64 id) const
+{
+    if (m_directory.isEmpty()) {
+        return;
+    }
+    const QString name = fileName(id);
+    QFile::remove(name);
+    QFile::remove(rotatedFileName(name));
+}
+
+/*!
+ * \brief Removes the logs of the items other than the given \a ids,
+ * e.g. the items not saved in the session.
+ */
+void LogStore::prune(const QList<qint64> &ids) const
+{
+    if (m_directory.isEmpty()) {
+        return;
+    }
+    const QSet<qint64> kept(ids.begin(), ids.end());
+    QDir dir(m_directory);
+    const QStringList names = dir.entryList({"*.log", "*.log.1"}, QDir::Files);
+    for (const auto &name : names) {
+        bool ok = false;
+        const qint64 id = name.section(QLatin1Char('.'), 0, 0).toLongLong(&ok);
+        if (!ok || !kept.contains(id)) {
+            dir.remove(name);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_LOG_STORE_H
+#define CORE_LOG_STORE_H
+
+#include <Core/EventLog>
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+class LogStore
+{
+public:
+    static constexpr qint64 defaultMaxFileSize = 64 * 1024;
+
+    LogStore() = default;
+
+    QString directory() const;
+    void setDirectory(const QString &path);
+
+    qint64 maxFileSize() const;
+    void setMaxFileSize(qint64 bytes);
+
+    QString fileName(qint64 id) const;
+
+    bool append(qint64 id, const QList<EventLog::Entry> &entries) const;
+    QString read(qint64 id) const;
+    void remove(qint64 id) const;
+    void prune(const QList<qint64> &ids) const;
+
+private:
+    QString m_directory;
+    qint64 m_maxFileSize{defaultMaxFileSize};
+};
+
+#endif // CORE_LOG_STORE_H
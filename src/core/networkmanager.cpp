@@ -19,18 +19,62 @@
 #include <Core/Settings>
 
 #include <QtCore/QDebug>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QThread>
+#include <QtCore/QUrl>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+#  include <QtNetwork/QHttp1Configuration>
+#endif
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkRequest>
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QNetworkProxy>
 
 constexpr int max_redirects_allowed = 5;
+constexpr int max_transfer_threads = 4;
+constexpr int msec_warm_up_interval = 30000;
+constexpr int max_warm_up_origins = 256;
 
+/*!
+ * \class NetworkManager
+ *
+ * The class NetworkManager creates the network requests.
+ *
+ * The requests can be sent from the GUI thread or from the transfer
+ * threads returned by transferThread(). Each thread uses its own
+ * QNetworkAccessManager, configured with a copy of the settings.
+ *
+ * A QNetworkAccessManager keeps a pool of connections per host, so the
+ * transfers of a same host are always run in the same thread, where they
+ * share (and reuse) the connections of this pool.
+ */
 
 NetworkManager::NetworkManager(QObject *parent) : QObject(parent)
   , m_networkAccessManager(new QNetworkAccessManager(this))
   , m_settings(Q_NULLPTR)
+  , m_nextTransferThread(0)
+  , m_httpUserAgent(QString())
+  , m_proxy(QNetworkProxy::NoProxy)
+  , m_transferTimeout(0)
+  , m_connectionsPerHost(6)
+  , m_isHttp2Enabled(false)
+  , m_generation(0)
+  , m_isWarmUpEnabled(false)
+{
+}
+
+NetworkManager::~NetworkManager()
+{
+    foreach (auto thread, m_transferThreads) {
+        thread->quit();
+        thread->wait();
+    }
+    qDeleteAll(m_transferContexts);
+}
+
+NetworkManager::ThreadAccessManager::~ThreadAccessManager()
 {
+    delete manager;
 }
 
 /******************************************************************************
@@ -49,6 +93,7 @@ void NetworkManager::setSettings(Settings *settings)
     if (m_settings) {
         connect(m_settings, SIGNAL(changed()), this, SLOT(onSettingsChanged()));
     }
+    setNetworkSettings(m_settings);
 }
 
 void NetworkManager::onSettingsChanged()
@@ -85,23 +130,153 @@ void NetworkManager::setNetworkSettings(Settings *settings)
         return;
     }
     // Proxy options
+    QNetworkProxy proxy(QNetworkProxy::NoProxy);
     QNetworkProxy::ProxyType type = toProxyType(settings->proxyType());
-    if (type == QNetworkProxy::NoProxy) {
-        QNetworkProxy::setApplicationProxy(type);
-        m_networkAccessManager->setProxy(type);
-    } else {
-        QNetworkProxy proxy;
+    if (type != QNetworkProxy::NoProxy) {
         proxy.setType(type);
         proxy.setHostName(settings->proxyHostName());
         proxy.setPort(static_cast<quint16>(settings->proxyPort()));
         proxy.setUser(settings->proxyUser());
         proxy.setPassword(settings->proxyPassword());
-        QNetworkProxy::setApplicationProxy(proxy);
-        m_networkAccessManager->setProxy(proxy);
     }
+    QNetworkProxy::setApplicationProxy(proxy);
+    m_networkAccessManager->setProxy(proxy);
+
     // Socket options
     auto timeout_msec = settings->connectionTimeout() * 1000;
     m_networkAccessManager->setTransferTimeout(timeout_msec);
+
+    // Copy for the transfer threads
+    QMutexLocker locker(&m_mutex);
+    m_httpUserAgent = settings->httpUserAgent();
+    m_proxy = proxy;
+    m_transferTimeout = timeout_msec;
+    m_connectionsPerHost = qMax(1, settings->connectionsPerHost());
+    m_isHttp2Enabled = settings->isHttp2Enabled();
+    m_generation++;
+    locker.unlock();
+
+    m_isWarmUpEnabled = settings->isConnectionWarmUpEnabled();
+    if (!m_isWarmUpEnabled) {
+        m_warmUps.clear();
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns a thread where to run the network and disk I/O of a transfer.
+ *
+ * The threads are created on demand. The transfers of a same \a host
+ * are always given the same thread, so that they share its connection
+ * pool. Without host, the threads are given in a round-robin fashion.
+ */
+QThread* NetworkManager::transferThread(const QString &host)
+{
+    if (m_transferThreads.isEmpty()) {
+        createTransferThreads();
+    }
+    if (!host.isEmpty()) {
+        auto index = qHash(host.toLower()) % static_cast<uint>(m_transferThreads.count());
+        return m_transferThreads.at(static_cast<int>(index));
+    }
+    m_nextTransferThread = (m_nextTransferThread + 1) % m_transferThreads.count();
+    return m_transferThreads.at(m_nextTransferThread);
+}
+
+void NetworkManager::createTransferThreads()
+{
+    const int count = qBound(1, QThread::idealThreadCount() / 2, max_transfer_threads);
+    for (int i = 0; i < count; ++i) {
+        auto thread = new QThread(this);
+        thread->setObjectName(QString("Transfer thread %0").arg(i));
+
+        auto context = new QObject();
+        context->moveToThread(thread);
+
+        thread->start();
+        m_transferThreads.append(thread);
+        m_transferContexts.append(context);
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Opens a connection to the origin of \a url before it's needed.
+ *
+ * The DNS lookup, TCP and TLS handshakes are done in advance, in the
+ * thread where the transfers of this host will run, so that the first
+ * request of the transfer finds a ready connection in the pool.
+ * An origin is warmed up at most once every 30 seconds.
+ */
+void NetworkManager::warmUp(const QUrl &url)
+{
+    if (!m_isWarmUpEnabled || !url.isValid()) {
+        return;
+    }
+    const QString scheme = url.scheme().toLower();
+    if (scheme != QLatin1String("http") && scheme != QLatin1String("https")) {
+        return;
+    }
+    const QString origin = scheme + QLatin1String("://") + url.authority().toLower();
+    auto it = m_warmUps.find(origin);
+    if (it != m_warmUps.end() && !it.value().hasExpired(msec_warm_up_interval)) {
+        return;
+    }
+    if (m_warmUps.count() >= max_warm_up_origins) {
+        m_warmUps.clear();
+    }
+    m_warmUps[origin].start();
+
+    auto thread = transferThread(url.host());
+    auto context = m_transferContexts.at(m_transferThreads.indexOf(thread));
+    QMetaObject::invokeMethod(context, [this, url]() {
+        /*
+         * A HEAD request, rather than QNetworkAccessManager::connectToHost(),
+         * because the connection pool of a host is sized by its first request.
+         */
+        QNetworkRequest request = createRequest(url, QString());
+        QNetworkReply *reply = accessManager()->head(request);
+        Q_ASSERT(reply);
+        m_warmUpCount.fetchAndAddRelaxed(1);
+        connect(reply, &QNetworkReply::finished, reply, &QNetworkReply::deleteLater);
+    });
+}
+
+NetworkManager::Statistics NetworkManager::statistics() const
+{
+    Statistics stats;
+    stats.requests = m_requestCount.loadRelaxed();
+    stats.connections = m_connectionCount.loadRelaxed();
+    stats.http2Requests = m_http2Count.loadRelaxed();
+    stats.warmUps = m_warmUpCount.loadRelaxed();
+    return stats;
+}
+
+/*!
+ * \brief Returns the access manager of the current thread.
+ *
+ * A QNetworkAccessManager can only be used from the thread it lives in.
+ */
+QNetworkAccessManager* NetworkManager::accessManager()
+{
+    if (QThread::currentThread() == thread()) {
+        return m_networkAccessManager;
+    }
+    if (!m_threadAccessManagers.hasLocalData()) {
+        auto local = new ThreadAccessManager();
+        local->manager = new QNetworkAccessManager();
+        m_threadAccessManagers.setLocalData(local);
+    }
+    auto local = m_threadAccessManagers.localData();
+    QMutexLocker locker(&m_mutex);
+    if (local->generation != m_generation) {
+        local->manager->setProxy(m_proxy);
+        local->manager->setTransferTimeout(m_transferTimeout);
+        local->generation = m_generation;
+    }
+    return local->manager;
 }
 
 /******************************************************************************
@@ -109,13 +284,86 @@ void NetworkManager::setNetworkSettings(Settings *settings)
 QNetworkReply* NetworkManager::get(const QUrl &url, const QString &referer)
 {
     Q_ASSERT(m_networkAccessManager);
+    QNetworkRequest request = createRequest(url, referer);
+    QNetworkReply* reply = accessManager()->get(request);
+    Q_ASSERT(reply);
+    watch(reply);
+
+    return reply;
+}
 
+/*!
+ * \brief Requests the byte range [begin, end] of the given url.
+ *
+ * If \a end is negative, the range is open-ended, i.e. 'bytes=begin-'.
+ * The server replies 206 (Partial Content) if it honors the range,
+ * otherwise 200 with the whole content.
+ */
+QNetworkReply* NetworkManager::getRange(const QUrl &url, qsizetype begin, qsizetype end,
+                                        const QString &validator,
+                                        const QString &referer)
+{
+    Q_ASSERT(m_networkAccessManager);
+    QNetworkRequest request = createRequest(url, referer);
+
+    QByteArray range = "bytes=" + QByteArray::number(begin) + "-";
+    if (end >= 0) {
+        range += QByteArray::number(end);
+    }
+    request.setRawHeader(QByteArray("Range"), range);
+
+    // If the remote file has changed, the server sends the whole file instead
+    if (!validator.isEmpty()) {
+        request.setRawHeader(QByteArray("If-Range"), validator.toLatin1());
+    }
+
+    QNetworkReply* reply = accessManager()->get(request);
+    Q_ASSERT(reply);
+    watch(reply);
+
+    return reply;
+}
+
+inline void NetworkManager::watch(QNetworkReply *reply)
+{
+    m_requestCount.fetchAndAddRelaxed(1);
+
+    /* Direct connections: the counters are atomic, and the reply can live in any thread */
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    connect(reply, &QNetworkReply::socketStartedConnecting, reply, [this]() {
+        m_connectionCount.fetchAndAddRelaxed(1);
+    });
+#endif
+    connect(reply, &QNetworkReply::finished, reply, [this, reply]() {
+        if (reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool()) {
+            m_http2Count.fetchAndAddRelaxed(1);
+        }
+    });
+
+    /* Don't queue the signals of the transfer threads to the GUI thread */
+    if (reply->thread() == thread()) {
+        connect(reply, SIGNAL(metaDataChanged()), this, SLOT(onMetaDataChanged()));
+        connect(reply, SIGNAL(redirected(QUrl)), this, SLOT(onRedirected(QUrl)));
+    }
+}
+
+inline QNetworkRequest NetworkManager::createRequest(const QUrl &url, const QString &referer) const
+{
     QNetworkRequest request;
     request.setUrl(url);
 
     // User-Agent
-    const QString httpUserAgent = m_settings ? m_settings->httpUserAgent() : QLatin1String("");
-    request.setHeader(QNetworkRequest::UserAgentHeader, httpUserAgent);
+    QMutexLocker locker(&m_mutex);
+    request.setHeader(QNetworkRequest::UserAgentHeader, m_httpUserAgent);
+
+    // Connection pool
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, m_isHttp2Enabled);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+    QHttp1Configuration http1;
+    http1.setNumberOfConnectionsPerHost(static_cast<qsizetype>(m_connectionsPerHost));
+    request.setHttp1Configuration(http1);
+#endif
+    locker.unlock();
 
     // Referer
     if (!referer.isEmpty()) {
@@ -136,13 +384,7 @@ QNetworkReply* NetworkManager::get(const QUrl &url, const QString &referer)
     request.setAttribute(QNetworkRequest::RedirectPolicyAttribute,
                          QNetworkRequest::NoLessSafeRedirectPolicy);
 #endif
-
-    QNetworkReply* reply = m_networkAccessManager->get(request);
-    Q_ASSERT(reply);
-    connect(reply, SIGNAL(metaDataChanged()), this, SLOT(onMetaDataChanged()));
-    connect(reply, SIGNAL(redirected(QUrl)), this, SLOT(onRedirected(QUrl)));
-
-    return reply;
+    return request;
 }
 
 /******************************************************************************
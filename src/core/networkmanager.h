@@ -17,13 +17,23 @@
 #ifndef CORE_NETWORK_MANAGER_H
 #define CORE_NETWORK_MANAGER_H
 
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
 #include <QtCore/QObject>
 #include <QtCore/QString>
+#include <QtCore/QThreadStorage>
+#include <QtNetwork/QNetworkProxy>
 
 class Settings;
 
 class QNetworkAccessManager;
 class QNetworkReply;
+class QNetworkRequest;
+class QThread;
+class QUrl;
 
 class NetworkManager : public QObject
 {
@@ -31,12 +41,30 @@ class NetworkManager : public QObject
 
 public:
     explicit NetworkManager(QObject *parent);
-    ~NetworkManager() Q_DECL_OVERRIDE = default;
+    ~NetworkManager() Q_DECL_OVERRIDE;
 
     Settings* settings() const;
     void setSettings(Settings *settings);
 
     QNetworkReply* get(const QUrl &url, const QString &referer = QString());
+    QNetworkReply* getRange(const QUrl &url, qsizetype begin, qsizetype end = -1,
+                            const QString &validator = QString(),
+                            const QString &referer = QString());
+
+    QThread* transferThread(const QString &host = QString());
+
+    void warmUp(const QUrl &url);
+
+    struct Statistics
+    {
+        qint64 requests{0};         ///< Requests sent
+        qint64 connections{0};      ///< Connections opened by the requests
+        qint64 http2Requests{0};    ///< Requests multiplexed over HTTP/2
+        qint64 warmUps{0};          ///< Connections opened in advance
+
+        qint64 reusedConnections() const { return qMax(qint64(0), requests - connections); }
+    };
+    Statistics statistics() const;
 
     static QStringList proxyTypeNames();
 
@@ -46,11 +74,47 @@ private slots:
     void onRedirected(const QUrl &url);
 
 private:
+    struct ThreadAccessManager
+    {
+        QNetworkAccessManager *manager{Q_NULLPTR};
+        int generation{-1};
+        ~ThreadAccessManager();
+    };
+
     /* Network parameters (SSL, Proxy, UserAgent...) */
     QNetworkAccessManager *m_networkAccessManager;
     Settings *m_settings;
 
+    /* Threads of the transfers, each with its own access manager */
+    QList<QThread*> m_transferThreads;
+    QList<QObject*> m_transferContexts; ///< One object living in each transfer thread
+    int m_nextTransferThread;
+    QThreadStorage<ThreadAccessManager*> m_threadAccessManagers;
+
+    /* Copy of the network parameters, readable from any thread */
+    mutable QMutex m_mutex;
+    QString m_httpUserAgent;
+    QNetworkProxy m_proxy;
+    int m_transferTimeout;
+    int m_connectionsPerHost;
+    bool m_isHttp2Enabled;
+    int m_generation;
+
+    /* Connection warm-up, by origin */
+    bool m_isWarmUpEnabled;
+    QHash<QString, QElapsedTimer> m_warmUps;
+
+    /* Statistics */
+    QAtomicInteger<qint64> m_requestCount;
+    QAtomicInteger<qint64> m_connectionCount;
+    QAtomicInteger<qint64> m_http2Count;
+    QAtomicInteger<qint64> m_warmUpCount;
+
     void setNetworkSettings(Settings *settings);
+    void createTransferThreads();
+    QNetworkAccessManager* accessManager();
+    inline void watch(QNetworkReply *reply);
+    inline QNetworkRequest createRequest(const QUrl &url, const QString &referer) const;
 };
 
 #endif // CORE_NETWORK_MANAGER_H
@@ -0,0 +1,128 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "rateestimator.h"
+
+#include <QtCore/QtMath>
+
+constexpr qint64 msec_window = 3000;    ///< Duration of the samples averaged
+constexpr qreal rate_smoothing = 0.3;   ///< Weight of the latest window in the rate
+constexpr qreal time_smoothing = 0.2;   ///< Weight of the latest estimate in the remaining time
+
+/*!
+ * \class RateEstimator
+ *
+ * The class RateEstimator estimates the instantaneous transfer rate from
+ * the amount of bytes received over time, and the remaining time.
+ *
+ * It keeps the samples of the last 3 seconds in a ring buffer. The rate
+ * is the rate over this window, smoothed with an exponentially weighted
+ * moving average (EWMA), so that a stall shows within the window instead
+ * of being hidden by the average since the beginning.
+ *
+ * The remaining time is smoothed too, so that it doesn't jitter.
+ */
+
+/******************************************************************************
+ ******************************************************************************/
+void RateEstimator::reset()
+{
+    m_first = 0;
+    m_count = 0;
+    m_rate = -1;
+    m_remainingTime = -1;
+}
+
+/*!
+ * \brief Adds the total of bytes received at the given time.
+ *
+ * \a bytesTotal is the size to receive, to estimate the remaining time,
+ * or -1 if unknown.
+ */
+void RateEstimator::addSample(qint64 msecs, qint64 bytes, qint64 bytesTotal)
+{
+    if (m_count > 0) {
+        const Sample &last = sampleAt(m_count - 1);
+        if (bytes < last.bytes || msecs < last.msecs || msecs - last.msecs > msec_window) {
+            /* Restarted from the beginning, or not sampled for a long time */
+            reset();
+        } else if (msecs == last.msecs) {
+            return;
+        }
+    }
+    if (m_count == capacity) {
+        m_first = (m_first + 1) % capacity;
+        m_count--;
+    }
+    Sample &sample = m_samples[(m_first + m_count) % capacity];
+    sample.msecs = msecs;
+    sample.bytes = bytes;
+    m_count++;
+
+    /* Drop the samples out of the window, but keep two at least */
+    while (m_count > 2 && msecs - sampleAt(0).msecs > msec_window) {
+        m_first = (m_first + 1) % capacity;
+        m_count--;
+    }
+    if (m_count < 2) {
+        return;
+    }
+    const Sample &first = sampleAt(0);
+    const qreal windowRate = qreal(1000 * (bytes - first.bytes)) / (msecs - first.msecs);
+    if (m_rate < 0 || windowRate == 0) {
+        m_rate = windowRate; /* A stall shows at once */
+    } else {
+        m_rate = rate_smoothing * windowRate + (1 - rate_smoothing) * m_rate;
+    }
+    updateRemainingTime(bytesTotal > 0 ? qMax(qint64(0), bytesTotal - bytes) : -1);
+}
+
+/*!
+ * \brief Returns the rate in bytes per second, or -1 if unknown.
+ */
+qreal RateEstimator::rate() const
+{
+    return m_rate;
+}
+
+/*!
+ * \brief Returns the remaining time in seconds, or -1 if unknown.
+ */
+qint64 RateEstimator::remainingTime() const
+{
+    return m_remainingTime < 0 ? -1 : qCeil(m_remainingTime);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+const RateEstimator::Sample& RateEstimator::sampleAt(int i) const
+{
+    return m_samples[(m_first + i) % capacity];
+}
+
+void RateEstimator::updateRemainingTime(qint64 bytesRemaining)
+{
+    if (bytesRemaining < 0 || m_rate <= 0) {
+        m_remainingTime = -1;
+        return;
+    }
+    const qreal estimate = bytesRemaining / m_rate;
+    if (m_remainingTime < 0 || bytesRemaining == 0) {
+        m_remainingTime = estimate;
+    } else {
+        m_remainingTime = time_smoothing * estimate + (1 - time_smoothing) * m_remainingTime;
+    }
+}
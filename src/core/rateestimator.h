@@ -0,0 +1,51 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_RATE_ESTIMATOR_H
+#define CORE_RATE_ESTIMATOR_H
+
+#include <QtCore/QtGlobal>
+
+class RateEstimator
+{
+public:
+    RateEstimator() = default;
+
+    void reset();
+    void addSample(qint64 msecs, qint64 bytes, qint64 bytesTotal = -1);
+
+    qreal rate() const;
+    qint64 remainingTime() const;
+
+private:
+    struct Sample
+    {
+        qint64 msecs{0};
+        qint64 bytes{0};
+    };
+    static constexpr int capacity = 64;
+    Sample m_samples[capacity];
+    int m_first{0};
+    int m_count{0};
+
+    qreal m_rate{-1};
+    qreal m_remainingTime{-1};
+
+    const Sample& sampleAt(int i) const;
+    void updateRemainingTime(qint64 bytesRemaining);
+};
+
+#endif // CORE_RATE_ESTIMATOR_H
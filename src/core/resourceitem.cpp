@@ -22,30 +22,95 @@
 
 #include <QtCore/QDir>
 #include <QtCore/QFile>
+#include <QtCore/QMutex>
 #include <QtCore/QRegularExpression>
+#include <QtCore/QSet>
 #include <QtCore/QUrl>
 
 static const QString s_regular = QLatin1String("regular");
 static const QString s_stream  = QLatin1String("stream");
 static const QString s_torrent = QLatin1String("torrent");
 
+constexpr qsizetype max_interned_strings = 4096; ///< Size of the pool of shared strings
+
+/*!
+ * \class ResourceItem
+ *
+ * The class ResourceItem describes the resource to download, and where to
+ * save it. A queue can hold a million of them, so the layout is compact:
+ * \li the properties repeated by the items of a batch (destination, mask,
+ * referring page) share a single string buffer, see intern();
+ * \li the properties of the remote file, of the streams and of the torrents
+ * are in blocks, allocated only when one of their properties is set;
+ * \li the host is parsed once, when the URL is set, and shared by the items
+ * of the same host; the full URL is parsed only when needed.
+ */
 
 ResourceItem::ResourceItem()
     : m_type(Type::Regular)
     , m_url(QString())
+    , m_host(QString())
     , m_destination(QString())
     , m_mask(QString())
     , m_customFileName(QString())
     , m_referringPage(QString())
     , m_description(QString())
     , m_checkSum(QString())
-    , m_streamFileName(QString())
-    , m_streamFormatId(QString())
-    , m_streamFileSize(0)
-    , m_torrentPreferredFilePriorities(QString())
 {
 }
 
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns a copy of \a str that shares its buffer with the equal
+ * strings returned before.
+ *
+ * The pool is bounded: once full, it's emptied, and the strings in use
+ * stay shared by the items that hold them.
+ */
+QString ResourceItem::intern(const QString &str)
+{
+    if (str.isEmpty()) {
+        return QString();
+    }
+    static QMutex mutex;
+    static QSet<QString> pool;
+    QMutexLocker locker(&mutex);
+    auto it = pool.constFind(str);
+    if (it != pool.constEnd()) {
+        return *it;
+    }
+    if (pool.count() >= max_interned_strings) {
+        pool.clear();
+    }
+    pool.insert(str);
+    return str;
+}
+
+ResourceItem::RemoteData* ResourceItem::remote()
+{
+    if (!m_remote) {
+        m_remote = new RemoteData();
+    }
+    return m_remote.data();
+}
+
+ResourceItem::StreamData* ResourceItem::stream()
+{
+    if (!m_stream) {
+        m_stream = new StreamData();
+    }
+    return m_stream.data();
+}
+
+ResourceItem::TorrentData* ResourceItem::torrent()
+{
+    if (!m_torrent) {
+        m_torrent = new TorrentData();
+    }
+    return m_torrent.data();
+}
+
 /******************************************************************************
  ******************************************************************************/
 ResourceItem::Type ResourceItem::type() const
@@ -84,12 +149,23 @@ QString ResourceItem::url() const
 
 void ResourceItem::setUrl(const QString &url)
 {
-    m_url = url;
+    if (m_url != url) {
+        m_url = url;
+        m_host = url.isEmpty() ? QString() : intern(QUrl(url).host());
+    }
 }
 
 QUrl ResourceItem::distantFileUrl() const
 {
-    return m_url;
+    return QUrl(m_url);
+}
+
+/*!
+ * \brief Returns the host of the URL, without parsing the URL again.
+ */
+QString ResourceItem::host() const
+{
+    return m_host;
 }
 
 /******************************************************************************
@@ -101,7 +177,7 @@ QString ResourceItem::destination() const
 
 void ResourceItem::setDestination(const QString &destination)
 {
-    m_destination = destination;
+    m_destination = intern(destination);
 }
 
 /******************************************************************************
@@ -113,7 +189,7 @@ QString ResourceItem::mask() const
 
 void ResourceItem::setMask(const QString &mask)
 {
-    m_mask = mask;
+    m_mask = intern(mask);
 }
 
 /******************************************************************************
@@ -162,7 +238,7 @@ QString ResourceItem::referringPage() const
 
 void ResourceItem::setReferringPage(const QString &referringPage)
 {
-    m_referringPage = referringPage;
+    m_referringPage = intern(referringPage);
 }
 
 /******************************************************************************
@@ -205,82 +281,198 @@ void ResourceItem::setCheckSum(const QString &checkSum)
     m_checkSum = checkSum;
 }
 
+/******************************************************************************
+ ******************************************************************************/
+QString ResourceItem::eTag() const
+{
+    return m_remote ? m_remote->eTag : QString();
+}
+
+void ResourceItem::setETag(const QString &eTag)
+{
+    if (m_remote || !eTag.isEmpty()) {
+        remote()->eTag = eTag;
+    }
+}
+
+QString ResourceItem::lastModified() const
+{
+    return m_remote ? m_remote->lastModified : QString();
+}
+
+void ResourceItem::setLastModified(const QString &lastModified)
+{
+    if (m_remote || !lastModified.isEmpty()) {
+        remote()->lastModified = lastModified;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns true if the remote file was probed before the download
+ * started, even if the server didn't tell its size.
+ */
+bool ResourceItem::isProbed() const
+{
+    return m_remote ? m_remote->isProbed : false;
+}
+
+void ResourceItem::setProbed(bool probed)
+{
+    if (m_remote || probed) {
+        remote()->isProbed = probed;
+    }
+}
+
+/*!
+ * \brief Returns the URL of the file, once the redirections are followed.
+ */
+QString ResourceItem::redirectedUrl() const
+{
+    return m_remote ? m_remote->redirectedUrl : QString();
+}
+
+void ResourceItem::setRedirectedUrl(const QString &redirectedUrl)
+{
+    if (m_remote || !redirectedUrl.isEmpty()) {
+        remote()->redirectedUrl = redirectedUrl;
+    }
+}
+
+/*!
+ * \brief Returns the file name suggested by the server, in 'Content-Disposition'.
+ */
+QString ResourceItem::remoteFileName() const
+{
+    return m_remote ? m_remote->remoteFileName : QString();
+}
+
+void ResourceItem::setRemoteFileName(const QString &remoteFileName)
+{
+    if (m_remote || !remoteFileName.isEmpty()) {
+        remote()->remoteFileName = remoteFileName;
+    }
+}
+
+/*!
+ * \brief Returns the size of the remote file, or -1 if unknown.
+ */
+qsizetype ResourceItem::remoteFileSize() const
+{
+    return m_remote ? m_remote->remoteFileSize : -1;
+}
+
+void ResourceItem::setRemoteFileSize(qsizetype remoteFileSize)
+{
+    if (m_remote || remoteFileSize >= 0) {
+        remote()->remoteFileSize = remoteFileSize;
+    }
+}
+
+/*!
+ * \brief Returns true if the server accepts the byte ranges, i.e. if the
+ * file can be split into segments.
+ */
+bool ResourceItem::isRangeSupported() const
+{
+    return m_remote ? m_remote->isRangeSupported : false;
+}
+
+void ResourceItem::setRangeSupported(bool supported)
+{
+    if (m_remote || supported) {
+        remote()->isRangeSupported = supported;
+    }
+}
+
 /******************************************************************************
  ******************************************************************************/
 QString ResourceItem::streamFileName() const
 {
-    return m_streamFileName;
+    return m_stream ? m_stream->fileName : QString();
 }
 
 void ResourceItem::setStreamFileName(const QString &streamFileName)
 {
-    m_streamFileName = streamFileName;
+    if (m_stream || !streamFileName.isEmpty()) {
+        stream()->fileName = streamFileName;
+    }
 }
 
 /******************************************************************************
  ******************************************************************************/
 QString ResourceItem::streamFormatId() const
 {
-    return m_streamFormatId;
+    return m_stream ? m_stream->formatId : QString();
 }
 
 void ResourceItem::setStreamFormatId(const QString &streamFormatId)
 {
-    m_streamFormatId = streamFormatId;
+    if (m_stream || !streamFormatId.isEmpty()) {
+        stream()->formatId = streamFormatId;
+    }
 }
 
 /******************************************************************************
  ******************************************************************************/
 qsizetype ResourceItem::streamFileSize() const
 {
-    return m_streamFileSize;
+    return m_stream ? m_stream->fileSize : 0;
 }
 
 void ResourceItem::setStreamFileSize(qsizetype streamFileSize)
 {
-    m_streamFileSize = streamFileSize;
+    if (m_stream || streamFileSize != 0) {
+        stream()->fileSize = streamFileSize;
+    }
 }
 
 /******************************************************************************
  ******************************************************************************/
 StreamObject::Config ResourceItem::streamConfig() const
 {
-    return m_streamConfig;
+    return m_stream ? m_stream->config : StreamObject::Config();
 }
 
 void ResourceItem::setStreamConfig(const StreamObject::Config &config)
 {
-    m_streamConfig = config;
+    if (m_stream || !(config == StreamObject::Config())) {
+        stream()->config = config;
+    }
 }
 
 /******************************************************************************
  ******************************************************************************/
 QString ResourceItem::torrentPreferredFilePriorities() const
 {
-    return m_torrentPreferredFilePriorities;
+    return m_torrent ? m_torrent->preferredFilePriorities : QString();
 }
 
 void ResourceItem::setTorrentPreferredFilePriorities(const QString &priorities)
 {
-    m_torrentPreferredFilePriorities = priorities;
+    if (m_torrent || !priorities.isEmpty()) {
+        torrent()->preferredFilePriorities = priorities;
+    }
 }
 
 /******************************************************************************
  ******************************************************************************/
 inline QString ResourceItem::localFilePath(const QString &customFileName) const
 {
-    if (QUrl(m_url).scheme() == "magnet") {
+    const QUrl url = distantFileUrl();
+    if (url.scheme() == "magnet") {
         return localMagnetFile(customFileName);
     }
     if (m_type == Type::Stream) {
         return localStreamFile(customFileName);
     }
-    return localFile(m_destination, m_url, customFileName, m_mask);
+    return localFile(m_destination, url, customFileName, m_mask);
 }
 
 inline QString ResourceItem::localStreamFile(const QString &customFileName) const
 {
-    QString url = QUrl(m_url).host() + "/" + m_streamFileName;
+    QString url = m_host + "/" + streamFileName();
     QString fileName = Mask::interpret(url, customFileName, m_mask);
     fileName = FileUtils::validateFileName(fileName, true);
     return QDir(m_destination).filePath(fileName);
@@ -19,6 +19,8 @@
 
 #include <Core/Stream>
 
+#include <QtCore/QSharedData>
+#include <QtCore/QSharedDataPointer>
 #include <QtCore/QString>
 #include <QtCore/QUrl>
 #include <QtCore/QVariant>
@@ -45,6 +47,7 @@ public:
     QString url() const;
     void setUrl(const QString &url);
     QUrl distantFileUrl() const;
+    QString host() const;
 
     /* Destination */
     QString destination() const;
@@ -71,6 +74,29 @@ public:
     QString checkSum() const;
     void setCheckSum(const QString &checkSum);
 
+    /* Validators of the remote file, sent back in 'If-Range' on resume */
+    QString eTag() const;
+    void setETag(const QString &eTag);
+
+    QString lastModified() const;
+    void setLastModified(const QString &lastModified);
+
+    /* Metadata of the remote file, probed before the download starts */
+    bool isProbed() const;
+    void setProbed(bool probed);
+
+    QString redirectedUrl() const;
+    void setRedirectedUrl(const QString &redirectedUrl);
+
+    QString remoteFileName() const;
+    void setRemoteFileName(const QString &remoteFileName);
+
+    qsizetype remoteFileSize() const;
+    void setRemoteFileSize(qsizetype remoteFileSize);
+
+    bool isRangeSupported() const;
+    void setRangeSupported(bool supported);
+
     QString streamFileName() const;
     void setStreamFileName(const QString &streamFileName);
 
@@ -86,28 +112,56 @@ public:
     QString torrentPreferredFilePriorities() const;
     void setTorrentPreferredFilePriorities(const QString &priorities);
 
+    static QString intern(const QString &str);
+
 private:
+    /* Properties of the remote file, known once it's probed or downloaded */
+    struct RemoteData : public QSharedData
+    {
+        QString eTag;
+        QString lastModified;
+        QString redirectedUrl;
+        QString remoteFileName;
+        qsizetype remoteFileSize{-1};
+        bool isRangeSupported{false};
+        bool isProbed{false};
+    };
+
+    /* Stream-specific properties */
+    struct StreamData : public QSharedData
+    {
+        QString fileName;
+        QString formatId;
+        qsizetype fileSize{0};
+        StreamObject::Config config;
+    };
+
+    /* Torrent-specific properties */
+    struct TorrentData : public QSharedData
+    {
+        QString preferredFilePriorities;
+    };
+
     Type m_type{Type::Regular};
-    QString m_url;              // QUrl ?
-    QString m_destination;      // QDir ?
-    QString m_mask;             // Mask ?
-    QString m_customFileName;   // QFileInfo ?
+    QString m_url;
+    QString m_host;                 ///< Interned
+    QString m_destination;          ///< Interned
+    QString m_mask;                 ///< Interned
+    QString m_customFileName;
 
-    QString m_referringPage;
+    QString m_referringPage;        ///< Interned
     QString m_description;
 
-    /* Regular file-specific properties */
     QString m_checkSum;
 
-    /* Stream-specific properties */
-    QString m_streamFileName;
-    QString m_streamFormatId;
-    qsizetype m_streamFileSize{0};
-
-    StreamObject::Config m_streamConfig;
+    /* Allocated only when a property is set */
+    QSharedDataPointer<RemoteData> m_remote;
+    QSharedDataPointer<StreamData> m_stream;
+    QSharedDataPointer<TorrentData> m_torrent;
 
-    /* Torrent-specific properties */
-    QString m_torrentPreferredFilePriorities;
+    RemoteData* remote();
+    StreamData* stream();
+    TorrentData* torrent();
 
     inline QString localFilePath(const QString &customFileName) const;
     inline QString localStreamFile(const QString &customFileName) const;
@@ -0,0 +1,306 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "resourceprober.h"
+
+#include <Core/NetworkManager>
+
+#include <QtCore/QDebug>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkRequest>
+
+constexpr int default_max_probes = 4;
+
+/*!
+ * \class ResourceProber
+ *
+ * The class ResourceProber requests the metadata of the queued files
+ * before their download starts: size, support of the byte ranges,
+ * validators, file name suggested by the server, and URL once the
+ * redirections are followed.
+ *
+ * The probe is a 'Range: bytes=0-0' request, rather than HEAD, because
+ * some servers don't implement HEAD, and because a 206 (Partial Content)
+ * reply proves the range support. The reply is aborted as soon as its
+ * headers are received, so a server that ignores the range doesn't send
+ * the whole file.
+ *
+ * At most maxProbes() requests are sent at the same time, the other items
+ * wait in a queue. A canceled probe stays in the queue, marked stale, and
+ * is skipped when its turn comes, so that cancel() doesn't scan the queue.
+ */
+
+ResourceProber::ResourceProber(NetworkManager *networkManager, QObject *parent) : QObject(parent)
+  , m_networkManager(networkManager)
+  , m_maxProbes(default_max_probes)
+  , m_nextSerial(0)
+{
+}
+
+ResourceProber::~ResourceProber()
+{
+    clear();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+int ResourceProber::maxProbes() const
+{
+    return m_maxProbes;
+}
+
+void ResourceProber::setMaxProbes(int count)
+{
+    m_maxProbes = qMax(1, count);
+    processQueue();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Queues the probe of the file at \a url, for the given \a item.
+ *
+ * The item is only used as a key: it's given back by probed().
+ */
+void ResourceProber::probe(IDownloadItem *item, const QUrl &url, const QString &referer)
+{
+    if (!item || !url.isValid()) {
+        return;
+    }
+    if (m_queuedItems.contains(item) || m_replies.key(item, Q_NULLPTR)) {
+        return;
+    }
+    Probe probe;
+    probe.item = item;
+    probe.serial = m_nextSerial++;
+    probe.url = url;
+    probe.referer = referer;
+    m_queue.append(probe);
+    m_queuedItems.insert(item, probe.serial);
+    processQueue();
+}
+
+/*!
+ * \brief Forgets the given \a item, e.g. when it's removed or started.
+ */
+void ResourceProber::cancel(IDownloadItem *item)
+{
+    if (m_queuedItems.remove(item)) {
+        /* Purges the stale probes once they outnumber the valid ones */
+        if (m_queue.count() > 2 * m_queuedItems.count()) {
+            m_queue.removeIf([this](const Probe &probe) { return isStale(probe); });
+        }
+        return;
+    }
+    auto reply = m_replies.key(item, Q_NULLPTR);
+    if (reply) {
+        release(reply);
+        processQueue();
+    }
+}
+
+void ResourceProber::clear()
+{
+    m_queue.clear();
+    m_queuedItems.clear();
+    const auto replies = m_replies.keys();
+    for (auto reply : replies) {
+        release(reply);
+    }
+}
+
+int ResourceProber::pendingCount() const
+{
+    return m_queuedItems.count() + m_replies.count();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns true if the probe was canceled, or queued again since.
+ */
+bool ResourceProber::isStale(const Probe &probe) const
+{
+    auto it = m_queuedItems.constFind(probe.item);
+    return it == m_queuedItems.constEnd() || it.value() != probe.serial;
+}
+
+void ResourceProber::processQueue()
+{
+    while (m_replies.count() < m_maxProbes && !m_queue.isEmpty()) {
+        const Probe probe = m_queue.takeFirst();
+        if (isStale(probe)) {
+            continue;
+        }
+        m_queuedItems.remove(probe.item);
+        QNetworkReply *reply = m_networkManager->getRange(probe.url, 0, 0, QString(), probe.referer);
+        Q_ASSERT(reply);
+        m_replies.insert(reply, probe.item);
+
+        connect(reply, SIGNAL(metaDataChanged()), this, SLOT(onMetaDataChanged()));
+        connect(reply, SIGNAL(finished()), this, SLOT(onFinished()));
+    }
+}
+
+void ResourceProber::release(QNetworkReply *reply)
+{
+    m_replies.remove(reply);
+    reply->disconnect(this);
+    reply->abort();
+    reply->deleteLater();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void ResourceProber::onMetaDataChanged()
+{
+    auto reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply || !m_replies.contains(reply)) {
+        return;
+    }
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (statusCode >= 300 && statusCode < 400) {
+        return; /* Redirection, followed by the access manager */
+    }
+    if (statusCode == 200 || statusCode == 206) {
+        MetaData metaData;
+        metaData.redirectedUrl = reply->url();
+        metaData.fileName = fileNameFromContentDisposition(reply->rawHeader("Content-Disposition"));
+        if (statusCode == 206) {
+            metaData.size = sizeFromContentRange(reply->rawHeader("Content-Range"));
+            metaData.isRangeSupported = true;
+        } else {
+            const QVariant length = reply->header(QNetworkRequest::ContentLengthHeader);
+            metaData.size = length.isValid() ? length.toLongLong() : -1;
+            metaData.isRangeSupported =
+                    reply->rawHeader("Accept-Ranges").trimmed().toLower() == "bytes";
+        }
+        metaData.eTag = QString::fromLatin1(reply->rawHeader("ETag"));
+        metaData.lastModified = QString::fromLatin1(reply->rawHeader("Last-Modified"));
+
+        emit probed(m_replies.value(reply), metaData);
+    }
+    /* Don't download the content, even if the server ignored the range */
+    release(reply);
+    processQueue();
+}
+
+void ResourceProber::onFinished()
+{
+    auto reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply || !m_replies.contains(reply)) {
+        return;
+    }
+    release(reply);
+    processQueue();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+static QString unquote(const QByteArray &value)
+{
+    if (value.size() < 2 || !value.startsWith('"') || !value.endsWith('"')) {
+        return QString::fromUtf8(value);
+    }
+    QByteArray unescaped;
+    unescaped.reserve(value.size());
+    for (qsizetype i = 1; i < value.size() - 1; ++i) {
+        if (value.at(i) == '\\' && i + 1 < value.size() - 1) {
+            ++i;
+        }
+        unescaped.append(value.at(i));
+    }
+    return QString::fromUtf8(unescaped);
+}
+
+/*!
+ * \brief Returns the file name of the 'Content-Disposition' header, or an
+ * empty string.
+ *
+ * The encoded form 'filename*=UTF-8''...' (RFC 6266) is preferred to the
+ * plain 'filename="..."'. The directories, if any, are removed.
+ */
+QString ResourceProber::fileNameFromContentDisposition(const QByteArray &header)
+{
+    QString fileName;
+    QString encodedFileName;
+
+    /* Split the parameters on ';', except inside the quotes */
+    QList<QByteArray> parameters;
+    QByteArray current;
+    bool quoted = false;
+    for (qsizetype i = 0; i < header.size(); ++i) {
+        const char ch = header.at(i);
+        if (ch == '"') {
+            quoted = !quoted;
+        } else if (ch == '\\' && quoted && i + 1 < header.size()) {
+            current.append(ch);
+            current.append(header.at(++i));
+            continue;
+        } else if (ch == ';' && !quoted) {
+            parameters.append(current);
+            current.clear();
+            continue;
+        }
+        current.append(ch);
+    }
+    parameters.append(current);
+
+    for (const auto &parameter : std::as_const(parameters)) {
+        const qsizetype equal = parameter.indexOf('=');
+        if (equal < 0) {
+            continue;
+        }
+        const QByteArray name = parameter.left(equal).trimmed().toLower();
+        const QByteArray value = parameter.mid(equal + 1).trimmed();
+        if (name == "filename*") {
+            /* charset'language'percent-encoded */
+            const qsizetype first = value.indexOf('\'');
+            const qsizetype second = first < 0 ? -1 : value.indexOf('\'', first + 1);
+            if (second < 0) {
+                continue;
+            }
+            const QByteArray charset = value.left(first).toLower();
+            const QByteArray decoded = QByteArray::fromPercentEncoding(value.mid(second + 1));
+            encodedFileName = charset == "iso-8859-1"
+                    ? QString::fromLatin1(decoded)
+                    : QString::fromUtf8(decoded);
+        } else if (name == "filename") {
+            fileName = unquote(value);
+        }
+    }
+    if (!encodedFileName.isEmpty()) {
+        fileName = encodedFileName;
+    }
+    /* Never trust a path sent by the server */
+    fileName = fileName.mid(qMax(fileName.lastIndexOf('/'), fileName.lastIndexOf('\\')) + 1);
+    return fileName.trimmed();
+}
+
+/*!
+ * \brief Returns the complete length of the 'Content-Range' header,
+ * e.g. 1000 for 'bytes 0-0/1000', or -1 if unknown.
+ */
+qsizetype ResourceProber::sizeFromContentRange(const QByteArray &header)
+{
+    const qsizetype slash = header.lastIndexOf('/');
+    if (slash < 0) {
+        return -1;
+    }
+    bool ok = false;
+    const qsizetype size = header.mid(slash + 1).trimmed().toLongLong(&ok);
+    return ok && size >= 0 ? size : -1;
+}
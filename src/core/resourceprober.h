@@ -0,0 +1,89 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_RESOURCE_PROBER_H
+#define CORE_RESOURCE_PROBER_H
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QUrl>
+
+class IDownloadItem;
+class NetworkManager;
+
+class QNetworkReply;
+
+class ResourceProber : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct MetaData
+    {
+        QUrl redirectedUrl;
+        QString fileName;           ///< From 'Content-Disposition'
+        qsizetype size{-1};         ///< -1 if unknown
+        bool isRangeSupported{false};
+        QString eTag;
+        QString lastModified;
+    };
+
+    explicit ResourceProber(NetworkManager *networkManager, QObject *parent = Q_NULLPTR);
+    ~ResourceProber() Q_DECL_OVERRIDE;
+
+    int maxProbes() const;
+    void setMaxProbes(int count);
+
+    void probe(IDownloadItem *item, const QUrl &url, const QString &referer = QString());
+    void cancel(IDownloadItem *item);
+    void clear();
+
+    int pendingCount() const;
+
+    static QString fileNameFromContentDisposition(const QByteArray &header);
+    static qsizetype sizeFromContentRange(const QByteArray &header);
+
+signals:
+    void probed(IDownloadItem *item, const ResourceProber::MetaData &metaData);
+
+private slots:
+    void onMetaDataChanged();
+    void onFinished();
+
+private:
+    struct Probe
+    {
+        IDownloadItem *item{Q_NULLPTR};
+        quint64 serial{0};
+        QUrl url;
+        QString referer;
+    };
+
+    NetworkManager *m_networkManager;
+    int m_maxProbes;
+    QList<Probe> m_queue;                           ///< Including the canceled probes
+    QHash<IDownloadItem*, quint64> m_queuedItems;   ///< Serial of the valid probe
+    quint64 m_nextSerial;
+    QHash<QNetworkReply*, IDownloadItem*> m_replies;
+
+    bool isStale(const Probe &probe) const;
+    void processQueue();
+    void release(QNetworkReply *reply);
+};
+
+#endif // CORE_RESOURCE_PROBER_H
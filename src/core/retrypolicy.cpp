@@ -0,0 +1,149 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "retrypolicy.h"
+
+#include <QtCore/QRandomGenerator>
+
+/*!
+ * \class RetryPolicy
+ *
+ * The class RetryPolicy decides if a download that failed with a network
+ * error is tried again, and when.
+ *
+ * Only the transient errors are retried: timeouts, connections closed or
+ * refused, proxy failures and server errors (500, 503...). The errors that
+ * would fail again, like 404 or 403, are not.
+ *
+ * The delay doubles at each attempt, from baseDelay() up to maxDelay(),
+ * with a random jitter of up to half the delay, so that the downloads
+ * that failed together don't hit the server again at the same time.
+ */
+
+/******************************************************************************
+ ******************************************************************************/
+int RetryPolicy::maxAttempts() const
+{
+    return m_maxAttempts;
+}
+
+/*!
+ * \brief Sets the number of retries after the first failure, or 0 to never retry.
+ */
+void RetryPolicy::setMaxAttempts(int attempts)
+{
+    m_maxAttempts = qMax(0, attempts);
+}
+
+qint64 RetryPolicy::baseDelay() const
+{
+    return m_baseDelay;
+}
+
+void RetryPolicy::setBaseDelay(qint64 msecs)
+{
+    m_baseDelay = qMax(qint64(0), msecs);
+}
+
+qint64 RetryPolicy::maxDelay() const
+{
+    return m_maxDelay;
+}
+
+void RetryPolicy::setMaxDelay(qint64 msecs)
+{
+    m_maxDelay = qMax(qint64(0), msecs);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns true if the error is likely to disappear by itself.
+ *
+ * See DownloadItem::statusToHttp() for the corresponding HTTP status.
+ */
+bool RetryPolicy::isTransient(QNetworkReply::NetworkError error)
+{
+    switch (error) {
+    // network layer errors
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+
+    /*
+     * The transfer timeout (see QNetworkRequest::setTransferTimeout())
+     * aborts the stalled reply. HttpTransfer disconnects the replies it
+     * aborts itself, so it only gets this error from the timeout.
+     */
+    case QNetworkReply::OperationCanceledError:
+        return true;
+
+    // proxy errors
+    case QNetworkReply::ProxyConnectionRefusedError:
+    case QNetworkReply::ProxyConnectionClosedError:
+    case QNetworkReply::ProxyTimeoutError:
+        return true;
+
+    // protocol errors
+    case QNetworkReply::ProtocolFailure:
+        return true;
+
+    // server side errors (500, 503, 5xx)
+    case QNetworkReply::InternalServerError:
+    case QNetworkReply::ServiceUnavailableError:
+    case QNetworkReply::UnknownServerError:
+        return true;
+
+    default:
+        /*
+         * SSL handshake, redirections, proxy authentication,
+         * content errors (401, 403, 404, 405, 409, 410...), 501...
+         */
+        return false;
+    }
+}
+
+/*!
+ * \brief Returns true if the download must be tried again, after
+ * \a attempt retries already.
+ */
+bool RetryPolicy::shouldRetry(QNetworkReply::NetworkError error, int attempt) const
+{
+    return attempt < m_maxAttempts && isTransient(error);
+}
+
+/*!
+ * \brief Returns the delay before the retry number \a attempt (starting at 0),
+ * in milliseconds.
+ */
+qint64 RetryPolicy::delay(int attempt) const
+{
+    qint64 delay = m_baseDelay;
+    for (int i = 0; i < attempt && delay < m_maxDelay; ++i) {
+        delay *= 2;
+    }
+    delay = qMin(delay, m_maxDelay);
+    const qint64 half = delay / 2;
+    if (half <= 0) {
+        return delay;
+    }
+    return delay - half + QRandomGenerator::global()->bounded(half + 1);
+}
@@ -0,0 +1,47 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_RETRY_POLICY_H
+#define CORE_RETRY_POLICY_H
+
+#include <QtNetwork/QNetworkReply>
+
+class RetryPolicy
+{
+public:
+    RetryPolicy() = default;
+
+    int maxAttempts() const;
+    void setMaxAttempts(int attempts);
+
+    qint64 baseDelay() const;
+    void setBaseDelay(qint64 msecs);
+
+    qint64 maxDelay() const;
+    void setMaxDelay(qint64 msecs);
+
+    static bool isTransient(QNetworkReply::NetworkError error);
+
+    bool shouldRetry(QNetworkReply::NetworkError error, int attempt) const;
+    qint64 delay(int attempt) const;
+
+private:
+    int m_maxAttempts{5};
+    qint64 m_baseDelay{5000};
+    qint64 m_maxDelay{300000};
+};
+
+#endif // CORE_RETRY_POLICY_H
@@ -0,0 +1,430 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scheduler.h"
+
+#include <Core/IDownloadItem>
+
+#include <QtCore/QDebug>
+#include <QtCore/QUrl>
+
+#include <limits>
+
+/*!
+ * \class Scheduler
+ *
+ * The class Scheduler chooses the next Idle item to start, when the
+ * DownloadEngine has a free slot.
+ *
+ * The engine keeps the scheduler informed of the Idle and running items,
+ * so that next() doesn't scan the queue. The Idle items are sorted by the
+ * order of the policy, then by their rank in the queue, and grouped by
+ * host. The running downloads are counted per host and per priority.
+ * So next() costs a lookup per host that has Idle items, whatever the
+ * number of items.
+ *
+ * Each policy reimplements select(), and all of them respect the maximum
+ * number of downloads per host, if any.
+ */
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Starts the items in the order of the queue.
+ */
+class FifoScheduler : public Scheduler
+{
+public:
+    Policy policy() const Q_DECL_OVERRIDE { return Fifo; }
+
+protected:
+    IDownloadItem* select() Q_DECL_OVERRIDE
+    {
+        return firstAvailable(Key(0, std::numeric_limits<qint64>::min()));
+    }
+};
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Starts the item with the fewest bytes to download first.
+ *
+ * The items of unknown size are started last, in the order of the queue.
+ */
+class SmallestFirstScheduler : public Scheduler
+{
+public:
+    Policy policy() const Q_DECL_OVERRIDE { return SmallestFirst; }
+
+protected:
+    qint64 order(const IDownloadItem *item) const Q_DECL_OVERRIDE
+    {
+        return item->bytesTotal() > 0
+                ? item->bytesTotal() - item->bytesReceived()
+                : std::numeric_limits<qint64>::max();
+    }
+
+    IDownloadItem* select() Q_DECL_OVERRIDE
+    {
+        return firstAvailable(Key(std::numeric_limits<qint64>::min(),
+                                  std::numeric_limits<qint64>::min()));
+    }
+};
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Shares the slots between the hosts.
+ *
+ * Starts the first item of the host that has the fewest running downloads.
+ * Between hosts with as many running downloads, the host started the least
+ * recently goes first, then the host of the first item in the queue.
+ */
+class HostRoundRobinScheduler : public Scheduler
+{
+public:
+    Policy policy() const Q_DECL_OVERRIDE { return HostRoundRobin; }
+
+protected:
+    IDownloadItem* select() Q_DECL_OVERRIDE
+    {
+        IDownloadItem *selected = Q_NULLPTR;
+        int selectedRunning = 0;
+        qint64 selectedTurn = 0;
+        Key selectedKey;
+        for (auto it = m_idleByHost.cbegin(); it != m_idleByHost.cend(); ++it) {
+            if (!isHostAvailable(it.key())) {
+                continue;
+            }
+            const int running = m_runningPerHost.value(it.key());
+            const qint64 turn = m_lastTurns.value(it.key(), -1);
+            const Key key = it.value().firstKey();
+            if (!selected || running < selectedRunning
+                    || (running == selectedRunning && turn < selectedTurn)
+                    || (running == selectedRunning && turn == selectedTurn && key < selectedKey)) {
+                selected = it.value().first();
+                selectedRunning = running;
+                selectedTurn = turn;
+                selectedKey = key;
+            }
+        }
+        return selected;
+    }
+
+    void started(const QString &host) Q_DECL_OVERRIDE
+    {
+        m_lastTurns.insert(host, m_turn++);
+    }
+
+private:
+    QHash<QString, qint64> m_lastTurns;
+    qint64 m_turn = 0;
+};
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Shares the slots between the priorities, in proportion to their
+ * weights.
+ *
+ * A High priority item weighs as much as two Normal ones, and four Low
+ * ones: the High priority items get more slots, but the others are never
+ * starved. The items of a given priority are started in the order of the
+ * queue.
+ */
+class WeightedPriorityScheduler : public Scheduler
+{
+public:
+    Policy policy() const Q_DECL_OVERRIDE { return WeightedPriority; }
+
+protected:
+    qint64 order(const IDownloadItem *item) const Q_DECL_OVERRIDE
+    {
+        return item->priority();
+    }
+
+    IDownloadItem* select() Q_DECL_OVERRIDE
+    {
+        /* The priority with the least running downloads per weight goes first */
+        IDownloadItem *selected = Q_NULLPTR;
+        qreal selectedShare = 0;
+        for (int priority = priority_count - 1; priority >= 0; --priority) {
+            auto first = firstAvailable(Key(priority, std::numeric_limits<qint64>::min()));
+            if (!first || first->priority() != priority) {
+                continue; /* None of this priority */
+            }
+            const qreal share = qreal(m_runningPerPriority[priority] + 1) / weight(priority);
+            if (!selected || share < selectedShare) {
+                selected = first;
+                selectedShare = share;
+            }
+        }
+        return selected;
+    }
+
+private:
+    static constexpr int priority_count = IDownloadItem::HighPriority + 1;
+
+    static int weight(int priority)
+    {
+        return 1 << priority; /* Low: 1, Normal: 2, High: 4 */
+    }
+};
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Creates a scheduler with the given policy.
+ */
+Scheduler* Scheduler::create(Policy policy)
+{
+    switch (policy) {
+    case SmallestFirst:     return new SmallestFirstScheduler();
+    case HostRoundRobin:    return new HostRoundRobinScheduler();
+    case WeightedPriority:  return new WeightedPriorityScheduler();
+    case Fifo:
+    case LastPolicy:
+        break;
+    }
+    return new FifoScheduler();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the maximum number of downloads per host, or 0 if unlimited.
+ */
+int Scheduler::maxDownloadsPerHost() const
+{
+    return m_maxDownloadsPerHost;
+}
+
+void Scheduler::setMaxDownloadsPerHost(int count)
+{
+    m_maxDownloadsPerHost = qMax(0, count);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Adds the item that became Idle, with its \a rank in the queue.
+ */
+void Scheduler::addIdle(IDownloadItem *item, qint64 rank)
+{
+    if (m_idleEntries.contains(item)) {
+        removeIdle(item);
+    }
+    IdleEntry entry;
+    entry.host = host(item);
+    entry.key = Key(order(item), rank);
+    m_idle.insert(entry.key, item);
+    m_idleByHost[entry.host].insert(entry.key, item);
+    m_idleEntries.insert(item, entry);
+}
+
+/*!
+ * \brief Sorts the Idle item again, e.g. after its size or its priority
+ * changed.
+ */
+void Scheduler::updateIdle(IDownloadItem *item, qint64 rank)
+{
+    auto it = m_idleEntries.constFind(item);
+    if (it != m_idleEntries.constEnd() && it->key == Key(order(item), rank)) {
+        return;
+    }
+    addIdle(item, rank);
+}
+
+void Scheduler::removeIdle(IDownloadItem *item)
+{
+    auto it = m_idleEntries.find(item);
+    if (it == m_idleEntries.end()) {
+        return;
+    }
+    m_idle.remove(it->key);
+    auto byHost = m_idleByHost.find(it->host);
+    if (byHost != m_idleByHost.end()) {
+        byHost->remove(it->key);
+        if (byHost->isEmpty()) {
+            m_idleByHost.erase(byHost);
+        }
+    }
+    m_idleEntries.erase(it);
+}
+
+/*!
+ * \brief Counts the item that started, until removeRunning().
+ *
+ * The host and the priority are kept, so that the counts stay right if
+ * the item changes meanwhile.
+ */
+void Scheduler::addRunning(IDownloadItem *item)
+{
+    if (m_runningEntries.contains(item)) {
+        return;
+    }
+    RunningEntry entry;
+    entry.host = host(item);
+    entry.priority = qBound(0, static_cast<int>(item->priority()),
+                            static_cast<int>(IDownloadItem::HighPriority));
+    countRunning(entry, 1);
+    m_runningEntries.insert(item, entry);
+    started(entry.host);
+}
+
+void Scheduler::removeRunning(IDownloadItem *item)
+{
+    auto it = m_runningEntries.find(item);
+    if (it == m_runningEntries.end()) {
+        return;
+    }
+    countRunning(*it, -1);
+    m_runningEntries.erase(it);
+}
+
+void Scheduler::countRunning(const RunningEntry &entry, int delta)
+{
+    auto count = m_runningPerHost.find(entry.host);
+    if (count == m_runningPerHost.end()) {
+        count = m_runningPerHost.insert(entry.host, 0);
+    }
+    *count += delta;
+    if (*count <= 0) {
+        m_runningPerHost.erase(count);
+    }
+    m_runningPerPriority[entry.priority] += delta;
+}
+
+void Scheduler::clear()
+{
+    m_idle.clear();
+    m_idleByHost.clear();
+    m_idleEntries.clear();
+    m_runningPerHost.clear();
+    m_runningEntries.clear();
+    for (auto &count : m_runningPerPriority) {
+        count = 0;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the Idle item to start next, or nullptr if none can start,
+ * e.g. because their hosts have too many running downloads.
+ */
+IDownloadItem* Scheduler::next()
+{
+    if (m_idle.isEmpty()) {
+        return Q_NULLPTR;
+    }
+    return select();
+}
+
+/*!
+ * \brief Returns the Idle items that next() would return if they were
+ * started one after the other, up to \a count, without starting them.
+ *
+ * Used to prepare the items that are about to start.
+ */
+QList<IDownloadItem *> Scheduler::candidates(int count)
+{
+    QList<IDownloadItem *> items;
+    QList<QPair<qint64, RunningEntry> > entries;
+    while (items.count() < count) {
+        auto item = next();
+        if (!item) {
+            break;
+        }
+        RunningEntry entry;
+        entry.host = host(item);
+        entry.priority = qBound(0, static_cast<int>(item->priority()),
+                                static_cast<int>(IDownloadItem::HighPriority));
+        entries.append(qMakePair(m_idleEntries.value(item).key.second, entry));
+        items.append(item);
+        removeIdle(item);
+        countRunning(entry, 1);
+    }
+    /* Restores the index, without calling started() */
+    for (int i = 0; i < items.count(); ++i) {
+        countRunning(entries.at(i).second, -1);
+        addIdle(items.at(i), entries.at(i).first);
+    }
+    return items;
+}
+
+/*!
+ * \brief Returns the key of the Idle item in the policy order, before its
+ * rank in the queue. The default is the order of the queue.
+ */
+qint64 Scheduler::order(const IDownloadItem * /*item*/) const
+{
+    return 0;
+}
+
+/*!
+ * \brief Called when an item of the \a host starts.
+ *
+ * The default implementation does nothing.
+ */
+void Scheduler::started(const QString & /*host*/)
+{
+}
+
+/*!
+ * \brief Returns the Idle item of available host with the smallest key
+ * not less than \a from, or nullptr if none.
+ */
+IDownloadItem* Scheduler::firstAvailable(const Key &from) const
+{
+    if (m_maxDownloadsPerHost <= 0) {
+        auto it = m_idle.lowerBound(from);
+        return it != m_idle.cend() ? it.value() : Q_NULLPTR;
+    }
+    IDownloadItem *selected = Q_NULLPTR;
+    Key selectedKey;
+    for (auto it = m_idleByHost.cbegin(); it != m_idleByHost.cend(); ++it) {
+        if (!isHostAvailable(it.key())) {
+            continue;
+        }
+        auto first = it.value().lowerBound(from);
+        if (first != it.value().cend() && (!selected || first.key() < selectedKey)) {
+            selected = first.value();
+            selectedKey = first.key();
+        }
+    }
+    return selected;
+}
+
+/*!
+ * \brief Returns the host of the item, or an empty string if none, e.g.
+ * for a magnet link.
+ */
+QString Scheduler::host(const IDownloadItem *item)
+{
+    return item->sourceUrl().host();
+}
+
+/*!
+ * \brief Returns true if the host can have one more download.
+ */
+bool Scheduler::isHostAvailable(const QString &host) const
+{
+    if (m_maxDownloadsPerHost <= 0) {
+        return true;
+    }
+    return host.isEmpty() || m_runningPerHost.value(host) < m_maxDownloadsPerHost;
+}
@@ -0,0 +1,100 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_SCHEDULER_H
+#define CORE_SCHEDULER_H
+
+#include <Core/IDownloadItem>
+
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMap>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+
+class Scheduler
+{
+public:
+    enum Policy {
+        Fifo = 0,
+        SmallestFirst,
+        HostRoundRobin,
+        WeightedPriority,
+
+        LastPolicy // for safe cast
+    };
+
+    virtual ~Scheduler() = default;
+
+    static Scheduler* create(Policy policy);
+
+    virtual Policy policy() const = 0;
+
+    int maxDownloadsPerHost() const;
+    void setMaxDownloadsPerHost(int count);
+
+    /* Index of the queue, kept up to date by the DownloadEngine */
+    void addIdle(IDownloadItem *item, qint64 rank);
+    void updateIdle(IDownloadItem *item, qint64 rank);
+    void removeIdle(IDownloadItem *item);
+    void addRunning(IDownloadItem *item);
+    void removeRunning(IDownloadItem *item);
+    void clear();
+
+    IDownloadItem* next();
+    QList<IDownloadItem *> candidates(int count);
+
+    static QString host(const IDownloadItem *item);
+
+protected:
+    /* Order of the Idle items: policy order, then rank in the queue */
+    using Key = QPair<qint64, qint64>;
+    using Items = QMap<Key, IDownloadItem *>;
+
+    Scheduler() = default;
+
+    QHash<QString, Items> m_idleByHost; ///< Hosts without Idle item are removed
+    QHash<QString, int> m_runningPerHost;
+    int m_runningPerPriority[IDownloadItem::HighPriority + 1] = {};
+
+    bool isHostAvailable(const QString &host) const;
+    IDownloadItem* firstAvailable(const Key &from) const;
+
+    virtual qint64 order(const IDownloadItem *item) const;
+    virtual IDownloadItem* select() = 0;
+    virtual void started(const QString &host);
+
+private:
+    struct IdleEntry
+    {
+        QString host;
+        Key key;
+    };
+    struct RunningEntry
+    {
+        QString host;
+        int priority{0};
+    };
+
+    int m_maxDownloadsPerHost = 0;
+    Items m_idle;
+    QHash<IDownloadItem *, IdleEntry> m_idleEntries;
+    QHash<IDownloadItem *, RunningEntry> m_runningEntries;
+
+    void countRunning(const RunningEntry &entry, int delta);
+};
+
+#endif // CORE_SCHEDULER_H
@@ -0,0 +1,257 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "segment.h"
+
+#include <QtCore/QDebug>
+#ifdef QT_TESTLIB_LIB
+#  include <QtTest/QTest>
+#endif
+
+#include <algorithm>
+
+/*!
+ * \class Segment
+ *
+ * The class Segment describes a byte range of a remote file, and how much
+ * of it has already been written to the destination.
+ *
+ * The bounds are inclusive, like the HTTP 'Range' header: the segment
+ * [0, 99] contains 100 bytes.
+ */
+
+Segment::Segment(qsizetype begin, qsizetype end, qsizetype received)
+    : m_begin(begin)
+    , m_end(end)
+    , m_received(received)
+{
+}
+
+/******************************************************************************
+ ******************************************************************************/
+qsizetype Segment::begin() const
+{
+    return m_begin;
+}
+
+qsizetype Segment::end() const
+{
+    return m_end;
+}
+
+void Segment::setEnd(qsizetype end)
+{
+    m_end = end;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+qsizetype Segment::received() const
+{
+    return m_received;
+}
+
+void Segment::setReceived(qsizetype received)
+{
+    m_received = received;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the absolute offset in the file of the next byte to write.
+ */
+qsizetype Segment::position() const
+{
+    return m_begin + m_received;
+}
+
+/*!
+ * \brief Returns the size of the range, or -1 if the range is open-ended.
+ */
+qsizetype Segment::size() const
+{
+    return isOpenEnded() ? -1 : m_end - m_begin + 1;
+}
+
+/*!
+ * \brief Returns the number of bytes still to download, or -1 if unknown.
+ */
+qsizetype Segment::remaining() const
+{
+    return isOpenEnded() ? -1 : qMax(qsizetype(0), size() - m_received);
+}
+
+bool Segment::isOpenEnded() const
+{
+    return m_end < 0;
+}
+
+bool Segment::isComplete() const
+{
+    return !isOpenEnded() && m_received >= size();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool Segment::operator==(const Segment &other) const
+{
+    return m_begin == other.m_begin
+            && m_end == other.m_end
+            && m_received == other.m_received;
+}
+
+bool Segment::operator!=(const Segment &other) const
+{
+    return !(*this == other);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QString Segment::toString() const
+{
+    return QString("[%0-%1] %2").arg(
+                QString::number(m_begin),
+                isOpenEnded() ? QLatin1String("?") : QString::number(m_end),
+                QString::number(m_received));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Splits a file of the given size into at most \a count segments of
+ * about the same size.
+ *
+ * No segment is smaller than \a minimumSize, except if the file itself is
+ * smaller. If \a bytesTotal is unknown (i.e. <= 0), returns one open-ended
+ * segment.
+ */
+QList<Segment> Segment::split(qsizetype bytesTotal, int count, qsizetype minimumSize)
+{
+    QList<Segment> segments;
+    if (bytesTotal <= 0) {
+        segments.append(Segment(0, -1));
+        return segments;
+    }
+    qsizetype maximumCount = minimumSize > 0 ? bytesTotal / minimumSize : bytesTotal;
+    maximumCount = qBound(qsizetype(1), maximumCount, qsizetype(count > 0 ? count : 1));
+
+    const qsizetype size = bytesTotal / maximumCount;
+    for (qsizetype i = 0; i < maximumCount; ++i) {
+        const qsizetype begin = i * size;
+        const qsizetype end = (i == maximumCount - 1) ? bytesTotal - 1 : begin + size - 1;
+        segments.append(Segment(begin, end));
+    }
+    return segments;
+}
+
+/*!
+ * \brief Splits the remaining bytes of the given \a segment in two halves.
+ *
+ * The \a segment keeps the first half and \a tail receives the second half.
+ * Returns false if the segment is open-ended or if one half would be
+ * smaller than \a minimumSize.
+ */
+bool Segment::splitRemaining(Segment &segment, Segment &tail, qsizetype minimumSize)
+{
+    const qsizetype remaining = segment.remaining();
+    if (remaining < 0 || remaining < 2 * qMax(qsizetype(1), minimumSize)) {
+        return false;
+    }
+    const qsizetype half = remaining / 2;
+    const qsizetype newEnd = segment.position() + (remaining - half) - 1;
+    tail = Segment(newEnd + 1, segment.end());
+    segment.setEnd(newEnd);
+    return true;
+}
+
+/*!
+ * \brief Returns the number of bytes received without gap from the
+ * beginning of the file.
+ */
+qsizetype Segment::contiguousSize(const QList<Segment> &segments)
+{
+    QList<Segment> sorted = segments;
+    std::sort(sorted.begin(), sorted.end(), [](const Segment &a, const Segment &b) {
+        return a.begin() < b.begin();
+    });
+    qsizetype size = 0;
+    for (const Segment &segment : std::as_const(sorted)) {
+        if (segment.begin() > size) {
+            break;
+        }
+        size = qMax(size, segment.position());
+        if (!segment.isComplete()) {
+            break;
+        }
+    }
+    return size;
+}
+
+/*!
+ * \brief Parses the 'Content-Range' header of a 206 reply, e.g.
+ * 'bytes 100-199/1000', into the \a range [100, 199] and its \a total.
+ *
+ * The \a total is -1 if unknown ('bytes 100-199/*').
+ *
+ * Returns false if the header isn't a valid byte range.
+ */
+bool Segment::fromContentRange(const QByteArray &header, Segment &range, qsizetype &total)
+{
+    const QByteArray value = header.trimmed();
+    if (!value.toLower().startsWith("bytes ")) {
+        return false;
+    }
+    const qsizetype dash = value.indexOf('-');
+    const qsizetype slash = value.indexOf('/');
+    if (dash < 0 || slash < dash) {
+        return false;
+    }
+    bool ok = false;
+    const qsizetype first = value.mid(6, dash - 6).trimmed().toLongLong(&ok);
+    if (!ok || first < 0) {
+        return false;
+    }
+    const qsizetype last = value.mid(dash + 1, slash - dash - 1).trimmed().toLongLong(&ok);
+    if (!ok || last < first) {
+        return false;
+    }
+    const QByteArray size = value.mid(slash + 1).trimmed();
+    if (size == "*") {
+        total = -1;
+    } else {
+        total = size.toLongLong(&ok);
+        if (!ok || total <= last) {
+            return false;
+        }
+    }
+    range = Segment(first, last);
+    return true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+#ifdef QT_TESTLIB_LIB
+/// This function is used by QCOMPARE() to output verbose information in case of a test failure.
+char *toString(const Segment &segment)
+{
+    // bring QTest::toString overloads into scope:
+    using QTest::toString;
+
+    // delegate char* handling to QTest::toString(QByteArray):
+    return toString(segment.toString());
+}
+#endif
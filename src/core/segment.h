@@ -0,0 +1,71 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_SEGMENT_H
+#define CORE_SEGMENT_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+/*!
+ * A Segment is a byte range [begin, end] of the remote file, downloaded
+ * through its own connection. An end of -1 means the range is open-ended
+ * (i.e. the size of the file is still unknown).
+ */
+class Segment
+{
+public:
+    Segment() = default;
+    Segment(qsizetype begin, qsizetype end, qsizetype received = 0);
+
+    qsizetype begin() const;
+    qsizetype end() const;
+    void setEnd(qsizetype end);
+
+    qsizetype received() const;
+    void setReceived(qsizetype received);
+
+    qsizetype position() const;
+    qsizetype size() const;
+    qsizetype remaining() const;
+
+    bool isOpenEnded() const;
+    bool isComplete() const;
+
+    bool operator==(const Segment &other) const;
+    bool operator!=(const Segment &other) const;
+
+    QString toString() const;
+
+    static QList<Segment> split(qsizetype bytesTotal, int count, qsizetype minimumSize);
+    static bool splitRemaining(Segment &segment, Segment &tail, qsizetype minimumSize);
+    static qsizetype contiguousSize(const QList<Segment> &segments);
+    static bool fromContentRange(const QByteArray &header, Segment &range, qsizetype &total);
+
+private:
+    qsizetype m_begin{0};
+    qsizetype m_end{-1};
+    qsizetype m_received{0};
+};
+
+Q_DECLARE_TYPEINFO(Segment, Q_PRIMITIVE_TYPE);
+
+#ifdef QT_TESTLIB_LIB
+char *toString(const Segment &segment);
+#endif
+
+#endif // CORE_SEGMENT_H
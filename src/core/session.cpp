@@ -21,13 +21,16 @@
 #include <Core/DownloadStreamItem>
 #include <Core/DownloadTorrentItem>
 #include <Core/ResourceItem>
+#include <Core/SessionJournal>
 
 #include <QtCore/QDebug>
 #include <QtCore/QByteArray>
+#include <QtCore/QCborArray>
+#include <QtCore/QCborMap>
+#include <QtCore/QCborStreamReader>
+#include <QtCore/QCborValue>
 #include <QtCore/QFile>
-#include <QtCore/QJsonArray>
-#include <QtCore/QJsonDocument>
-#include <QtCore/QJsonObject>
+#include <QtCore/QSet>
 
 static inline IDownloadItem::State intToState(int value)
 {
@@ -50,238 +53,429 @@ static inline int stateToInt(IDownloadItem::State state)
     }
 }
 
-static inline StreamObject::Config readStreamConfig(const QJsonObject &json)
+/*!
+ * \brief Returns true if the item was queued, downloading or waiting to be
+ * retried.
+ *
+ * Such items are stored as paused, but they are resumed at startup.
+ */
+static inline bool isRunning(const DownloadItem *item)
+{
+    return item->state() == IDownloadItem::Idle || item->isDownloading()
+            || item->isRetryPending();
+}
+
+static inline QList<Segment> readSegments(const QCborArray &json)
+{
+    QList<Segment> segments;
+    foreach (auto value, json) {
+        auto j = value.toMap();
+        segments.append(Segment(static_cast<qsizetype>(j[QLatin1String("begin")].toInteger()),
+                                static_cast<qsizetype>(j[QLatin1String("end")].toInteger()),
+                                static_cast<qsizetype>(j[QLatin1String("received")].toInteger())));
+    }
+    return segments;
+}
+
+static inline QCborArray writeSegments(const QList<Segment> &segments)
+{
+    QCborArray json;
+    foreach (auto segment, segments) {
+        QCborMap j;
+        j[QLatin1String("begin")] = segment.begin();
+        j[QLatin1String("end")] = segment.end();
+        j[QLatin1String("received")] = segment.received();
+        json.append(j);
+    }
+    return json;
+}
+
+static inline StreamObject::Config readStreamConfig(const QCborMap &json)
 {
     StreamObject::Config config;
     {
-        auto j = json["overview"].toObject();
-        config.overview.skipVideo = j["skipVideo"].toBool();
-        config.overview.markWatched = j["markWatched"].toBool();
+        auto j = json[QLatin1String("overview")].toMap();
+        config.overview.skipVideo = j[QLatin1String("skipVideo")].toBool();
+        config.overview.markWatched = j[QLatin1String("markWatched")].toBool();
     }
     {
-        auto j = json["subtitle"].toObject();
-        config.subtitle.writeSubtitle = j["writeSubtitle"].toBool();
-        config.subtitle.isAutoGenerated = j["isAutoGenerated"].toBool();
-        config.subtitle.extensions = j["extensions"].toString();
-        config.subtitle.languages = j["languages"].toString();
-        config.subtitle.convert = j["convert"].toString();
+        auto j = json[QLatin1String("subtitle")].toMap();
+        config.subtitle.writeSubtitle = j[QLatin1String("writeSubtitle")].toBool();
+        config.subtitle.isAutoGenerated = j[QLatin1String("isAutoGenerated")].toBool();
+        config.subtitle.extensions = j[QLatin1String("extensions")].toString();
+        config.subtitle.languages = j[QLatin1String("languages")].toString();
+        config.subtitle.convert = j[QLatin1String("convert")].toString();
     }
     {
-        auto j = json["chapter"].toObject();
-        config.chapter.writeChapters = j["writeChapters"].toBool();
+        auto j = json[QLatin1String("chapter")].toMap();
+        config.chapter.writeChapters = j[QLatin1String("writeChapters")].toBool();
     }
     {
-        auto j = json["thumbnail"].toObject();
-        config.thumbnail.writeDefaultThumbnail = j["writeDefaultThumbnail"].toBool();
+        auto j = json[QLatin1String("thumbnail")].toMap();
+        config.thumbnail.writeDefaultThumbnail = j[QLatin1String("writeDefaultThumbnail")].toBool();
     }
     {
-        auto j = json["comment"].toObject();
-        config.comment.writeComment = j["writeComment"].toBool();
+        auto j = json[QLatin1String("comment")].toMap();
+        config.comment.writeComment = j[QLatin1String("writeComment")].toBool();
     }
     {
-        auto j = json["metadata"].toObject();
-        config.metadata.writeDescription = j["writeDescription"].toBool();
-        config.metadata.writeMetadata = j["writeMetadata"].toBool();
-        config.metadata.writeInternetShortcut = j["writeInternetShortcut"].toBool();
+        auto j = json[QLatin1String("metadata")].toMap();
+        config.metadata.writeDescription = j[QLatin1String("writeDescription")].toBool();
+        config.metadata.writeMetadata = j[QLatin1String("writeMetadata")].toBool();
+        config.metadata.writeInternetShortcut = j[QLatin1String("writeInternetShortcut")].toBool();
     }
     {
-        auto j = json["processing"].toObject();
+        auto j = json[QLatin1String("processing")].toMap();
     }
     {
-        auto j = json["sponsor"].toObject();
+        auto j = json[QLatin1String("sponsor")].toMap();
     }
     return config;
 }
 
-static inline QJsonObject writeStreamConfig(const StreamObject::Config &config)
+static inline QCborMap writeStreamConfig(const StreamObject::Config &config)
 {
-    QJsonObject json;
+    QCborMap json;
     {
-        QJsonObject j;
-        j["skipVideo"] = config.overview.skipVideo;
-        j["markWatched"] = config.overview.markWatched;
-        json["overview"] = j;
+        QCborMap j;
+        j[QLatin1String("skipVideo")] = config.overview.skipVideo;
+        j[QLatin1String("markWatched")] = config.overview.markWatched;
+        json[QLatin1String("overview")] = j;
     }
     {
-        QJsonObject j;
-        j["writeSubtitle"] = config.subtitle.writeSubtitle;
-        j["isAutoGenerated"] = config.subtitle.isAutoGenerated;
-        j["extensions"] = config.subtitle.extensions;
-        j["languages"] = config.subtitle.languages;
-        j["convert"] = config.subtitle.convert;
-        json["subtitle"] = j;
+        QCborMap j;
+        j[QLatin1String("writeSubtitle")] = config.subtitle.writeSubtitle;
+        j[QLatin1String("isAutoGenerated")] = config.subtitle.isAutoGenerated;
+        j[QLatin1String("extensions")] = config.subtitle.extensions;
+        j[QLatin1String("languages")] = config.subtitle.languages;
+        j[QLatin1String("convert")] = config.subtitle.convert;
+        json[QLatin1String("subtitle")] = j;
     }
     {
-        QJsonObject j;
-        j["writeChapters"] = config.chapter.writeChapters;
-        json["chapter"] = j;
+        QCborMap j;
+        j[QLatin1String("writeChapters")] = config.chapter.writeChapters;
+        json[QLatin1String("chapter")] = j;
     }
     {
-        QJsonObject j;
-        j["writeDefaultThumbnail"] = config.thumbnail.writeDefaultThumbnail;
-        json["thumbnail"] = j;
+        QCborMap j;
+        j[QLatin1String("writeDefaultThumbnail")] = config.thumbnail.writeDefaultThumbnail;
+        json[QLatin1String("thumbnail")] = j;
     }
     {
-        QJsonObject j;
-        j["writeComment"] = config.comment.writeComment;
-        json["comment"] = j;
+        QCborMap j;
+        j[QLatin1String("writeComment")] = config.comment.writeComment;
+        json[QLatin1String("comment")] = j;
     }
     {
-        QJsonObject j;
-        j["writeDescription"] = config.metadata.writeDescription;
-        j["writeMetadata"] = config.metadata.writeMetadata;
-        j["writeInternetShortcut"] = config.metadata.writeInternetShortcut;
-        json["metadata"] = j;
+        QCborMap j;
+        j[QLatin1String("writeDescription")] = config.metadata.writeDescription;
+        j[QLatin1String("writeMetadata")] = config.metadata.writeMetadata;
+        j[QLatin1String("writeInternetShortcut")] = config.metadata.writeInternetShortcut;
+        json[QLatin1String("metadata")] = j;
     }
     return json;
 }
 
-static inline DownloadItem* readJob(const QJsonObject &json, DownloadManager *downloadManager)
+static inline ResourceItem* readResource(const QCborMap &json)
 {
     auto resourceItem = new ResourceItem();
 
-    resourceItem->setType(ResourceItem::fromString(json["type"].toString()));
+    resourceItem->setType(ResourceItem::fromString(json[QLatin1String("type")].toString()));
 
     /// \deprecated since 2.0.8
-    if (json.contains("streamEnabled")) {
+    if (json.contains(QLatin1String("streamEnabled"))) {
         qWarning("Deprecated tag in session file: 'streamEnabled'. Use tag 'type' instead.");
-        if (json["streamEnabled"].toBool()) {
+        if (json[QLatin1String("streamEnabled")].toBool()) {
             resourceItem->setType(ResourceItem::Type::Stream);
         }
     }
     /// \deprecated since 2.0.8
-    if (json.contains("torrentEnabled")) {
+    if (json.contains(QLatin1String("torrentEnabled"))) {
         qWarning("Deprecated tag in session file: 'torrentEnabled'. Use tag 'type' instead.");
-        if (json["torrentEnabled"].toBool()) {
+        if (json[QLatin1String("torrentEnabled")].toBool()) {
             resourceItem->setType(ResourceItem::Type::Torrent);
         }
     }
 
-    resourceItem->setUrl(json["url"].toString());
-    resourceItem->setDestination(json["destination"].toString());
-    resourceItem->setMask(json["mask"].toString());
-    resourceItem->setCustomFileName(json["customFileName"].toString());
-    resourceItem->setReferringPage(json["referringPage"].toString());
-    resourceItem->setDescription(json["description"].toString());
-    resourceItem->setCheckSum(json["checkSum"].toString());
-
-    resourceItem->setStreamFileName(json["streamFileName"].toString());
-    resourceItem->setStreamFormatId(json["streamFormatId"].toString());
-    resourceItem->setStreamFileSize(static_cast<qsizetype>(json["streamFileSize"].toInteger()));
-
-    auto config = readStreamConfig(json["streamConfig"].toObject());
-    resourceItem->setStreamConfig(config);
-
-    resourceItem->setTorrentPreferredFilePriorities(json["torrentPreferredFilePriorities"].toString());
+    resourceItem->setUrl(json[QLatin1String("url")].toString());
+    resourceItem->setDestination(json[QLatin1String("destination")].toString());
+    resourceItem->setMask(json[QLatin1String("mask")].toString());
+    resourceItem->setCustomFileName(json[QLatin1String("customFileName")].toString());
+    resourceItem->setReferringPage(json[QLatin1String("referringPage")].toString());
+    resourceItem->setDescription(json[QLatin1String("description")].toString());
+    resourceItem->setCheckSum(json[QLatin1String("checkSum")].toString());
+    resourceItem->setETag(json[QLatin1String("eTag")].toString());
+    resourceItem->setLastModified(json[QLatin1String("lastModified")].toString());
+    resourceItem->setRedirectedUrl(json[QLatin1String("redirectedUrl")].toString());
+    resourceItem->setRemoteFileName(json[QLatin1String("remoteFileName")].toString());
+    resourceItem->setRemoteFileSize(static_cast<qsizetype>(json[QLatin1String("remoteFileSize")].toInteger(-1)));
+    resourceItem->setRangeSupported(json[QLatin1String("rangeSupported")].toBool());
+    /* The jobs of the previous versions are probed if their size is known */
+    resourceItem->setProbed(json[QLatin1String("probed")].toBool(resourceItem->remoteFileSize() >= 0));
+
+    /* The properties of the other types aren't stored */
+    if (resourceItem->type() == ResourceItem::Type::Stream) {
+        resourceItem->setStreamFileName(json[QLatin1String("streamFileName")].toString());
+        resourceItem->setStreamFormatId(json[QLatin1String("streamFormatId")].toString());
+        resourceItem->setStreamFileSize(static_cast<qsizetype>(json[QLatin1String("streamFileSize")].toInteger()));
+
+        auto config = readStreamConfig(json[QLatin1String("streamConfig")].toMap());
+        resourceItem->setStreamConfig(config);
+    }
+    if (resourceItem->type() == ResourceItem::Type::Torrent) {
+        resourceItem->setTorrentPreferredFilePriorities(json[QLatin1String("torrentPreferredFilePriorities")].toString());
+    }
+    return resourceItem;
+}
 
-    DownloadItem *item;
-    switch (resourceItem->type()) {
+static inline DownloadItem* createItem(ResourceItem::Type type, DownloadManager *downloadManager)
+{
+    switch (type) {
     case ResourceItem::Type::Stream:
-        item = new DownloadStreamItem(downloadManager);
-        break;
+        return new DownloadStreamItem(downloadManager);
     case ResourceItem::Type::Torrent:
-        item = new DownloadTorrentItem(downloadManager);
-        break;
+        return new DownloadTorrentItem(downloadManager);
     default:
-        item = new DownloadItem(downloadManager);
-        break;
+        return new DownloadItem(downloadManager);
     }
-    item->setResource(resourceItem);
+}
 
-    item->setState(intToState(json["state"].toInt()));
-    item->setBytesReceived(static_cast<qsizetype>(json["bytesReceived"].toInteger()));
-    item->setBytesTotal(static_cast<qsizetype>(json["bytesTotal"].toInteger()));
-    item->setMaxConnectionSegments(json["maxConnectionSegments"].toInt());
-    item->setMaxConnections(json["maxConnections"].toInt());
-    item->setLog(json["log"].toString());
+static inline void readState(const QCborMap &json, DownloadItem *item)
+{
+    /* Idle means queued: the item continues where it stopped */
+    item->setState(json[QLatin1String("running")].toBool()
+                   ? IDownloadItem::Idle
+                   : intToState(static_cast<int>(json[QLatin1String("state")].toInteger())));
+    item->setBytesReceived(static_cast<qsizetype>(json[QLatin1String("bytesReceived")].toInteger()));
+    item->setBytesTotal(static_cast<qsizetype>(json[QLatin1String("bytesTotal")].toInteger()));
+    item->setMaxConnectionSegments(static_cast<int>(json[QLatin1String("maxConnectionSegments")].toInteger()));
+    item->setMaxConnections(static_cast<int>(json[QLatin1String("maxConnections")].toInteger()));
+    item->setPriority(static_cast<IDownloadItem::Priority>(
+                          json[QLatin1String("priority")].toInteger(IDownloadItem::NormalPriority)));
+}
 
+static inline void readPartial(const QCborMap &json, DownloadItem *item)
+{
+    item->setSegments(readSegments(json[QLatin1String("segments")].toArray()));
+    item->setPartialFileName(json[QLatin1String("partialFileName")].toString());
+}
+
+static inline DownloadItem* readJob(const QCborMap &json, DownloadManager *downloadManager)
+{
+    auto resourceItem = readResource(json);
+    auto item = createItem(resourceItem->type(), downloadManager);
+    item->setResource(resourceItem);
+    readState(json, item);
+    readPartial(json, item);
     return item;
 }
 
-static inline void writeJob(const DownloadItem *item, QJsonObject &json)
+/*
+ * The fields shown in the queue, and needed to schedule the job. They're
+ * stored in the job, so that the job isn't decoded until it's used.
+ */
+static inline void writeState(const DownloadItem *item, QCborMap &json)
 {
-    json["type"] = ResourceItem::toString(item->resource()->type());
-    json["url"] = item->resource()->url();
-    json["destination"] = item->resource()->destination();
-    json["mask"] = item->resource()->mask();
-    json["customFileName"] = item->resource()->customFileName();
-    json["referringPage"] = item->resource()->referringPage();
-    json["description"] = item->resource()->description();
-    json["checkSum"] = item->resource()->checkSum();
-
-    json["streamFileName"] = item->resource()->streamFileName();
-    json["streamFormatId"] = item->resource()->streamFormatId();
-    json["streamFileSize"] = static_cast<qsizetype>(item->resource()->streamFileSize());
-
-    auto config = item->resource()->streamConfig();
-    json["streamConfig"] = writeStreamConfig(config);
-
-    json["torrentPreferredFilePriorities"] = item->resource()->torrentPreferredFilePriorities();
-
-    json["state"] = stateToInt(item->state());
-    json["bytesReceived"] = static_cast<qsizetype>(item->bytesReceived());
-    json["bytesTotal"] = static_cast<qsizetype>(item->bytesTotal());
-    json["maxConnectionSegments"] = item->maxConnectionSegments();
-    json["maxConnections"] = item->maxConnections();
-    json["log"] = item->log();
+    json[QLatin1String("fileName")] = item->localFileName();
+    json[QLatin1String("state")] = stateToInt(item->state());
+    json[QLatin1String("bytesReceived")] = static_cast<qsizetype>(item->bytesReceived());
+    json[QLatin1String("bytesTotal")] = static_cast<qsizetype>(item->bytesTotal());
+    json[QLatin1String("maxConnectionSegments")] = item->maxConnectionSegments();
+    json[QLatin1String("maxConnections")] = item->maxConnections();
+    json[QLatin1String("priority")] = static_cast<int>(item->priority());
 }
 
-/******************************************************************************
- ******************************************************************************/
-static inline void readList(QList<DownloadItem *> &downloadItems, const QJsonObject &json, DownloadManager *downloadManager)
+static inline void writeJob(const DownloadItem *item, QCborMap &json)
 {
-    QJsonArray jobs = json["jobs"].toArray();
-    foreach (auto job, jobs) {
-        QJsonObject jobObject = job.toObject();
-        auto item = readJob(jobObject, downloadManager);
-        downloadItems.append(item);
+    json[QLatin1String("type")] = ResourceItem::toString(item->resource()->type());
+    json[QLatin1String("url")] = item->resource()->url();
+    json[QLatin1String("destination")] = item->resource()->destination();
+    json[QLatin1String("mask")] = item->resource()->mask();
+    json[QLatin1String("customFileName")] = item->resource()->customFileName();
+    json[QLatin1String("referringPage")] = item->resource()->referringPage();
+    json[QLatin1String("description")] = item->resource()->description();
+    json[QLatin1String("checkSum")] = item->resource()->checkSum();
+    json[QLatin1String("eTag")] = item->resource()->eTag();
+    json[QLatin1String("lastModified")] = item->resource()->lastModified();
+    json[QLatin1String("redirectedUrl")] = item->resource()->redirectedUrl();
+    json[QLatin1String("remoteFileName")] = item->resource()->remoteFileName();
+    json[QLatin1String("remoteFileSize")] = static_cast<qsizetype>(item->resource()->remoteFileSize());
+    json[QLatin1String("rangeSupported")] = item->resource()->isRangeSupported();
+    json[QLatin1String("probed")] = item->resource()->isProbed();
+
+    if (item->resource()->type() == ResourceItem::Type::Stream) {
+        json[QLatin1String("streamFileName")] = item->resource()->streamFileName();
+        json[QLatin1String("streamFormatId")] = item->resource()->streamFormatId();
+        json[QLatin1String("streamFileSize")] = static_cast<qsizetype>(item->resource()->streamFileSize());
+
+        auto config = item->resource()->streamConfig();
+        json[QLatin1String("streamConfig")] = writeStreamConfig(config);
+    }
+    if (item->resource()->type() == ResourceItem::Type::Torrent) {
+        json[QLatin1String("torrentPreferredFilePriorities")] = item->resource()->torrentPreferredFilePriorities();
+    }
+
+    writeState(item, json);
+
+    const QList<Segment> segments = item->segments();
+    if (!segments.isEmpty() && item->bytesReceived() > 0) {
+        json[QLatin1String("running")] = isRunning(item);
+        json[QLatin1String("partialFileName")] = item->partialFileName();
+        json[QLatin1String("segments")] = writeSegments(segments);
     }
 }
 
-static inline void writeList(const QList<DownloadItem *> &downloadItems, QJsonObject &json)
+/*!
+ * \brief Returns the fields of the job read by readState(), and its type,
+ * url, file name, referring page and probe result, without decoding the
+ * other fields.
+ */
+static QCborMap readSummary(const QByteArray &job)
 {
-    QJsonArray jobs;
-    foreach (auto item, downloadItems) {
-        QJsonObject jobObject;
-        writeJob(item, jobObject);
-        jobs.append(jobObject);
+    static const QSet<QString> keys = {
+        QLatin1String("type"), QLatin1String("url"), QLatin1String("fileName"),
+        QLatin1String("referringPage"), QLatin1String("probed"), QLatin1String("remoteFileSize"),
+        QLatin1String("running"), QLatin1String("state"),
+        QLatin1String("bytesReceived"), QLatin1String("bytesTotal"),
+        QLatin1String("maxConnectionSegments"), QLatin1String("maxConnections"),
+        QLatin1String("priority")
+    };
+    QCborMap summary;
+    QCborStreamReader reader(job);
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return summary;
     }
-    json["jobs"] = jobs;
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        const QString key = QCborValue::fromCbor(reader).toString();
+        if (keys.contains(key)) {
+            summary[key] = QCborValue::fromCbor(reader);
+        } else {
+            reader.next();
+        }
+    }
+    return summary;
 }
 
+/*!
+ * \brief Returns true if the job can wait to be decoded.
+ *
+ * The running jobs are resumed at startup. The torrents are added to the
+ * torrent session at startup. The jobs written by the previous versions
+ * have no file name to show.
+ */
+static inline bool isLazy(const QCborMap &summary)
+{
+    return summary.contains(QLatin1String("fileName"))
+            && !summary[QLatin1String("running")].toBool()
+            && ResourceItem::fromString(summary[QLatin1String("type")].toString())
+            != ResourceItem::Type::Torrent;
+}
 
 /******************************************************************************
  ******************************************************************************/
-void Session::read(QList<DownloadItem *> &downloadItems, const QString &filename, DownloadManager *downloadManager)
+/*!
+ * \brief Reads the session, and the journal of the changes saved after it.
+ *
+ * If \a ids isn't null, it receives the id of each item in the journal.
+ *
+ * Only the fields shown in the queue are decoded: the other fields of a
+ * completed, paused or stopped job are decoded when the job is used.
+ * If \a isOutdated isn't null, it's set to true if jobs were written by
+ * a previous version, without these fields.
+ */
+void Session::read(QList<DownloadItem *> &downloadItems, const QString &filename,
+                   DownloadManager *downloadManager, QList<qint64> *ids, bool *isOutdated)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qWarning("Couldn't open file.");
-        return;
+    if (isOutdated) {
+        *isOutdated = false;
     }
-    QByteArray saveData = file.readAll();
-    QJsonParseError ok = {};
-    QJsonDocument loadDoc( QJsonDocument::fromJson(saveData, &ok) );
-
-    if (ok.error != QJsonParseError::NoError) {
-        qCritical("Couldn't parse JSON file.");
+    bool ok = false;
+    const QList<SessionJournal::Job> jobs = SessionJournal::read(filename, &ok);
+    if (!ok) {
         return;
     }
+    downloadItems.reserve(jobs.count());
+    for (const auto &job : jobs) {
+        const QCborMap summary = readSummary(job.data);
+        DownloadItem *item;
+        if (isLazy(summary)) {
+            const auto type = ResourceItem::fromString(summary[QLatin1String("type")].toString());
+            item = createItem(type, downloadManager);
+            readState(summary, item);
+
+            DownloadItem::RecordSummary recordSummary;
+            recordSummary.url = summary[QLatin1String("url")].toString();
+            recordSummary.fileName = summary[QLatin1String("fileName")].toString();
+            recordSummary.referringPage = summary[QLatin1String("referringPage")].toString();
+            recordSummary.isRegular = type == ResourceItem::Type::Regular;
+            recordSummary.isProbed = summary[QLatin1String("probed")].toBool(
+                        summary[QLatin1String("remoteFileSize")].toInteger(-1) >= 0);
+            item->setRecord(job.data, recordSummary);
+        } else {
+            item = readJob(QCborValue::fromCbor(job.data).toMap(), downloadManager);
+            if (isOutdated && !summary.contains(QLatin1String("fileName"))) {
+                *isOutdated = true;
+            }
+        }
+        downloadItems.append(item);
+        if (ids) {
+            ids->append(job.id);
+        }
+    }
+}
 
-    readList(downloadItems, loadDoc.object(), downloadManager);
+/*!
+ * \brief Decodes the \a job that the given item kept to be decoded on first
+ * use, see DownloadItem::setRecord().
+ */
+void Session::load(DownloadItem *downloadItem, const QByteArray &job)
+{
+    const QCborMap json = QCborValue::fromCbor(job).toMap();
+    downloadItem->setResource(readResource(json));
+    readPartial(json, downloadItem);
 }
 
+/*!
+ * \brief Writes the session.
+ *
+ * The file is replaced atomically, so that a crash during the write
+ * doesn't corrupt the previous session.
+ */
 void Session::write(const QList<DownloadItem *> &downloadItems, const QString &filename)
 {
-    QFile file(filename);
+    QList<SessionJournal::Job> jobs;
+    jobs.reserve(downloadItems.count());
+    for (qsizetype i = 0; i < downloadItems.count(); ++i) {
+        jobs.append({i, encodeJob(downloadItems.at(i), i)});
+    }
+    if (SessionJournal::writeSnapshot(jobs, filename)) {
+        QFile::remove(SessionJournal::journalFileName(filename));
+    }
+}
 
-    if (!file.open(QIODevice::WriteOnly)) {
-        qWarning("Couldn't open save file.");
-        return;
+/*!
+ * \brief Returns the job encoded in CBOR, identified by the given id, to be
+ * referenced by the records of the journal.
+ */
+QByteArray Session::encodeJob(const DownloadItem *downloadItem, qint64 id)
+{
+    if (!downloadItem->isLoaded()) {
+        /* Only the fields shown in the queue can have changed */
+        QCborMap json = QCborValue::fromCbor(downloadItem->record()).toMap();
+        json[QLatin1String("id")] = id;
+        writeState(downloadItem, json);
+        return QCborValue(json).toCbor();
     }
+    QCborMap json;
+    json[QLatin1String("id")] = id;
+    writeJob(downloadItem, json);
+    return QCborValue(json).toCbor();
+}
 
-    QJsonObject json;
-    writeList(downloadItems, json);
-    QJsonDocument saveDoc(json);
-    file.write( saveDoc.toJson() );
+/*!
+ * \brief Returns the journal record of the job.
+ */
+QByteArray Session::putRecord(const DownloadItem *downloadItem, qint64 id)
+{
+    return SessionJournal::putRecord(id, encodeJob(downloadItem, id));
 }
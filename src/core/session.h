@@ -17,6 +17,7 @@
 #ifndef CORE_SESSION_H
 #define CORE_SESSION_H
 
+#include <QtCore/QByteArray>
 #include <QtCore/QList>
 #include <QtCore/QString>
 
@@ -28,9 +29,16 @@ class Session
 public:
     Session() = default;
 
-    static void read(QList<DownloadItem *> &downloadItems, const QString &filename, DownloadManager *downloadManager);
+    static void read(QList<DownloadItem *> &downloadItems, const QString &filename,
+                     DownloadManager *downloadManager, QList<qint64> *ids = Q_NULLPTR,
+                     bool *isOutdated = Q_NULLPTR);
+    static void load(DownloadItem *downloadItem, const QByteArray &job);
     static void write(const QList<DownloadItem *> &downloadItems, const QString &filename);
 
+    /* Incremental save, see SessionJournal */
+    static QByteArray encodeJob(const DownloadItem *downloadItem, qint64 id);
+    static QByteArray putRecord(const DownloadItem *downloadItem, qint64 id);
+
 };
 
 #endif // CORE_SESSION_H
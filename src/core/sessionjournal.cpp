@@ -0,0 +1,722 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "sessionjournal.h"
+
+#include <QtCore/QCborMap>
+#include <QtCore/QCborStreamReader>
+#include <QtCore/QCborValue>
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonParseError>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+
+static const QString s_journal_suffix = QLatin1String(".journal");
+
+/* CBOR self-described tag (RFC 8949), that starts the binary snapshots */
+static const QByteArray s_cbor_signature = QByteArrayLiteral("\xd9\xd9\xf7");
+
+constexpr int snapshot_version = 2; ///< 1 was the JSON session
+
+constexpr quint8 cbor_array = 4; ///< Major types of CBOR
+constexpr quint8 cbor_map = 5;
+
+/*!
+ * \class SessionJournal
+ *
+ * The class SessionJournal saves the queue incrementally.
+ *
+ * The session file is a snapshot of the whole queue, in CBOR (a binary
+ * JSON). The JSON sessions of the previous versions are still read, and
+ * converted by the next snapshot. Between two snapshots, the changes are
+ * appended to a journal, next to the session file: one CBOR record per
+ * change, either the new content of a job ("put"), its removal ("remove"),
+ * or the new order of the jobs ("order"). The jobs are identified by the
+ * "id" stored in the snapshot.
+ *
+ * When the journal grows too much, it's compacted: the previous snapshot
+ * and the journal are merged into a new snapshot, that replaces the
+ * session file atomically, then the journal is removed. The merge runs
+ * in the background, so the caller only encodes the jobs that changed.
+ *
+ * If the application crashes between the snapshot and the removal, the
+ * journal is replayed on the new snapshot, that already contains its
+ * changes. A crash can also cut the last record of the journal: the
+ * replay stops there, and the record is removed before the next ones
+ * are appended.
+ *
+ * The files are written in a dedicated thread, in the order of the calls.
+ */
+
+/******************************************************************************
+ ******************************************************************************/
+/*
+ * Returns the head of a CBOR data item (RFC 8949, section 3). The jobs are
+ * already encoded: they are inserted as is in the records and snapshots.
+ */
+static QByteArray cborHead(quint8 majorType, quint64 value)
+{
+    const int type = majorType << 5;
+    QByteArray head;
+    if (value < 24) {
+        head.append(char(type | int(value)));
+        return head;
+    }
+    int bytes = 8;
+    if (value <= 0xff) {
+        head.append(char(type | 24));
+        bytes = 1;
+    } else if (value <= 0xffff) {
+        head.append(char(type | 25));
+        bytes = 2;
+    } else if (value <= 0xffffffff) {
+        head.append(char(type | 26));
+        bytes = 4;
+    } else {
+        head.append(char(type | 27));
+    }
+    for (int i = bytes - 1; i >= 0; --i) {
+        head.append(char((value >> (8 * i)) & 0xff));
+    }
+    return head;
+}
+
+static inline QByteArray cborText(const char *text)
+{
+    return QCborValue(QLatin1String(text)).toCbor();
+}
+
+static inline QByteArray cborInteger(qint64 value)
+{
+    return QCborValue(value).toCbor();
+}
+
+/*
+ * Reads the text string at the position of the reader, and moves to the
+ * next element.
+ */
+static bool readString(QCborStreamReader &reader, QString *string)
+{
+    if (!reader.isString()) {
+        return false;
+    }
+    string->clear();
+    auto result = reader.readString();
+    while (result.status == QCborStreamReader::Ok) {
+        *string += result.data;
+        result = reader.readString();
+    }
+    return result.status == QCborStreamReader::EndOfString;
+}
+
+static bool readInteger(QCborStreamReader &reader, qint64 *value)
+{
+    if (reader.isInteger()) {
+        *value = reader.toInteger();
+    } else if (reader.isDouble()) {
+        *value = static_cast<qint64>(reader.toDouble()); /* Converted from JSON */
+    } else {
+        return false;
+    }
+    return reader.next();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+struct Record
+{
+    enum Operation {
+        Unknown,
+        Put,
+        Remove,
+        Order
+    };
+    Operation operation{Unknown};
+    qint64 id{-1};
+    QByteArray job;
+    QList<qint64> ids;
+};
+
+/*
+ * Reads the record at the given offset of the journal. Returns its size,
+ * or -1 if it's invalid, e.g. truncated by a crash.
+ */
+static qsizetype readRecord(const QByteArray &journal, qsizetype offset, Record *record)
+{
+    const QByteArray data = QByteArray::fromRawData(journal.constData() + offset,
+                                                    journal.size() - offset);
+    QCborStreamReader reader(data);
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return -1;
+    }
+    QString operation;
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        QString key;
+        if (!readString(reader, &key)) {
+            return -1;
+        }
+        if (key == QLatin1String("op")) {
+            if (!readString(reader, &operation)) {
+                return -1;
+            }
+        } else if (key == QLatin1String("id")) {
+            if (!readInteger(reader, &record->id)) {
+                return -1;
+            }
+        } else if (key == QLatin1String("job")) {
+            const qint64 begin = reader.currentOffset();
+            if (!reader.isMap() || !reader.next()) {
+                return -1;
+            }
+            record->job = QByteArray(data.constData() + begin, reader.currentOffset() - begin);
+        } else if (key == QLatin1String("ids")) {
+            if (!reader.isArray() || !reader.enterContainer()) {
+                return -1;
+            }
+            while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+                qint64 id = -1;
+                if (!readInteger(reader, &id)) {
+                    return -1;
+                }
+                record->ids.append(id);
+            }
+            if (reader.lastError() != QCborError::NoError || !reader.leaveContainer()) {
+                return -1;
+            }
+        } else if (!reader.next()) {
+            return -1;
+        }
+    }
+    if (reader.lastError() != QCborError::NoError || !reader.leaveContainer()) {
+        return -1;
+    }
+    if (operation == QLatin1String("put") && record->id >= 0 && !record->job.isEmpty()) {
+        record->operation = Record::Put;
+    } else if (operation == QLatin1String("remove") && record->id >= 0) {
+        record->operation = Record::Remove;
+    } else if (operation == QLatin1String("order")) {
+        record->operation = Record::Order;
+    }
+    return static_cast<qsizetype>(reader.currentOffset());
+}
+
+/******************************************************************************
+ ******************************************************************************/
+static QByteArray snapshotHead(qsizetype count)
+{
+    QByteArray head = s_cbor_signature;
+    head += cborHead(cbor_map, 2);
+    head += cborText("version");
+    head += cborInteger(snapshot_version);
+    head += cborText("jobs");
+    head += cborHead(cbor_array, static_cast<quint64>(count));
+    return head;
+}
+
+/*
+ * Reads the id of the job at the position of the reader, and moves after
+ * the job.
+ */
+static bool readJobId(QCborStreamReader &reader, qint64 *id)
+{
+    if (!reader.isMap() || !reader.enterContainer()) {
+        return false;
+    }
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        QString key;
+        if (!readString(reader, &key)) {
+            return false;
+        }
+        if (key == QLatin1String("id")) {
+            if (!readInteger(reader, id)) {
+                return false;
+            }
+        } else if (!reader.next()) {
+            return false;
+        }
+    }
+    return reader.lastError() == QCborError::NoError && reader.leaveContainer();
+}
+
+/*
+ * The sessions written without journal have no ids: the jobs get the
+ * next id, stored in the job, so that the next snapshots keep it.
+ */
+static QByteArray withId(const QByteArray &job, qint64 id)
+{
+    QCborMap map = QCborValue::fromCbor(job).toMap();
+    map[QLatin1String("id")] = id;
+    return QCborValue(map).toCbor();
+}
+
+static bool decodeCborSnapshot(const QByteArray &data, QList<SessionJournal::Job> *jobs)
+{
+    QCborStreamReader reader(data);
+    if (!reader.isTag() || !reader.next() || !reader.isMap() || !reader.enterContainer()) {
+        return false;
+    }
+    qint64 nextId = 0;
+    while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+        QString key;
+        if (!readString(reader, &key)) {
+            return false;
+        }
+        if (key == QLatin1String("version")) {
+            qint64 version = 0;
+            if (!readInteger(reader, &version)) {
+                return false;
+            }
+            if (version > snapshot_version) {
+                qWarning("Session file written by a newer version.");
+            }
+        } else if (key == QLatin1String("jobs")) {
+            if (!reader.isArray() || !reader.enterContainer()) {
+                return false;
+            }
+            while (reader.lastError() == QCborError::NoError && reader.hasNext()) {
+                const qint64 begin = reader.currentOffset();
+                qint64 id = -1;
+                if (!readJobId(reader, &id)) {
+                    return false;
+                }
+                SessionJournal::Job job;
+                job.data = data.mid(begin, reader.currentOffset() - begin);
+                if (id < 0) {
+                    id = nextId;
+                    job.data = withId(job.data, id);
+                }
+                job.id = id;
+                nextId = qMax(nextId, id + 1);
+                jobs->append(job);
+            }
+            if (reader.lastError() != QCborError::NoError || !reader.leaveContainer()) {
+                return false;
+            }
+        } else if (!reader.next()) {
+            return false;
+        }
+    }
+    return reader.lastError() == QCborError::NoError && reader.leaveContainer();
+}
+
+static bool decodeJsonSnapshot(const QByteArray &data, QList<SessionJournal::Job> *jobs)
+{
+    QJsonParseError error = {};
+    const QJsonDocument document = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError) {
+        return false;
+    }
+    const QJsonArray array = document.object()["jobs"].toArray();
+    jobs->reserve(array.count());
+    qint64 nextId = 0;
+    for (const auto &value : array) {
+        QJsonObject object = value.toObject();
+        const qint64 id = object.contains("id") ? object["id"].toInteger() : nextId;
+        nextId = qMax(nextId, id + 1);
+        object["id"] = id;
+        jobs->append({id, QCborValue::fromJsonValue(object).toCbor()});
+    }
+    return true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+SessionJournal::SessionJournal(QObject *parent) : QObject(parent)
+  , m_thread(new QThread(this))
+  , m_context(new QObject())
+  , m_fileName(QString())
+  , m_recordCount(0)
+{
+    m_thread->setObjectName(QLatin1String("Session thread"));
+    m_context->moveToThread(m_thread);
+    m_thread->start();
+}
+
+SessionJournal::~SessionJournal()
+{
+    waitForWrites();
+    m_thread->quit();
+    m_thread->wait();
+    delete m_context;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QString SessionJournal::fileName() const
+{
+    return m_fileName;
+}
+
+/*!
+ * \brief Sets the session file. The journal is written next to it.
+ *
+ * If the existing journal ends with a record cut by a crash, the record
+ * is removed in the background, before the next records are appended.
+ * The count of records starts at zero: compact() an existing journal to
+ * keep the count right.
+ */
+void SessionJournal::setFileName(const QString &fileName)
+{
+    m_fileName = fileName;
+    m_recordCount = 0;
+    if (m_fileName.isEmpty()) {
+        return;
+    }
+    const QString journal = journalFileName(m_fileName);
+    QMetaObject::invokeMethod(m_context, [journal]() {
+        QFile file(journal);
+        if (!file.exists() || !file.open(QIODevice::ReadWrite)) {
+            return;
+        }
+        const qsizetype size = validSize(file.readAll());
+        if (size < file.size()) {
+            qWarning("Invalid record at the end of the journal file, removed.");
+            file.resize(size);
+        }
+    });
+}
+
+QString SessionJournal::journalFileName(const QString &fileName)
+{
+    return fileName + s_journal_suffix;
+}
+
+/*!
+ * \brief Returns the number of records appended since the last snapshot.
+ */
+int SessionJournal::recordCount() const
+{
+    return m_recordCount;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Appends the given \a count records to the journal, in the background.
+ *
+ * If not null, the \a barrier is called in the background before the write,
+ * e.g. to wait until the data described by the records is on disk.
+ */
+void SessionJournal::append(const QByteArray &records, int count, const Barrier &barrier)
+{
+    if (m_fileName.isEmpty() || records.isEmpty()) {
+        return;
+    }
+    m_recordCount += count;
+    const QString fileName = journalFileName(m_fileName);
+    QMetaObject::invokeMethod(m_context, [fileName, records, barrier]() {
+        if (barrier) {
+            barrier();
+        }
+        QFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            qWarning("Couldn't open journal file.");
+            return;
+        }
+        if (file.write(records) != records.size()) {
+            qWarning("Couldn't write journal file.");
+        }
+    });
+}
+
+/*!
+ * \brief Merges the journal into a new snapshot, in the background, and
+ * removes the journal.
+ */
+void SessionJournal::compact()
+{
+    if (m_fileName.isEmpty()) {
+        return;
+    }
+    m_recordCount = 0;
+    const QString fileName = m_fileName;
+    QMetaObject::invokeMethod(m_context, [fileName]() {
+        merge(fileName);
+    });
+}
+
+/*!
+ * \brief Runs the \a task in the background, after the pending writes,
+ * e.g. to write other files of the session.
+ */
+void SessionJournal::post(const Task &task)
+{
+    QMetaObject::invokeMethod(m_context, task);
+}
+
+/*!
+ * \brief Blocks until the pending writes are done.
+ */
+void SessionJournal::waitForWrites()
+{
+    if (m_thread->isRunning()) {
+        QMetaObject::invokeMethod(m_context, []() {}, Qt::BlockingQueuedConnection);
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns the record of the new content of a job, already encoded
+ * in CBOR.
+ */
+QByteArray SessionJournal::putRecord(qint64 id, const QByteArray &job)
+{
+    QByteArray record = cborHead(cbor_map, 3);
+    record += cborText("op");
+    record += cborText("put");
+    record += cborText("id");
+    record += cborInteger(id);
+    record += cborText("job");
+    record += job;
+    return record;
+}
+
+QByteArray SessionJournal::removeRecord(qint64 id)
+{
+    QByteArray record = cborHead(cbor_map, 2);
+    record += cborText("op");
+    record += cborText("remove");
+    record += cborText("id");
+    record += cborInteger(id);
+    return record;
+}
+
+/*!
+ * \brief Returns the record of the new order of the jobs.
+ */
+QByteArray SessionJournal::orderRecord(const QList<qint64> &ids)
+{
+    QByteArray record = cborHead(cbor_map, 2);
+    record += cborText("op");
+    record += cborText("order");
+    record += cborText("ids");
+    record += cborHead(cbor_array, static_cast<quint64>(ids.count()));
+    for (auto id : ids) {
+        record += cborInteger(id);
+    }
+    return record;
+}
+
+/*!
+ * \brief Returns the \a jobs of the snapshot, once the records of the
+ * \a journal are applied.
+ *
+ * A put replaces the job with the same id, in place, or appends it.
+ * An order moves the listed jobs first, in that order.
+ * The replay stops at the first invalid record, e.g. a record truncated
+ * by a crash.
+ */
+QList<SessionJournal::Job> SessionJournal::replay(const QList<Job> &jobs, const QByteArray &journal)
+{
+    QList<qint64> order;
+    QHash<qint64, QByteArray> byId;
+    order.reserve(jobs.count());
+    byId.reserve(jobs.count());
+    for (const auto &job : jobs) {
+        if (!byId.contains(job.id)) {
+            order.append(job.id);
+        }
+        byId.insert(job.id, job.data);
+    }
+
+    qsizetype offset = 0;
+    while (offset < journal.size()) {
+        Record record;
+        const qsizetype size = readRecord(journal, offset, &record);
+        if (size <= 0) {
+            qWarning("Invalid record in journal file, the rest is ignored.");
+            break;
+        }
+        offset += size;
+        switch (record.operation) {
+        case Record::Put:
+            if (!byId.contains(record.id)) {
+                order.append(record.id);
+            }
+            byId.insert(record.id, record.job);
+            break;
+        case Record::Remove:
+            byId.remove(record.id);
+            break;
+        case Record::Order:
+        {
+            const QSet<qint64> listed(record.ids.cbegin(), record.ids.cend());
+            QList<qint64> reordered = record.ids;
+            for (auto id : std::as_const(order)) {
+                if (!listed.contains(id)) {
+                    reordered.append(id);
+                }
+            }
+            order = reordered;
+        }
+            break;
+        case Record::Unknown:
+            break;
+        }
+    }
+
+    QList<Job> replayed;
+    replayed.reserve(byId.count());
+    for (auto id : std::as_const(order)) {
+        auto it = byId.find(id);
+        if (it != byId.end()) {
+            replayed.append({id, it.value()});
+            byId.erase(it); /* A removed then put again id appears once */
+        }
+    }
+    return replayed;
+}
+
+/*!
+ * \brief Returns the size of the valid records at the start of the \a journal.
+ */
+qsizetype SessionJournal::validSize(const QByteArray &journal)
+{
+    qsizetype offset = 0;
+    while (offset < journal.size()) {
+        Record record;
+        const qsizetype size = readRecord(journal, offset, &record);
+        if (size <= 0) {
+            break;
+        }
+        offset += size;
+    }
+    return offset;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QByteArray SessionJournal::encodeSnapshot(const QList<Job> &jobs)
+{
+    QByteArray data = snapshotHead(jobs.count());
+    for (const auto &job : jobs) {
+        data += job.data;
+    }
+    return data;
+}
+
+/*!
+ * \brief Returns the jobs of the snapshot encoded in \a data, either in
+ * CBOR or in the JSON of the previous versions.
+ */
+QList<SessionJournal::Job> SessionJournal::decodeSnapshot(const QByteArray &data, bool *ok)
+{
+    if (ok) {
+        *ok = false;
+    }
+    QList<Job> jobs;
+    if (data.startsWith(s_cbor_signature)) {
+        if (!decodeCborSnapshot(data, &jobs)) {
+            qCritical("Couldn't parse CBOR file.");
+            return {};
+        }
+    } else if (!decodeJsonSnapshot(data, &jobs)) {
+        qCritical("Couldn't parse JSON file.");
+        return {};
+    }
+    if (ok) {
+        *ok = true;
+    }
+    return jobs;
+}
+
+/*!
+ * \brief Writes the snapshot of the \a jobs to the given file.
+ *
+ * The file is replaced atomically, so that a crash during the write
+ * doesn't corrupt the previous session.
+ */
+bool SessionJournal::writeSnapshot(const QList<Job> &jobs, const QString &fileName)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Couldn't open save file.");
+        return false;
+    }
+    file.write(snapshotHead(jobs.count()));
+    for (const auto &job : jobs) {
+        file.write(job.data);
+    }
+    if (!file.commit()) {
+        qWarning("Couldn't save file.");
+        return false;
+    }
+    return true;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Reads the snapshot, and replays the journal of the changes saved
+ * after it.
+ *
+ * A missing snapshot is an empty queue, whose jobs are in the journal only.
+ */
+QList<SessionJournal::Job> SessionJournal::read(const QString &fileName, bool *ok)
+{
+    if (ok) {
+        *ok = false;
+    }
+    QList<Job> jobs;
+    QFile file(fileName);
+    if (file.exists()) {
+        if (!file.open(QIODevice::ReadOnly)) {
+            qWarning("Couldn't open file.");
+            return {};
+        }
+        bool decoded = false;
+        jobs = decodeSnapshot(file.readAll(), &decoded);
+        if (!decoded) {
+            return {};
+        }
+    }
+    QFile journal(journalFileName(fileName));
+    if (journal.open(QIODevice::ReadOnly)) {
+        jobs = replay(jobs, journal.readAll());
+    }
+    if (ok) {
+        *ok = true;
+    }
+    return jobs;
+}
+
+/*!
+ * \brief Merges the journal into a new snapshot, and removes the journal.
+ */
+bool SessionJournal::merge(const QString &fileName)
+{
+    if (!QFile::exists(journalFileName(fileName))) {
+        return true; /* Nothing changed */
+    }
+    bool ok = false;
+    const QList<Job> jobs = read(fileName, &ok);
+    if (!ok) {
+        qWarning("Couldn't merge the journal file.");
+        return false;
+    }
+    if (!writeSnapshot(jobs, fileName)) {
+        return false;
+    }
+    QFile::remove(journalFileName(fileName));
+    return true;
+}
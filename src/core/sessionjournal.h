@@ -0,0 +1,81 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CORE_SESSION_JOURNAL_H
+#define CORE_SESSION_JOURNAL_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <functional>
+
+class QThread;
+
+class SessionJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    /* A job of the session, encoded in CBOR */
+    struct Job
+    {
+        qint64 id{-1};
+        QByteArray data;
+    };
+
+    using Barrier = std::function<void()>;
+    using Task = std::function<void()>;
+
+    explicit SessionJournal(QObject *parent = Q_NULLPTR);
+    ~SessionJournal() Q_DECL_OVERRIDE;
+
+    QString fileName() const;
+    void setFileName(const QString &fileName);
+
+    static QString journalFileName(const QString &fileName);
+
+    int recordCount() const;
+
+    void append(const QByteArray &records, int count, const Barrier &barrier = {});
+    void compact();
+    void post(const Task &task);
+    void waitForWrites();
+
+    /* Records */
+    static QByteArray putRecord(qint64 id, const QByteArray &job);
+    static QByteArray removeRecord(qint64 id);
+    static QByteArray orderRecord(const QList<qint64> &ids);
+    static QList<Job> replay(const QList<Job> &jobs, const QByteArray &journal);
+    static qsizetype validSize(const QByteArray &journal);
+
+    /* Snapshot */
+    static QByteArray encodeSnapshot(const QList<Job> &jobs);
+    static QList<Job> decodeSnapshot(const QByteArray &data, bool *ok = Q_NULLPTR);
+    static bool writeSnapshot(const QList<Job> &jobs, const QString &fileName);
+
+    static QList<Job> read(const QString &fileName, bool *ok = Q_NULLPTR);
+    static bool merge(const QString &fileName);
+
+private:
+    QThread *m_thread;
+    QObject *m_context; ///< Lives in m_thread
+    QString m_fileName;
+    int m_recordCount;
+};
+
+#endif // CORE_SESSION_JOURNAL_H
@@ -47,10 +47,17 @@ static const QString REGISTRY_PROXY_USERNAME   = "ProxyUser";
 static const QString REGISTRY_PROXY_PASSWORD   = "ProxyPwd";
 static const QString REGISTRY_SOCKET_TYPE      = "SocketType";
 static const QString REGISTRY_SOCKET_TIMEOUT   = "SocketTimeout";
+static const QString REGISTRY_SOCKET_PER_HOST  = "SocketConnectionsPerHost";
+static const QString REGISTRY_SOCKET_HTTP2     = "SocketHttp2Enabled";
+static const QString REGISTRY_SOCKET_WARM_UP   = "SocketWarmUpEnabled";
+static const QString REGISTRY_SOCKET_PREFLIGHT = "SocketPreflightProbeEnabled";
 static const QString REGISTRY_REMOTE_CREATION  = "RemoteCreationTime";
 static const QString REGISTRY_REMOTE_LAST_MOD  = "RemoteLastModifiedTime";
 static const QString REGISTRY_REMOTE_ACCESS    = "RemoteAccessTime";
 static const QString REGISTRY_REMOTE_META_MOD  = "RemoteMetadataChangeTime";
+static const QString REGISTRY_PREALLOCATE     = "FilePreallocation";
+static const QString REGISTRY_DISK_SPACE      = "DiskSpaceCheck";
+static const QString REGISTRY_IO_URING        = "IoUringEnabled";
 static const QString REGISTRY_STREAM_WATCHED   = "StreamMarkWatchedEnabled";
 static const QString REGISTRY_STREAM_SUBTITLE  = "StreamSubtitleEnabled";
 static const QString REGISTRY_STREAM_THUMBNAIL = "StreamThumbnailEnabled";
@@ -61,7 +68,18 @@ static const QString REGISTRY_STREAM_SHORTCUT  = "StreamShortcutEnabled";
 
 // Tab Network
 static const QString REGISTRY_MAX_SIMULTANEOUS = "MaxSimultaneous";
+static const QString REGISTRY_AUTO_SIMULTANEOUS = "AutoSimultaneousEnabled";
 static const QString REGISTRY_CONCURRENT_FRAG  = "ConcurrentFragments";
+static const QString REGISTRY_SCHEDULING      = "SchedulingPolicy";
+static const QString REGISTRY_MAX_PER_HOST     = "MaxDownloadsPerHost";
+static const QString REGISTRY_BANDWIDTH        = "BandwidthLimit";
+static const QString REGISTRY_BANDWIDTH_HOST   = "BandwidthHostLimit";
+static const QString REGISTRY_BANDWIDTH_ITEM   = "BandwidthItemLimit";
+static const QString REGISTRY_BANDWIDTH_REDUCED = "BandwidthReducedLimit";
+static const QString REGISTRY_BANDWIDTH_FROM   = "BandwidthReducedFrom";
+static const QString REGISTRY_BANDWIDTH_TO     = "BandwidthReducedTo";
+static const QString REGISTRY_RETRY_ATTEMPTS   = "RetryMaxAttempts";
+static const QString REGISTRY_RETRY_DELAY      = "RetryDelay";
 static const QString REGISTRY_CUSTOM_BATCH     = "CustomBatchEnabled";
 static const QString REGISTRY_CUSTOM_BATCH_BL  = "CustomBatchButtonLabel";
 static const QString REGISTRY_CUSTOM_BATCH_RGE = "CustomBatchRange";
@@ -126,7 +144,18 @@ Settings::Settings(QObject *parent) : AbstractSettings(parent)
 
     // Tab Network
     addDefaultSettingInt(REGISTRY_MAX_SIMULTANEOUS, 4);
+    addDefaultSettingBool(REGISTRY_AUTO_SIMULTANEOUS, false);
     addDefaultSettingInt(REGISTRY_CONCURRENT_FRAG, DEFAULT_CONCURRENT_FRAGMENTS);
+    addDefaultSettingInt(REGISTRY_SCHEDULING, 0);
+    addDefaultSettingInt(REGISTRY_MAX_PER_HOST, 0);
+    addDefaultSettingInt(REGISTRY_BANDWIDTH, 0);
+    addDefaultSettingInt(REGISTRY_BANDWIDTH_HOST, 0);
+    addDefaultSettingInt(REGISTRY_BANDWIDTH_ITEM, 0);
+    addDefaultSettingInt(REGISTRY_BANDWIDTH_REDUCED, 0);
+    addDefaultSettingString(REGISTRY_BANDWIDTH_FROM, QLatin1String("08:00"));
+    addDefaultSettingString(REGISTRY_BANDWIDTH_TO, QLatin1String("18:00"));
+    addDefaultSettingInt(REGISTRY_RETRY_ATTEMPTS, 5);
+    addDefaultSettingInt(REGISTRY_RETRY_DELAY, 5);
     addDefaultSettingBool(REGISTRY_CUSTOM_BATCH, true);
     addDefaultSettingString(REGISTRY_CUSTOM_BATCH_BL, QLatin1String("1 -> 25"));
     addDefaultSettingString(REGISTRY_CUSTOM_BATCH_RGE, QLatin1String("[1:25]"));
@@ -142,12 +171,20 @@ Settings::Settings(QObject *parent) : AbstractSettings(parent)
 
     addDefaultSettingInt(REGISTRY_SOCKET_TYPE, 0);
     addDefaultSettingInt(REGISTRY_SOCKET_TIMEOUT, DEFAULT_TIMEOUT_SECS);
+    addDefaultSettingInt(REGISTRY_SOCKET_PER_HOST, 6);
+    addDefaultSettingBool(REGISTRY_SOCKET_HTTP2, false);
+    addDefaultSettingBool(REGISTRY_SOCKET_WARM_UP, true);
+    addDefaultSettingBool(REGISTRY_SOCKET_PREFLIGHT, false);
 
     addDefaultSettingBool(REGISTRY_REMOTE_CREATION, true);
     addDefaultSettingBool(REGISTRY_REMOTE_LAST_MOD, true);
     addDefaultSettingBool(REGISTRY_REMOTE_ACCESS, false);
     addDefaultSettingBool(REGISTRY_REMOTE_META_MOD, false);
 
+    addDefaultSettingBool(REGISTRY_PREALLOCATE, true);
+    addDefaultSettingBool(REGISTRY_DISK_SPACE, true);
+    addDefaultSettingBool(REGISTRY_IO_URING, false);
+
     addDefaultSettingBool(REGISTRY_STREAM_WATCHED, false);
     addDefaultSettingBool(REGISTRY_STREAM_SUBTITLE, false);
     addDefaultSettingBool(REGISTRY_STREAM_THUMBNAIL, false);
@@ -372,6 +409,16 @@ void Settings::setMaxSimultaneousDownloads(int number)
     setSettingInt(REGISTRY_MAX_SIMULTANEOUS, number);
 }
 
+bool Settings::isAutoSimultaneousDownloadsEnabled() const
+{
+    return getSettingBool(REGISTRY_AUTO_SIMULTANEOUS);
+}
+
+void Settings::setAutoSimultaneousDownloadsEnabled(bool enabled)
+{
+    setSettingBool(REGISTRY_AUTO_SIMULTANEOUS, enabled);
+}
+
 int Settings::concurrentFragments() const
 {
     return getSettingInt(REGISTRY_CONCURRENT_FRAG);
@@ -382,6 +429,123 @@ void Settings::setConcurrentFragments(int fragments)
     setSettingInt(REGISTRY_CONCURRENT_FRAG, fragments);
 }
 
+int Settings::schedulingPolicy() const
+{
+    return getSettingInt(REGISTRY_SCHEDULING);
+}
+
+void Settings::setSchedulingPolicy(int policy)
+{
+    setSettingInt(REGISTRY_SCHEDULING, policy);
+}
+
+int Settings::maxDownloadsPerHost() const
+{
+    return getSettingInt(REGISTRY_MAX_PER_HOST);
+}
+
+void Settings::setMaxDownloadsPerHost(int number)
+{
+    setSettingInt(REGISTRY_MAX_PER_HOST, number);
+}
+
+/*!
+ * \brief Returns the global download rate limit, in KiB/s, or 0 if unlimited.
+ */
+int Settings::bandwidthLimit() const
+{
+    return getSettingInt(REGISTRY_BANDWIDTH);
+}
+
+void Settings::setBandwidthLimit(int kibPerSecond)
+{
+    setSettingInt(REGISTRY_BANDWIDTH, kibPerSecond);
+}
+
+int Settings::bandwidthHostLimit() const
+{
+    return getSettingInt(REGISTRY_BANDWIDTH_HOST);
+}
+
+void Settings::setBandwidthHostLimit(int kibPerSecond)
+{
+    setSettingInt(REGISTRY_BANDWIDTH_HOST, kibPerSecond);
+}
+
+int Settings::bandwidthItemLimit() const
+{
+    return getSettingInt(REGISTRY_BANDWIDTH_ITEM);
+}
+
+void Settings::setBandwidthItemLimit(int kibPerSecond)
+{
+    setSettingInt(REGISTRY_BANDWIDTH_ITEM, kibPerSecond);
+}
+
+/*!
+ * \brief Returns the global limit during the reduced period, in KiB/s,
+ * or 0 if there is no reduced period.
+ */
+int Settings::bandwidthReducedLimit() const
+{
+    return getSettingInt(REGISTRY_BANDWIDTH_REDUCED);
+}
+
+void Settings::setBandwidthReducedLimit(int kibPerSecond)
+{
+    setSettingInt(REGISTRY_BANDWIDTH_REDUCED, kibPerSecond);
+}
+
+/*!
+ * \brief Returns the start of the reduced period, as "HH:mm".
+ */
+QString Settings::bandwidthReducedFrom() const
+{
+    return getSettingString(REGISTRY_BANDWIDTH_FROM);
+}
+
+void Settings::setBandwidthReducedFrom(const QString &time)
+{
+    setSettingString(REGISTRY_BANDWIDTH_FROM, time);
+}
+
+QString Settings::bandwidthReducedTo() const
+{
+    return getSettingString(REGISTRY_BANDWIDTH_TO);
+}
+
+void Settings::setBandwidthReducedTo(const QString &time)
+{
+    setSettingString(REGISTRY_BANDWIDTH_TO, time);
+}
+
+/*!
+ * \brief Returns the number of automatic retries after a network error,
+ * or 0 if disabled.
+ */
+int Settings::retryMaxAttempts() const
+{
+    return getSettingInt(REGISTRY_RETRY_ATTEMPTS);
+}
+
+void Settings::setRetryMaxAttempts(int attempts)
+{
+    setSettingInt(REGISTRY_RETRY_ATTEMPTS, attempts);
+}
+
+/*!
+ * \brief Returns the delay before the first retry, in seconds.
+ */
+int Settings::retryDelay() const
+{
+    return getSettingInt(REGISTRY_RETRY_DELAY);
+}
+
+void Settings::setRetryDelay(int secs)
+{
+    setSettingInt(REGISTRY_RETRY_DELAY, secs);
+}
+
 bool Settings::isCustomBatchEnabled() const
 {
     return getSettingBool(REGISTRY_CUSTOM_BATCH);
@@ -492,6 +656,53 @@ void Settings::setConnectionTimeout(int number)
     setSettingInt(REGISTRY_SOCKET_TIMEOUT, number);
 }
 
+/*!
+ * \brief Returns the maximum number of HTTP/1 connections opened to the same host.
+ */
+int Settings::connectionsPerHost() const
+{
+    return getSettingInt(REGISTRY_SOCKET_PER_HOST);
+}
+
+void Settings::setConnectionsPerHost(int number)
+{
+    setSettingInt(REGISTRY_SOCKET_PER_HOST, number);
+}
+
+bool Settings::isHttp2Enabled() const
+{
+    return getSettingBool(REGISTRY_SOCKET_HTTP2);
+}
+
+void Settings::setHttp2Enabled(bool enabled)
+{
+    setSettingBool(REGISTRY_SOCKET_HTTP2, enabled);
+}
+
+bool Settings::isConnectionWarmUpEnabled() const
+{
+    return getSettingBool(REGISTRY_SOCKET_WARM_UP);
+}
+
+void Settings::setConnectionWarmUpEnabled(bool enabled)
+{
+    setSettingBool(REGISTRY_SOCKET_WARM_UP, enabled);
+}
+
+/*!
+ * \brief Returns true if the metadata of the queued files are requested
+ * before their download starts.
+ */
+bool Settings::isPreflightProbeEnabled() const
+{
+    return getSettingBool(REGISTRY_SOCKET_PREFLIGHT);
+}
+
+void Settings::setPreflightProbeEnabled(bool enabled)
+{
+    setSettingBool(REGISTRY_SOCKET_PREFLIGHT, enabled);
+}
+
 bool Settings::isRemoteCreationTimeEnabled() const
 {
     return getSettingBool(REGISTRY_REMOTE_CREATION);
@@ -532,6 +743,36 @@ void Settings::setRemoteMetadataChangeTimeEnabled(bool enabled)
     setSettingBool(REGISTRY_REMOTE_META_MOD, enabled);
 }
 
+bool Settings::isFilePreallocationEnabled() const
+{
+    return getSettingBool(REGISTRY_PREALLOCATE);
+}
+
+void Settings::setFilePreallocationEnabled(bool enabled)
+{
+    setSettingBool(REGISTRY_PREALLOCATE, enabled);
+}
+
+bool Settings::isDiskSpaceCheckEnabled() const
+{
+    return getSettingBool(REGISTRY_DISK_SPACE);
+}
+
+void Settings::setDiskSpaceCheckEnabled(bool enabled)
+{
+    setSettingBool(REGISTRY_DISK_SPACE, enabled);
+}
+
+bool Settings::isIoUringEnabled() const
+{
+    return getSettingBool(REGISTRY_IO_URING);
+}
+
+void Settings::setIoUringEnabled(bool enabled)
+{
+    setSettingBool(REGISTRY_IO_URING, enabled);
+}
+
 bool Settings::isStreamMarkWatchedEnabled() const
 {
     return getSettingBool(REGISTRY_STREAM_WATCHED);
@@ -105,9 +105,42 @@ public:
     int maxSimultaneousDownloads() const;
     void setMaxSimultaneousDownloads(int number);
 
+    bool isAutoSimultaneousDownloadsEnabled() const;
+    void setAutoSimultaneousDownloadsEnabled(bool enabled);
+
     int concurrentFragments() const;
     void setConcurrentFragments(int fragments);
 
+    int schedulingPolicy() const;
+    void setSchedulingPolicy(int policy);
+
+    int maxDownloadsPerHost() const;
+    void setMaxDownloadsPerHost(int number);
+
+    int bandwidthLimit() const;
+    void setBandwidthLimit(int kibPerSecond);
+
+    int bandwidthHostLimit() const;
+    void setBandwidthHostLimit(int kibPerSecond);
+
+    int bandwidthItemLimit() const;
+    void setBandwidthItemLimit(int kibPerSecond);
+
+    int bandwidthReducedLimit() const;
+    void setBandwidthReducedLimit(int kibPerSecond);
+
+    QString bandwidthReducedFrom() const;
+    void setBandwidthReducedFrom(const QString &time);
+
+    QString bandwidthReducedTo() const;
+    void setBandwidthReducedTo(const QString &time);
+
+    int retryMaxAttempts() const;
+    void setRetryMaxAttempts(int attempts);
+
+    int retryDelay() const;
+    void setRetryDelay(int secs);
+
     bool isCustomBatchEnabled() const;
     void setCustomBatchEnabled(bool enabled);
 
@@ -141,6 +174,18 @@ public:
     int connectionTimeout() const;
     void setConnectionTimeout(int number);
 
+    int connectionsPerHost() const;
+    void setConnectionsPerHost(int number);
+
+    bool isHttp2Enabled() const;
+    void setHttp2Enabled(bool enabled);
+
+    bool isConnectionWarmUpEnabled() const;
+    void setConnectionWarmUpEnabled(bool enabled);
+
+    bool isPreflightProbeEnabled() const;
+    void setPreflightProbeEnabled(bool enabled);
+
     bool isRemoteCreationTimeEnabled() const;
     void setRemoteCreationTimeEnabled(bool enabled);
 
@@ -153,6 +198,15 @@ public:
     bool isRemoteMetadataChangeTimeEnabled() const;
     void setRemoteMetadataChangeTimeEnabled(bool enabled);
 
+    bool isFilePreallocationEnabled() const;
+    void setFilePreallocationEnabled(bool enabled);
+
+    bool isDiskSpaceCheckEnabled() const;
+    void setDiskSpaceCheckEnabled(bool enabled);
+
+    bool isIoUringEnabled() const;
+    void setIoUringEnabled(bool enabled);
+
     bool isStreamMarkWatchedEnabled() const;
     void setStreamMarkWatchedEnabled(bool enabled);
 
@@ -329,6 +329,24 @@ void Stream::setConfig(const StreamObject::Config &config)
     m_config = config;
 }
 
+/******************************************************************************
+ ******************************************************************************/
+qint64 Stream::rateLimit() const
+{
+    return m_rateLimit;
+}
+
+/*!
+ * \brief Sets the maximum download rate, in bytes per second, or 0 if unlimited.
+ *
+ * The rate is given to the process when it starts, so it can't change
+ * during the download.
+ */
+void Stream::setRateLimit(qint64 bytesPerSecond)
+{
+    m_rateLimit = qMax(qint64(0), bytesPerSecond);
+}
+
 /******************************************************************************
  ******************************************************************************/
 QString Stream::fileName() const
@@ -423,6 +441,9 @@ QStringList Stream::arguments() const
     default:
         break;
     }
+    if (m_rateLimit > 0) {
+        arguments << QLatin1String("--limit-rate") << QString::number(m_rateLimit);
+    }
     if (!m_referringPage.isEmpty()) {
         arguments << QLatin1String("--referer") << m_referringPage;
     }
@@ -485,6 +485,9 @@ public:
     StreamObject::Config config() const;
     void setConfig(const StreamObject::Config &config);
 
+    qint64 rateLimit() const;
+    void setRateLimit(qint64 bytesPerSecond);
+
     void initialize(const StreamObject &streamObject);
 
     QString command(int indent = 4) const;
@@ -529,6 +532,7 @@ private:
     QString m_fileExtension;
 
     StreamObject::Config m_config;
+    qint64 m_rateLimit{0};
 
     qsizetype _q_bytesTotal() const;
     bool isMergeFormat(const QString &suffix) const;
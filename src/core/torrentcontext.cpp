@@ -132,6 +132,30 @@ QList<TorrentSettingItem> TorrentContext::presetHighPerf() const
     return d->presetHighPerf();
 }
 
+/******************************************************************************
+ ******************************************************************************/
+int TorrentContext::downloadRateLimit() const
+{
+    return d->downloadRateLimit;
+}
+
+/*!
+ * \brief Caps the download rate of the session, in bytes per second,
+ * or 0 if unlimited.
+ *
+ * This is the share of the global bandwidth limit given to the torrents.
+ * It overrides the 'download_rate_limit' of the torrent settings when lower.
+ */
+void TorrentContext::setDownloadRateLimit(int bytesPerSecond)
+{
+    bytesPerSecond = qMax(0, bytesPerSecond);
+    if (d->downloadRateLimit == bytesPerSecond) {
+        return;
+    }
+    d->downloadRateLimit = bytesPerSecond;
+    d->onSettingsChanged();
+}
+
 /******************************************************************************
  ******************************************************************************/
 bool TorrentContext::isEnabled() const
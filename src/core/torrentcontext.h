@@ -77,6 +77,8 @@ public:
     QList<TorrentSettingItem> presetMinCache() const;
     QList<TorrentSettingItem> presetHighPerf() const;
 
+    int downloadRateLimit() const;
+    void setDownloadRateLimit(int bytesPerSecond);
 
     /* Session */
     bool isEnabled() const;
@@ -100,6 +100,7 @@ TorrentContextPrivate::TorrentContextPrivate(TorrentContext *qq)
     , workerThread(Q_NULLPTR)
     , settings(Q_NULLPTR)
     , networkManager(Q_NULLPTR)
+    , downloadRateLimit(0)
 {
     qRegisterMetaType<TorrentData>("TorrentData");
     qRegisterMetaType<TorrentStatus>("TorrentStatus");
@@ -168,6 +169,14 @@ void TorrentContextPrivate::onSettingsChanged()
         }
     }
 
+    /* Share of the global bandwidth limit */
+    if (downloadRateLimit > 0) {
+        const int limit = pack.get_int(lt::settings_pack::download_rate_limit);
+        if (limit <= 0 || limit > downloadRateLimit) {
+            pack.set_int(lt::settings_pack::download_rate_limit, downloadRateLimit);
+        }
+    }
+
     workerThread->setSettings(pack);
 
     bool enabled = settings->isTorrentEnabled();
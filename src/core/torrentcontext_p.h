@@ -110,6 +110,7 @@ public:
     WorkerThread *workerThread;
     Settings *settings;
     NetworkManager *networkManager;
+    int downloadRateLimit;
     QHash<UniqueId, Torrent*> hashMap;
 
     inline Torrent *find(const UniqueId &uuid);
@@ -19,6 +19,7 @@
 
 #include <Globals>
 #include <Core/DownloadItem>
+#include <Core/DownloadManager>
 #include <Core/Format>
 #include <Core/IDownloadItem>
 #include <Core/MimeDatabase>
@@ -30,9 +31,12 @@
 #include <QtCore/QScopedPointer>
 #include <QtCore/QSettings>
 
-InformationDialog::InformationDialog(const QList<IDownloadItem *> &jobs, QWidget *parent)
+InformationDialog::InformationDialog(DownloadManager *downloadManager,
+                                     const QList<IDownloadItem *> &jobs, QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::InformationDialog)
+    , m_downloadManager(downloadManager)
+    , m_isLogLoaded(false)
 {
     ui->setupUi(this);
 
@@ -45,9 +49,11 @@ InformationDialog::InformationDialog(const QList<IDownloadItem *> &jobs, QWidget
     ui->logTextEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
 
     connect(ui->wrapCheckBox, SIGNAL(toggled(bool)), this, SLOT(wrapLog(bool)));
+    connect(ui->tabWidget, SIGNAL(currentChanged(int)), this, SLOT(onCurrentTabChanged(int)));
 
     initialize(jobs);
     readUiSettings();
+    onCurrentTabChanged(ui->tabWidget->currentIndex());
 }
 
 InformationDialog::~InformationDialog()
@@ -137,17 +143,32 @@ void InformationDialog::initialize(const QList<IDownloadItem *> &items)
     if (downloadItem) {
         ui->urlFormWidget->setResource(downloadItem->resource());
     }
+}
 
-    /* Log */
-    if (downloadItem) {
-        ui->logTextEdit->setPlainText(downloadItem->log());
+/*!
+ * \brief Reads the log when its tab is shown, as it can be long.
+ */
+void InformationDialog::onCurrentTabChanged(int index)
+{
+    if (!m_isLogLoaded && ui->tabWidget->widget(index) == ui->log) {
+        loadLog();
+    }
+}
 
-        // Scroll to last line
-        QTextCursor cursor = ui->logTextEdit->textCursor();
-        cursor.movePosition(QTextCursor::End);
-        ui->logTextEdit->setTextCursor(cursor);
-        ui->logTextEdit->ensureCursorVisible();
+void InformationDialog::loadLog()
+{
+    m_isLogLoaded = true;
+    if (m_items.isEmpty()) {
+        return;
     }
+    IDownloadItem *item = m_items.first();
+    ui->logTextEdit->setPlainText(m_downloadManager ? m_downloadManager->log(item) : item->log());
+
+    // Scroll to last line
+    QTextCursor cursor = ui->logTextEdit->textCursor();
+    cursor.movePosition(QTextCursor::End);
+    ui->logTextEdit->setTextCursor(cursor);
+    ui->logTextEdit->ensureCursorVisible();
 }
 
 void InformationDialog::wrapLog(bool enabled)
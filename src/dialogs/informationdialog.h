@@ -20,6 +20,7 @@
 #include <QtCore/QList>
 #include <QtWidgets/QDialog>
 
+class DownloadManager;
 class IDownloadItem;
 
 namespace Ui {
@@ -30,7 +31,8 @@ class InformationDialog : public QDialog
 {
     Q_OBJECT
 public:
-    explicit InformationDialog(const QList<IDownloadItem *> &jobs, QWidget *parent);
+    explicit InformationDialog(DownloadManager *downloadManager,
+                               const QList<IDownloadItem *> &jobs, QWidget *parent);
     ~InformationDialog() Q_DECL_OVERRIDE;
 
 public slots:
@@ -38,12 +40,16 @@ public slots:
 
 private slots:
     void wrapLog(bool enabled);
+    void onCurrentTabChanged(int index);
 
 private:
     Ui::InformationDialog *ui;
+    DownloadManager *m_downloadManager;
     QList<IDownloadItem *> m_items;
+    bool m_isLogLoaded;
 
     void initialize(const QList<IDownloadItem*> &items);
+    void loadLog();
 
     void readUiSettings();
     void writeUiSettings();
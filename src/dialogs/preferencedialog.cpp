@@ -18,6 +18,7 @@
 #include "ui_preferencedialog.h"
 
 #include <Globals>
+#include <Core/DiskWriter>
 #include <Core/Locale>
 #include <Core/NetworkManager>
 #include <Core/Settings>
@@ -31,6 +32,7 @@
 #include <QtCore/QDir>
 #include <QtCore/QSettings>
 #include <QtCore/QSignalBlocker>
+#include <QtCore/QTime>
 #include <QtGui/QAction>
 #include <QtGui/QCloseEvent>
 #include <QtGui/QTextBlock>
@@ -191,13 +193,33 @@ void PreferenceDialog::initializeUi()
                 new QIntValidator(std::numeric_limits<quint16>::min(),
                                   std::numeric_limits<quint16>::max(), this));
 
+    ui->autoSimultaneousDownloadCheckBox->setChecked(false);
+    ui->schedulingPolicyComboBox->setCurrentIndex(0);
+    ui->maxDownloadsPerHostSpinBox->setValue(0);
+    ui->bandwidthLimitSpinBox->setValue(0);
+    ui->bandwidthHostLimitSpinBox->setValue(0);
+    ui->bandwidthItemLimitSpinBox->setValue(0);
+    ui->bandwidthReducedLimitSpinBox->setValue(0);
+    ui->bandwidthReducedFromTimeEdit->setTime(QTime(8, 0));
+    ui->bandwidthReducedToTimeEdit->setTime(QTime(18, 0));
+    ui->retryMaxAttemptsSpinBox->setValue(5);
+    ui->retryDelaySpinBox->setValue(5);
+
     ui->connectionProtocolComboBox->setCurrentIndex(0);
     ui->connectionTimeoutSpinBox->setValue(DEFAULT_TIMEOUT_SECS);
+    ui->connectionsPerHostSpinBox->setValue(6);
+    ui->http2CheckBox->setChecked(false);
+    ui->connectionWarmUpCheckBox->setChecked(true);
+    ui->preflightProbeCheckBox->setChecked(false);
 
     ui->useRemoteLastModifiedTimeCheckBox->setChecked(true);
     ui->useRemoteCreationTimeCheckBox->setChecked(true);
     ui->useRemoteAccessTimeCheckBox->setChecked(false);
     ui->useRemoteMetadataChangeTimeCheckBox->setChecked(false);
+    ui->filePreallocationCheckBox->setChecked(true);
+    ui->diskSpaceCheckBox->setChecked(true);
+    ui->ioUringCheckBox->setChecked(false);
+    ui->ioUringCheckBox->setEnabled(DiskWriter::isIoUringSupported());
 
     ui->streamMarkWatchedCheckBox->setChecked(false);
     ui->streamSubtitleCheckBox->setChecked(false);
@@ -494,7 +516,18 @@ void PreferenceDialog::read()
 
     // Tab Network
     ui->maxSimultaneousDownloadSlider->setValue(m_settings->maxSimultaneousDownloads());
+    ui->autoSimultaneousDownloadCheckBox->setChecked(m_settings->isAutoSimultaneousDownloadsEnabled());
     ui->concurrentFragmentSlider->setValue(m_settings->concurrentFragments());
+    ui->schedulingPolicyComboBox->setCurrentIndex(m_settings->schedulingPolicy());
+    ui->maxDownloadsPerHostSpinBox->setValue(m_settings->maxDownloadsPerHost());
+    ui->bandwidthLimitSpinBox->setValue(m_settings->bandwidthLimit());
+    ui->bandwidthHostLimitSpinBox->setValue(m_settings->bandwidthHostLimit());
+    ui->bandwidthItemLimitSpinBox->setValue(m_settings->bandwidthItemLimit());
+    ui->bandwidthReducedLimitSpinBox->setValue(m_settings->bandwidthReducedLimit());
+    ui->bandwidthReducedFromTimeEdit->setTime(QTime::fromString(m_settings->bandwidthReducedFrom(), "HH:mm"));
+    ui->bandwidthReducedToTimeEdit->setTime(QTime::fromString(m_settings->bandwidthReducedTo(), "HH:mm"));
+    ui->retryMaxAttemptsSpinBox->setValue(m_settings->retryMaxAttempts());
+    ui->retryDelaySpinBox->setValue(m_settings->retryDelay());
 
     ui->customBatchGroupBox->setChecked(m_settings->isCustomBatchEnabled());
     ui->customBatchButtonLabelLineEdit->setText(m_settings->customBatchButtonLabel());
@@ -502,6 +535,10 @@ void PreferenceDialog::read()
 
     ui->connectionProtocolComboBox->setCurrentIndex(m_settings->connectionProtocol());
     ui->connectionTimeoutSpinBox->setValue(m_settings->connectionTimeout());
+    ui->connectionsPerHostSpinBox->setValue(m_settings->connectionsPerHost());
+    ui->http2CheckBox->setChecked(m_settings->isHttp2Enabled());
+    ui->connectionWarmUpCheckBox->setChecked(m_settings->isConnectionWarmUpEnabled());
+    ui->preflightProbeCheckBox->setChecked(m_settings->isPreflightProbeEnabled());
 
     int proxyIndex = qBound(0, m_settings->proxyType(), ui->proxyTypeComboBox->count() - 1);
     ui->proxyTypeComboBox->setCurrentIndex(proxyIndex);
@@ -515,6 +552,9 @@ void PreferenceDialog::read()
     ui->useRemoteCreationTimeCheckBox->setChecked(m_settings->isRemoteCreationTimeEnabled());
     ui->useRemoteAccessTimeCheckBox->setChecked(m_settings->isRemoteAccessTimeEnabled());
     ui->useRemoteMetadataChangeTimeCheckBox->setChecked(m_settings->isRemoteMetadataChangeTimeEnabled());
+    ui->filePreallocationCheckBox->setChecked(m_settings->isFilePreallocationEnabled());
+    ui->diskSpaceCheckBox->setChecked(m_settings->isDiskSpaceCheckEnabled());
+    ui->ioUringCheckBox->setChecked(m_settings->isIoUringEnabled());
 
     ui->streamMarkWatchedCheckBox->setChecked(m_settings->isStreamMarkWatchedEnabled());
     ui->streamSubtitleCheckBox->setChecked(m_settings->isStreamSubtitleEnabled());
@@ -575,7 +615,18 @@ void PreferenceDialog::write()
 
     // Tab Network
     m_settings->setMaxSimultaneousDownloads(ui->maxSimultaneousDownloadSlider->value());
+    m_settings->setAutoSimultaneousDownloadsEnabled(ui->autoSimultaneousDownloadCheckBox->isChecked());
     m_settings->setConcurrentFragments(ui->concurrentFragmentSlider->value());
+    m_settings->setSchedulingPolicy(ui->schedulingPolicyComboBox->currentIndex());
+    m_settings->setMaxDownloadsPerHost(ui->maxDownloadsPerHostSpinBox->value());
+    m_settings->setBandwidthLimit(ui->bandwidthLimitSpinBox->value());
+    m_settings->setBandwidthHostLimit(ui->bandwidthHostLimitSpinBox->value());
+    m_settings->setBandwidthItemLimit(ui->bandwidthItemLimitSpinBox->value());
+    m_settings->setBandwidthReducedLimit(ui->bandwidthReducedLimitSpinBox->value());
+    m_settings->setBandwidthReducedFrom(ui->bandwidthReducedFromTimeEdit->time().toString("HH:mm"));
+    m_settings->setBandwidthReducedTo(ui->bandwidthReducedToTimeEdit->time().toString("HH:mm"));
+    m_settings->setRetryMaxAttempts(ui->retryMaxAttemptsSpinBox->value());
+    m_settings->setRetryDelay(ui->retryDelaySpinBox->value());
 
     m_settings->setCustomBatchEnabled(ui->customBatchGroupBox->isChecked());
     m_settings->setCustomBatchButtonLabel(ui->customBatchButtonLabelLineEdit->text());
@@ -590,11 +641,18 @@ void PreferenceDialog::write()
 
     m_settings->setConnectionProtocol(ui->connectionProtocolComboBox->currentIndex());
     m_settings->setConnectionTimeout(ui->connectionTimeoutSpinBox->value());
+    m_settings->setConnectionsPerHost(ui->connectionsPerHostSpinBox->value());
+    m_settings->setHttp2Enabled(ui->http2CheckBox->isChecked());
+    m_settings->setConnectionWarmUpEnabled(ui->connectionWarmUpCheckBox->isChecked());
+    m_settings->setPreflightProbeEnabled(ui->preflightProbeCheckBox->isChecked());
 
     m_settings->setRemoteLastModifiedTimeEnabled(ui->useRemoteLastModifiedTimeCheckBox->isChecked());
     m_settings->setRemoteCreationTimeEnabled(ui->useRemoteCreationTimeCheckBox->isChecked());
     m_settings->setRemoteAccessTimeEnabled(ui->useRemoteAccessTimeCheckBox->isChecked());
     m_settings->setRemoteMetadataChangeTimeEnabled(ui->useRemoteMetadataChangeTimeCheckBox->isChecked());
+    m_settings->setFilePreallocationEnabled(ui->filePreallocationCheckBox->isChecked());
+    m_settings->setDiskSpaceCheckEnabled(ui->diskSpaceCheckBox->isChecked());
+    m_settings->setIoUringEnabled(ui->ioUringCheckBox->isChecked());
 
     m_settings->setStreamMarkWatchedEnabled(ui->streamMarkWatchedCheckBox->isChecked());
     m_settings->setStreamSubtitleEnabled(ui->streamSubtitleCheckBox->isChecked());
@@ -0,0 +1,135 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fileexporter.h"
+
+#include <Core/DownloadEngine>
+#include <Core/IDownloadItem>
+#include <Io/FileWriter>
+#include <Io/IFileHandler>
+
+#include <QtCore/QFile>
+#include <QtCore/QThread>
+#include <QtCore/QUrl>
+
+/*!
+ * \class FileExporter
+ *
+ * The class FileExporter writes the URLs of the items in the background.
+ *
+ * The URLs are copied on the GUI thread, then a worker thread writes them
+ * batch by batch. A canceled export removes the partial file.
+ */
+
+FileExporter::FileExporter(DownloadEngine *engine, QObject *parent) : QObject(parent)
+  , m_engine(engine)
+{
+}
+
+FileExporter::~FileExporter()
+{
+    if (m_thread) {
+        cancel();
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Starts the export of the items. finished() is emitted once it's done.
+ */
+void FileExporter::start(const QString &fileName)
+{
+    if (isRunning()) {
+        return;
+    }
+    m_isCanceled = false;
+    m_isOk = false;
+    m_errorString.clear();
+
+    {
+        FileWriter writer(fileName);
+        if (!writer.isStreamable()) {
+            m_isOk = writer.write(m_engine);
+            if (!m_isOk) {
+                m_errorString = writer.errorString();
+            }
+            QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection, Q_ARG(bool, m_isOk));
+            return;
+        }
+    }
+
+    const QList<IDownloadItem*> items = m_engine->downloadItems();
+    QList<QUrl> urls;
+    urls.reserve(items.count());
+    for (auto item : items) {
+        urls.append(item->sourceUrl());
+    }
+
+    m_thread = QThread::create([this, fileName, urls]() {
+        const qint64 total = urls.count();
+        {
+            FileWriter writer(fileName);
+            m_isOk = writer.writeUrls(urls, IFileHandler::defaultBatchSize, [&](qsizetype written) {
+                if (m_isCanceled) {
+                    return false;
+                }
+                emit progress(written, total);
+                return true;
+            });
+            if (!m_isOk && !m_isCanceled) {
+                m_errorString = writer.errorString();
+            }
+        }
+        if (m_isCanceled) {
+            QFile::remove(fileName);
+        }
+    });
+    m_thread->setObjectName(QLatin1String("Export thread"));
+    connect(m_thread, SIGNAL(finished()), this, SLOT(onThreadFinished()));
+    m_thread->start();
+}
+
+void FileExporter::cancel()
+{
+    m_isCanceled = true;
+}
+
+bool FileExporter::isRunning() const
+{
+    return m_thread != Q_NULLPTR;
+}
+
+bool FileExporter::isCanceled() const
+{
+    return m_isCanceled;
+}
+
+QString FileExporter::errorString() const
+{
+    return m_errorString;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void FileExporter::onThreadFinished()
+{
+    m_thread->deleteLater();
+    m_thread = Q_NULLPTR;
+    emit finished(m_isOk);
+}
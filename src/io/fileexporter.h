@@ -0,0 +1,63 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IO_FILE_EXPORTER_H
+#define IO_FILE_EXPORTER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+
+#include <atomic>
+
+class DownloadEngine;
+class QThread;
+
+class FileExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileExporter(DownloadEngine *engine, QObject *parent = Q_NULLPTR);
+    ~FileExporter() Q_DECL_OVERRIDE;
+
+    void start(const QString &fileName);
+
+    bool isRunning() const;
+    bool isCanceled() const;
+
+    QString errorString() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void progress(qint64 written, qint64 total);
+    void finished(bool ok);
+
+private slots:
+    void onThreadFinished();
+
+private:
+    DownloadEngine *m_engine;
+    QThread *m_thread{Q_NULLPTR};
+    std::atomic<bool> m_isCanceled{false};
+
+    /* Written by the worker thread, read once it's finished */
+    bool m_isOk{false};
+    QString m_errorString;
+};
+
+#endif // IO_FILE_EXPORTER_H
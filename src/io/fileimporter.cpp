@@ -0,0 +1,203 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "fileimporter.h"
+
+#include <Core/DownloadEngine>
+#include <Core/IDownloadItem>
+#include <Io/FileReader>
+#include <Io/IFileHandler>
+
+#include <QtCore/QDebug>
+#include <QtCore/QSet>
+#include <QtCore/QThread>
+
+constexpr int max_pending_batches = 4; ///< Batches read ahead, not appended yet
+constexpr int msec_wait_batch = 50;
+
+/*!
+ * \class FileImporter
+ *
+ * The class FileImporter imports the URLs of a file in the background.
+ *
+ * A worker thread parses the file incrementally, and drops the URLs already
+ * in the queue or already read. The GUI thread creates the items of each
+ * batch, and appends them to the engine, batch by batch. The worker stays
+ * at most a few batches ahead, so that a huge file doesn't fill the memory.
+ *
+ * The formats that can't be streamed (e.g. torrent files) are read at once.
+ */
+
+FileImporter::FileImporter(DownloadEngine *engine, QObject *parent) : QObject(parent)
+  , m_engine(engine)
+  , m_pendingBatches(max_pending_batches)
+{
+}
+
+FileImporter::~FileImporter()
+{
+    if (m_thread) {
+        cancel();
+        m_thread->wait();
+        delete m_thread;
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Starts the import. finished() is emitted once it's done.
+ */
+void FileImporter::start(const QString &fileName)
+{
+    if (isRunning()) {
+        return;
+    }
+    m_isCanceled = false;
+    m_duplicateCount = 0;
+    m_importedCount = 0;
+    m_isOk = false;
+    m_errorString.clear();
+
+    {
+        FileReader reader(fileName);
+        if (!reader.isStreamable()) {
+            m_isOk = reader.read(m_engine);
+            if (!m_isOk) {
+                m_errorString = reader.errorString();
+            }
+            QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection, Q_ARG(bool, m_isOk));
+            return;
+        }
+    }
+
+    QSet<QString> knownUrls;
+    const QList<IDownloadItem*> items = m_engine->downloadItems();
+    knownUrls.reserve(items.count());
+    for (auto item : items) {
+        knownUrls.insert(item->sourceUrl().toString());
+    }
+
+    m_thread = QThread::create([this, fileName, knownUrls]() mutable {
+        FileReader reader(fileName);
+        m_isOk = reader.readUrls(IFileHandler::defaultBatchSize, [&](const QList<QUrl> &urls) {
+            QList<QUrl> newUrls;
+            newUrls.reserve(urls.count());
+            for (const auto &url : urls) {
+                const QString key = url.toString();
+                if (knownUrls.contains(key)) {
+                    m_duplicateCount++;
+                    continue;
+                }
+                knownUrls.insert(key);
+                newUrls.append(url);
+            }
+            /* Wait for the GUI thread to append the previous batches */
+            while (!m_pendingBatches.tryAcquire(1, msec_wait_batch)) {
+                if (m_isCanceled) {
+                    return false;
+                }
+            }
+            if (m_isCanceled) {
+                m_pendingBatches.release();
+                return false;
+            }
+            const qint64 position = reader.position();
+            const qint64 size = reader.size();
+            QMetaObject::invokeMethod(this, [this, newUrls, position, size]() {
+                appendBatch(newUrls);
+                m_pendingBatches.release();
+                emit progress(position, size);
+            }, Qt::QueuedConnection);
+            return true;
+        });
+        if (!m_isOk && !m_isCanceled) {
+            m_errorString = reader.errorString();
+        }
+    });
+    m_thread->setObjectName(QLatin1String("Import thread"));
+    connect(m_thread, SIGNAL(finished()), this, SLOT(onThreadFinished()));
+    m_thread->start();
+}
+
+/*!
+ * \brief Stops the reading. The items already appended stay in the queue.
+ */
+void FileImporter::cancel()
+{
+    m_isCanceled = true;
+}
+
+bool FileImporter::isRunning() const
+{
+    return m_thread != Q_NULLPTR;
+}
+
+bool FileImporter::isCanceled() const
+{
+    return m_isCanceled;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+qsizetype FileImporter::importedCount() const
+{
+    return m_importedCount;
+}
+
+/*!
+ * \brief Returns the count of URLs ignored, because already in the queue,
+ * or repeated in the file.
+ */
+qsizetype FileImporter::duplicateCount() const
+{
+    return m_duplicateCount;
+}
+
+QString FileImporter::errorString() const
+{
+    return m_errorString;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void FileImporter::appendBatch(const QList<QUrl> &urls)
+{
+    if (m_isCanceled || urls.isEmpty()) {
+        return;
+    }
+    QList<IDownloadItem*> items;
+    items.reserve(urls.count());
+    for (const auto &url : urls) {
+        IDownloadItem *item = m_engine->createItem(url);
+        if (!item) {
+            qWarning("DownloadEngine::createItem() not overridden. It still returns null pointer!");
+            cancel();
+            return;
+        }
+        items.append(item);
+    }
+    m_engine->append(items, false);
+    m_importedCount += items.count();
+}
+
+void FileImporter::onThreadFinished()
+{
+    /* The batches were queued before this signal, so they're all appended */
+    m_thread->deleteLater();
+    m_thread = Q_NULLPTR;
+    emit finished(m_isOk);
+}
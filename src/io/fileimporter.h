@@ -0,0 +1,73 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef IO_FILE_IMPORTER_H
+#define IO_FILE_IMPORTER_H
+
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QSemaphore>
+#include <QtCore/QString>
+#include <QtCore/QUrl>
+
+#include <atomic>
+
+class DownloadEngine;
+class QThread;
+
+class FileImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileImporter(DownloadEngine *engine, QObject *parent = Q_NULLPTR);
+    ~FileImporter() Q_DECL_OVERRIDE;
+
+    void start(const QString &fileName);
+
+    bool isRunning() const;
+    bool isCanceled() const;
+
+    qsizetype importedCount() const;
+    qsizetype duplicateCount() const;
+    QString errorString() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void progress(qint64 bytesRead, qint64 bytesTotal);
+    void finished(bool ok);
+
+private slots:
+    void onThreadFinished();
+
+private:
+    DownloadEngine *m_engine;
+    QThread *m_thread{Q_NULLPTR};
+    QSemaphore m_pendingBatches;
+    std::atomic<bool> m_isCanceled{false};
+    std::atomic<qsizetype> m_duplicateCount{0};
+    qsizetype m_importedCount{0};
+
+    /* Written by the worker thread, read once it's finished */
+    bool m_isOk{false};
+    QString m_errorString;
+
+    void appendBatch(const QList<QUrl> &urls);
+};
+
+#endif // IO_FILE_IMPORTER_H
@@ -100,6 +100,62 @@ bool FileReader::read(DownloadEngine *engine)
     return true;
 }
 
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns true if the file can be read incrementally, by readUrls().
+ */
+bool FileReader::isStreamable()
+{
+    if (m_handler.isNull() && !initHandler()) {
+        return false;
+    }
+    return m_handler->isStreamable();
+}
+
+/*!
+ * \brief Reads the URLs of the file, by batches passed to the callback.
+ *
+ * Unlike read(), it doesn't create the items, so that it can run in a
+ * worker thread.
+ */
+bool FileReader::readUrls(int batchSize, const IFileHandler::ReadCallback &callback)
+{
+    if (!isStreamable()) {
+        if (m_handler) {
+            m_fileReaderError = UnsupportedFormatError;
+            m_errorString = FileReader::tr("Unsupported format");
+        }
+        return false;
+    }
+    try {
+        const bool result = m_handler->readUrls(batchSize, callback);
+        if (!result) {
+            m_fileReaderError = InvalidDataError;
+            m_errorString = FileReader::tr("Unable to read data");
+            return false;
+        }
+    } catch (std::exception const& e) {
+        m_fileReaderError = UnknownError;
+        m_errorString = QString::fromUtf8(e.what());
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief Returns the position of the reading in the file, in bytes.
+ */
+qint64 FileReader::position() const
+{
+    return m_device ? m_device->pos() : 0;
+}
+
+qint64 FileReader::size() const
+{
+    return m_device ? m_device->size() : 0;
+}
+
 FileReader::FileReaderError FileReader::error() const
 {
     return m_fileReaderError;
@@ -125,7 +181,7 @@ IFileHandlerPtr FileReader::createReadHandlerHelper(QIODevice *device)
     }
     // check if any built-in handlers can write the data
     if (!handler && !suffix.isEmpty()) {
-        handler = Io::findHandlerFromSuffix(suffix);
+        handler = Io::createHandlerFromSuffix(suffix);
     }
 
     /// \todo implement autoDetectFormat ?
@@ -43,6 +43,12 @@ public:
 
     bool read(DownloadEngine *engine);
 
+    /* Streaming */
+    bool isStreamable();
+    bool readUrls(int batchSize, const IFileHandler::ReadCallback &callback);
+    qint64 position() const;
+    qint64 size() const;
+
     FileReaderError error() const;
     QString errorString() const;
 
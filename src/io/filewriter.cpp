@@ -110,6 +110,46 @@ bool FileWriter::write(DownloadEngine *engine)
     return true;
 }
 
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * \brief Returns true if the file can be written incrementally, by writeUrls().
+ */
+bool FileWriter::isStreamable()
+{
+    if (!canWrite()) {
+        return false;
+    }
+    return m_handler->isStreamable();
+}
+
+/*!
+ * \brief Writes the URLs, and passes the count written to the callback
+ * after each batch.
+ *
+ * Unlike write(), it doesn't access the items, so that it can run in a
+ * worker thread.
+ */
+bool FileWriter::writeUrls(const QList<QUrl> &urls, int batchSize, const IFileHandler::WriteCallback &callback)
+{
+    if (!isStreamable()) {
+        if (m_handler) {
+            m_fileWriterError = FileWriter::UnsupportedFormatError;
+            m_errorString = FileWriter::tr("Unsupported format");
+        }
+        return false;
+    }
+    if (!m_handler->writeUrls(urls, batchSize, callback)) {
+        m_fileWriterError = FileWriter::DeviceError;
+        m_errorString = FileWriter::tr("Unable to write data");
+        return false;
+    }
+    if (auto file = qobject_cast<QFile *>(m_device)) {
+        file->flush();
+    }
+    return true;
+}
+
 FileWriter::FileWriterError FileWriter::error() const
 {
     return m_fileWriterError;
@@ -137,7 +177,7 @@ IFileHandlerPtr FileWriter::createWriteHandlerHelper(QIODevice *device)
     }
     // check if any built-in handlers can write the data
     if (!handler && !suffix.isEmpty()) {
-        handler = Io::findHandlerFromSuffix(suffix);
+        handler = Io::createHandlerFromSuffix(suffix);
     }
     if (!handler) {
         return IFileHandlerPtr();
@@ -44,6 +44,10 @@ public:
     bool canWrite();
     bool write(DownloadEngine *engine);
 
+    /* Streaming */
+    bool isStreamable();
+    bool writeUrls(const QList<QUrl> &urls, int batchSize, const IFileHandler::WriteCallback &callback);
+
     FileWriterError error() const;
     QString errorString() const;
 
@@ -48,16 +48,15 @@ static const FileFormat formats[] = {
     { Q_NULLPTR, Q_NULLPTR, IFileHandlerPtr() }
 };
 
-static IFileHandlerPtr findHandlerFromSuffix(const QString &suffix)
+/*!
+ * \brief Returns a new handler, not shared, that can be used in a worker thread.
+ */
+static IFileHandlerPtr createHandlerFromSuffix(const QString &suffix)
 {
-    IFileHandlerPtr handler;
-    for (const FileFormat *fmt = &formats[0]; fmt->suffix; fmt++) {
-        if (suffix == fmt->suffix) {
-            handler = fmt->handler;
-            break;
-        }
-    }
-    return handler;
+    if (suffix == "txt") {     return IFileHandlerPtr(new TextHandler()); }
+    if (suffix == "json") {    return IFileHandlerPtr(new JsonHandler()); }
+    if (suffix == "torrent") { return IFileHandlerPtr(new TorrentHandler()); }
+    return IFileHandlerPtr();
 }
 
 }
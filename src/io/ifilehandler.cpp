@@ -16,6 +16,9 @@
 
 #include "ifilehandler.h"
 
+#include <Core/IDownloadItem>
+
+#include <QtCore/QDebug>
 #include <QtCore/QIODevice>
 
 /*!
@@ -39,3 +42,58 @@ bool IFileHandler::write(const DownloadEngine &engine)
     Q_UNUSED(engine);
     return false;
 }
+
+/******************************************************************************
+ ******************************************************************************/
+bool IFileHandler::isStreamable() const
+{
+    return false;
+}
+
+bool IFileHandler::readUrls(int batchSize, const ReadCallback &callback)
+{
+    Q_UNUSED(batchSize);
+    Q_UNUSED(callback);
+    return false;
+}
+
+bool IFileHandler::writeUrls(const QList<QUrl> &urls, int batchSize, const WriteCallback &callback)
+{
+    Q_UNUSED(urls);
+    Q_UNUSED(batchSize);
+    Q_UNUSED(callback);
+    return false;
+}
+
+/*!
+ * \brief Creates the items of the URLs, and appends them to the engine.
+ */
+bool IFileHandler::appendUrls(DownloadEngine *engine, const QList<QUrl> &urls)
+{
+    if (urls.isEmpty()) {
+        return true;
+    }
+    QList<IDownloadItem*> items;
+    items.reserve(urls.count());
+    for (const auto &url : urls) {
+        IDownloadItem *item = engine->createItem(url);
+        if (!item) {
+            qWarning("DownloadEngine::createItem() not overridden. It still returns null pointer!");
+            return false;
+        }
+        items.append(item);
+    }
+    engine->append(items, false);
+    return true;
+}
+
+QList<QUrl> IFileHandler::sourceUrls(const DownloadEngine &engine)
+{
+    const QList<IDownloadItem*> items = engine.downloadItems();
+    QList<QUrl> urls;
+    urls.reserve(items.count());
+    for (auto item : items) {
+        urls.append(item->sourceUrl());
+    }
+    return urls;
+}
@@ -19,7 +19,11 @@
 
 #include <Core/DownloadEngine>
 
+#include <QtCore/QList>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QUrl>
+
+#include <functional>
 
 class QIODevice;
 
@@ -49,6 +53,38 @@ public:
      */
     virtual bool write(const DownloadEngine &engine);
 
+    /* Streaming */
+    static constexpr int defaultBatchSize = 1000;
+
+    using ReadCallback = std::function<bool(const QList<QUrl> &urls)>;
+    using WriteCallback = std::function<bool(qsizetype written)>;
+
+    /*!
+     * \brief Returns true if the handler reads and writes URLs incrementally,
+     * with readUrls() and writeUrls(), that can run in a worker thread.
+     */
+    virtual bool isStreamable() const;
+
+    /*!
+     * \brief Read the internal device incrementally, and pass the URLs
+     * to the callback by batches of at most \a batchSize. (Optional)
+     * The callback returns false to cancel the reading.
+     * \return true if the whole device was read.
+     */
+    virtual bool readUrls(int batchSize, const ReadCallback &callback);
+
+    /*!
+     * \brief Write the URLs to the internal device, and pass the count of
+     * URLs written to the callback after each batch. (Optional)
+     * The callback returns false to cancel the writing.
+     * \return true if all the URLs were written.
+     */
+    virtual bool writeUrls(const QList<QUrl> &urls, int batchSize, const WriteCallback &callback);
+
+protected:
+    static bool appendUrls(DownloadEngine *engine, const QList<QUrl> &urls);
+    static QList<QUrl> sourceUrls(const DownloadEngine &engine);
+
 
 private:
     QIODevice *m_device{Q_NULLPTR};
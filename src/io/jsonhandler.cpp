@@ -20,11 +20,125 @@
 
 #include <QtCore/QDebug>
 #include <QtCore/QIODevice>
-#include <QtCore/QJsonArray>
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QUrl>
 
+constexpr qint64 bytes_per_chunk = 64 * 1024; ///< Size of the chunks of the device parsed at once
+
+/*
+ * Scans the document chunk by chunk, and parses the objects of the "links"
+ * array one at a time, so that the whole document is never in memory.
+ */
+class LinkScanner
+{
+public:
+    bool feed(const QByteArray &chunk, QList<QUrl> *urls);
+    bool isComplete() const;
+
+private:
+    QByteArray m_buffer;
+    qsizetype m_stringStart{-1};
+    qsizetype m_objectStart{-1};
+    QByteArray m_lastString;
+    int m_depth{0};
+    bool m_hasRoot{false};
+    bool m_inString{false};
+    bool m_isEscaped{false};
+    bool m_inLinks{false};
+};
+
+/*!
+ * Appends the URLs of the objects completed by the \a chunk.
+ * Returns false if the document is invalid.
+ */
+bool LinkScanner::feed(const QByteArray &chunk, QList<QUrl> *urls)
+{
+    const qsizetype from = m_buffer.size();
+    m_buffer += chunk;
+    for (qsizetype i = from; i < m_buffer.size(); ++i) {
+        const char c = m_buffer.at(i);
+        if (m_inString) {
+            if (m_isEscaped) {
+                m_isEscaped = false;
+            } else if (c == '\\') {
+                m_isEscaped = true;
+            } else if (c == '"') {
+                m_inString = false;
+                if (m_depth == 1) {
+                    m_lastString = m_buffer.mid(m_stringStart + 1, i - m_stringStart - 1);
+                }
+            }
+            continue;
+        }
+        switch (c) {
+        case '"':
+            if (m_depth == 0) {
+                return false;
+            }
+            m_inString = true;
+            m_stringStart = i;
+            break;
+        case '{':
+        case '[':
+            if (m_depth == 0) {
+                if (c != '{' || m_hasRoot) {
+                    return false;
+                }
+                m_hasRoot = true;
+            } else if (m_depth == 1 && c == '[') {
+                m_inLinks = m_lastString == "links";
+            } else if (m_depth == 2 && c == '{' && m_inLinks) {
+                m_objectStart = i;
+            }
+            m_depth++;
+            break;
+        case '}':
+        case ']':
+            m_depth--;
+            if (m_depth < 0) {
+                return false;
+            }
+            if (m_depth == 2 && c == '}' && m_objectStart >= 0) {
+                QJsonParseError error{};
+                const QJsonDocument doc = QJsonDocument::fromJson(
+                            m_buffer.mid(m_objectStart, i - m_objectStart + 1), &error);
+                if (error.error != QJsonParseError::NoError) {
+                    return false;
+                }
+                urls->append(QUrl(doc.object()["url"].toString()));
+                m_objectStart = -1;
+            } else if (m_depth == 1 && c == ']') {
+                m_inLinks = false;
+            }
+            break;
+        default:
+            if (m_depth == 0 && !QChar::isSpace(static_cast<uchar>(c))) {
+                return false;
+            }
+            break;
+        }
+    }
+    /* Keep only the bytes of the object or the string not complete yet */
+    qsizetype keep = m_buffer.size();
+    if (m_objectStart >= 0) {
+        keep = m_objectStart;
+    } else if (m_inString && m_depth == 1) {
+        keep = m_stringStart;
+    }
+    m_buffer.remove(0, keep);
+    m_objectStart = m_objectStart >= 0 ? m_objectStart - keep : -1;
+    m_stringStart = m_inString && m_depth == 1 ? m_stringStart - keep : -1;
+    return true;
+}
+
+bool LinkScanner::isComplete() const
+{
+    return m_hasRoot && m_depth == 0 && !m_inString;
+}
+
+/******************************************************************************
+ ******************************************************************************/
 
 bool JsonHandler::canRead() const
 {
@@ -42,56 +156,75 @@ bool JsonHandler::read(DownloadEngine *engine)
         qWarning("JsonHandler::read() Can't read into null pointer");
         return false;
     }
+    return readUrls(defaultBatchSize, [engine](const QList<QUrl> &urls) {
+        return appendUrls(engine, urls);
+    });
+}
+
+bool JsonHandler::write(const DownloadEngine &engine)
+{
+    return writeUrls(sourceUrls(engine), defaultBatchSize, [](qsizetype) { return true; });
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool JsonHandler::isStreamable() const
+{
+    return true;
+}
+
+/*!
+ * \brief Reads the "links" array, object by object.
+ *
+ * The batches read before a syntax error are already passed to the callback.
+ */
+bool JsonHandler::readUrls(int batchSize, const ReadCallback &callback)
+{
     QIODevice *d = device();
     if (!d->isReadable()) {
         return false;
     }
-    QByteArray saveData = d->readAll();
-    QJsonParseError ok{};
-    QJsonDocument loadDoc( QJsonDocument::fromJson(saveData, &ok) );
-
-    if (ok.error != QJsonParseError::NoError) {
+    LinkScanner scanner;
+    QList<QUrl> urls;
+    while (!d->atEnd()) {
+        const QByteArray chunk = d->read(bytes_per_chunk);
+        if (chunk.isEmpty() || !scanner.feed(chunk, &urls)) {
+            break;
+        }
+        if (urls.count() >= batchSize) {
+            if (!callback(urls)) {
+                return false;
+            }
+            urls.clear();
+        }
+    }
+    if (!scanner.isComplete()) {
+        callback(urls);
         qCritical("Couldn't parse JSON file.");
         return false;
     }
-
-    QJsonObject json = loadDoc.object();
-
-    QList<IDownloadItem *> items;
-
-    QJsonArray jobsArray = json["links"].toArray();
-    for (int i = 0; i < jobsArray.size(); ++i) {
-        QJsonObject jobObject = jobsArray[i].toObject();
-
-        QUrl url = QUrl(jobObject["url"].toString());
-        IDownloadItem *item = engine->createItem(url);
-        items.append(item);
-    }
-
-    engine->append(items, false);
-    return true;
+    return callback(urls);
 }
 
-bool JsonHandler::write(const DownloadEngine &engine)
+/*!
+ * \brief Writes the "links" array, one object per line.
+ */
+bool JsonHandler::writeUrls(const QList<QUrl> &urls, int batchSize, const WriteCallback &callback)
 {
     QIODevice *d = device();
-    QTextStream out(d);
     if (!d->isWritable()) {
         return false;
     }
-    QJsonObject json;
-    QJsonArray jobsArray;
-    foreach (auto item, engine.downloadItems()) {
-        QUrl url = item->sourceUrl();
-
+    d->write("{\n    \"links\": [");
+    for (qsizetype i = 0; i < urls.count(); ++i) {
         QJsonObject jobObject;
-        jobObject["url"] = url.toString();
-        jobsArray.append(jobObject);
+        jobObject["url"] = urls.at(i).toString();
+        d->write(i == 0 ? "\n        " : ",\n        ");
+        d->write(QJsonDocument(jobObject).toJson(QJsonDocument::Compact));
+        if ((i + 1) % batchSize == 0 && !callback(i + 1)) {
+            return false;
+        }
     }
-    json["links"] = jobsArray;
-
-    QJsonDocument saveDoc(json);
-    d->write( saveDoc.toJson() );
-
-    return true;
+    d->write("\n    ]\n}\n");
+    return callback(urls.count());
 }
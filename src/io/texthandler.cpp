@@ -46,32 +46,54 @@ bool TextHandler::read(DownloadEngine *engine)
         qWarning("TextHandler::read() cannot read into null pointer");
         return false;
     }
+    return readUrls(defaultBatchSize, [engine](const QList<QUrl> &urls) {
+        return appendUrls(engine, urls);
+    });
+}
+
+bool TextHandler::write(const DownloadEngine &engine)
+{
+    return writeUrls(sourceUrls(engine), defaultBatchSize, [](qsizetype) { return true; });
+}
+
+/******************************************************************************
+ ******************************************************************************/
+bool TextHandler::isStreamable() const
+{
+    return true;
+}
+
+/*!
+ * \brief Reads one URL per line, line by line.
+ */
+bool TextHandler::readUrls(int batchSize, const ReadCallback &callback)
+{
     QIODevice *d = device();
     QTextStream in(d);
     in.setEncoding(QStringConverter::Utf8);
     if (!d->isReadable()) {
         return false;
     }
-    QList<IDownloadItem*> items;
+    QList<QUrl> urls;
+    urls.reserve(batchSize);
     QString line;
     while (readLineInto(in, &line)) {
         line = line.simplified();
         if (line.isEmpty()) {
             continue;
         }
-        const QUrl url(line);
-        IDownloadItem *item = engine->createItem(url);
-        if (!item) {
-            qWarning("DownloadEngine::createItem() not overridden. It still returns null pointer!");
-            return false;
+        urls.append(QUrl(line));
+        if (urls.count() >= batchSize) {
+            if (!callback(urls)) {
+                return false;
+            }
+            urls.clear();
         }
-        items.append(item);
     }
-    engine->append(items, false);
-    return true;
+    return callback(urls);
 }
 
-bool TextHandler::write(const DownloadEngine &engine)
+bool TextHandler::writeUrls(const QList<QUrl> &urls, int batchSize, const WriteCallback &callback)
 {
     QIODevice *d = device();
     QTextStream out(d);
@@ -79,10 +101,16 @@ bool TextHandler::write(const DownloadEngine &engine)
     if (!d->isWritable()) {
         return false;
     }
-    foreach (auto item, engine.downloadItems()) {
-        QUrl url = item->sourceUrl();
-        QByteArray data = url.toString().toUtf8();
+    for (qsizetype i = 0; i < urls.count(); ++i) {
+        QByteArray data = urls.at(i).toString().toUtf8();
         out << data << '\n';
+        if ((i + 1) % batchSize == 0) {
+            out.flush();
+            if (!callback(i + 1)) {
+                return false;
+            }
+        }
     }
-    return true;
+    out.flush();
+    return callback(urls.count());
 }
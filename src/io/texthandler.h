@@ -30,6 +30,10 @@ public:
     bool read(DownloadEngine *engine) Q_DECL_OVERRIDE;
     bool write(const DownloadEngine &engine) Q_DECL_OVERRIDE;
 
+    bool isStreamable() const Q_DECL_OVERRIDE;
+    bool readUrls(int batchSize, const ReadCallback &callback) Q_DECL_OVERRIDE;
+    bool writeUrls(const QList<QUrl> &urls, int batchSize, const WriteCallback &callback) Q_DECL_OVERRIDE;
+
 private:
 };
 
@@ -49,6 +49,8 @@
 #include <Dialogs/TutorialDialog>
 #include <Dialogs/UpdateDialog>
 #include <Ipc/InterProcessCommunication>
+#include <Io/FileExporter>
+#include <Io/FileImporter>
 #include <Io/FileReader>
 #include <Io/FileWriter>
 #include <Widgets/DownloadQueueView>
@@ -79,6 +81,7 @@
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QMenu>
 #include <QtWidgets/QMessageBox>
+#include <QtWidgets/QProgressDialog>
 #include <QtWidgets/QSplitter>
 
 #ifdef USE_QT_WINEXTRAS
@@ -150,8 +153,8 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent)
             this, SLOT(onJobAddedOrRemoved(DownloadRange)));
     connect(m_downloadManager, SIGNAL(jobRemoved(DownloadRange)),
             this, SLOT(onJobAddedOrRemoved(DownloadRange)));
-    connect(m_downloadManager, SIGNAL(jobStateChanged(IDownloadItem*)),
-            this, SLOT(onJobStateChanged(IDownloadItem*)));
+    connect(m_downloadManager, SIGNAL(jobsChanged(DownloadChanges)),
+            this, SLOT(onJobsChanged(DownloadChanges)));
     connect(m_downloadManager, SIGNAL(jobFinished(IDownloadItem*)),
             this, SLOT(onJobFinished(IDownloadItem*)));
     connect(m_downloadManager, SIGNAL(jobRenamed(QString, QString, bool)),
@@ -299,6 +302,8 @@ void MainWindow::createActions()
     connect(ui->actionManageMirrors, SIGNAL(triggered()), this, SLOT(manageMirrors()));
     connect(ui->actionOneMoreSegment, SIGNAL(triggered()), this, SLOT(oneMoreSegment()));
     connect(ui->actionOneFewerSegment, SIGNAL(triggered()), this, SLOT(oneFewerSegment()));
+    connect(ui->actionRaisePriority, SIGNAL(triggered()), this, SLOT(raisePriority()));
+    connect(ui->actionLowerPriority, SIGNAL(triggered()), this, SLOT(lowerPriority()));
     //! [1]
 
     //! [2] View
@@ -412,6 +417,9 @@ void MainWindow::createContextMenu()
     advanced->addAction(ui->actionOneMoreSegment);
     advanced->addAction(ui->actionOneFewerSegment);
     advanced->addSeparator();
+    advanced->addAction(ui->actionRaisePriority);
+    advanced->addAction(ui->actionLowerPriority);
+    advanced->addSeparator();
     advanced->addAction(ui->actionManageMirrors);
     advanced->addSeparator();
     advanced->addAction(ui->actionForceStart);
@@ -601,10 +609,20 @@ void MainWindow::oneFewerSegment()
     m_downloadManager->oneFewerSegment();
 }
 
+void MainWindow::raisePriority()
+{
+    m_downloadManager->raisePriority();
+}
+
+void MainWindow::lowerPriority()
+{
+    m_downloadManager->lowerPriority();
+}
+
 void MainWindow::showInformation()
 {
     if (m_downloadManager->selection().count() == 1) {
-        InformationDialog dialog(m_downloadManager->selection(), this);
+        InformationDialog dialog(m_downloadManager, m_downloadManager->selection(), this);
         int answer = dialog.exec();
         if (answer == QDialog::Accepted) {
             m_downloadManager->updateItems(m_downloadManager->selection());
@@ -1074,11 +1092,14 @@ void MainWindow::onJobAddedOrRemoved(const DownloadRange &/*range*/)
     refreshTitleAndStatus();
 }
 
-void MainWindow::onJobStateChanged(IDownloadItem * /*downloadItem*/)
+void MainWindow::onJobsChanged(const DownloadChanges &changes)
 {
-    // if (m_downloadManager->isSelected(downloadItem)) {
-    refreshMenus();
-    // }
+    for (const auto &change : changes) {
+        if (change.changes.testFlag(IDownloadItem::StateChange)) {
+            refreshMenus(); // once per batch
+            break;
+        }
+    }
     refreshTitleAndStatus();
 }
 
@@ -1125,9 +1146,9 @@ void MainWindow::refreshTitleAndStatus()
             ? QString("~%0").arg(Format::currentSpeedToString(speed))
             : QString();
 
-    const int completedCount = m_downloadManager->completedJobs().count();
-    const int runningCount = m_downloadManager->runningJobs().count();
-    const int failedCount = m_downloadManager->failedJobs().count();
+    const int completedCount = m_downloadManager->completedCount();
+    const int runningCount = m_downloadManager->runningCount();
+    const int failedCount = m_downloadManager->failedCount();
     const int count = m_downloadManager->count();
     const int doneCount = completedCount + failedCount;
 
@@ -1231,6 +1252,8 @@ void MainWindow::refreshMenus()
     ui->actionManageMirrors->setEnabled(hasAtLeastOneUncompletedSelected);
     ui->actionOneMoreSegment->setEnabled(hasAtLeastOneUncompletedSelected);
     ui->actionOneFewerSegment->setEnabled(hasAtLeastOneUncompletedSelected);
+    ui->actionRaisePriority->setEnabled(hasAtLeastOneUncompletedSelected);
+    ui->actionLowerPriority->setEnabled(hasAtLeastOneUncompletedSelected);
     //! [1]
 
     //! [2] View
@@ -1416,38 +1439,91 @@ QString MainWindow::askSaveFileName(const QString &fileFilter, const QString &ti
 
 /******************************************************************************
  ******************************************************************************/
-bool MainWindow::saveFile(const QString &path)
-{
-    FileWriter writer(path);
-    if (!writer.write(m_downloadManager)) {
-        qWarning() << tr("Can't save file.");
-        QMessageBox::warning(this, tr("Error"),
-                             QString("%0\n%1").arg(
-                                 tr("Can't save file %0:").arg(path),
-                                 writer.errorString()));
-        return false;
+static QProgressDialog* createFileProgressDialog(const QString &text, QWidget *parent)
+{
+    auto dialog = new QProgressDialog(text, QObject::tr("Cancel"), 0, 1000, parent);
+    dialog->setWindowModality(Qt::WindowModal);
+    dialog->setMinimumDuration(500);
+    dialog->setAutoClose(false);
+    dialog->setAutoReset(false);
+    return dialog;
+}
+
+static void setFileProgress(QProgressDialog *dialog, qint64 done, qint64 total)
+{
+    if (total > 0) {
+        dialog->setValue(int(qBound<qint64>(0, (1000 * done) / total, 1000)));
     }
-    this->refreshTitleAndStatus();
-    this->refreshMenus();
-    this->statusBar()->showMessage(tr("File saved"), 2000);
-    return true;
 }
 
 /******************************************************************************
  ******************************************************************************/
-bool MainWindow::loadFile(const QString &path)
-{
-    FileReader reader(path);
-    if (!reader.read(m_downloadManager)) {
-        qWarning() << tr("Can't load file.");
-        QMessageBox::warning(this, tr("Error"),
-                             QString("%0\n%1").arg(
-                                 tr("Can't load file %0:").arg(path),
-                                 reader.errorString()));
-        return false;
-    }
-    this->refreshTitleAndStatus();
-    this->refreshMenus();
-    this->statusBar()->showMessage(tr("File loaded"), 5000);
-    return true;
+void MainWindow::saveFile(const QString &path)
+{
+    auto exporter = new FileExporter(m_downloadManager, this);
+    auto progressDialog = createFileProgressDialog(tr("Saving %0...").arg(path), this);
+    connect(progressDialog, SIGNAL(canceled()), exporter, SLOT(cancel()));
+    connect(exporter, &FileExporter::progress, progressDialog, [progressDialog](qint64 written, qint64 total) {
+        setFileProgress(progressDialog, written, total);
+    });
+    connect(exporter, &FileExporter::finished, this, [this, exporter, progressDialog, path](bool ok) {
+        progressDialog->deleteLater();
+        exporter->deleteLater();
+        if (exporter->isCanceled()) {
+            this->statusBar()->showMessage(tr("Saving canceled"), 2000);
+            return;
+        }
+        if (!ok) {
+            qWarning() << tr("Can't save file.");
+            QMessageBox::warning(this, tr("Error"),
+                                 QString("%0\n%1").arg(
+                                     tr("Can't save file %0:").arg(path),
+                                     exporter->errorString()));
+            return;
+        }
+        this->refreshTitleAndStatus();
+        this->refreshMenus();
+        this->statusBar()->showMessage(tr("File saved"), 2000);
+    });
+    exporter->start(path);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void MainWindow::loadFile(const QString &path)
+{
+    auto importer = new FileImporter(m_downloadManager, this);
+    auto progressDialog = createFileProgressDialog(tr("Loading %0...").arg(path), this);
+    connect(progressDialog, SIGNAL(canceled()), importer, SLOT(cancel()));
+    connect(importer, &FileImporter::progress, progressDialog, [progressDialog](qint64 bytesRead, qint64 bytesTotal) {
+        setFileProgress(progressDialog, bytesRead, bytesTotal);
+    });
+    connect(importer, &FileImporter::finished, this, [this, importer, progressDialog, path](bool ok) {
+        progressDialog->deleteLater();
+        importer->deleteLater();
+        this->refreshTitleAndStatus();
+        this->refreshMenus();
+        if (importer->isCanceled()) {
+            this->statusBar()->showMessage(
+                        tr("Loading canceled (%0 links added)").arg(importer->importedCount()), 5000);
+            return;
+        }
+        if (!ok) {
+            qWarning() << tr("Can't load file.");
+            QMessageBox::warning(this, tr("Error"),
+                                 QString("%0\n%1").arg(
+                                     tr("Can't load file %0:").arg(path),
+                                     importer->errorString()));
+            return;
+        }
+        if (importer->duplicateCount() > 0) {
+            this->statusBar()->showMessage(
+                        tr("File loaded (%0 links added, %1 duplicates ignored)").arg(
+                            QString::number(importer->importedCount()),
+                            QString::number(importer->duplicateCount())), 5000);
+        } else {
+            this->statusBar()->showMessage(tr("File loaded"), 5000);
+        }
+    });
+    importer->start(path);
 }
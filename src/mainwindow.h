@@ -52,8 +52,8 @@ public:
     explicit MainWindow(QWidget *parent = Q_NULLPTR);
     ~MainWindow() Q_DECL_OVERRIDE;
 
-    bool saveFile(const QString &path);
-    bool loadFile(const QString &path);
+    void saveFile(const QString &path);
+    void loadFile(const QString &path);
 
 protected:
     void closeEvent(QCloseEvent *event) Q_DECL_OVERRIDE;
@@ -79,6 +79,8 @@ public slots:
     void manageMirrors();
     void oneMoreSegment();
     void oneFewerSegment();
+    void raisePriority();
+    void lowerPriority();
 
     // View
     void showInformation();
@@ -134,7 +136,7 @@ public slots:
 
 private slots:
     void onJobAddedOrRemoved(const DownloadRange &range);
-    void onJobStateChanged(IDownloadItem *downloadItem);
+    void onJobsChanged(const DownloadChanges &changes);
     void onJobFinished(IDownloadItem *downloadItem);
     void onJobRenamed(const QString &oldName, const QString &newName, bool success);
     void onSelectionChanged();
@@ -370,8 +370,6 @@ QueueItem::QueueItem(AbstractDownloadItem *downloadItem, QTreeWidget *view)
     this->setSizeHint(col_2_progress_bar, QSize(column_default_width, row_default_height));
     this->setFlags(Qt::ItemIsEditable | flags());
 
-    connect(m_downloadItem, SIGNAL(changed()), this, SLOT(updateItem()));
-
     updateItem();
 }
 
@@ -388,27 +386,39 @@ static QString estimatedTime(AbstractDownloadItem *downloadItem)
     }
 }
 
-void QueueItem::updateItem()
+/*!
+ * \brief Updates the columns of the given \a changes only.
+ */
+void QueueItem::updateItem(IDownloadItem::Changes changes)
 {
-    QString size;
-    if (m_downloadItem->bytesTotal() > 0) {
-        size = tr("%0 of %1").arg(
-                    Format::fileSizeToString(m_downloadItem->bytesReceived()),
-                    Format::fileSizeToString(m_downloadItem->bytesTotal()));
-    } else {
-        size = tr("Unknown");
+    if (changes & IDownloadItem::NameChange) {
+        this->setText(col_0_file_name      , m_downloadItem->localFileName());
+        this->setText(col_1_website_domain , m_downloadItem->sourceUrl().host()); /// \todo domain only
+    }
+    if (changes & IDownloadItem::StateChange) {
+        this->setData(col_2_progress_bar   , StateRole, m_downloadItem->state());
+    }
+    if (changes & (IDownloadItem::StateChange | IDownloadItem::ProgressChange)) {
+        QString size;
+        if (m_downloadItem->bytesTotal() > 0) {
+            size = tr("%0 of %1").arg(
+                        Format::fileSizeToString(m_downloadItem->bytesReceived()),
+                        Format::fileSizeToString(m_downloadItem->bytesTotal()));
+        } else {
+            size = tr("Unknown");
+        }
+        this->setData(col_2_progress_bar   , ProgressRole, m_downloadItem->progress());
+        this->setText(col_3_percent        , QString("%0%").arg(qMax(0, m_downloadItem->progress())));
+        this->setText(col_4_size           , size);
+    }
+    if (changes & (IDownloadItem::StateChange | IDownloadItem::ProgressChange
+                   | IDownloadItem::SpeedChange | IDownloadItem::OtherChange)) {
+        this->setText(col_5_estimated_time , estimatedTime(m_downloadItem));
+    }
+    if (changes & (IDownloadItem::StateChange | IDownloadItem::SpeedChange)) {
+        QString speed = Format::currentSpeedToString(m_downloadItem->speed());
+        this->setText(col_6_speed          , speed);
     }
-
-    QString speed = Format::currentSpeedToString(m_downloadItem->speed());
-
-    this->setText(col_0_file_name      , m_downloadItem->localFileName());
-    this->setText(col_1_website_domain , m_downloadItem->sourceUrl().host()); /// \todo domain only
-    this->setData(col_2_progress_bar   , StateRole, m_downloadItem->state());
-    this->setData(col_2_progress_bar   , ProgressRole, m_downloadItem->progress());
-    this->setText(col_3_percent        , QString("%0%").arg(qMax(0, m_downloadItem->progress())));
-    this->setText(col_4_size           , size);
-    this->setText(col_5_estimated_time , estimatedTime(m_downloadItem));
-    this->setText(col_6_speed          , speed);
 
     //item->setText(C_COL_7_SEGMENTS, "Unknown");
     // todo etc...
@@ -567,8 +577,8 @@ void DownloadQueueView::setEngine(DownloadEngine *downloadEngine)
           SLOT(onJobAdded(DownloadRange)) },
         { SIGNAL(jobRemoved(DownloadRange)),
           SLOT(onJobRemoved(DownloadRange)) },
-        { SIGNAL(jobStateChanged(IDownloadItem*)),
-          SLOT(onJobStateChanged(IDownloadItem*)) },
+        { SIGNAL(jobsChanged(DownloadChanges)),
+          SLOT(onJobsChanged(DownloadChanges)) },
         { SIGNAL(selectionChanged()),
           SLOT(onSelectionChanged()) },
         { SIGNAL(sortChanged()),
@@ -647,6 +657,7 @@ void DownloadQueueView::onJobAdded(const DownloadRange &range)
         auto downloadItem = dynamic_cast<AbstractDownloadItem*>(item);
         auto queueItem = new QueueItem(downloadItem, m_queueView);
         m_queueView->addTopLevelItem(queueItem);
+        m_queueItems.insert(item, queueItem);
     }
 }
 
@@ -662,14 +673,20 @@ void DownloadQueueView::onJobRemoved(const DownloadRange &range)
                 queueItem->deleteLater();
             }
         }
+        m_queueItems.remove(item);
     }
 }
 
-void DownloadQueueView::onJobStateChanged(IDownloadItem *item)
+/*!
+ * \brief Updates the changed columns of the changed rows only.
+ */
+void DownloadQueueView::onJobsChanged(const DownloadChanges &changes)
 {
-    QueueItem* queueItem = getQueueItem(item);
-    if (queueItem) {
-        queueItem->updateItem();
+    for (const auto &change : changes) {
+        QueueItem* queueItem = getQueueItem(change.item);
+        if (queueItem) {
+            queueItem->updateItem(change.changes);
+        }
     }
 }
 
@@ -718,31 +735,16 @@ void DownloadQueueView::onSortChanged()
  ******************************************************************************/
 int DownloadQueueView::getIndex(IDownloadItem *downloadItem) const
 {
-    for (int index = 0, count = m_queueView->topLevelItemCount(); index < count; ++index) {
-        auto treeItem = m_queueView->topLevelItem(index);
-        if (treeItem->type() == QTreeWidgetItem::UserType) {
-            auto queueItem = dynamic_cast<const QueueItem *>(treeItem);
-            if (queueItem && downloadItem && queueItem->downloadItem() == downloadItem) {
-                return index;
-            }
-        }
+    auto queueItem = m_queueItems.value(downloadItem, Q_NULLPTR);
+    if (queueItem) {
+        return m_queueView->indexOfTopLevelItem(queueItem);
     }
     return -1;
 }
 
 QueueItem* DownloadQueueView::getQueueItem(IDownloadItem *downloadItem)
 {
-    auto index = getIndex(downloadItem);
-    if (index >= 0) {
-        auto treeItem = m_queueView->topLevelItem(index);
-        if (treeItem->type() == QTreeWidgetItem::UserType) {
-            auto queueItem = dynamic_cast<QueueItem *>(treeItem);
-            if (queueItem && queueItem->downloadItem() == downloadItem) {
-                return queueItem;
-            }
-        }
-    }
-    return Q_NULLPTR;
+    return m_queueItems.value(downloadItem, Q_NULLPTR);
 }
 
 /******************************************************************************
@@ -20,6 +20,7 @@
 #include <Core/IDownloadItem>
 
 #include <QtWidgets/QWidget>
+#include <QtCore/QHash>
 #include <QtCore/QModelIndex>
 
 using DownloadRange = QList<IDownloadItem *>;
@@ -59,7 +60,7 @@ protected slots:
 private slots:
     void onJobAdded(const DownloadRange &range);
     void onJobRemoved(const DownloadRange &range);
-    void onJobStateChanged(IDownloadItem *item);
+    void onJobsChanged(const DownloadChanges &changes);
     void onSelectionChanged();
     void onSortChanged();
 
@@ -74,6 +75,7 @@ private:
     DownloadEngine *m_downloadEngine;
     QueueView *m_queueView;
     QMenu *m_contextMenu;
+    QHash<IDownloadItem *, QueueItem *> m_queueItems;
 
     void retranslateUi();
     void restylizeUi();
@@ -38,7 +38,7 @@ public:
     AbstractDownloadItem* downloadItem() const { return m_downloadItem; }
 
 public slots:
-    void updateItem();
+    void updateItem(IDownloadItem::Changes changes = IDownloadItem::AllChanges);
 
 private:
     AbstractDownloadItem *m_downloadItem;
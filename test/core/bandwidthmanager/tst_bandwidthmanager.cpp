@@ -0,0 +1,238 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/BandwidthManager>
+
+#include <QtCore/QDebug>
+#include <QtCore/QTime>
+
+#include <QtTest/QtTest>
+
+#include <limits>
+
+class tst_BandwidthManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+
+    void tokenBucketUnlimited();
+    void tokenBucket();
+    void isInPeriod_data();
+    void isInPeriod();
+    void protocolLimit();
+    void streamLimit();
+    void streamLimitReserved();
+    void hostLimit();
+};
+
+void tst_BandwidthManager::cleanup()
+{
+    auto &target = BandwidthManager::getInstance();
+    target.setGlobalLimit(0);
+    target.setHostLimit(0);
+    target.setItemLimit(0);
+    for (int i = 0; i < BandwidthManager::ProtocolCount; ++i) {
+        target.setActiveCount(static_cast<BandwidthManager::Protocol>(i), 0);
+    }
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_BandwidthManager::tokenBucketUnlimited()
+{
+    // Given
+    TokenBucket target;
+
+    // When
+    target.consume(1000000);
+
+    // Then
+    QCOMPARE(target.available(0), std::numeric_limits<qint64>::max());
+}
+
+void tst_BandwidthManager::tokenBucket()
+{
+    // Given
+    TokenBucket target;
+    target.setRate(10000);
+
+    // When
+    auto burst = target.available(0);
+    target.consume(burst);
+
+    // Then
+    QVERIFY(burst > 0);
+    QCOMPARE(target.available(0), qint64(0));
+    QCOMPARE(target.available(100), qint64(1000));
+    QCOMPARE(target.available(60000), burst); // no more than the burst
+
+    // When
+    target.consume(2 * burst);
+
+    // Then
+    QCOMPARE(target.available(60000), qint64(0)); // debt
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_BandwidthManager::isInPeriod_data()
+{
+    QTest::addColumn<QTime>("time");
+    QTest::addColumn<QTime>("from");
+    QTest::addColumn<QTime>("to");
+    QTest::addColumn<bool>("expected");
+
+    QTest::newRow("in day") << QTime(12, 0) << QTime(8, 0) << QTime(18, 0) << true;
+    QTest::newRow("begin") << QTime(8, 0) << QTime(8, 0) << QTime(18, 0) << true;
+    QTest::newRow("end") << QTime(18, 0) << QTime(8, 0) << QTime(18, 0) << false;
+    QTest::newRow("out day") << QTime(20, 0) << QTime(8, 0) << QTime(18, 0) << false;
+    QTest::newRow("in night") << QTime(23, 0) << QTime(22, 0) << QTime(6, 0) << true;
+    QTest::newRow("in morning") << QTime(5, 59) << QTime(22, 0) << QTime(6, 0) << true;
+    QTest::newRow("out night") << QTime(12, 0) << QTime(22, 0) << QTime(6, 0) << false;
+    QTest::newRow("empty") << QTime(12, 0) << QTime(12, 0) << QTime(12, 0) << false;
+    QTest::newRow("invalid") << QTime(12, 0) << QTime() << QTime(18, 0) << false;
+}
+
+void tst_BandwidthManager::isInPeriod()
+{
+    QFETCH(QTime, time);
+    QFETCH(QTime, from);
+    QFETCH(QTime, to);
+    QFETCH(bool, expected);
+
+    QCOMPARE(BandwidthManager::isInPeriod(time, from, to), expected);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_BandwidthManager::protocolLimit()
+{
+    // Given
+    auto &target = BandwidthManager::getInstance();
+    QSignalSpy spyLimitsChanged(&target, SIGNAL(limitsChanged()));
+
+    // When
+    target.setGlobalLimit(90000);
+    target.setActiveCount(BandwidthManager::Http, 2);
+
+    // Then
+    QCOMPARE(target.protocolLimit(BandwidthManager::Http), qint64(90000));
+    QCOMPARE(target.protocolLimit(BandwidthManager::Torrent), qint64(90000)); // alone when it starts
+    QCOMPARE(spyLimitsChanged.count(), 1);
+
+    // When
+    target.setActiveCount(BandwidthManager::Torrent, 1);
+
+    // Then
+    QCOMPARE(target.protocolLimit(BandwidthManager::Http), qint64(60000));
+    QCOMPARE(target.protocolLimit(BandwidthManager::Torrent), qint64(30000));
+    QCOMPARE(spyLimitsChanged.count(), 2);
+
+    // When
+    target.setGlobalLimit(0);
+
+    // Then
+    QCOMPARE(target.protocolLimit(BandwidthManager::Torrent), qint64(0));
+}
+
+void tst_BandwidthManager::streamLimit()
+{
+    // Given
+    auto &target = BandwidthManager::getInstance();
+    target.setGlobalLimit(90000);
+    target.setActiveCount(BandwidthManager::Http, 2);
+
+    // When
+    auto limit = target.reserveStreamLimit();
+    target.releaseStreamLimit(limit);
+
+    // Then
+    QCOMPARE(limit, qint64(30000));
+
+    // When
+    target.setItemLimit(10000);
+    limit = target.reserveStreamLimit();
+    target.releaseStreamLimit(limit);
+
+    // Then
+    QCOMPARE(limit, qint64(10000));
+
+    // When
+    target.setGlobalLimit(0);
+    limit = target.reserveStreamLimit();
+    target.releaseStreamLimit(limit);
+
+    // Then
+    QCOMPARE(limit, qint64(10000));
+}
+
+void tst_BandwidthManager::streamLimitReserved()
+{
+    // Given
+    auto &target = BandwidthManager::getInstance();
+    target.setGlobalLimit(90000);
+    target.setActiveCount(BandwidthManager::Http, 2);
+    target.setActiveCount(BandwidthManager::Torrent, 1);
+    QSignalSpy spyLimitsChanged(&target, SIGNAL(limitsChanged()));
+
+    // When
+    auto limit1 = target.reserveStreamLimit();
+    auto limit2 = target.reserveStreamLimit();
+
+    // Then
+    QCOMPARE(limit1, qint64(22500)); // 90000 / 4
+    QCOMPARE(limit2, qint64(18000)); // 90000 / 5
+    QCOMPARE(target.protocolLimit(BandwidthManager::Stream), qint64(40500));
+    QCOMPARE(target.protocolLimit(BandwidthManager::Http), qint64(33000));
+    QCOMPARE(target.protocolLimit(BandwidthManager::Torrent), qint64(16500));
+    QCOMPARE(limit1 + limit2
+             + target.protocolLimit(BandwidthManager::Http)
+             + target.protocolLimit(BandwidthManager::Torrent), qint64(90000));
+    QCOMPARE(spyLimitsChanged.count(), 2);
+
+    // When
+    target.releaseStreamLimit(limit1);
+    target.releaseStreamLimit(limit2);
+
+    // Then
+    QCOMPARE(target.protocolLimit(BandwidthManager::Http), qint64(60000));
+    QCOMPARE(target.protocolLimit(BandwidthManager::Torrent), qint64(30000));
+    QCOMPARE(spyLimitsChanged.count(), 4);
+}
+
+void tst_BandwidthManager::hostLimit()
+{
+    // Given
+    auto &target = BandwidthManager::getInstance();
+    target.setHostLimit(10000);
+
+    // When
+    auto burst = target.available("www.example.com");
+    target.consume("www.example.com", burst);
+
+    // Then
+    QVERIFY(burst > 0 && burst < std::numeric_limits<qint64>::max());
+    QVERIFY(target.available("www.example.com") < burst / 2);
+    QCOMPARE(target.available("www.example.org"), burst);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QTEST_APPLESS_MAIN(tst_BandwidthManager)
+
+#include "tst_bandwidthmanager.moc"
@@ -0,0 +1,87 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/BufferPool>
+
+#include <QtCore/QDebug>
+#include <QtTest/QtTest>
+
+class tst_BufferPool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void acquire();
+    void reuse();
+    void releaseForeignBuffer();
+};
+
+/******************************************************************************
+******************************************************************************/
+void tst_BufferPool::acquire()
+{
+    auto &pool = BufferPool::getInstance();
+    const qint64 acquireCount = pool.acquireCount();
+
+    QByteArray buffer = pool.acquire();
+
+    QCOMPARE(buffer.size(), BufferPool::slabSize());
+    QCOMPARE(pool.acquireCount(), acquireCount + 1);
+
+    pool.release(buffer);
+    QVERIFY(buffer.isEmpty());
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_BufferPool::reuse()
+{
+    auto &pool = BufferPool::getInstance();
+
+    QByteArray first = pool.acquire();
+    pool.release(first);
+    const qint64 allocationCount = pool.allocationCount();
+    const int freeCount = pool.freeCount();
+    QVERIFY(freeCount > 0);
+
+    QByteArray second = pool.acquire();
+
+    QCOMPARE(pool.allocationCount(), allocationCount);
+    QCOMPARE(pool.freeCount(), freeCount - 1);
+
+    pool.release(second);
+    QCOMPARE(pool.freeCount(), freeCount);
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_BufferPool::releaseForeignBuffer()
+{
+    auto &pool = BufferPool::getInstance();
+    const int freeCount = pool.freeCount();
+
+    QByteArray buffer("not from the pool");
+    pool.release(buffer);
+
+    QVERIFY(buffer.isEmpty());
+    QCOMPARE(pool.freeCount(), freeCount);
+}
+
+/******************************************************************************
+******************************************************************************/
+QTEST_APPLESS_MAIN(tst_BufferPool)
+
+#include "tst_bufferpool.moc"
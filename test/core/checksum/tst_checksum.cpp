@@ -0,0 +1,165 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/Checksum>
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QtTest>
+
+class tst_Checksum : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parse_data();
+    void parse();
+
+    void addDataInOrder();
+    void addDataOutOfOrder();
+    void reset();
+};
+
+static const QByteArray s_data("The quick brown fox jumps over the lazy dog");
+
+/******************************************************************************
+******************************************************************************/
+void tst_Checksum::parse_data()
+{
+    QTest::addColumn<QString>("checkSum");
+    QTest::addColumn<bool>("expectedValid");
+    QTest::addColumn<QCryptographicHash::Algorithm>("expectedAlgorithm");
+
+    QTest::newRow("empty")
+            << QString() << false << QCryptographicHash::Md5;
+
+    QTest::newRow("md5")
+            << "9e107d9d372bb6826bd81d3542a419d6"
+            << true << QCryptographicHash::Md5;
+
+    QTest::newRow("sha1 uppercase")
+            << "2FD4E1C67A2D28FCED849EE1BB76E7391B93EB12"
+            << true << QCryptographicHash::Sha1;
+
+    QTest::newRow("sha256")
+            << "d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592"
+            << true << QCryptographicHash::Sha256;
+
+    QTest::newRow("sha512")
+            << "07e547d9586f6a73f73fbac0435ed76951218fb7d0c8d788a309d785436bbb64"
+               "2e93a252a954f23912547d1e8a3b5ed6e1bfd7097821233fa0538f3db854fee6"
+            << true << QCryptographicHash::Sha512;
+
+    QTest::newRow("prefix with colon")
+            << "sha256:d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592"
+            << true << QCryptographicHash::Sha256;
+
+    QTest::newRow("prefix with equal and dash")
+            << "SHA-1=2fd4e1c67a2d28fced849ee1bb76e7391b93eb12"
+            << true << QCryptographicHash::Sha1;
+
+    QTest::newRow("prefix with space")
+            << "  md5 9e107d9d372bb6826bd81d3542a419d6  "
+            << true << QCryptographicHash::Md5;
+
+    QTest::newRow("prefix and length mismatch")
+            << "sha256:9e107d9d372bb6826bd81d3542a419d6"
+            << false << QCryptographicHash::Md5;
+
+    QTest::newRow("unknown prefix")
+            << "crc32:414fa339"
+            << false << QCryptographicHash::Md5;
+
+    QTest::newRow("unknown length")
+            << "9e107d9d372bb6826bd81d3542a419"
+            << false << QCryptographicHash::Md5;
+
+    QTest::newRow("not hexadecimal")
+            << "9e107d9d372bb6826bd81d3542a419zz"
+            << false << QCryptographicHash::Md5;
+}
+
+void tst_Checksum::parse()
+{
+    QFETCH(QString, checkSum);
+    QFETCH(bool, expectedValid);
+    QFETCH(QCryptographicHash::Algorithm, expectedAlgorithm);
+
+    Checksum target(checkSum);
+
+    QCOMPARE(target.isValid(), expectedValid);
+    if (expectedValid) {
+        QCOMPARE(target.algorithm(), expectedAlgorithm);
+        QCOMPARE(target.expected(), target.expected().toLower());
+    }
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_Checksum::addDataInOrder()
+{
+    Checksum target("sha256:d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592");
+
+    target.addData(0, s_data.constData(), 10);
+    target.addData(10, s_data.constData() + 10, s_data.size() - 10);
+
+    QCOMPARE(target.position(), qsizetype(s_data.size()));
+    QVERIFY(target.verify());
+}
+
+void tst_Checksum::addDataOutOfOrder()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile file(dir.filePath("data.bin"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(s_data);
+    file.close();
+
+    Checksum target("9e107d9d372bb6826bd81d3542a419d6");
+
+    /* The bytes after a gap are ignored, overlapping bytes are hashed once */
+    target.addData(20, s_data.constData() + 20, s_data.size() - 20);
+    QCOMPARE(target.position(), qsizetype(0));
+    target.addData(0, s_data.constData(), 10);
+    target.addData(5, s_data.constData() + 5, 10);
+    QCOMPARE(target.position(), qsizetype(15));
+
+    /* The rest is read from the file */
+    std::atomic<bool> canceled{false};
+    QVERIFY(target.addFile(file.fileName(), s_data.size(), canceled));
+    QCOMPARE(target.position(), qsizetype(s_data.size()));
+    QVERIFY(target.verify());
+}
+
+void tst_Checksum::reset()
+{
+    Checksum target("9e107d9d372bb6826bd81d3542a419d6");
+
+    target.addData(0, "garbage", 7);
+    target.reset();
+    QCOMPARE(target.position(), qsizetype(0));
+
+    target.addData(0, s_data.constData(), s_data.size());
+    QVERIFY(target.verify());
+}
+
+/******************************************************************************
+******************************************************************************/
+QTEST_APPLESS_MAIN(tst_Checksum)
+
+#include "tst_checksum.moc"
@@ -0,0 +1,189 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/ConcurrencyController>
+
+#include <QtCore/QDebug>
+
+#include <QtTest/QtTest>
+
+constexpr int samples_per_period = 5;
+
+class tst_ConcurrencyController : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void reset();
+    void additiveIncrease();
+    void knee();
+    void multiplicativeDecrease();
+    void isolatedError();
+    void notSaturated();
+
+private:
+    bool period(ConcurrencyController &target, qreal goodput, bool isSaturated = true);
+};
+
+/******************************************************************************
+ ******************************************************************************/
+bool tst_ConcurrencyController::period(ConcurrencyController &target, qreal goodput, bool isSaturated)
+{
+    bool changed = false;
+    for (int i = 0; i < samples_per_period; ++i) {
+        changed = target.addSample(goodput, isSaturated);
+    }
+    return changed;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_ConcurrencyController::reset()
+{
+    // Given
+    ConcurrencyController target;
+    target.setRange(2, 6);
+
+    // When
+    target.reset(10);
+
+    // Then
+    QCOMPARE(target.limit(), 6);
+
+    // When
+    target.reset(0);
+
+    // Then
+    QCOMPARE(target.limit(), 2);
+}
+
+void tst_ConcurrencyController::additiveIncrease()
+{
+    // Given
+    ConcurrencyController target;
+    target.setRange(1, 4);
+    target.reset(2);
+
+    // When
+    for (int i = 1; i < samples_per_period; ++i) {
+        QVERIFY(!target.addSample(100, true));
+    }
+
+    // Then
+    QVERIFY(target.addSample(100, true));
+    QCOMPARE(target.limit(), 3);
+
+    // When
+    QVERIFY(period(target, 200));
+    QVERIFY(!period(target, 400)); // maximum reached
+
+    // Then
+    QCOMPARE(target.limit(), 4);
+}
+
+void tst_ConcurrencyController::knee()
+{
+    // Given
+    ConcurrencyController target;
+    target.setRange(1, 10);
+    target.reset(4);
+    QVERIFY(period(target, 1000));
+    QCOMPARE(target.limit(), 5);
+
+    // When
+    QVERIFY(period(target, 1020)); // less than 5% more
+
+    // Then
+    QCOMPARE(target.limit(), 4);
+
+    // When
+    QVERIFY(!period(target, 1000));
+    QVERIFY(!period(target, 1000));
+
+    // Then
+    QCOMPARE(target.limit(), 4); // held
+}
+
+void tst_ConcurrencyController::multiplicativeDecrease()
+{
+    // Given
+    ConcurrencyController target;
+    target.setRange(1, 10);
+    target.reset(8);
+
+    // When
+    target.addResult("www.example.com", false);
+    target.addResult("www.example.com", true);
+    target.addResult("www.example.com", true);
+    target.addResult("www.example.org", false);
+
+    // Then
+    QVERIFY(period(target, 1000));
+    QCOMPARE(target.limit(), 6);
+
+    // When
+    target.reset(2);
+    target.addResult("www.example.com", true);
+    target.addResult("www.example.com", true);
+
+    // Then
+    QVERIFY(period(target, 1000));
+    QCOMPARE(target.limit(), 1);
+}
+
+void tst_ConcurrencyController::isolatedError()
+{
+    // Given
+    ConcurrencyController target;
+    target.setRange(1, 10);
+    target.reset(8);
+
+    // When
+    target.addResult("www.example.com", true);
+    for (int i = 0; i < 10; ++i) {
+        target.addResult("www.example.org", true);
+        target.addResult("www.example.org", false);
+        target.addResult("www.example.org", false);
+        target.addResult("www.example.org", false);
+        target.addResult("www.example.org", false);
+    }
+
+    // Then
+    QVERIFY(period(target, 1000));
+    QCOMPARE(target.limit(), 9);
+}
+
+void tst_ConcurrencyController::notSaturated()
+{
+    // Given
+    ConcurrencyController target;
+    target.setRange(1, 10);
+    target.reset(4);
+
+    // When
+    for (int i = 0; i < samples_per_period; ++i) {
+        target.addSample(1000, i != 2);
+    }
+
+    // Then
+    QCOMPARE(target.limit(), 4);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QTEST_APPLESS_MAIN(tst_ConcurrencyController)
+
+#include "tst_concurrencycontroller.moc"
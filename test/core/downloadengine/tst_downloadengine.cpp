@@ -27,6 +27,23 @@
 
 Q_DECLARE_OPAQUE_POINTER(IDownloadItem*)
 Q_DECLARE_METATYPE(DownloadRange)
+Q_DECLARE_METATYPE(DownloadChanges)
+
+class PreparingEngine : public DownloadEngine
+{
+public:
+    explicit PreparingEngine(QObject *parent) : DownloadEngine(parent) {}
+
+    QList<IDownloadItem*> prepared;
+
+protected:
+    void prepareToStart(IDownloadItem *item) Q_DECL_OVERRIDE
+    {
+        if (!prepared.contains(item)) {
+            prepared.append(item);
+        }
+    }
+};
 
 class tst_DownloadEngine : public QObject
 {
@@ -42,12 +59,21 @@ private slots:
     void moveCurrentUp();
     void moveCurrentDown();
     void moveCurrentBottom();
+
+    void startNext();
+    void prepareToStart();
+    void autoSimultaneousDownloads();
+
+    void tick();
+    void batchChanges();
+    void comparedChanges();
 };
 
 void tst_DownloadEngine::initTestCase()
 {
     qRegisterMetaType<IDownloadItem*>("IDownloadItem*");
     qRegisterMetaType<DownloadRange>("DownloadRange");
+    qRegisterMetaType<DownloadChanges>("DownloadChanges");
 }
 
 /******************************************************************************
@@ -59,7 +85,7 @@ void tst_DownloadEngine::append()
 
     QSignalSpy spyJobAppended(target.data(), SIGNAL(jobAppended(DownloadRange)));
     QSignalSpy spyJobRemoved(target.data(), &DownloadEngine::jobRemoved);
-    QSignalSpy spyJobStateChanged(target.data(), &DownloadEngine::jobStateChanged);
+    QSignalSpy spyJobsChanged(target.data(), &DownloadEngine::jobsChanged);
     QSignalSpy spyJobFinished(target.data(), &DownloadEngine::jobFinished);
 
     const qsizetype bytesTotal = 123*1024*1024;
@@ -79,7 +105,7 @@ void tst_DownloadEngine::append()
     // Then
     QCOMPARE(spyJobAppended.count(), 1);
     QCOMPARE(spyJobRemoved.count(), 0);
-    QCOMPARE(spyJobStateChanged.count(), 1); // Paused
+    QCOMPARE(spyJobsChanged.count(), 0); // Paused before being appended
     QCOMPARE(spyJobFinished.count(), 0);
 
     // When
@@ -212,6 +238,170 @@ void tst_DownloadEngine::moveCurrentBottom()
     VERIFY_ORDER(target, QList<int>({0, 1, 3, 5, 8, 9, 2, 4, 6, 7}));
 }
 
+/******************************************************************************
+ ******************************************************************************/
+void tst_DownloadEngine::startNext()
+{
+    // Given
+    QScopedPointer<DownloadEngine> target(new DownloadEngine(this));
+    target->setMaxSimultaneousDownloads(2);
+    auto items = createDummyList();
+
+    // When
+    target->append(items, true);
+
+    // Then
+    QCOMPARE(target->runningCount(), 2);
+    QCOMPARE(target->waitingCount(), 8);
+    QCOMPARE(target->runningJobs(), QList<IDownloadItem*>({items.at(0), items.at(1)}));
+    QCOMPARE(target->waitingJobs().first(), items.at(2));
+
+    // When
+    select(target, QList<int>({9}));
+    target->moveCurrentTop();
+    target->cancel(items.at(0));
+
+    // Then
+    QCOMPARE(target->runningCount(), 2);
+    QCOMPARE(target->waitingCount(), 7);
+    QCOMPARE(target->failedCount(), 1);
+    QCOMPARE(target->runningJobs(), QList<IDownloadItem*>({items.at(9), items.at(1)}));
+    QCOMPARE(target->failedJobs(), QList<IDownloadItem*>({items.at(0)}));
+}
+
+void tst_DownloadEngine::prepareToStart()
+{
+    // Given
+    QScopedPointer<PreparingEngine> target(new PreparingEngine(this));
+    target->setMaxSimultaneousDownloads(2);
+    auto items = createDummyList();
+
+    // When
+    target->append(items, true);
+
+    // Then
+    QCOMPARE(target->runningJobs(), QList<IDownloadItem*>({items.at(0), items.at(1)}));
+    QCOMPARE(target->prepared, QList<IDownloadItem*>({items.at(2), items.at(3)}));
+}
+
+void tst_DownloadEngine::autoSimultaneousDownloads()
+{
+    // Given
+    QScopedPointer<DownloadEngine> target(new DownloadEngine(this));
+    target->setMaxSimultaneousDownloads(2);
+
+    // When
+    target->setAutoSimultaneousDownloadsEnabled(true);
+
+    // Then
+    QCOMPARE(target->simultaneousDownloadsLimit(), 2);
+
+    // When
+    target->setMaxSimultaneousDownloads(1);
+
+    // Then
+    QCOMPARE(target->simultaneousDownloadsLimit(), 1);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_DownloadEngine::tick()
+{
+    // Given
+    QScopedPointer<DownloadEngine> target(new DownloadEngine(this));
+
+    QSignalSpy spyJobsChanged(target.data(), &DownloadEngine::jobsChanged);
+    QSignalSpy spyJobFinished(target.data(), &DownloadEngine::jobFinished);
+
+    FakeDownloadItem* item = new FakeDownloadItem(
+                QUrl("http://www.example.com/favicon.png"), QLatin1String("favicon.png"),
+                123*1024*1024, 150, 1000);
+
+    // When
+    target->append({item}, true);
+
+    // Then
+    QVERIFY(spyJobsChanged.wait(1000));
+    auto changes = spyJobsChanged.first().first().value<DownloadChanges>();
+    QCOMPARE(changes.count(), 1);
+    QCOMPARE(changes.first().item, item);
+
+    // When
+    QVERIFY(spyJobFinished.wait(5000));
+    spyJobsChanged.clear();
+
+    // Then
+    QVERIFY(!spyJobsChanged.wait(500)); // the clock stops without active item
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_DownloadEngine::batchChanges()
+{
+    // Given
+    QScopedPointer<DownloadEngine> target(new DownloadEngine(this));
+    auto items = createDummyList();
+    target->append(items, false);
+
+    QSignalSpy spyJobsChanged(target.data(), &DownloadEngine::jobsChanged);
+
+    // When
+    target->updateItems(items);
+    target->updateItems({items.at(2)});
+
+    // Then
+    QCOMPARE(spyJobsChanged.count(), 0); // not before the next frame
+    QVERIFY(spyJobsChanged.wait(1000));
+    QCOMPARE(spyJobsChanged.count(), 1);
+    auto changes = spyJobsChanged.first().first().value<DownloadChanges>();
+    QCOMPARE(changes.count(), items.count());
+    for (int i = 0; i < items.count(); ++i) {
+        QCOMPARE(changes.at(i).item, items.at(i));
+        QCOMPARE(changes.at(i).changes, IDownloadItem::Changes(IDownloadItem::AllChanges));
+    }
+
+    // When
+    spyJobsChanged.clear();
+    target->updateItems(items);
+    target->remove({items.at(0)});
+
+    // Then
+    QVERIFY(spyJobsChanged.wait(1000));
+    changes = spyJobsChanged.first().first().value<DownloadChanges>();
+    QCOMPARE(changes.count(), items.count() - 1); // the removed item isn't notified
+    QCOMPARE(changes.first().item, items.at(1));
+}
+
+void tst_DownloadEngine::comparedChanges()
+{
+    // Given
+    QScopedPointer<DownloadEngine> target(new DownloadEngine(this));
+    auto items = createDummyList();
+    target->append(items, false);
+    auto item = static_cast<FakeDownloadItem*>(items.at(1));
+
+    QSignalSpy spyJobsChanged(target.data(), &DownloadEngine::jobsChanged);
+
+    // When
+    item->setPriority(IDownloadItem::HighPriority);
+
+    // Then
+    QVERIFY(spyJobsChanged.wait(1000));
+    auto changes = spyJobsChanged.first().first().value<DownloadChanges>();
+    QCOMPARE(changes.count(), 1);
+    QCOMPARE(changes.first().changes, IDownloadItem::Changes(IDownloadItem::OtherChange));
+
+    // When
+    spyJobsChanged.clear();
+    item->setState(IDownloadItem::Stopped);
+
+    // Then
+    QVERIFY(spyJobsChanged.wait(1000));
+    changes = spyJobsChanged.first().first().value<DownloadChanges>();
+    QCOMPARE(changes.count(), 1);
+    QCOMPARE(changes.first().changes, IDownloadItem::Changes(IDownloadItem::StateChange));
+}
+
 /******************************************************************************
  ******************************************************************************/
 /*
@@ -18,6 +18,7 @@
 #include <Core/DownloadItem>
 #include <Core/Mask>
 #include <Core/ResourceItem>
+#include <Core/Session>
 
 #include <QtCore/QDebug>
 #include <QtCore/QFile>
@@ -49,6 +50,8 @@ private slots:
     }
 
     void appendJobPaused();
+    void readSessionLazily();
+    void readSessionProbeable();
 
 private:
     QTemporaryDir m_tempDir;
@@ -115,6 +118,74 @@ void tst_DownloadManager::appendJobPaused()
     QCOMPARE(localFile.size(), qsizetype(1256));
 }
 
+void tst_DownloadManager::readSessionLazily()
+{
+    // Given
+    QSharedPointer<DownloadManager> downloadManager(new DownloadManager(this));
+    DownloadItem *item = createDummyJob(downloadManager, "http://www.example.com/index.html", "*name*.*ext*");
+    item->setState(IDownloadItem::Completed);
+    item->setBytesReceived(1256);
+    item->setBytesTotal(1256);
+
+    const QString fileName = m_tempDir.filePath("queue.json");
+    Session::write({item}, fileName);
+
+    // When
+    QList<DownloadItem*> items;
+    Session::read(items, fileName, downloadManager.data());
+
+    // Then
+    QCOMPARE(items.count(), 1);
+    auto actual = items.first();
+    QVERIFY(!actual->isLoaded());
+    QCOMPARE(actual->state(), IDownloadItem::Completed);
+    QCOMPARE(actual->bytesTotal(), qsizetype(1256));
+    QCOMPARE(actual->localFileName(), item->localFileName());
+    QCOMPARE(actual->sourceUrl(), item->sourceUrl());
+
+    // When
+    auto resource = actual->resource();
+
+    // Then
+    QVERIFY(actual->isLoaded());
+    QCOMPARE(resource->url(), item->resource()->url());
+    QCOMPARE(actual->localFullFileName(), item->localFullFileName());
+}
+
+void tst_DownloadManager::readSessionProbeable()
+{
+    // Given
+    QSharedPointer<DownloadManager> downloadManager(new DownloadManager(this));
+    DownloadItem *probed = createDummyJob(downloadManager, "http://www.example.com/a.zip", "*name*.*ext*");
+    probed->setState(IDownloadItem::Paused);
+    probed->resource()->setProbed(true); // no Content-Length
+    DownloadItem *queued = createDummyJob(downloadManager, "http://www.example.com/b.zip", "*name*.*ext*");
+    queued->setState(IDownloadItem::Paused);
+    queued->resource()->setReferringPage("http://www.example.com/");
+
+    const QString fileName = m_tempDir.filePath("probe.json");
+    Session::write({probed, queued}, fileName);
+
+    // When
+    QList<DownloadItem*> items;
+    Session::read(items, fileName, downloadManager.data());
+
+    // Then
+    QCOMPARE(items.count(), 2);
+    QVERIFY(!items.at(0)->isProbeable());
+    QVERIFY(items.at(1)->isProbeable());
+    QCOMPARE(items.at(1)->referringPage(), QString("http://www.example.com/"));
+    QVERIFY(!items.at(0)->isLoaded());
+    QVERIFY(!items.at(1)->isLoaded());
+
+    // When
+    auto resource = items.at(0)->resource();
+
+    // Then
+    QVERIFY(resource->isProbed());
+    QCOMPARE(resource->remoteFileSize(), qsizetype(-1));
+}
+
 /******************************************************************************
  ******************************************************************************/
 
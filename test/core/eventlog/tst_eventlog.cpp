@@ -0,0 +1,140 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/EventLog>
+
+#include <QtCore/QDebug>
+
+#include <QtTest/QtTest>
+
+class tst_EventLog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+
+    void message();
+    void messageWithMarkerInArgument();
+    void ringBuffer();
+    void takePending();
+    void verbosity();
+
+private:
+    static QStringList messages(const QList<EventLog::Entry> &entries);
+};
+
+void tst_EventLog::cleanup()
+{
+    EventLog::setVerbosity(EventLog::Info);
+}
+
+QStringList tst_EventLog::messages(const QList<EventLog::Entry> &entries)
+{
+    QStringList messages;
+    for (const auto &entry : entries) {
+        messages.append(entry.message());
+    }
+    return messages;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_EventLog::message()
+{
+    // Given
+    EventLog target;
+
+    // When
+    target.append(EventLog::Info, "Downloaded '%0' (%1 of %2 bytes).", {"a.zip", "10", "20"});
+
+    // Then
+    QCOMPARE(target.count(), 1);
+    QCOMPARE(target.at(0).message(), QString("Downloaded 'a.zip' (10 of 20 bytes)."));
+    QVERIFY(target.at(0).toString().endsWith("] Downloaded 'a.zip' (10 of 20 bytes)."));
+}
+
+void tst_EventLog::messageWithMarkerInArgument()
+{
+    // Given
+    EventLog target;
+
+    // When
+    target.append(EventLog::Error, "Error '%0': '%1'.", {"http://a/%1.zip", "Not found"});
+
+    // Then
+    QCOMPARE(target.at(0).message(), QString("Error 'http://a/%1.zip': 'Not found'."));
+    QVERIFY(target.at(0).toString().contains("] Error: Error"));
+}
+
+void tst_EventLog::ringBuffer()
+{
+    // Given
+    EventLog target(3);
+
+    // When
+    for (int i = 0; i < 5; ++i) {
+        target.append(EventLog::Info, "Event %0", {QString::number(i)});
+    }
+
+    // Then
+    QCOMPARE(target.count(), 3);
+    QCOMPARE(target.droppedCount(), 2);
+    QCOMPARE(messages(target.entries()), QStringList({"Event 2", "Event 3", "Event 4"}));
+    QVERIFY(target.toString().startsWith("(2 earlier events not shown)\n"));
+}
+
+void tst_EventLog::takePending()
+{
+    // Given
+    EventLog target(3);
+    target.append(EventLog::Info, "Event 0");
+    target.append(EventLog::Info, "Event 1");
+    target.takePending();
+
+    // When
+    target.append(EventLog::Info, "Event 2");
+    target.append(EventLog::Info, "Event 3");
+    auto actual = target.takePending();
+
+    // Then
+    QCOMPARE(messages(actual), QStringList({"Event 2", "Event 3"}));
+    QCOMPARE(target.pendingCount(), 0);
+    QCOMPARE(target.count(), 3);
+}
+
+void tst_EventLog::verbosity()
+{
+    // Given
+    EventLog target;
+    EventLog::setVerbosity(EventLog::Warning);
+
+    // When
+    target.append(EventLog::Debug, "Debug");
+    target.append(EventLog::Info, "Info");
+    target.append(EventLog::Warning, "Warning");
+    target.append(EventLog::Error, "Error");
+
+    // Then
+    QVERIFY(!EventLog::isEnabled(EventLog::Info));
+    QCOMPARE(messages(target.entries()), QStringList({"Warning", "Error"}));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QTEST_APPLESS_MAIN(tst_EventLog)
+
+#include "tst_eventlog.moc"
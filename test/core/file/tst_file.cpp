@@ -0,0 +1,354 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/BufferPool>
+#include <Core/DiskWriter>
+#include <Core/File>
+#include <Core/ResourceItem>
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+#include <QtTest/QSignalSpy>
+#include <QtTest/QtTest>
+
+class tst_File : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void writeAtOffset();
+    void writeQueuedBuffers_data();
+    void writeQueuedBuffers();
+    void writeError();
+    void preallocate();
+    void isSpaceAvailable();
+    void renameInPlace();
+    void move();
+    void verifyChecksum_data();
+    void verifyChecksum();
+    void verifyResumedChecksum();
+
+private:
+    static void initResource(ResourceItem *resource, const QTemporaryDir &dir);
+};
+
+void tst_File::initResource(ResourceItem *resource, const QTemporaryDir &dir)
+{
+    resource->setUrl("https://www.example.com/files/archive.bin");
+    resource->setDestination(dir.path());
+    resource->setMask("*name*.*ext*");
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_File::writeAtOffset()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResourceItem resource;
+    initResource(&resource, dir);
+
+    File file;
+    QCOMPARE(file.open(&resource), File::Open);
+
+    /* Segments received out of order */
+    file.write(8, QByteArray("89"));
+    file.write(4, QByteArray("4567"));
+    file.write(0, QByteArray("0123"));
+    QCOMPARE(file.size(), 10);
+
+    QVERIFY(file.commit());
+
+    QFile target(resource.localFileUrl().toLocalFile());
+    QVERIFY(target.open(QIODevice::ReadOnly));
+    QCOMPARE(target.readAll(), QByteArray("0123456789"));
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_File::writeQueuedBuffers_data()
+{
+    QTest::addColumn<bool>("ioUring");
+
+    QTest::newRow("plain writes") << false;
+    QTest::newRow("io_uring (or fallback)") << true;
+}
+
+void tst_File::writeQueuedBuffers()
+{
+    QFETCH(bool, ioUring);
+    DiskWriter::getInstance().setIoUringEnabled(ioUring);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResourceItem resource;
+    initResource(&resource, dir);
+
+    File file;
+    QCOMPARE(file.open(&resource), File::Open);
+
+    /* More buffers than the queue can hold */
+    const int count = 2 * DiskWriter::maxQueuedWrites();
+    const qsizetype slabSize = BufferPool::slabSize();
+    for (int i = 0; i < count; ++i) {
+        QByteArray buffer = BufferPool::getInstance().acquire();
+        buffer.fill(char('a' + i % 26));
+        file.write(i * slabSize, buffer, slabSize);
+    }
+
+    QVERIFY(file.commit());
+    QCOMPARE(DiskWriter::getInstance().queueDepth(), 0);
+    QVERIFY(DiskWriter::getInstance().maxQueueDepth() > 0);
+
+    QFile target(resource.localFileUrl().toLocalFile());
+    QVERIFY(target.open(QIODevice::ReadOnly));
+    const QByteArray data = target.readAll();
+    QCOMPARE(data.size(), count * slabSize);
+    for (int i = 0; i < count; ++i) {
+        QCOMPARE(data.at(i * slabSize), char('a' + i % 26));
+        QCOMPARE(data.at((i + 1) * slabSize - 1), char('a' + i % 26));
+    }
+    DiskWriter::getInstance().setIoUringEnabled(false);
+}
+
+/*!
+ * The partial file is /dev/full, where each write fails with ENOSPC.
+ */
+void tst_File::writeError()
+{
+#if defined(Q_OS_LINUX)
+    if (!QFile::exists("/dev/full")) {
+        QSKIP("No /dev/full on this system");
+    }
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResourceItem resource;
+    initResource(&resource, dir);
+    const QString fileName = resource.localFileUrl().toLocalFile();
+    QVERIFY(QFile::link("/dev/full", File::partialFileName(fileName)));
+
+    File file;
+    QCOMPARE(file.open(&resource, true), File::Open);
+    QVERIFY(file.errorString().isEmpty());
+    file.write(0, QByteArray("0123456789"));
+    QVERIFY(!file.commit());
+    QVERIFY(!file.errorString().isEmpty());
+    QVERIFY(!QFile::exists(fileName));
+
+    file.cancel();
+    QVERIFY(file.errorString().isEmpty());
+#else
+    QSKIP("Needs /dev/full");
+#endif
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_File::preallocate()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResourceItem resource;
+    initResource(&resource, dir);
+
+    File file;
+    QCOMPARE(file.open(&resource), File::Open);
+
+    const qsizetype size = 1024 * 1024;
+    QVERIFY(file.preallocate(size));
+    QCOMPARE(file.size(), size);
+
+    /* Writes don't change the size of a preallocated file */
+    file.write(size - 4, QByteArray("tail"));
+    file.write(0, QByteArray("head"));
+    QCOMPARE(file.size(), size);
+
+    /* Never shrinks the file */
+    QVERIFY(file.preallocate(10));
+    QCOMPARE(file.size(), size);
+
+    QVERIFY(file.commit());
+
+    QFile target(resource.localFileUrl().toLocalFile());
+    QVERIFY(target.open(QIODevice::ReadOnly));
+    const QByteArray data = target.readAll();
+    QCOMPARE(data.size(), size);
+    QVERIFY(data.startsWith("head"));
+    QVERIFY(data.endsWith("tail"));
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_File::isSpaceAvailable()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResourceItem resource;
+    initResource(&resource, dir);
+
+    File file;
+    QCOMPARE(file.open(&resource), File::Open);
+
+    QVERIFY(file.isSpaceAvailable(1024));
+    QVERIFY(!file.isSpaceAvailable(std::numeric_limits<qsizetype>::max()));
+
+    file.cancel();
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_File::renameInPlace()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResourceItem resource;
+    initResource(&resource, dir);
+
+    File file;
+    QCOMPARE(file.open(&resource), File::Open);
+    file.write(0, QByteArray("01234"));
+    file.write(5, QByteArray("56")); // maybe still queued
+    const QString oldPartial = file.partialFileName();
+
+    resource.setCustomFileName("renamed");
+    QVERIFY(file.rename(&resource));
+
+    QVERIFY(file.isOpen());
+    QVERIFY(!QFile::exists(oldPartial));
+    QVERIFY(QFile::exists(file.partialFileName()));
+    QVERIFY(file.partialFileName() != oldPartial);
+
+    /* The download continues in the renamed file */
+    file.write(7, QByteArray("789"));
+    QVERIFY(file.commit());
+
+    QFile target(resource.localFileUrl().toLocalFile());
+    QVERIFY(target.fileName().contains("renamed"));
+    QVERIFY(target.open(QIODevice::ReadOnly));
+    QCOMPARE(target.readAll(), QByteArray("0123456789"));
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_File::move()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResourceItem resource;
+    initResource(&resource, dir);
+
+    File file;
+    QCOMPARE(file.open(&resource), File::Open);
+    file.write(0, QByteArray("01234"));
+    const QString oldPartial = file.partialFileName();
+
+    resource.setDestination(dir.filePath("other"));
+    QSignalSpy spyMoved(&file, SIGNAL(moved(bool)));
+    file.move(&resource);
+    QVERIFY(file.isMoving());
+
+    QVERIFY(spyMoved.wait());
+    QCOMPARE(spyMoved.first().first().toBool(), true);
+    QVERIFY(!file.isMoving());
+    QVERIFY(file.isOpen());
+    QVERIFY(!QFile::exists(oldPartial));
+
+    file.write(5, QByteArray("56789"));
+    QVERIFY(file.commit());
+
+    QFile target(resource.localFileUrl().toLocalFile());
+    QVERIFY(target.fileName().contains("other"));
+    QVERIFY(target.open(QIODevice::ReadOnly));
+    QCOMPARE(target.readAll(), QByteArray("0123456789"));
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_File::verifyChecksum_data()
+{
+    QTest::addColumn<QString>("checkSum");
+    QTest::addColumn<bool>("expected");
+
+    QTest::newRow("md5") << "781e5e245d69b566979b86e28d23f2c7" << true;
+    QTest::newRow("sha1") << "sha1:87acec17cd9dcd20a716cc2cf67417b71c8a7016" << true;
+    QTest::newRow("mismatch") << "00000000000000000000000000000000" << false;
+}
+
+void tst_File::verifyChecksum()
+{
+    QFETCH(QString, checkSum);
+    QFETCH(bool, expected);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResourceItem resource;
+    initResource(&resource, dir);
+
+    File file;
+    QCOMPARE(file.open(&resource), File::Open);
+    QVERIFY(file.setCheckSum(checkSum));
+    QVERIFY(file.hasCheckSum());
+
+    /* In order, then a segment after a gap, read back by verify() */
+    file.write(0, QByteArray("0123"));
+    file.write(8, QByteArray("89"));
+    file.write(4, QByteArray("4567"));
+
+    QSignalSpy spyVerified(&file, SIGNAL(verified(bool)));
+    file.verify();
+    QVERIFY(spyVerified.wait());
+    QCOMPARE(spyVerified.first().first().toBool(), expected);
+
+    QVERIFY(file.commit());
+}
+
+void tst_File::verifyResumedChecksum()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ResourceItem resource;
+    initResource(&resource, dir);
+
+    File file;
+    QCOMPARE(file.open(&resource), File::Open);
+    file.write(0, QByteArray("01234"));
+    file.close();
+
+    /* The existing bytes are hashed in the background */
+    QCOMPARE(file.open(&resource, true), File::Open);
+    QVERIFY(file.setCheckSum("781e5e245d69b566979b86e28d23f2c7", 5));
+    file.write(5, QByteArray("56789"));
+
+    QSignalSpy spyVerified(&file, SIGNAL(verified(bool)));
+    file.verify();
+    QVERIFY(spyVerified.wait());
+    QCOMPARE(spyVerified.first().first().toBool(), true);
+
+    QVERIFY(!file.setCheckSum("crc32:a684c7c6"));
+    QVERIFY(!file.hasCheckSum());
+    file.cancel();
+}
+
+/******************************************************************************
+******************************************************************************/
+/*
+ * QSignalSpy::wait() requires an event loop, so QTEST_GUILESS_MAIN
+ * instead of QTEST_APPLESS_MAIN.
+ */
+QTEST_GUILESS_MAIN(tst_File)
+
+#include "tst_file.moc"
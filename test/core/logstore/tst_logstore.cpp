@@ -0,0 +1,133 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/EventLog>
+#include <Core/LogStore>
+
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+
+#include <QtTest/QtTest>
+
+class tst_LogStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void appendAndRead();
+    void rotate();
+    void remove();
+    void prune();
+
+private:
+    static QList<EventLog::Entry> entries(const QString &message);
+};
+
+QList<EventLog::Entry> tst_LogStore::entries(const QString &message)
+{
+    EventLog log;
+    log.append(EventLog::Info, "%0", {message});
+    return log.takePending();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_LogStore::appendAndRead()
+{
+    // Given
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    LogStore target;
+    target.setDirectory(dir.filePath("logs"));
+
+    // When
+    QVERIFY(target.append(7, entries("Resume.")));
+    QVERIFY(target.append(7, entries("Pause.")));
+
+    // Then
+    auto lines = target.read(7).split('\n', Qt::SkipEmptyParts);
+    QCOMPARE(lines.count(), 2);
+    QVERIFY(lines.at(0).endsWith("] Resume."));
+    QVERIFY(lines.at(1).endsWith("] Pause."));
+    QVERIFY(target.read(8).isEmpty());
+}
+
+void tst_LogStore::rotate()
+{
+    // Given
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    LogStore target;
+    target.setDirectory(dir.path());
+    target.setMaxFileSize(100);
+
+    // When
+    for (int i = 0; i < 10; ++i) {
+        target.append(0, entries(QString("Event %0").arg(i)));
+    }
+
+    // Then
+    QVERIFY(QFile::exists(target.fileName(0) + ".1"));
+    QVERIFY(QFileInfo(target.fileName(0)).size() <= 100);
+    auto lines = target.read(0).split('\n', Qt::SkipEmptyParts);
+    QVERIFY(lines.count() < 10);
+    QVERIFY(lines.last().endsWith("] Event 9"));
+}
+
+void tst_LogStore::remove()
+{
+    // Given
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    LogStore target;
+    target.setDirectory(dir.path());
+    target.append(3, entries("Stop."));
+
+    // When
+    target.remove(3);
+
+    // Then
+    QVERIFY(!QFile::exists(target.fileName(3)));
+    QVERIFY(target.read(3).isEmpty());
+}
+
+void tst_LogStore::prune()
+{
+    // Given
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    LogStore target;
+    target.setDirectory(dir.path());
+    target.append(1, entries("a"));
+    target.append(2, entries("b"));
+    target.append(3, entries("c"));
+
+    // When
+    target.prune({1, 3});
+
+    // Then
+    QVERIFY(QFile::exists(target.fileName(1)));
+    QVERIFY(!QFile::exists(target.fileName(2)));
+    QVERIFY(QFile::exists(target.fileName(3)));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QTEST_APPLESS_MAIN(tst_LogStore)
+
+#include "tst_logstore.moc"
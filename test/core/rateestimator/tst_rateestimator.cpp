@@ -0,0 +1,150 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/RateEstimator>
+
+#include <QtCore/QDebug>
+
+#include <QtTest/QtTest>
+
+constexpr qint64 msec_tick = 150;
+
+class tst_RateEstimator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void unknown();
+    void constantRate();
+    void stall();
+    void restart();
+    void remainingTime();
+
+private:
+    qint64 run(RateEstimator &target, qint64 msecs, qint64 bytes,
+               qint64 duration, qreal bytesPerSecond, qint64 bytesTotal = -1);
+};
+
+/******************************************************************************
+ ******************************************************************************/
+/*!
+ * Samples the target at each tick during the given \a duration, and returns
+ * the bytes received at the end.
+ */
+qint64 tst_RateEstimator::run(RateEstimator &target, qint64 msecs, qint64 bytes,
+                              qint64 duration, qreal bytesPerSecond, qint64 bytesTotal)
+{
+    for (qint64 t = msec_tick; t <= duration; t += msec_tick) {
+        target.addSample(msecs + t, bytes + qint64(bytesPerSecond * t / 1000), bytesTotal);
+    }
+    return bytes + qint64(bytesPerSecond * duration / 1000);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_RateEstimator::unknown()
+{
+    // Given
+    RateEstimator target;
+
+    // When
+    target.addSample(0, 1000);
+
+    // Then
+    QCOMPARE(target.rate(), qreal(-1));
+    QCOMPARE(target.remainingTime(), qint64(-1));
+}
+
+void tst_RateEstimator::constantRate()
+{
+    // Given
+    RateEstimator target;
+    target.addSample(0, 0);
+
+    // When
+    run(target, 0, 0, 6000, 1000);
+
+    // Then
+    QVERIFY(qAbs(target.rate() - 1000) < 1);
+}
+
+void tst_RateEstimator::stall()
+{
+    // Given
+    RateEstimator target;
+    target.addSample(0, 0);
+    auto bytes = run(target, 0, 0, 6000, 1024*1024);
+
+    // When
+    run(target, 6000, bytes, 1500, 0);
+
+    // Then
+    QVERIFY(target.rate() < 0.75 * 1024*1024); // not hidden by the average since the beginning
+
+    // When
+    run(target, 7500, bytes, 1650, 0);
+
+    // Then
+    QCOMPARE(target.rate(), qreal(0));
+    QCOMPARE(target.remainingTime(), qint64(-1));
+}
+
+void tst_RateEstimator::restart()
+{
+    // Given
+    RateEstimator target;
+    target.addSample(0, 0);
+    auto bytes = run(target, 0, 0, 1500, 1000);
+    QVERIFY(target.rate() > 0);
+
+    // When
+    target.addSample(1650, bytes / 2);
+
+    // Then
+    QCOMPARE(target.rate(), qreal(-1));
+
+    // When
+    target.reset();
+
+    // Then
+    QCOMPARE(target.rate(), qreal(-1));
+}
+
+void tst_RateEstimator::remainingTime()
+{
+    // Given
+    RateEstimator target;
+    target.addSample(0, 0, 10000);
+
+    // When
+    run(target, 0, 0, 3000, 1000, 10000);
+
+    // Then
+    QVERIFY(target.remainingTime() >= 7);
+    QVERIFY(target.remainingTime() <= 8);
+
+    // When
+    target.addSample(3150, 10000, 10000);
+
+    // Then
+    QCOMPARE(target.remainingTime(), qint64(0));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QTEST_APPLESS_MAIN(tst_RateEstimator)
+
+#include "tst_rateestimator.moc"
@@ -16,11 +16,16 @@
 
 #include <Core/ResourceItem>
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
 #include <QtCore/QUrl>
 
 #include <QtCore/QDebug>
 #include <QtTest/QtTest>
 
+constexpr int benchmark_items = 1000000;
+constexpr qint64 max_bytes_per_item = 1024; ///< The URL and the description aren't shared
+
 class tst_ResourceItem : public QObject
 {
     Q_OBJECT
@@ -28,8 +33,34 @@ class tst_ResourceItem : public QObject
 private slots:
     void localFileUrl_data();
     void localFileUrl();
+
+    void internedStrings();
+    void extensionBlocks();
+    void host();
+    void memoryBenchmark();
+
+private:
+    static qint64 residentSetSize();
 };
 
+/*!
+ * Returns the resident memory of the process, in bytes, or -1 if unknown.
+ */
+qint64 tst_ResourceItem::residentSetSize()
+{
+    QFile file("/proc/self/status");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return -1;
+    }
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        if (line.startsWith("VmRSS:")) {
+            return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+        }
+    }
+    return -1;
+}
+
 /******************************************************************************
 ******************************************************************************/
 void tst_ResourceItem::localFileUrl_data()
@@ -133,6 +164,106 @@ void tst_ResourceItem::localFileUrl()
     QCOMPARE(actual, expected);
 }
 
+/******************************************************************************
+******************************************************************************/
+void tst_ResourceItem::internedStrings()
+{
+    // Given
+    ResourceItem item1;
+    ResourceItem item2;
+
+    // When
+    item1.setDestination(QString("/home/me/") + "downloads/");
+    item2.setDestination(QString("/home/me/") + "downloads/");
+    item1.setReferringPage(QString("https://www.example.com/") + "index.html");
+    item2.setReferringPage(QString("https://www.example.com/") + "index.html");
+
+    // Then
+    QCOMPARE(item1.destination(), item2.destination());
+    QCOMPARE(item1.destination().constData(), item2.destination().constData());
+    QCOMPARE(item1.referringPage().constData(), item2.referringPage().constData());
+}
+
+void tst_ResourceItem::extensionBlocks()
+{
+    // Given
+    ResourceItem target;
+
+    // When
+    target.setStreamFileName(QString());
+    target.setRemoteFileSize(-1);
+    target.setTorrentPreferredFilePriorities("1,0,1");
+
+    // Then
+    QCOMPARE(target.streamFileName(), QString());
+    QCOMPARE(target.streamFileSize(), qsizetype(0));
+    QCOMPARE(target.remoteFileSize(), qsizetype(-1));
+    QVERIFY(!target.isProbed());
+    QCOMPARE(target.torrentPreferredFilePriorities(), QString("1,0,1"));
+
+    ResourceItem copy(target);
+    copy.setTorrentPreferredFilePriorities("0,0,0");
+    QCOMPARE(target.torrentPreferredFilePriorities(), QString("1,0,1"));
+}
+
+void tst_ResourceItem::host()
+{
+    // Given
+    ResourceItem target;
+    target.setUrl("https://www.example.com/a.zip");
+    ResourceItem other;
+    other.setUrl("https://www.example.com/b.zip");
+    QCOMPARE(target.host(), QString("www.example.com"));
+    QCOMPARE(target.host().constData(), other.host().constData());
+
+    // When
+    target.setUrl("https://www.example.org/a.zip");
+
+    // Then
+    QCOMPARE(target.host(), QString("www.example.org"));
+    QCOMPARE(target.distantFileUrl().host(), QString("www.example.org"));
+}
+
+/*!
+ * Measures the memory of a queue of 1M items, from a few batches.
+ *
+ * Slow, so only run if DZA_BENCHMARK is set.
+ */
+void tst_ResourceItem::memoryBenchmark()
+{
+    if (!qEnvironmentVariableIsSet("DZA_BENCHMARK")) {
+        QSKIP("Set DZA_BENCHMARK to run the benchmark");
+    }
+    const qint64 before = residentSetSize();
+    if (before < 0) {
+        QSKIP("Resident memory unknown on this platform");
+    }
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<ResourceItem*> items;
+    items.reserve(benchmark_items);
+    for (int i = 0; i < benchmark_items; ++i) {
+        const int batch = i / 10000;
+        auto item = new ResourceItem();
+        item->setUrl(QString("https://www.example.com/files/%0/file-%1.zip").arg(batch).arg(i));
+        item->setDestination(QString("/home/me/Downloads/batch-%0/").arg(batch));
+        item->setMask("*name*.*ext*");
+        item->setReferringPage(QString("https://www.example.com/files/%0/").arg(batch));
+        item->setDescription(QString("File %0").arg(i));
+        items.append(item);
+    }
+    const qint64 after = residentSetSize();
+    const qint64 bytesPerItem = (after - before) / benchmark_items;
+    qInfo("%d items: %lld bytes per item (sizeof %d), created in %lld msec",
+          benchmark_items, bytesPerItem, int(sizeof(ResourceItem)), timer.elapsed());
+
+    QVERIFY2(bytesPerItem <= max_bytes_per_item,
+             qPrintable(QString("%0 bytes per item").arg(bytesPerItem)));
+    QCOMPARE(items.first()->mask().constData(), items.last()->mask().constData());
+    qDeleteAll(items);
+}
+
 
 /******************************************************************************
 ******************************************************************************/
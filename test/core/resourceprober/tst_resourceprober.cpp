@@ -0,0 +1,99 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/ResourceProber>
+
+#include <QtCore/QDebug>
+
+#include <QtTest/QtTest>
+
+class tst_ResourceProber : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fileNameFromContentDisposition_data();
+    void fileNameFromContentDisposition();
+    void sizeFromContentRange_data();
+    void sizeFromContentRange();
+};
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_ResourceProber::fileNameFromContentDisposition_data()
+{
+    QTest::addColumn<QByteArray>("header");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("empty") << QByteArray() << QString();
+    QTest::newRow("inline") << QByteArray("inline") << QString();
+    QTest::newRow("token") << QByteArray("attachment; filename=file.zip") << "file.zip";
+    QTest::newRow("quoted") << QByteArray("attachment; filename=\"my file.zip\"") << "my file.zip";
+    QTest::newRow("semicolon") << QByteArray("attachment; filename=\"a;b.zip\"; size=10") << "a;b.zip";
+    QTest::newRow("escaped") << QByteArray("attachment; filename=\"a\\\"b.zip\"") << "a\"b.zip";
+    QTest::newRow("case") << QByteArray("Attachment; FileName=\"file.zip\"") << "file.zip";
+    QTest::newRow("utf-8")
+            << QByteArray("attachment; filename*=UTF-8''caf%C3%A9.txt")
+            << QString::fromUtf8("caf\xc3\xa9.txt");
+    QTest::newRow("latin-1")
+            << QByteArray("attachment; filename*=iso-8859-1'en'caf%E9.txt")
+            << QString::fromUtf8("caf\xc3\xa9.txt");
+    QTest::newRow("encoded first")
+            << QByteArray("attachment; filename=\"fallback.txt\"; filename*=UTF-8''real.txt")
+            << "real.txt";
+    QTest::newRow("path") << QByteArray("attachment; filename=\"../../etc/passwd\"") << "passwd";
+    QTest::newRow("windows path") << QByteArray("attachment; filename=\"C:\\\\dir\\\\file.zip\"") << "file.zip";
+}
+
+void tst_ResourceProber::fileNameFromContentDisposition()
+{
+    QFETCH(QByteArray, header);
+    QFETCH(QString, expected);
+
+    auto actual = ResourceProber::fileNameFromContentDisposition(header);
+
+    QCOMPARE(actual, expected);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_ResourceProber::sizeFromContentRange_data()
+{
+    QTest::addColumn<QByteArray>("header");
+    QTest::addColumn<qsizetype>("expected");
+
+    QTest::newRow("empty") << QByteArray() << qsizetype(-1);
+    QTest::newRow("first byte") << QByteArray("bytes 0-0/1000") << qsizetype(1000);
+    QTest::newRow("big") << QByteArray("bytes 0-0/8589934592") << qsizetype(8589934592);
+    QTest::newRow("unknown") << QByteArray("bytes 0-0/*") << qsizetype(-1);
+    QTest::newRow("unsatisfied") << QByteArray("bytes */1000") << qsizetype(1000);
+}
+
+void tst_ResourceProber::sizeFromContentRange()
+{
+    QFETCH(QByteArray, header);
+    QFETCH(qsizetype, expected);
+
+    auto actual = ResourceProber::sizeFromContentRange(header);
+
+    QCOMPARE(actual, expected);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QTEST_APPLESS_MAIN(tst_ResourceProber)
+
+#include "tst_resourceprober.moc"
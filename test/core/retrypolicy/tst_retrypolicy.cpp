@@ -0,0 +1,122 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/RetryPolicy>
+
+#include <QtCore/QDebug>
+
+#include <QtTest/QtTest>
+
+class tst_RetryPolicy : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void isTransient_data();
+    void isTransient();
+    void shouldRetry();
+    void delay();
+    void delayCapped();
+};
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_RetryPolicy::isTransient_data()
+{
+    QTest::addColumn<QNetworkReply::NetworkError>("error");
+    QTest::addColumn<bool>("expected");
+
+    QTest::newRow("timeout") << QNetworkReply::TimeoutError << true;
+    QTest::newRow("closed") << QNetworkReply::RemoteHostClosedError << true;
+    QTest::newRow("refused") << QNetworkReply::ConnectionRefusedError << true;
+    QTest::newRow("proxy timeout") << QNetworkReply::ProxyTimeoutError << true;
+    QTest::newRow("500") << QNetworkReply::InternalServerError << true;
+    QTest::newRow("503") << QNetworkReply::ServiceUnavailableError << true;
+    QTest::newRow("5xx") << QNetworkReply::UnknownServerError << true;
+    QTest::newRow("transfer timeout") << QNetworkReply::OperationCanceledError << true;
+
+    QTest::newRow("ssl") << QNetworkReply::SslHandshakeFailedError << false;
+    QTest::newRow("401") << QNetworkReply::AuthenticationRequiredError << false;
+    QTest::newRow("403") << QNetworkReply::ContentAccessDenied << false;
+    QTest::newRow("404") << QNetworkReply::ContentNotFoundError << false;
+    QTest::newRow("410") << QNetworkReply::ContentGoneError << false;
+    QTest::newRow("501") << QNetworkReply::OperationNotImplementedError << false;
+}
+
+void tst_RetryPolicy::isTransient()
+{
+    QFETCH(QNetworkReply::NetworkError, error);
+    QFETCH(bool, expected);
+
+    QCOMPARE(RetryPolicy::isTransient(error), expected);
+}
+
+void tst_RetryPolicy::shouldRetry()
+{
+    // Given
+    RetryPolicy target;
+    target.setMaxAttempts(3);
+
+    // Then
+    QVERIFY(target.shouldRetry(QNetworkReply::ServiceUnavailableError, 0));
+    QVERIFY(target.shouldRetry(QNetworkReply::ServiceUnavailableError, 2));
+    QVERIFY(!target.shouldRetry(QNetworkReply::ServiceUnavailableError, 3));
+    QVERIFY(!target.shouldRetry(QNetworkReply::ContentNotFoundError, 0));
+
+    // When
+    target.setMaxAttempts(0);
+
+    // Then
+    QVERIFY(!target.shouldRetry(QNetworkReply::ServiceUnavailableError, 0));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_RetryPolicy::delay()
+{
+    // Given
+    RetryPolicy target;
+    target.setBaseDelay(1000);
+    target.setMaxDelay(60000);
+
+    // Then
+    for (int i = 0; i < 100; ++i) {
+        auto delay0 = target.delay(0);
+        auto delay3 = target.delay(3);
+        QVERIFY(delay0 >= 500 && delay0 <= 1000);
+        QVERIFY(delay3 >= 4000 && delay3 <= 8000);
+    }
+}
+
+void tst_RetryPolicy::delayCapped()
+{
+    // Given
+    RetryPolicy target;
+    target.setBaseDelay(1000);
+    target.setMaxDelay(10000);
+
+    // When
+    auto delay = target.delay(100);
+
+    // Then
+    QVERIFY(delay >= 5000 && delay <= 10000);
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QTEST_APPLESS_MAIN(tst_RetryPolicy)
+
+#include "tst_retrypolicy.moc"
@@ -0,0 +1,277 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../utils/fakedownloaditem.h"
+
+#include <Core/IDownloadItem>
+#include <Core/Scheduler>
+
+#include <QtCore/QDebug>
+#include <QtCore/QUrl>
+
+#include <QtTest/QtTest>
+
+class tst_Scheduler : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+
+    void fifo();
+    void smallestFirst();
+    void hostRoundRobin();
+    void weightedPriority();
+    void maxDownloadsPerHost();
+    void updateIdle();
+    void candidates();
+    void clear();
+
+private:
+    QList<IDownloadItem*> m_items;
+
+    IDownloadItem* createItem(const QString &url, qsizetype bytesTotal = 0,
+                              IDownloadItem::Priority priority = IDownloadItem::NormalPriority);
+    void addIdle(Scheduler *target, const QList<int> &indexes) const;
+    void start(Scheduler *target, int index) const;
+};
+
+/******************************************************************************
+ ******************************************************************************/
+IDownloadItem* tst_Scheduler::createItem(const QString &url, qsizetype bytesTotal,
+                                         IDownloadItem::Priority priority)
+{
+    auto item = new FakeDownloadItem(this);
+    item->setSourceUrl(QUrl(url));
+    item->setBytesTotal(bytesTotal);
+    item->setPriority(priority);
+    m_items.append(item);
+    return item;
+}
+
+/*!
+ * Adds the items as Idle, ranked by their index in the queue.
+ */
+void tst_Scheduler::addIdle(Scheduler *target, const QList<int> &indexes) const
+{
+    for (auto index : indexes) {
+        target->addIdle(m_items.at(index), index);
+    }
+}
+
+/*!
+ * Moves the item from Idle to running, as the DownloadEngine does.
+ */
+void tst_Scheduler::start(Scheduler *target, int index) const
+{
+    target->removeIdle(m_items.at(index));
+    target->addRunning(m_items.at(index));
+}
+
+void tst_Scheduler::cleanup()
+{
+    qDeleteAll(m_items);
+    m_items.clear();
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_Scheduler::fifo()
+{
+    // Given
+    QScopedPointer<Scheduler> target(Scheduler::create(Scheduler::Fifo));
+    createItem("https://www.example.com/a.zip", 3000);
+    createItem("https://www.example.com/b.zip", 1000);
+    addIdle(target.data(), {1, 0});
+
+    // When
+    auto actual = target->next();
+
+    // Then
+    QCOMPARE(target->policy(), Scheduler::Fifo);
+    QCOMPARE(actual, m_items.at(0));
+
+    // When
+    target->removeIdle(m_items.at(0));
+    target->removeIdle(m_items.at(1));
+
+    // Then
+    QCOMPARE(target->next(), nullptr);
+}
+
+void tst_Scheduler::smallestFirst()
+{
+    // Given
+    QScopedPointer<Scheduler> target(Scheduler::create(Scheduler::SmallestFirst));
+    createItem("https://www.example.com/unknown.zip", 0);
+    createItem("https://www.example.com/big.zip", 3000);
+    createItem("https://www.example.com/small.zip", 1000);
+    addIdle(target.data(), {0, 1, 2});
+
+    // When
+    auto first = target->next();
+    start(target.data(), 2);
+    auto second = target->next();
+    start(target.data(), 1);
+    auto third = target->next();
+
+    // Then
+    QCOMPARE(first, m_items.at(2));
+    QCOMPARE(second, m_items.at(1));
+    QCOMPARE(third, m_items.at(0));
+}
+
+void tst_Scheduler::hostRoundRobin()
+{
+    // Given
+    QScopedPointer<Scheduler> target(Scheduler::create(Scheduler::HostRoundRobin));
+    createItem("https://www.example.com/a.zip");
+    createItem("https://www.example.com/b.zip");
+    createItem("https://www.example.org/c.zip");
+    createItem("https://www.example.net/d.zip");
+    addIdle(target.data(), {0, 1, 2, 3});
+
+    // When
+    auto first = target->next();
+    start(target.data(), 0);
+    auto second = target->next();
+    start(target.data(), 2);
+    auto third = target->next();
+    start(target.data(), 3);
+    auto fourth = target->next();
+
+    // Then
+    QCOMPARE(first, m_items.at(0));
+    QCOMPARE(second, m_items.at(2));
+    QCOMPARE(third, m_items.at(3));
+    QCOMPARE(fourth, m_items.at(1));
+}
+
+void tst_Scheduler::weightedPriority()
+{
+    // Given
+    QScopedPointer<Scheduler> target(Scheduler::create(Scheduler::WeightedPriority));
+    createItem("https://www.example.com/low.zip", 0, IDownloadItem::LowPriority);
+    createItem("https://www.example.com/normal.zip", 0, IDownloadItem::NormalPriority);
+    createItem("https://www.example.com/high-1.zip", 0, IDownloadItem::HighPriority);
+    createItem("https://www.example.com/high-2.zip", 0, IDownloadItem::HighPriority);
+    createItem("https://www.example.com/high-3.zip", 0, IDownloadItem::HighPriority);
+    addIdle(target.data(), {0, 1, 2, 3, 4});
+
+    // When
+    auto first = target->next();
+    start(target.data(), 2);
+    auto second = target->next();
+    start(target.data(), 3);
+    auto third = target->next();
+
+    // Then
+    QCOMPARE(first, m_items.at(2));
+    QCOMPARE(second, m_items.at(3));
+    QCOMPARE(third, m_items.at(1)); // Normal isn't starved by High
+}
+
+void tst_Scheduler::maxDownloadsPerHost()
+{
+    // Given
+    QScopedPointer<Scheduler> target(Scheduler::create(Scheduler::Fifo));
+    target->setMaxDownloadsPerHost(1);
+    createItem("https://www.example.com/a.zip");
+    createItem("https://www.example.com/b.zip");
+    createItem("https://www.example.org/c.zip");
+    addIdle(target.data(), {0, 1, 2});
+    start(target.data(), 0);
+
+    // When
+    auto first = target->next();
+    start(target.data(), 2);
+    auto second = target->next();
+
+    // Then
+    QCOMPARE(first, m_items.at(2));
+    QCOMPARE(second, nullptr);
+
+    // When
+    target->setMaxDownloadsPerHost(0);
+
+    // Then
+    QCOMPARE(target->next(), m_items.at(1));
+
+    // When
+    target->setMaxDownloadsPerHost(1);
+    target->removeRunning(m_items.at(0));
+
+    // Then
+    QCOMPARE(target->next(), m_items.at(1));
+}
+
+void tst_Scheduler::updateIdle()
+{
+    // Given
+    QScopedPointer<Scheduler> target(Scheduler::create(Scheduler::WeightedPriority));
+    auto low = static_cast<FakeDownloadItem*>(
+                createItem("https://www.example.com/low.zip", 0, IDownloadItem::LowPriority));
+    createItem("https://www.example.com/normal.zip", 0, IDownloadItem::NormalPriority);
+    addIdle(target.data(), {0, 1});
+
+    // When
+    low->setPriority(IDownloadItem::HighPriority);
+    target->updateIdle(low, 0);
+
+    // Then
+    QCOMPARE(target->next(), low);
+}
+
+void tst_Scheduler::candidates()
+{
+    // Given
+    QScopedPointer<Scheduler> target(Scheduler::create(Scheduler::HostRoundRobin));
+    createItem("https://www.example.com/a.zip");
+    createItem("https://www.example.com/b.zip");
+    createItem("https://www.example.org/c.zip");
+    addIdle(target.data(), {0, 1, 2});
+
+    // When
+    auto actual = target->candidates(2);
+
+    // Then
+    QCOMPARE(actual, QList<IDownloadItem*>({m_items.at(0), m_items.at(2)}));
+    QCOMPARE(target->next(), m_items.at(0)); // Nothing started
+}
+
+void tst_Scheduler::clear()
+{
+    // Given
+    QScopedPointer<Scheduler> target(Scheduler::create(Scheduler::Fifo));
+    target->setMaxDownloadsPerHost(1);
+    createItem("https://www.example.com/a.zip");
+    createItem("https://www.example.com/b.zip");
+    addIdle(target.data(), {0, 1});
+    start(target.data(), 0);
+
+    // When
+    target->clear();
+    addIdle(target.data(), {1});
+
+    // Then
+    QCOMPARE(target->next(), m_items.at(1)); // The host isn't busy anymore
+}
+
+/******************************************************************************
+ ******************************************************************************/
+QTEST_APPLESS_MAIN(tst_Scheduler)
+
+#include "tst_scheduler.moc"
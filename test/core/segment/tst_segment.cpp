@@ -0,0 +1,227 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/Segment>
+
+#include <QtCore/QDebug>
+#include <QtTest/QtTest>
+
+class tst_Segment : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void size();
+
+    void split_data();
+    void split();
+
+    void splitRemaining();
+    void splitRemainingTooSmall();
+
+    void contiguousSize_data();
+    void contiguousSize();
+
+    void fromContentRange_data();
+    void fromContentRange();
+};
+
+/******************************************************************************
+******************************************************************************/
+void tst_Segment::size()
+{
+    Segment segment(100, 199);
+    QCOMPARE(segment.size(), qsizetype(100));
+    QCOMPARE(segment.remaining(), qsizetype(100));
+    QCOMPARE(segment.position(), qsizetype(100));
+    QVERIFY(!segment.isComplete());
+
+    segment.setReceived(100);
+    QCOMPARE(segment.remaining(), qsizetype(0));
+    QCOMPARE(segment.position(), qsizetype(200));
+    QVERIFY(segment.isComplete());
+
+    Segment openEnded(0, -1);
+    QVERIFY(openEnded.isOpenEnded());
+    QCOMPARE(openEnded.size(), qsizetype(-1));
+    QCOMPARE(openEnded.remaining(), qsizetype(-1));
+    QVERIFY(!openEnded.isComplete());
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_Segment::split_data()
+{
+    QTest::addColumn<qsizetype>("bytesTotal");
+    QTest::addColumn<int>("count");
+    QTest::addColumn<qsizetype>("minimumSize");
+    QTest::addColumn<QList<Segment> >("expected");
+
+    QTest::newRow("unknown size")
+            << qsizetype(0) << 4 << qsizetype(10)
+            << QList<Segment>{ Segment(0, -1) };
+
+    QTest::newRow("one segment")
+            << qsizetype(100) << 1 << qsizetype(10)
+            << QList<Segment>{ Segment(0, 99) };
+
+    QTest::newRow("even")
+            << qsizetype(100) << 4 << qsizetype(10)
+            << QList<Segment>{ Segment(0, 24), Segment(25, 49), Segment(50, 74), Segment(75, 99) };
+
+    QTest::newRow("odd")
+            << qsizetype(101) << 2 << qsizetype(10)
+            << QList<Segment>{ Segment(0, 49), Segment(50, 100) };
+
+    QTest::newRow("bounded by minimum size")
+            << qsizetype(100) << 8 << qsizetype(40)
+            << QList<Segment>{ Segment(0, 49), Segment(50, 99) };
+
+    QTest::newRow("smaller than minimum size")
+            << qsizetype(10) << 8 << qsizetype(40)
+            << QList<Segment>{ Segment(0, 9) };
+}
+
+void tst_Segment::split()
+{
+    QFETCH(qsizetype, bytesTotal);
+    QFETCH(int, count);
+    QFETCH(qsizetype, minimumSize);
+    QFETCH(QList<Segment>, expected);
+
+    auto actual = Segment::split(bytesTotal, count, minimumSize);
+
+    QCOMPARE(actual, expected);
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_Segment::splitRemaining()
+{
+    Segment segment(0, 99, 20);
+    Segment tail;
+
+    QVERIFY(Segment::splitRemaining(segment, tail, 10));
+
+    QCOMPARE(segment, Segment(0, 59, 20));
+    QCOMPARE(tail, Segment(60, 99));
+    QCOMPARE(segment.remaining() + tail.remaining(), qsizetype(80));
+}
+
+void tst_Segment::splitRemainingTooSmall()
+{
+    Segment segment(0, 99, 90);
+    Segment tail;
+
+    QVERIFY(!Segment::splitRemaining(segment, tail, 10));
+    QCOMPARE(segment, Segment(0, 99, 90));
+
+    Segment openEnded(0, -1);
+    QVERIFY(!Segment::splitRemaining(openEnded, tail, 10));
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_Segment::contiguousSize_data()
+{
+    QTest::addColumn<QList<Segment> >("segments");
+    QTest::addColumn<qsizetype>("expected");
+
+    QTest::newRow("empty")
+            << QList<Segment>{}
+            << qsizetype(0);
+
+    QTest::newRow("one segment")
+            << QList<Segment>{ Segment(0, 99, 40) }
+            << qsizetype(40);
+
+    QTest::newRow("open-ended")
+            << QList<Segment>{ Segment(0, -1, 40) }
+            << qsizetype(40);
+
+    QTest::newRow("complete segments")
+            << QList<Segment>{ Segment(50, 99, 50), Segment(0, 49, 50) }
+            << qsizetype(100);
+
+    QTest::newRow("stops at the first incomplete segment")
+            << QList<Segment>{ Segment(0, 49, 50), Segment(50, 74, 10), Segment(75, 99, 25) }
+            << qsizetype(60);
+
+    QTest::newRow("gap at the beginning")
+            << QList<Segment>{ Segment(0, 49, 0), Segment(50, 99, 50) }
+            << qsizetype(0);
+}
+
+void tst_Segment::contiguousSize()
+{
+    QFETCH(QList<Segment>, segments);
+    QFETCH(qsizetype, expected);
+
+    auto actual = Segment::contiguousSize(segments);
+
+    QCOMPARE(actual, expected);
+}
+
+/******************************************************************************
+******************************************************************************/
+void tst_Segment::fromContentRange_data()
+{
+    QTest::addColumn<QByteArray>("header");
+    QTest::addColumn<bool>("expectedValid");
+    QTest::addColumn<Segment>("expectedRange");
+    QTest::addColumn<qsizetype>("expectedTotal");
+
+    QTest::newRow("range") << QByteArray("bytes 100-199/1000")
+                           << true << Segment(100, 199) << qsizetype(1000);
+    QTest::newRow("unknown total") << QByteArray("bytes 0-99/*")
+                                   << true << Segment(0, 99) << qsizetype(-1);
+    QTest::newRow("last byte") << QByteArray("bytes 999-999/1000")
+                               << true << Segment(999, 999) << qsizetype(1000);
+    QTest::newRow("beyond total") << QByteArray("bytes 0-1000/1000")
+                                  << false << Segment() << qsizetype(0);
+    QTest::newRow("reversed") << QByteArray("bytes 199-100/1000")
+                              << false << Segment() << qsizetype(0);
+    QTest::newRow("unsatisfied") << QByteArray("bytes */1000")
+                                 << false << Segment() << qsizetype(0);
+    QTest::newRow("other unit") << QByteArray("items 0-9/10")
+                                << false << Segment() << qsizetype(0);
+    QTest::newRow("empty") << QByteArray()
+                           << false << Segment() << qsizetype(0);
+}
+
+void tst_Segment::fromContentRange()
+{
+    QFETCH(QByteArray, header);
+    QFETCH(bool, expectedValid);
+    QFETCH(Segment, expectedRange);
+    QFETCH(qsizetype, expectedTotal);
+
+    Segment range;
+    qsizetype total = 0;
+    auto valid = Segment::fromContentRange(header, range, total);
+
+    QCOMPARE(valid, expectedValid);
+    if (expectedValid) {
+        QCOMPARE(range, expectedRange);
+        QCOMPARE(total, expectedTotal);
+    }
+}
+
+/******************************************************************************
+******************************************************************************/
+QTEST_APPLESS_MAIN(tst_Segment)
+
+#include "tst_segment.moc"
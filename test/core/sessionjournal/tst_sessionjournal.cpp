@@ -0,0 +1,299 @@
+/* - DownZemAll! - Copyright (C) 2019-present Sebastien Vavassori
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this program; If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Core/SessionJournal>
+
+#include <QtCore/QCborMap>
+#include <QtCore/QCborValue>
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+
+#include <QtTest/QtTest>
+
+using Job = SessionJournal::Job;
+
+class tst_SessionJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void replay();
+    void replayTruncated();
+    void replayOrder();
+    void validSize();
+    void appendAndCompact();
+    void post();
+    void truncateAtStartup();
+    void encodeSnapshot();
+    void decodeJsonSnapshot();
+    void decodeInvalidSnapshot();
+
+private:
+    static QByteArray job(qint64 id, const QString &url);
+    static QStringList urls(const QList<Job> &jobs);
+    static QList<Job> jobs(const QStringList &urls);
+};
+
+QByteArray tst_SessionJournal::job(qint64 id, const QString &url)
+{
+    QCborMap map;
+    map[QLatin1String("id")] = id;
+    map[QLatin1String("url")] = url;
+    return QCborValue(map).toCbor();
+}
+
+QStringList tst_SessionJournal::urls(const QList<Job> &jobs)
+{
+    QStringList urls;
+    for (const auto &job : jobs) {
+        const QCborMap map = QCborValue::fromCbor(job.data).toMap();
+        urls.append(map.value(QLatin1String("url")).toString());
+    }
+    return urls;
+}
+
+QList<Job> tst_SessionJournal::jobs(const QStringList &urls)
+{
+    QList<Job> jobs;
+    for (qsizetype i = 0; i < urls.count(); ++i) {
+        jobs.append({i, job(i, urls.at(i))});
+    }
+    return jobs;
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_SessionJournal::replay()
+{
+    // Given
+    QList<Job> snapshot;
+    snapshot.append({2, job(2, "c")}); // moved to the top
+    snapshot.append({0, job(0, "a")});
+    snapshot.append({1, job(1, "b")});
+
+    QByteArray journal;
+    journal += SessionJournal::putRecord(1, job(1, "b2"));
+    journal += SessionJournal::removeRecord(0);
+    journal += SessionJournal::putRecord(3, job(3, "d"));
+
+    // When
+    auto actual = SessionJournal::replay(snapshot, journal);
+
+    // Then
+    QCOMPARE(urls(actual), QStringList({"c", "b2", "d"}));
+}
+
+void tst_SessionJournal::replayTruncated()
+{
+    // Given
+    QByteArray journal;
+    journal += SessionJournal::putRecord(1, job(1, "b"));
+    journal += SessionJournal::putRecord(2, job(2, "c")).chopped(3); // crash
+    journal += SessionJournal::removeRecord(0);
+
+    // When
+    auto actual = SessionJournal::replay(jobs({"a"}), journal);
+
+    // Then
+    QCOMPARE(urls(actual), QStringList({"a", "b"}));
+}
+
+void tst_SessionJournal::replayOrder()
+{
+    // Given
+    QByteArray journal;
+    journal += SessionJournal::putRecord(3, job(3, "d"));
+    journal += SessionJournal::orderRecord({3, 1});
+    journal += SessionJournal::putRecord(4, job(4, "e"));
+
+    // When
+    auto actual = SessionJournal::replay(jobs({"a", "b", "c"}), journal);
+
+    // Then
+    QCOMPARE(urls(actual), QStringList({"d", "b", "a", "c", "e"}));
+}
+
+void tst_SessionJournal::validSize()
+{
+    // Given
+    QByteArray journal;
+    journal += SessionJournal::putRecord(1, job(1, "b"));
+    journal += SessionJournal::removeRecord(0);
+    const qsizetype expected = journal.size();
+    journal += SessionJournal::orderRecord({1, 0}).chopped(1); // crash
+
+    // When
+    auto actual = SessionJournal::validSize(journal);
+
+    // Then
+    QCOMPARE(actual, expected);
+}
+
+void tst_SessionJournal::appendAndCompact()
+{
+    // Given
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("queue.json");
+    const QString journalFileName = SessionJournal::journalFileName(fileName);
+    QVERIFY(SessionJournal::writeSnapshot(jobs({"a"}), fileName));
+
+    SessionJournal target;
+    target.setFileName(fileName);
+
+    // When
+    target.append(SessionJournal::putRecord(1, job(1, "b")), 1);
+    target.waitForWrites();
+
+    // Then
+    QCOMPARE(target.recordCount(), 1);
+    QVERIFY(QFile::exists(journalFileName));
+    QCOMPARE(urls(SessionJournal::read(fileName)), QStringList({"a", "b"}));
+
+    // When
+    target.compact();
+    target.waitForWrites();
+
+    // Then
+    QCOMPARE(target.recordCount(), 0);
+    QVERIFY(!QFile::exists(journalFileName));
+    QCOMPARE(urls(SessionJournal::read(fileName)), QStringList({"a", "b"}));
+}
+
+void tst_SessionJournal::post()
+{
+    // Given
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("queue.json");
+    const QString journalFileName = SessionJournal::journalFileName(fileName);
+
+    SessionJournal target;
+    target.setFileName(fileName);
+    bool isJournalWritten = false;
+    QThread *thread = Q_NULLPTR;
+
+    // When
+    target.append(SessionJournal::putRecord(0, job(0, "a")), 1);
+    target.post([&]() {
+        isJournalWritten = QFile::exists(journalFileName);
+        thread = QThread::currentThread();
+    });
+    target.waitForWrites();
+
+    // Then
+    QVERIFY(isJournalWritten); // in the order of the calls
+    QVERIFY(thread != Q_NULLPTR);
+    QVERIFY(thread != QThread::currentThread());
+}
+
+void tst_SessionJournal::truncateAtStartup()
+{
+    // Given
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("queue.json");
+    QVERIFY(SessionJournal::writeSnapshot(jobs({"a"}), fileName));
+    {
+        QFile journal(SessionJournal::journalFileName(fileName));
+        QVERIFY(journal.open(QIODevice::WriteOnly));
+        journal.write(SessionJournal::putRecord(1, job(1, "b")).chopped(2)); // crash
+    }
+
+    SessionJournal target;
+
+    // When
+    target.setFileName(fileName);
+    target.append(SessionJournal::putRecord(2, job(2, "c")), 1);
+    target.waitForWrites();
+
+    // Then
+    QCOMPARE(urls(SessionJournal::read(fileName)), QStringList({"a", "c"}));
+}
+
+/******************************************************************************
+ ******************************************************************************/
+void tst_SessionJournal::encodeSnapshot()
+{
+    // Given
+    QList<Job> snapshot;
+    snapshot.append({0, job(0, "a")});
+    snapshot.append({7, job(7, "b")});
+
+    // When
+    auto data = SessionJournal::encodeSnapshot(snapshot);
+    bool ok = false;
+    auto actual = SessionJournal::decodeSnapshot(data, &ok);
+
+    // Then
+    QVERIFY(ok);
+    QVERIFY(data.startsWith("\xd9\xd9\xf7")); // CBOR, not JSON
+    QCOMPARE(actual.count(), 2);
+    QCOMPARE(actual.at(1).id, qint64(7));
+    QCOMPARE(actual.at(1).data, snapshot.at(1).data); // not decoded
+    QCOMPARE(urls(actual), QStringList({"a", "b"}));
+}
+
+void tst_SessionJournal::decodeJsonSnapshot()
+{
+    // Given
+    QJsonObject a;
+    a["url"] = "a"; // no id: written without journal
+    QJsonObject b;
+    b["url"] = "b";
+    QJsonObject snapshot;
+    snapshot["jobs"] = QJsonArray({a, b});
+    auto data = QJsonDocument(snapshot).toJson();
+
+    // When
+    bool ok = false;
+    auto actual = SessionJournal::decodeSnapshot(data, &ok);
+
+    // Then
+    QVERIFY(ok);
+    QCOMPARE(actual.count(), 2);
+    QCOMPARE(actual.at(1).id, qint64(1));
+    QCOMPARE(urls(actual), QStringList({"a", "b"}));
+}
+
+void tst_SessionJournal::decodeInvalidSnapshot()
+{
+    // Given
+    auto data = SessionJournal::encodeSnapshot(jobs({"a"})).chopped(4);
+
+    // When
+    bool ok = true;
+    auto actual = SessionJournal::decodeSnapshot(data, &ok);
+
+    // Then
+    QVERIFY(!ok);
+    QVERIFY(actual.isEmpty());
+}
+
+/******************************************************************************
+ ******************************************************************************/
+/*
+ * The writes run in the event loop of a thread, so QTEST_GUILESS_MAIN
+ * instead of QTEST_APPLESS_MAIN.
+ */
+QTEST_GUILESS_MAIN(tst_SessionJournal)
+
+#include "tst_sessionjournal.moc"
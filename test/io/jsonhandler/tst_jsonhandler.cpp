@@ -30,6 +30,9 @@ class tst_JsonHandler : public QObject
 private slots:
     void write();
     void read();
+    void readUrlsInBatches();
+    void readUrlsInvalid();
+    void writeUrlsCanceled();
 
 private:
     inline QByteArray simplify(QByteArray &str);
@@ -135,6 +138,100 @@ void tst_JsonHandler::read()
     QVERIFY(toString(manager.downloadItems().at(4)) == "https://www.example.com/favicon.ico");
 }
 
+/******************************************************************************
+******************************************************************************/
+void tst_JsonHandler::readUrlsInBatches()
+{
+    // Given
+    QByteArray byteArray =
+            "{\"links\": ["
+            "{\"url\": \"https://www.example.com/1.jpg\"},"
+            "{\"url\": \"https://www.example.com/2.jpg\", \"extra\": {\"tag\": \"}\"}},"
+            "{\"url\": \"https://www.example.com/3.jpg\"},"
+            "{\"url\": \"https://www.example.com/4.jpg\"},"
+            "{\"url\": \"https://www.example.com/5.jpg\"}"
+            "], \"version\": [1, 2]}";
+
+    QBuffer buffer(&byteArray);
+    buffer.open(QIODevice::ReadOnly | QIODevice::Text);
+
+    JsonHandler target;
+    target.setDevice(&buffer);
+
+    QList<qsizetype> batchSizes;
+    QList<QUrl> urls;
+
+    // When
+    bool ok = target.readUrls(2, [&](const QList<QUrl> &batch) {
+        batchSizes << batch.count();
+        urls << batch;
+        return true;
+    });
+
+    // Then
+    QVERIFY(ok);
+    QCOMPARE(batchSizes, QList<qsizetype>({2, 2, 1}));
+    QCOMPARE(urls.count(), 5);
+    QCOMPARE(urls.at(1), QUrl("https://www.example.com/2.jpg"));
+    QCOMPARE(urls.at(4), QUrl("https://www.example.com/5.jpg"));
+}
+
+void tst_JsonHandler::readUrlsInvalid()
+{
+    // Given
+    QByteArray byteArray =
+            "{\"links\": ["
+            "{\"url\": \"https://www.example.com/1.jpg\"},"
+            "{\"url\": \"https://www.example.com/2.jpg\"},"
+            "{\"url\": \"https://www.example.com/3.jpg\"},"
+            "{\"url\": "; /* Truncated here */
+
+    QBuffer buffer(&byteArray);
+    buffer.open(QIODevice::ReadOnly | QIODevice::Text);
+
+    JsonHandler target;
+    target.setDevice(&buffer);
+
+    QList<QUrl> urls;
+
+    // When
+    bool ok = target.readUrls(2, [&](const QList<QUrl> &batch) {
+        urls << batch;
+        return true;
+    });
+
+    // Then
+    QVERIFY(!ok);
+    QCOMPARE(urls.count(), 3);
+}
+
+void tst_JsonHandler::writeUrlsCanceled()
+{
+    // Given
+    QList<QUrl> urls;
+    for (int i = 0; i < 10; ++i) {
+        urls << QUrl(QString("https://www.example.com/%0.jpg").arg(i));
+    }
+    QByteArray byteArray;
+    QBuffer buffer(&byteArray);
+    buffer.open(QIODevice::WriteOnly | QIODevice::Text);
+
+    JsonHandler target;
+    target.setDevice(&buffer);
+
+    QList<qsizetype> progress;
+
+    // When
+    bool ok = target.writeUrls(urls, 4, [&](qsizetype written) {
+        progress << written;
+        return written < 8;
+    });
+
+    // Then
+    QVERIFY(!ok);
+    QCOMPARE(progress, QList<qsizetype>({4, 8}));
+}
+
 /******************************************************************************
 ******************************************************************************/
 
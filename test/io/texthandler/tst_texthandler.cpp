@@ -32,6 +32,8 @@ private slots:
     void writeUTF8();
     void read();
     void readUTF8();
+    void readUrlsInBatches();
+    void writeUrlsInBatches();
 
 private:
     inline QByteArray simplify(QByteArray &str);
@@ -181,6 +183,77 @@ void tst_TextHandler::readUTF8()
     QVERIFY(toString(manager.downloadItems().at(0)) == "http://www.exemple.fr/Capture-d’écran-2017-06-20-à-10.22.38.png");
 }
 
+/******************************************************************************
+******************************************************************************/
+void tst_TextHandler::readUrlsInBatches()
+{
+    // Given
+    QByteArray byteArray =
+            "https://www.example.com/1.jpg\n"
+            "https://www.example.com/2.jpg\n"
+            "\n"
+            "https://www.example.com/3.jpg\n"
+            "https://www.example.com/4.jpg\n"
+            "https://www.example.com/5.jpg";
+
+    QBuffer buffer(&byteArray);
+    buffer.open(QIODevice::ReadOnly | QIODevice::Text);
+
+    TextHandler target;
+    target.setDevice(&buffer);
+
+    QList<qsizetype> batchSizes;
+    QList<QUrl> urls;
+
+    // When
+    bool ok = target.readUrls(2, [&](const QList<QUrl> &batch) {
+        batchSizes << batch.count();
+        urls << batch;
+        return true;
+    });
+
+    // Then
+    QVERIFY(ok);
+    QCOMPARE(batchSizes, QList<qsizetype>({2, 2, 1}));
+    QCOMPARE(urls.count(), 5);
+    QCOMPARE(urls.at(2), QUrl("https://www.example.com/3.jpg"));
+}
+
+void tst_TextHandler::writeUrlsInBatches()
+{
+    // Given
+    QList<QUrl> urls;
+    urls << QUrl("https://www.example.com/1.jpg")
+         << QUrl("https://www.example.com/2.jpg")
+         << QUrl("https://www.example.com/3.jpg");
+
+    QByteArray byteArray;
+    QBuffer buffer(&byteArray);
+    buffer.open(QIODevice::WriteOnly | QIODevice::Text);
+
+    QByteArray expected =
+            "https://www.example.com/1.jpg\n"
+            "https://www.example.com/2.jpg\n"
+            "https://www.example.com/3.jpg\n";
+
+    TextHandler target;
+    target.setDevice(&buffer);
+
+    QList<qsizetype> progress;
+
+    // When
+    bool ok = target.writeUrls(urls, 2, [&](qsizetype written) {
+        progress << written;
+        return true;
+    });
+    QByteArray actual = simplify(byteArray);
+
+    // Then
+    QVERIFY(ok);
+    QCOMPARE(progress, QList<qsizetype>({2, 3}));
+    QCOMPARE(actual, expected);
+}
+
 /******************************************************************************
 ******************************************************************************/
 
@@ -55,8 +55,8 @@ MainWindow::MainWindow(QWidget *parent): QMainWindow(parent)
                      this, SLOT(onJobAddedOrRemoved(DownloadRange)));
     QObject::connect(m_downloadManager, SIGNAL(jobRemoved(DownloadRange)),
                      this, SLOT(onJobAddedOrRemoved(DownloadRange)));
-    QObject::connect(m_downloadManager, SIGNAL(jobStateChanged(IDownloadItem*)),
-                     this, SLOT(onJobStateChanged(IDownloadItem*)));
+    QObject::connect(m_downloadManager, SIGNAL(jobsChanged(DownloadChanges)),
+                     this, SLOT(onJobsChanged(DownloadChanges)));
     QObject::connect(m_downloadManager, SIGNAL(selectionChanged()),
                      this, SLOT(onSelectionChanged()));
 
@@ -404,9 +404,14 @@ void MainWindow::onJobAddedOrRemoved(DownloadRange /*range*/)
     refreshTitleAndStatus();
 }
 
-void MainWindow::onJobStateChanged(IDownloadItem * /*downloadItem*/)
+void MainWindow::onJobsChanged(DownloadChanges changes)
 {
-    refreshMenus();
+    for (const auto &change : changes) {
+        if (change.changes.testFlag(IDownloadItem::StateChange)) {
+            refreshMenus();
+            break;
+        }
+    }
     refreshTitleAndStatus();
 }
 
@@ -85,7 +85,7 @@ public slots:
 
 private slots:
     void onJobAddedOrRemoved(DownloadRange downloadItem);
-    void onJobStateChanged(IDownloadItem *downloadItem);
+    void onJobsChanged(DownloadChanges changes);
     void onSelectionChanged();
 
 private: